@@ -1,5 +1,7 @@
 ﻿// Copyright 2017 Matt Tytel
 
+using System;
+using System.Collections.Generic;
 using UnityEngine;
 
 namespace AudioHelm
@@ -18,6 +20,18 @@ namespace AudioHelm
         static double lastSampledTime = 0.0;
         static AudioHelmClock singleton;
 
+        struct TempoChange
+        {
+            public double time;
+            public float bpm;
+            public double rampTime;
+        }
+
+        // Scheduled changes that haven't started yet, in time order.
+        static List<TempoChange> tempoChanges = new List<TempoChange>();
+        static float rampTargetBpm = 120.0f;
+        static double rampEndTime = 0.0;
+
         const double waitToSync = 1.0;
         const double SECONDS_PER_MIN = 60.0;
 
@@ -89,13 +103,83 @@ namespace AudioHelm
             Native.Pause(false);
         }
 
+        void OnApplicationQuit()
+        {
+            Native.HelmReleasePrewarmedInstances();
+        }
+
         void SetGlobalBpm()
         {
             if (bpm_ > 0.0f)
             {
                 Native.SetBpm(bpm_);
                 globalBpm = bpm_;
+                rampEndTime = 0.0;
+            }
+        }
+
+        /// <summary>
+        /// Changes the bpm at a scheduled dsp audio (AudioSettings.dspTime) time.
+        /// The tempo moves linearly to the new bpm over rampTime seconds, so
+        /// a rampTime of 0 jumps straight to it.
+        /// </summary>
+        /// <param name="newBpm">The bpm to move to.</param>
+        /// <param name="timeToStart">The audio thread time to start changing.</param>
+        /// <param name="rampTime">How many seconds the change takes.</param>
+        public void ScheduleBpm(float newBpm, double timeToStart, double rampTime)
+        {
+            if (newBpm <= 0.0f)
+                return;
+
+            Native.HelmScheduleBpm(timeToStart, newBpm, rampTime);
+
+            TempoChange change = new TempoChange();
+            change.time = timeToStart;
+            change.bpm = newBpm;
+            change.rampTime = rampTime;
+
+            int index = tempoChanges.Count;
+            while (index > 0 && tempoChanges[index - 1].time > timeToStart)
+                index--;
+            tempoChanges.Insert(index, change);
+        }
+
+        // Beats passed between two dsp times following the same tempo curve
+        // the native transport plays, so beat syncs only correct drift.
+        double AdvanceTempo(double startTime, double endTime)
+        {
+            double beats = 0.0;
+            while (startTime < endTime)
+            {
+                if (tempoChanges.Count > 0 && tempoChanges[0].time <= startTime)
+                {
+                    TempoChange change = tempoChanges[0];
+                    tempoChanges.RemoveAt(0);
+                    bpm_ = change.bpm;
+                    rampTargetBpm = change.bpm;
+                    rampEndTime = startTime + change.rampTime;
+                    if (change.rampTime <= 0.0)
+                        globalBpm = change.bpm;
+                    continue;
+                }
+
+                double time = endTime;
+                if (tempoChanges.Count > 0)
+                    time = Math.Min(time, tempoChanges[0].time);
+
+                double nextBpm = globalBpm;
+                if (rampEndTime > startTime)
+                {
+                    time = Math.Min(time, rampEndTime);
+                    double progress = (time - startTime) / (rampEndTime - startTime);
+                    nextBpm = globalBpm + progress * (rampTargetBpm - globalBpm);
+                }
+
+                beats += (time - startTime) * (globalBpm + nextBpm) / (2.0 * SECONDS_PER_MIN);
+                globalBpm = (float)nextBpm;
+                startTime = time;
             }
+            return beats;
         }
 
         void SetGlobalPause()
@@ -169,10 +253,9 @@ namespace AudioHelm
                 return;
             
             double time = AudioSettings.dspTime;
-            double deltaTime = time - lastSampledTime;
+            globalBeatTime += AdvanceTempo(lastSampledTime, time);
             lastSampledTime = time;
 
-            globalBeatTime += deltaTime * globalBpm / SECONDS_PER_MIN;
             Native.SetBeatTime(globalBeatTime);
         }
     }
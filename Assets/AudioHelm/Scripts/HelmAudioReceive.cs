@@ -15,6 +15,42 @@ namespace AudioHelm
     {
         public int channel = 0;
 
+        int registeredChannel = -1;
+
+        void RegisterReceiver()
+        {
+            if (registeredChannel == channel)
+                return;
+
+            UnregisterReceiver();
+            Native.HelmAddBufferReceiver(channel);
+            registeredChannel = channel;
+        }
+
+        void UnregisterReceiver()
+        {
+            if (registeredChannel < 0)
+                return;
+
+            Native.HelmRemoveBufferReceiver(registeredChannel);
+            registeredChannel = -1;
+        }
+
+        void OnEnable()
+        {
+            RegisterReceiver();
+        }
+
+        void OnDisable()
+        {
+            UnregisterReceiver();
+        }
+
+        void Update()
+        {
+            RegisterReceiver();
+        }
+
         void OnAudioFilterRead(float[] data, int audioChannels)
         {
             Native.HelmGetBufferData(channel, data, data.Length / audioChannels, audioChannels);
@@ -100,6 +100,24 @@ namespace AudioHelm
             }
         }
 
+        /// <summary>
+        /// Loads a synthesizer patch in the binary format at runtime.
+        /// The whole patch is applied natively in one call, which is much faster than
+        /// loading a JSON patch when many instances load at once.
+        /// Binary patches are exported from the Helm app with --export-binary.
+        /// </summary>
+        /// <param name="patchData">Contents of the binary patch file.</param>
+        /// <returns>True if the patch was valid and loaded into at least one instance.</returns>
+        public bool LoadPatch(byte[] patchData)
+        {
+            if (!Native.HelmLoadPatch(channel, patchData, patchData.Length))
+                return false;
+
+            for (int i = 0; i < synthParameters.Count; ++i)
+                SetParameterAtIndex(i, Native.HelmGetParameterValue(channel, (int)synthParameters[i].parameter));
+            return true;
+        }
+
         /// <summary>
         /// Gets the parameter value at index in the parameter list.
         /// </summary>
@@ -111,6 +111,15 @@ namespace AudioHelm
         #endif
         public static extern bool HelmSetParameterValue(int channel, int paramIndex, float newValue);
 
+        #if UNITY_IOS
+          [DllImport("__Internal")]
+        #else
+          [DllImport("AudioPluginHelm")]
+        #endif
+        public static extern bool HelmScheduleParameterValues(int channel, int numEvents, int[] paramIndices,
+                                                              float[] newValues, int[] sampleOffsets,
+                                                              int[] rampSamples);
+
         #if UNITY_IOS
           [DllImport("__Internal")]
         #else
@@ -139,6 +148,83 @@ namespace AudioHelm
         #endif
         public static extern bool HelmGetBufferData(int channel, float[] buffer, int samples, int numAudioChannels);
 
+        #if UNITY_IOS
+          [DllImport("__Internal")]
+        #else
+          [DllImport("AudioPluginHelm")]
+        #endif
+        public static extern void HelmAddAnalysisReceiver(int channel, int type);
+
+        #if UNITY_IOS
+          [DllImport("__Internal")]
+        #else
+          [DllImport("AudioPluginHelm")]
+        #endif
+        public static extern void HelmRemoveAnalysisReceiver(int channel, int type);
+
+        #if UNITY_IOS
+          [DllImport("__Internal")]
+        #else
+          [DllImport("AudioPluginHelm")]
+        #endif
+        public static extern int HelmGetAnalysisData(int channel, int type, float[] buffer, int size);
+
+        #if UNITY_IOS
+          [DllImport("__Internal")]
+        #else
+          [DllImport("AudioPluginHelm")]
+        #endif
+        public static extern void HelmSetVoiceThreads(int channel, int numThreads);
+
+        #if UNITY_IOS
+          [DllImport("__Internal")]
+        #else
+          [DllImport("AudioPluginHelm")]
+        #endif
+        public static extern void HelmSetControlInterval(int channel, int samples);
+
+        #if UNITY_IOS
+          [DllImport("__Internal")]
+        #else
+          [DllImport("AudioPluginHelm")]
+        #endif
+        public static extern void HelmSetSampleRateDivider(int channel, int divider);
+
+        #if UNITY_IOS
+          [DllImport("__Internal")]
+        #else
+          [DllImport("AudioPluginHelm")]
+        #endif
+        public static extern int HelmSaveState(int channel, byte[] buffer, int size);
+
+        #if UNITY_IOS
+          [DllImport("__Internal")]
+        #else
+          [DllImport("AudioPluginHelm")]
+        #endif
+        public static extern bool HelmLoadState(int channel, byte[] buffer, int size);
+
+        #if UNITY_IOS
+          [DllImport("__Internal")]
+        #else
+          [DllImport("AudioPluginHelm")]
+        #endif
+        public static extern bool HelmLoadPatch(int channel, byte[] buffer, int size);
+
+        #if UNITY_IOS
+          [DllImport("__Internal")]
+        #else
+          [DllImport("AudioPluginHelm")]
+        #endif
+        public static extern void HelmAddBufferReceiver(int channel);
+
+        #if UNITY_IOS
+          [DllImport("__Internal")]
+        #else
+          [DllImport("AudioPluginHelm")]
+        #endif
+        public static extern void HelmRemoveBufferReceiver(int channel);
+
         #if UNITY_IOS
           [DllImport("__Internal")]
         #else
@@ -146,6 +232,13 @@ namespace AudioHelm
         #endif
         public static extern void SetBpm(float bpm);
 
+        #if UNITY_IOS
+          [DllImport("__Internal")]
+        #else
+          [DllImport("AudioPluginHelm")]
+        #endif
+        public static extern void HelmScheduleBpm(double dspTime, float bpm, double rampSeconds);
+
         #if UNITY_IOS
           [DllImport("__Internal")]
         #else
@@ -253,6 +346,20 @@ namespace AudioHelm
         #endif
         public static extern void SetBeatTime(double time);
 
+        #if UNITY_IOS
+          [DllImport("__Internal")]
+        #else
+          [DllImport("AudioPluginHelm")]
+        #endif
+        public static extern void HelmPrewarmInstances(int numInstances, int sampleRate);
+
+        #if UNITY_IOS
+          [DllImport("__Internal")]
+        #else
+          [DllImport("AudioPluginHelm")]
+        #endif
+        public static extern void HelmReleasePrewarmedInstances();
+
 
         #if UNITY_IOS
           [DllImport("__Internal")]
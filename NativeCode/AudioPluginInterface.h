@@ -61,6 +61,7 @@
 #define UNITY_AUDIODSP_RESULT int
 
 #include <assert.h>
+#include <stdint.h>
 
 enum
 {
@@ -1,4 +1,5 @@
 #include "AudioPluginUtil.h"
+#include "realtime_check.h"
 #include <stdarg.h>
 
 #define ENABLE_TESTS ((PLATFORM_WIN || PLATFORM_OSX) && 1)
@@ -51,6 +52,9 @@ namespace AudioHelm {
 
   bool Mutex::TryLock()
   {
+  #ifdef HELM_REALTIME_CHECK
+      Helm::checkRealtime("mutex try lock");
+  #endif
   #if PLATFORM_WIN
       return TryEnterCriticalSection(&crit_sec) != 0;
   #else
@@ -60,6 +64,11 @@ namespace AudioHelm {
 
   void Mutex::Lock()
   {
+  #ifdef HELM_REALTIME_CHECK
+      // Even a free mutex can be held by another thread by the time it's
+      // taken, so the audio thread shouldn't take one at all.
+      Helm::checkRealtime("mutex lock");
+  #endif
   #if PLATFORM_WIN
       EnterCriticalSection(&crit_sec);
   #else
@@ -16,6 +16,7 @@
 
 #include "arpeggiator.h"
 
+#include "processor_state.h"
 #include "utils.h"
 
 #include <algorithm>
@@ -34,6 +35,10 @@ namespace mopo {
     MOPO_ASSERT(note_handler);
     pressed_notes_.reserve(MIDI_SIZE);
     sustained_notes_.reserve(MIDI_SIZE);
+    as_played_.reserve(MIDI_SIZE);
+    ascending_.reserve(MIDI_SIZE);
+    decending_.reserve(MIDI_SIZE);
+    active_notes_.reserve(MIDI_SIZE);
   }
 
   void Arpeggiator::process() {
@@ -114,10 +119,19 @@ namespace mopo {
     }
     mopo_float base_note = pattern->at(note_index_);
     mopo_float note = base_note + mopo::NOTES_PER_OCTAVE * current_octave_;
-    mopo_float velocity = active_notes_[base_note];
+    std::pair<mopo_float, mopo_float>* active_note = findActiveNote(base_note);
+    mopo_float velocity = active_note ? active_note->second : 0.0;
     return std::pair<mopo_float, mopo_float>(note, velocity);
   }
 
+  std::pair<mopo_float, mopo_float>* Arpeggiator::findActiveNote(mopo_float note) {
+    for (auto& active_note : active_notes_) {
+      if (active_note.first == note)
+        return &active_note;
+    }
+    return nullptr;
+  }
+
   CircularQueue<mopo_float>& Arpeggiator::getPressedNotes() {
     return pressed_notes_;
   }
@@ -161,14 +175,14 @@ namespace mopo {
   }
 
   void Arpeggiator::noteOn(mopo_float note, mopo_float velocity, int sample, int channel) {
-    if (active_notes_.count(note))
+    if (findActiveNote(note))
       return;
     if (pressed_notes_.size() == 0) {
       note_index_ = -1;
       current_octave_ = 0;
       phase_ = 1.0;
     }
-    active_notes_[note] = velocity;
+    active_notes_.push_back(std::make_pair(note, velocity));
     pressed_notes_.push_back(note);
     addNoteToPatterns(note);
   }
@@ -180,11 +194,28 @@ namespace mopo {
     if (sustain_)
       sustained_notes_.push_back(note);
     else {
-      active_notes_.erase(note);
+      std::pair<mopo_float, mopo_float>* active_note = findActiveNote(note);
+      if (active_note)
+        active_notes_.erase(active_notes_.begin() + (active_note - active_notes_.data()));
       removeNoteFromPatterns(note);
     }
 
     pressed_notes_.removeAll(note);
     return kVoiceOff;
   }
+
+  void Arpeggiator::syncState(ProcessorState* state) {
+    state->sync(sustain_);
+    state->sync(phase_);
+    state->sync(note_index_);
+    state->sync(current_octave_);
+    state->sync(octave_up_);
+    state->sync(last_played_note_);
+    state->syncVector(as_played_);
+    state->syncVector(ascending_);
+    state->syncVector(decending_);
+    state->syncVector(active_notes_);
+    state->syncQueue(pressed_notes_);
+    state->syncQueue(sustained_notes_);
+  }
 } // namespace mopo
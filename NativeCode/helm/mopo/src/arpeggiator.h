@@ -58,6 +58,7 @@ namespace mopo {
       }
 
       virtual void process() override;
+      virtual void syncState(ProcessorState* state) override;
 
       int getNumNotes() { return pressed_notes_.size(); }
       CircularQueue<mopo_float>& getPressedNotes();
@@ -75,6 +76,9 @@ namespace mopo {
     private:
       Arpeggiator() : Processor(0, 0) { }
 
+      // The held note's entry in active_notes_, or null if it isn't held.
+      std::pair<mopo_float, mopo_float>* findActiveNote(mopo_float note);
+
       NoteHandler* note_handler_;
 
       bool sustain_;
@@ -88,7 +92,9 @@ namespace mopo {
       std::vector<mopo_float> ascending_;
       std::vector<mopo_float> decending_;
 
-      std::map<mopo_float, mopo_float> active_notes_;
+      // Each held note and its velocity. Notes come and go on the audio
+      // thread, so these live in storage reserved up front instead of a map.
+      std::vector<std::pair<mopo_float, mopo_float>> active_notes_;
       CircularQueue<mopo_float> pressed_notes_;
       CircularQueue<mopo_float> sustained_notes_;
   };
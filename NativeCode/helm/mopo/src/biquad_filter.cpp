@@ -15,6 +15,7 @@
  */
 
 #include "biquad_filter.h"
+#include "processor_state.h"
 #include "utils.h"
 
 #include <cmath>
@@ -54,11 +55,9 @@ namespace mopo {
   void BiquadFilter::process() {
     MOPO_ASSERT(inputMatchesBufferSize(kAudio));
 
-    current_type_ = static_cast<Type>(static_cast<int>(input(kType)->at(0)));
-    mopo_float cutoff = utils::clamp(input(kCutoff)->at(0), MIN_CUTTOFF, sample_rate_);
-    mopo_float resonance = utils::clamp(input(kResonance)->at(0),
-                                        MIN_RESONANCE, MAX_RESONANCE);
-    computeCoefficients(current_type_, cutoff, resonance, input(kGain)->at(0));
+    Type type = static_cast<Type>(static_cast<int>(input(kType)->at(0)));
+    setTarget(type, input(kCutoff)->at(0), input(kResonance)->at(0),
+              input(kGain)->at(0));
 
     mopo_float delta_in_0 = (target_in_0_ - in_0_) / buffer_size_;
     mopo_float delta_in_1 = (target_in_1_ - in_1_) / buffer_size_;
@@ -98,6 +97,15 @@ namespace mopo {
     }
   }
 
+  void BiquadFilter::setTarget(Type type, mopo_float cutoff,
+                               mopo_float resonance, mopo_float gain) {
+    current_type_ = type;
+    computeCoefficients(type,
+                        utils::clamp(cutoff, MIN_CUTTOFF, sample_rate_),
+                        utils::clamp(resonance, MIN_RESONANCE, MAX_RESONANCE),
+                        gain);
+  }
+
   void BiquadFilter::computeCoefficients(Type type,
                                    mopo_float cutoff,
                                    mopo_float resonance,
@@ -246,4 +254,23 @@ namespace mopo {
     out_2_ = target_out_2_;
   }
 
+  void BiquadFilter::syncState(ProcessorState* state) {
+    state->sync(current_type_);
+    state->sync(current_cutoff_);
+    state->sync(current_resonance_);
+    state->sync(in_0_);
+    state->sync(in_1_);
+    state->sync(in_2_);
+    state->sync(out_1_);
+    state->sync(out_2_);
+    state->sync(target_in_0_);
+    state->sync(target_in_1_);
+    state->sync(target_in_2_);
+    state->sync(target_out_1_);
+    state->sync(target_out_2_);
+    state->sync(past_in_1_);
+    state->sync(past_in_2_);
+    state->sync(past_out_1_);
+    state->sync(past_out_2_);
+  }
 } // namespace mopo
@@ -51,6 +51,15 @@ namespace mopo {
         kNumTypes,
       };
 
+      enum Coefficients {
+        kIn0,
+        kIn1,
+        kIn2,
+        kOut1,
+        kOut2,
+        kNumCoefficients
+      };
+
       BiquadFilter();
       virtual ~BiquadFilter() { }
 
@@ -66,12 +75,27 @@ namespace mopo {
 
       virtual Processor* clone() const { return new BiquadFilter(*this); }
       virtual void process();
+      virtual void syncState(ProcessorState* state);
 
       void computeCoefficients(Type type,
                                mopo_float cutoff,
                                mopo_float resonance,
                                mopo_float gain);
 
+      // Clamps cutoff and resonance to the stable range and computes the
+      // target coefficients, the same as process() does with its inputs.
+      void setTarget(Type type, mopo_float cutoff,
+                     mopo_float resonance, mopo_float gain);
+
+      // Fills _coefficients_ in Coefficients order.
+      void getTargetCoefficients(mopo_float* coefficients) const {
+        coefficients[kIn0] = target_in_0_;
+        coefficients[kIn1] = target_in_1_;
+        coefficients[kIn2] = target_in_2_;
+        coefficients[kOut1] = target_out_1_;
+        coefficients[kOut2] = target_out_2_;
+      }
+
       inline void tick(int i, mopo_float* dest, const mopo_float* audio_buffer);
 
     private:
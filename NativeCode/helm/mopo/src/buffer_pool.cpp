@@ -0,0 +1,220 @@
+/* Copyright 2013-2017 Matt Tytel
+ *
+ * mopo is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * mopo is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with mopo.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "buffer_pool.h"
+
+#include "bypass_router.h"
+#include "tick_router.h"
+
+#include <algorithm>
+#include <map>
+
+namespace mopo {
+
+  namespace {
+    // Where an output is needed in the processing order, from the position
+    // its owner writes it to the position of its last reader.
+    struct Lifetime {
+      Output* output;
+      int start;
+      int end;
+      int size;
+    };
+
+    bool startsEarlier(const Lifetime& a, const Lifetime& b) {
+      return a.start < b.start;
+    }
+
+    bool passesThrough(const Processor* processor, const Output* source) {
+      const BypassRouter* bypass = dynamic_cast<const BypassRouter*>(processor);
+      return bypass && bypass->input(BypassRouter::kAudio)->source == source;
+    }
+
+    // A bypassed router skips what's inside it, so anything reading an
+    // output from in there has to be skipped along with it.
+    bool runsWith(const Processor* reader, const Processor* writer,
+                  const std::map<const Processor*, int>& positions) {
+      for (const Processor* router = writer->router(); router; router = router->router()) {
+        if (positions.count(router) == 0 || !dynamic_cast<const BypassRouter*>(router))
+          continue;
+
+        const Processor* inside = reader->router();
+        while (inside && inside != router)
+          inside = inside->router();
+        if (inside == nullptr)
+          return false;
+      }
+      return true;
+    }
+  } // namespace
+
+  BufferPool::BufferPool() :
+      working_set_size_(0), shared_working_set_size_(0),
+      allocated_size_(0), shared_allocated_size_(0) { }
+
+  void BufferPool::plan(const std::vector<Processor*>& order,
+                        const std::set<const Output*>& kept) {
+    release();
+
+    int num_processors = order.size();
+    std::map<const Processor*, int> positions;
+    for (int i = 0; i < num_processors; ++i)
+      positions[order[i]] = i;
+
+    // A router's span runs to the last processor inside it.
+    std::vector<int> span_end(num_processors);
+    for (int i = 0; i < num_processors; ++i) {
+      span_end[i] = i;
+      for (const Processor* router = order[i]->router(); router; router = router->router()) {
+        auto found = positions.find(router);
+        if (found != positions.end())
+          span_end[found->second] = i;
+      }
+    }
+
+    // Processors in a TickRouter run interleaved a sample at a time, so they
+    // count as running for the whole TickRouter.
+    std::vector<int> first(num_processors);
+    std::vector<int> last(num_processors);
+    for (int i = 0; i < num_processors; ++i) {
+      first[i] = i;
+      last[i] = i;
+      for (const Processor* router = order[i]->router(); router; router = router->router()) {
+        auto found = positions.find(router);
+        if (found != positions.end() && dynamic_cast<const TickRouter*>(router)) {
+          first[i] = found->second;
+          last[i] = span_end[found->second];
+        }
+      }
+    }
+
+    // Outputs registered on a router are read through it from outside.
+    std::set<const Output*> kept_outputs = kept;
+    std::map<const Output*, int> registrations;
+    std::map<const Output*, std::vector<int>> readers;
+    for (int i = 0; i < num_processors; ++i) {
+      for (const Input* input : *order[i]->inputPorts()) {
+        if (input && input->source)
+          readers[input->source].push_back(i);
+      }
+      for (const Output* output : *order[i]->outputPorts()) {
+        if (output && output->owner != order[i]) {
+          kept_outputs.insert(output);
+          registrations[output]++;
+        }
+      }
+    }
+
+    working_set_size_ = 0;
+    allocated_size_ = 0;
+    std::vector<Lifetime> lifetimes;
+    for (int i = 0; i < num_processors; ++i) {
+      Processor* processor = order[i];
+      if (processor->isControlRate())
+        continue;
+
+      int size = processor->getBufferSize() * sizeof(mopo_float);
+      for (Output* output : *processor->outputPorts()) {
+        if (output == nullptr || output->owner != processor || output->buffer_size <= 1)
+          continue;
+
+        working_set_size_ += size;
+        allocated_size_ += output->buffer_size * sizeof(mopo_float);
+        if (!processor->rewritesOutputs() || !processor->enabled() ||
+            kept_outputs.count(output) || output->buffer != output->ownBuffer()) {
+          continue;
+        }
+
+        // Readers have to run after the owner and only ever read the buffer.
+        // Bypassed routers pass it on, so their readers count too.
+        Lifetime lifetime = { output, first[i], last[i], size };
+        bool shareable = readers.count(output);
+        std::vector<const Output*> uses(1, output);
+        for (size_t u = 0; u < uses.size() && shareable; ++u) {
+          auto found = readers.find(uses[u]);
+          if (found == readers.end())
+            continue;
+
+          for (int reader : found->second) {
+            const Processor* reading = order[reader];
+            lifetime.end = std::max(lifetime.end, last[reader]);
+
+            if (first[reader] <= last[i] || reading->isControlRate() ||
+                !runsWith(reading, processor, positions)) {
+              shareable = false;
+            }
+            else if (passesThrough(reading, uses[u])) {
+              for (const Output* passed : *reading->outputPorts()) {
+                shareable = shareable && kept.count(passed) == 0 &&
+                            registrations[passed] == 1 && readers.count(passed);
+                uses.push_back(passed);
+              }
+            }
+            else if (!reading->rewritesOutputs())
+              shareable = false;
+          }
+        }
+
+        if (shareable)
+          lifetimes.push_back(lifetime);
+      }
+    }
+
+    // An output takes any buffer whose last reader has already run. The
+    // first output to take a buffer lends its own, and the outputs after it
+    // free theirs.
+    std::stable_sort(lifetimes.begin(), lifetimes.end(), startsEarlier);
+    std::vector<Output*> buffers;
+    std::vector<int> free_after;
+    std::vector<int> sizes;
+    shared_working_set_size_ = working_set_size_;
+    shared_allocated_size_ = allocated_size_;
+    for (const Lifetime& lifetime : lifetimes) {
+      int buffer = 0;
+      int num_buffers = buffers.size();
+      while (buffer < num_buffers && (free_after[buffer] >= lifetime.start ||
+             buffers[buffer]->buffer_size < lifetime.output->buffer_size)) {
+        buffer++;
+      }
+
+      if (buffer == num_buffers) {
+        buffers.push_back(lifetime.output);
+        free_after.push_back(0);
+        sizes.push_back(0);
+      }
+      else {
+        lifetime.output->shareBuffer(buffers[buffer]->ownBuffer());
+        shared_outputs_.push_back(lifetime.output);
+        shared_allocated_size_ -= lifetime.output->buffer_size * sizeof(mopo_float);
+      }
+
+      free_after[buffer] = lifetime.end;
+      sizes[buffer] = std::max(sizes[buffer], lifetime.size);
+      shared_working_set_size_ -= lifetime.size;
+    }
+
+    for (int size : sizes)
+      shared_working_set_size_ += size;
+  }
+
+  void BufferPool::release() {
+    for (Output* output : shared_outputs_)
+      output->shareBuffer(nullptr);
+    shared_outputs_.clear();
+    shared_working_set_size_ = working_set_size_;
+    shared_allocated_size_ = allocated_size_;
+  }
+} // namespace mopo
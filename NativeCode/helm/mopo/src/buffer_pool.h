@@ -0,0 +1,68 @@
+/* Copyright 2013-2017 Matt Tytel
+ *
+ * mopo is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * mopo is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with mopo.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+#ifndef BUFFER_POOL_H
+#define BUFFER_POOL_H
+
+#include "processor.h"
+
+#include <set>
+#include <vector>
+
+namespace mopo {
+
+  // Moves audio outputs of a processing order into a few shared buffers.
+  // An output only needs its buffer from the time its owner writes it until
+  // the last reader has run, so outputs whose lifetimes don't overlap can
+  // take turns with the same buffer. That keeps the buffers one pass through
+  // the order touches small enough to stay in cache.
+  class BufferPool {
+    public:
+      BufferPool();
+
+      // Shares buffers between outputs of _order_, which has to list the
+      // processors in the order they run with every router before the
+      // processors inside it. Outputs in _kept_ are read from outside the
+      // order and keep their own buffers.
+      void plan(const std::vector<Processor*>& order,
+                const std::set<const Output*>& kept);
+
+      // Gives every shared output a buffer of its own again.
+      void release();
+
+      // Bytes of audio output buffer one pass through the planned order
+      // touches, before and after sharing.
+      int workingSetSize() const { return working_set_size_; }
+      int sharedWorkingSetSize() const { return shared_working_set_size_; }
+
+      // Bytes of buffer the audio outputs of the planned order hold, before
+      // and after sharing. Shared outputs write into a buffer another output
+      // lends them and free their own until they're released.
+      int allocatedSize() const { return allocated_size_; }
+      int sharedAllocatedSize() const { return shared_allocated_size_; }
+
+    private:
+      std::vector<Output*> shared_outputs_;
+
+      int working_set_size_;
+      int shared_working_set_size_;
+      int allocated_size_;
+      int shared_allocated_size_;
+  };
+} // namespace mopo
+
+#endif // BUFFER_POOL_H
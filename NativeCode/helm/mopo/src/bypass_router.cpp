@@ -24,12 +24,17 @@ namespace mopo {
   void BypassRouter::process() {
     MOPO_ASSERT(inputMatchesBufferSize(kAudio));
 
+    // Bypassed outputs pass the audio buffer through instead of copying it.
     mopo_float should_process = input(kOn)->at(0);
-    if (should_process)
+    int num_outputs = numOutputs();
+    if (should_process) {
+      for (int i = 0; i < num_outputs; ++i)
+        output(i)->buffer = output(i)->ownBuffer();
       ProcessorRouter::process();
+    }
     else  {
-      for (int i = 0; i < numOutputs(); ++i)
-        utils::copyBuffer(output(i)->buffer, input(kAudio)->source->buffer, buffer_size_);
+      for (int i = 0; i < num_outputs; ++i)
+        output(i)->buffer = input(kAudio)->source->buffer;
     }
   }
 } // namespace mopo
@@ -183,6 +183,10 @@ namespace mopo {
         return (end_ - start_ + capacity_) % capacity_;
       }
 
+      int capacity() const {
+        return capacity_ - 1;
+      }
+
       iterator begin() const {
         return iterator(data_ + start_, data_, data_ + (capacity_ - 1));
       }
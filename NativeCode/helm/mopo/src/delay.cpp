@@ -16,6 +16,8 @@
 
 #include "delay.h"
 
+#include "processor_state.h"
+
 #define DEFAULT_PERIOD 100.0
 
 namespace mopo {
@@ -73,4 +75,12 @@ namespace mopo {
     dest[i] = current_dry_ * audio[i] + current_wet_ * read;
     MOPO_ASSERT(std::isfinite(dest[i]));
   }
+
+  void Delay::syncState(ProcessorState* state) {
+    memory_->syncState(state);
+    state->sync(current_feedback_);
+    state->sync(current_wet_);
+    state->sync(current_dry_);
+    state->sync(current_period_);
+  }
 } // namespace mopo
@@ -42,6 +42,7 @@ namespace mopo {
 
       virtual Processor* clone() const override { return new Delay(*this); }
       virtual void process() override;
+      virtual void syncState(ProcessorState* state) override;
 
       inline void tick(int i, const mopo_float* audio, mopo_float* dest);
 
@@ -15,113 +15,60 @@
  */
 
 #include "distortion.h"
+#include "processor_state.h"
 #include "utils.h"
 
 namespace mopo {
 
-  namespace {
-    inline mopo_float linearFold(mopo_float t) {
-      mopo_float adjust = 0.25 * t + 0.75;
-      mopo_float range = adjust - floor(adjust);
-      return fabs(2.0 - 4.0 * range) - 1.0;
-    }
-
-    inline mopo_float sinFold(mopo_float t) {
-      mopo_float adjust = -0.25 * t + 0.5;
-      mopo_float range = adjust - floor(adjust);
-      return utils::quickSin1(range);
-    }
-  } // namespace
-
-
   Distortion::Distortion() :
       Processor(Distortion::kNumInputs, 1), last_mix_(0.0), last_drive_(0.0) { }
 
-  void Distortion::processSoftClip() {
-    const mopo_float* audio = input(kAudio)->source->buffer;
+  void Distortion::driveInput() {
     mopo_float next_drive = input(kDrive)->at(0);
     mopo_float mult_drive = (next_drive - last_drive_) / buffer_size_;
-    mopo_float next_mix = input(kMix)->at(0);
-    mopo_float mult_mix = (next_mix - last_mix_) / buffer_size_;
 
     mopo_float* dest = output()->buffer;
-    int buffer_size = buffer_size_;
-
-    VECTORIZE_LOOP
-    for (int i = 0; i < buffer_size; ++i) {
-      mopo_float mix = last_mix_ + i * mult_mix;
-      mopo_float drive = last_drive_ + i * mult_drive;
-      mopo_float distort = drive * audio[i];
-      dest[i] = utils::interpolate(audio[i], utils::quickTanh(distort), mix);
-    }
-
-    last_mix_ = next_mix;
+    vector_math::ramp(dest, last_drive_, mult_drive, buffer_size_);
+    vector_math::multiply(dest, dest, input(kAudio)->source->buffer, buffer_size_);
     last_drive_ = next_drive;
   }
 
-  void Distortion::processHardClip() {
-    const mopo_float* audio = input(kAudio)->source->buffer;
-    mopo_float next_drive = input(kDrive)->at(0);
-    mopo_float mult_drive = (next_drive - last_drive_) / buffer_size_;
+  void Distortion::mixInput() {
     mopo_float next_mix = input(kMix)->at(0);
     mopo_float mult_mix = (next_mix - last_mix_) / buffer_size_;
 
     mopo_float* dest = output()->buffer;
-    int buffer_size = buffer_size_;
-
-    for (int i = 0; i < buffer_size; ++i) {
-      mopo_float mix = last_mix_ + i * mult_mix;
-      mopo_float drive = last_drive_ + i * mult_drive;
-      mopo_float distort = utils::clamp(drive * audio[i], -1.0, 1.0);
-      dest[i] = utils::interpolate(audio[i], distort, mix);
-    }
-
+    vector_math::ramp(mix_, last_mix_, mult_mix, buffer_size_);
+    vector_math::interpolate(dest, input(kAudio)->source->buffer, dest, mix_, buffer_size_);
     last_mix_ = next_mix;
-    last_drive_ = next_drive;
   }
 
-  void Distortion::processLinearFold() {
-    const mopo_float* audio = input(kAudio)->source->buffer;
-    mopo_float next_drive = input(kDrive)->at(0);
-    mopo_float mult_drive = (next_drive - last_drive_) / buffer_size_;
-    mopo_float next_mix = input(kMix)->at(0);
-    mopo_float mult_mix = (next_mix - last_mix_) / buffer_size_;
-
+  void Distortion::processSoftClip() {
     mopo_float* dest = output()->buffer;
-    int buffer_size = buffer_size_;
+    driveInput();
+    vector_math::tanh(dest, dest, buffer_size_);
+    mixInput();
+  }
 
-    VECTORIZE_LOOP
-    for (int i = 0; i < buffer_size; ++i) {
-      mopo_float mix = last_mix_ + i * mult_mix;
-      mopo_float drive = last_drive_ + i * mult_drive;
-      mopo_float distort = linearFold(drive * audio[i]);
-      dest[i] = utils::interpolate(audio[i], distort, mix);
-    }
+  void Distortion::processHardClip() {
+    mopo_float* dest = output()->buffer;
+    driveInput();
+    vector_math::clamp(dest, dest, -1.0, 1.0, buffer_size_);
+    mixInput();
+  }
 
-    last_mix_ = next_mix;
-    last_drive_ = next_drive;
+  void Distortion::processLinearFold() {
+    mopo_float* dest = output()->buffer;
+    driveInput();
+    vector_math::linearFold(dest, dest, buffer_size_);
+    mixInput();
   }
 
   void Distortion::processSinFold() {
-    const mopo_float* audio = input(kAudio)->source->buffer;
-    mopo_float next_drive = input(kDrive)->at(0);
-    mopo_float mult_drive = (next_drive - last_drive_) / buffer_size_;
-    mopo_float next_mix = input(kMix)->at(0);
-    mopo_float mult_mix = (next_mix - last_mix_) / buffer_size_;
-
     mopo_float* dest = output()->buffer;
-    int buffer_size = buffer_size_;
-
-    VECTORIZE_LOOP
-    for (int i = 0; i < buffer_size; ++i) {
-      mopo_float mix = last_mix_ + i * mult_mix;
-      mopo_float drive = last_drive_ + i * mult_drive;
-      mopo_float distort = sinFold(drive * audio[i]);
-      dest[i] = utils::interpolate(audio[i], distort, mix);
-    }
-
-    last_mix_ = next_mix;
-    last_drive_ = next_drive;
+    driveInput();
+    vector_math::sinFold(dest, dest, buffer_size_);
+    mixInput();
   }
 
   void Distortion::process() {
@@ -150,4 +97,9 @@ namespace mopo {
         utils::copyBuffer(output()->buffer, input(kAudio)->source->buffer, buffer_size_);
     }
   }
+
+  void Distortion::syncState(ProcessorState* state) {
+    state->sync(last_mix_);
+    state->sync(last_drive_);
+  }
 } // namespace mopo
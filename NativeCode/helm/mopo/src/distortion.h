@@ -51,6 +51,7 @@ namespace mopo {
       }
 
       virtual void process() override;
+      virtual void syncState(ProcessorState* state) override;
 
       void processSoftClip();
       void processHardClip();
@@ -58,8 +59,14 @@ namespace mopo {
       void processSinFold();
 
     private:
+      // Each type drives the input into the output, distorts the output in
+      // place, then mixes the input back in.
+      void driveInput();
+      void mixInput();
+
       mopo_float last_mix_;
       mopo_float last_drive_;
+      mopo_float mix_[MAX_BUFFER_SIZE];
   };
 } // namespace mopo
 
@@ -16,6 +16,7 @@
 
 #include "envelope.h"
 
+#include "processor_state.h"
 #include "sample_decay_lookup.h"
 
 #include <cmath>
@@ -93,4 +94,9 @@ namespace mopo {
       output(kValue)->buffer[0] = current_value_;
     }
   }
+
+  void Envelope::syncState(ProcessorState* state) {
+    state->sync(state_);
+    state->sync(current_value_);
+  }
 } // namespace mopo
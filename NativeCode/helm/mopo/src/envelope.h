@@ -62,6 +62,7 @@ namespace mopo {
 
       virtual Processor* clone() const override { return new Envelope(*this); }
       void process() override;
+      void syncState(ProcessorState* state) override;
       void trigger(mopo_float event);
 
     protected:
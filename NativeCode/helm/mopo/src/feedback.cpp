@@ -17,6 +17,7 @@
 #include "feedback.h"
 
 #include "processor_router.h"
+#include "processor_state.h"
 
 namespace mopo {
 
@@ -37,4 +38,14 @@ namespace mopo {
     else
       utils::copyBuffer(output(0)->buffer, buffer_, MAX_BUFFER_SIZE);
   }
+
+  void Feedback::syncState(ProcessorState* state) {
+    int size = buffer_size_;
+    state->sync(size);
+    if (size < 0 || size > MAX_BUFFER_SIZE) {
+      state->invalidate();
+      return;
+    }
+    state->syncArray(buffer_, size);
+  }
 } // namespace mopo
@@ -36,6 +36,7 @@ namespace mopo {
 
       virtual Processor* clone() const override { return new Feedback(*this); }
       virtual void process() override;
+      virtual void syncState(ProcessorState* state) override;
       virtual void refreshOutput();
 
       inline void tick(int i) {
@@ -16,34 +16,78 @@
 
 #include "formant_manager.h"
 
-#include "biquad_filter.h"
-#include "operators.h"
+#include "magnitude_lookup.h"
+#include "midi_lookup.h"
+#include "processor_state.h"
+#include "utils.h"
 
 namespace mopo {
 
-  FormantManager::FormantManager(int num_formants) : ProcessorRouter(0, 0) {
-    Bypass* audio_input = new Bypass();
-    cr::Bypass* reset_input = new cr::Bypass();
+  FormantManager::FormantManager(int num_formants) :
+      Processor(kNumInputs, 1), past_in_1_(0.0), past_in_2_(0.0) {
+    MOPO_ASSERT(num_formants <= MAX_FORMANTS);
 
-    registerInput(audio_input->input(), kAudio);
-    registerInput(reset_input->input(), kReset);
-
-    addProcessor(audio_input);
-    addProcessor(reset_input);
-
-    VariableAdd* total = new VariableAdd(num_formants);
     for (int i = 0; i < num_formants; ++i) {
-      BiquadFilter* formant = new BiquadFilter();
-      formant->plug(audio_input, BiquadFilter::kAudio);
-      formant->plug(reset_input, BiquadFilter::kReset);
-      formants_.push_back(formant);
+      formants_.push_back(new BiquadFilter());
+      types_[i] = BiquadFilter::kGainedBandPass;
+
+      for (int c = 0; c < kNumCorners; ++c) {
+        shapes_[i][c].decibels = 0.0;
+        shapes_[i][c].resonance = 1.0;
+        shapes_[i][c].midi_cutoff = 0.0;
+      }
+    }
 
-      addProcessor(formant);
-      total->plugNext(formant);
+    for (int i = 0; i < MAX_FORMANTS; ++i) {
+      for (int c = 0; c < BiquadFilter::kNumCoefficients; ++c) {
+        mopo_float value = c == BiquadFilter::kIn0 ? 1.0 : 0.0;
+        coefficients_[c][i] = value;
+        targets_[c][i] = value;
+      }
+      past_out_1_[i] = past_out_2_[i] = 0.0;
     }
+  }
+
+  FormantManager::FormantManager(const FormantManager& other) :
+      Processor(other), past_in_1_(other.past_in_1_),
+      past_in_2_(other.past_in_2_) {
+    for (BiquadFilter* formant : other.formants_)
+      formants_.push_back(new BiquadFilter(*formant));
+
+    memcpy(types_, other.types_, sizeof(types_));
+    memcpy(shapes_, other.shapes_, sizeof(shapes_));
+    memcpy(coefficients_, other.coefficients_, sizeof(coefficients_));
+    memcpy(targets_, other.targets_, sizeof(targets_));
+    memcpy(past_out_1_, other.past_out_1_, sizeof(past_out_1_));
+    memcpy(past_out_2_, other.past_out_2_, sizeof(past_out_2_));
+  }
+
+  FormantManager::~FormantManager() {
+    for (BiquadFilter* formant : formants_)
+      delete formant;
+  }
+
+  void FormantManager::destroy() {
+    for (BiquadFilter* formant : formants_)
+      formant->destroy();
+    Processor::destroy();
+  }
+
+  void FormantManager::setSampleRate(int sample_rate) {
+    Processor::setSampleRate(sample_rate);
+    for (BiquadFilter* formant : formants_)
+      formant->setSampleRate(sample_rate);
+  }
 
-    addProcessor(total);
-    registerOutput(total->output());
+  void FormantManager::setCorner(int index, Corner corner, mopo_float decibels,
+                                 mopo_float resonance, mopo_float midi_cutoff) {
+    shapes_[index][corner].decibels = decibels;
+    shapes_[index][corner].resonance = resonance;
+    shapes_[index][corner].midi_cutoff = midi_cutoff;
+  }
+
+  void FormantManager::setType(int index, BiquadFilter::Type type) {
+    types_[index] = type;
   }
 
   std::complex<mopo_float> FormantManager::getResponse(mopo_float frequency) {
@@ -53,4 +97,116 @@ namespace mopo {
 
     return total;
   }
+
+  void FormantManager::computeTargets() {
+    mopo_float x = input(kXPosition)->at(0);
+    mopo_float y = input(kYPosition)->at(0);
+
+    int num = formants_.size();
+    for (int i = 0; i < num; ++i) {
+      const FormantShape* shape = shapes_[i];
+
+      mopo_float decibels = utils::interpolate(
+          utils::interpolate(shape[kTopLeft].decibels, shape[kTopRight].decibels, x),
+          utils::interpolate(shape[kBottomLeft].decibels, shape[kBottomRight].decibels, x),
+          y);
+      mopo_float resonance = utils::interpolate(
+          utils::interpolate(shape[kTopLeft].resonance, shape[kTopRight].resonance, x),
+          utils::interpolate(shape[kBottomLeft].resonance, shape[kBottomRight].resonance, x),
+          y);
+      mopo_float midi = utils::interpolate(
+          utils::interpolate(shape[kTopLeft].midi_cutoff, shape[kTopRight].midi_cutoff, x),
+          utils::interpolate(shape[kBottomLeft].midi_cutoff, shape[kBottomRight].midi_cutoff, x),
+          y);
+
+      mopo_float gain = MagnitudeLookup::magnitudeLookup(decibels);
+      mopo_float cutoff = MidiLookup::centsLookup(CENTS_PER_NOTE * midi);
+
+      formants_[i]->setTarget(types_[i], cutoff, resonance, gain);
+      mopo_float target[BiquadFilter::kNumCoefficients];
+      formants_[i]->getTargetCoefficients(target);
+      for (int c = 0; c < BiquadFilter::kNumCoefficients; ++c)
+        targets_[c][i] = target[c];
+    }
+  }
+
+  void FormantManager::reset() {
+    past_in_1_ = past_in_2_ = 0.0;
+    for (int i = 0; i < MAX_FORMANTS; ++i) {
+      past_out_1_[i] = past_out_2_[i] = 0.0;
+      for (int c = 0; c < BiquadFilter::kNumCoefficients; ++c)
+        coefficients_[c][i] = targets_[c][i];
+    }
+  }
+
+  inline void FormantManager::tick(int i, mopo_float* dest,
+                                   const mopo_float* audio_buffer) {
+    mopo_float audio = audio_buffer[i];
+    mopo_float out[MAX_FORMANTS];
+
+    VECTORIZE_LOOP
+    for (int f = 0; f < MAX_FORMANTS; ++f) {
+      out[f] = audio * coefficients_[BiquadFilter::kIn0][f] +
+               past_in_1_ * coefficients_[BiquadFilter::kIn1][f] +
+               past_in_2_ * coefficients_[BiquadFilter::kIn2][f] -
+               past_out_1_[f] * coefficients_[BiquadFilter::kOut1][f] -
+               past_out_2_[f] * coefficients_[BiquadFilter::kOut2][f];
+      past_out_2_[f] = past_out_1_[f];
+      past_out_1_[f] = out[f];
+    }
+    past_in_2_ = past_in_1_;
+    past_in_1_ = audio;
+
+    mopo_float total = 0.0;
+    int num = formants_.size();
+    for (int f = 0; f < num; ++f)
+      total += out[f];
+    dest[i] = total;
+  }
+
+  void FormantManager::process() {
+    MOPO_ASSERT(inputMatchesBufferSize(kAudio));
+
+    computeTargets();
+
+    mopo_float delta[BiquadFilter::kNumCoefficients][MAX_FORMANTS];
+    for (int c = 0; c < BiquadFilter::kNumCoefficients; ++c) {
+      for (int f = 0; f < MAX_FORMANTS; ++f)
+        delta[c][f] = (targets_[c][f] - coefficients_[c][f]) / buffer_size_;
+    }
+
+    const mopo_float* audio_buffer = input(kAudio)->source->buffer;
+    mopo_float* dest = output()->buffer;
+
+    bool reset_voice = input(kReset)->source->triggered &&
+                       input(kReset)->source->trigger_value == kVoiceReset;
+    int ramp_samples = buffer_size_;
+    if (reset_voice)
+      ramp_samples = input(kReset)->source->trigger_offset;
+
+    int i = 0;
+    for (; i < ramp_samples; ++i) {
+      for (int c = 0; c < BiquadFilter::kNumCoefficients; ++c) {
+        VECTORIZE_LOOP
+        for (int f = 0; f < MAX_FORMANTS; ++f)
+          coefficients_[c][f] += delta[c][f];
+      }
+      tick(i, dest, audio_buffer);
+    }
+
+    if (reset_voice) {
+      reset();
+      for (; i < buffer_size_; ++i)
+        tick(i, dest, audio_buffer);
+    }
+  }
+
+  void FormantManager::syncState(ProcessorState* state) {
+    state->sync(coefficients_);
+    state->sync(targets_);
+    state->sync(past_out_1_);
+    state->sync(past_out_2_);
+    state->sync(past_in_1_);
+    state->sync(past_in_2_);
+  }
 } // namespace mopo
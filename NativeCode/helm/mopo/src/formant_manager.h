@@ -18,28 +18,56 @@
 #ifndef FORMANT_MANAGER_H
 #define FORMANT_MANAGER_H
 
-#include "processor_router.h"
+#include "biquad_filter.h"
+#include "processor.h"
 
 #include <complex>
+#include <vector>
 
 namespace mopo {
 
-  class BiquadFilter;
-
-  class FormantManager : public ProcessorRouter {
+  // A bank of parallel biquad formants driven by a 2D vowel position. Each
+  // formant's gain, resonance and cutoff are bilinearly interpolated between
+  // four corner shapes, and all formants run together in one kernel.
+  class FormantManager : public Processor {
     public:
       enum Inputs {
         kAudio,
         kReset,
+        kXPosition,
+        kYPosition,
         kNumInputs
       };
 
-      FormantManager(int num_formants = 4);
+      enum Corner {
+        kTopLeft,
+        kTopRight,
+        kBottomLeft,
+        kBottomRight,
+        kNumCorners
+      };
+
+      static const int MAX_FORMANTS = 4;
+
+      FormantManager(int num_formants = MAX_FORMANTS);
+      FormantManager(const FormantManager& other);
+      virtual ~FormantManager();
 
       virtual Processor* clone() const override {
         return new FormantManager(*this);
       }
 
+      virtual void destroy() override;
+      virtual void process() override;
+      virtual bool rewritesOutputs() const override { return true; }
+      virtual void syncState(ProcessorState* state) override;
+      virtual void setSampleRate(int sample_rate) override;
+
+      // Sets the shape of formant _index_ at one corner of the vowel space.
+      void setCorner(int index, Corner corner, mopo_float decibels,
+                     mopo_float resonance, mopo_float midi_cutoff);
+      void setType(int index, BiquadFilter::Type type);
+
       BiquadFilter* getFormant(int index = 0) { return formants_[index]; }
       int num_formants() { return formants_.size(); }
 
@@ -54,7 +82,28 @@ namespace mopo {
       }
 
     protected:
+      struct FormantShape {
+        mopo_float decibels;
+        mopo_float resonance;
+        mopo_float midi_cutoff;
+      };
+
+      void computeTargets();
+      void reset();
+      void tick(int i, mopo_float* dest, const mopo_float* audio_buffer);
+
+      // Hold the target coefficients, which getResponse() reads from.
       std::vector<BiquadFilter*> formants_;
+      BiquadFilter::Type types_[MAX_FORMANTS];
+      FormantShape shapes_[MAX_FORMANTS][kNumCorners];
+
+      // Per formant coefficients and history, one lane per formant. The input
+      // history is the same for every formant so it's shared.
+      mopo_float coefficients_[BiquadFilter::kNumCoefficients][MAX_FORMANTS];
+      mopo_float targets_[BiquadFilter::kNumCoefficients][MAX_FORMANTS];
+      mopo_float past_out_1_[MAX_FORMANTS];
+      mopo_float past_out_2_[MAX_FORMANTS];
+      mopo_float past_in_1_, past_in_2_;
   };
 } // namespace mopo
 
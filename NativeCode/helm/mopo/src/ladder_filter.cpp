@@ -15,6 +15,7 @@
  */
 
 #include "ladder_filter.h"
+#include "processor_state.h"
 #include "utils.h"
 
 #include <cmath>
@@ -88,6 +89,8 @@ namespace mopo {
     current_drive_ = drive;
   }
 
+  // Each stage saturates inside the feedback loop, one sample after the
+  // last, so unlike Distortion these can't run through vector_math::tanh.
   inline void LadderFilter::tick(int i, mopo_float* dest, const mopo_float* audio_buffer,
                                  mopo_float g, mopo_float resonance, mopo_float two_sr) {
     mopo_float audio = audio_buffer[i] * current_drive_;
@@ -130,4 +133,13 @@ namespace mopo {
     memset(tanh_v_, 0, sizeof(tanh_v_));
   }
 
+  void LadderFilter::syncState(ProcessorState* state) {
+    state->sync(current_resonance_);
+    state->sync(current_drive_);
+    state->sync(v_);
+    state->sync(delta_v_);
+    state->sync(tanh_v_);
+    state->sync(g_);
+    state->sync(resonance_multiple_);
+  }
 } // namespace mopo
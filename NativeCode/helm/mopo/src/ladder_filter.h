@@ -44,6 +44,7 @@ namespace mopo {
 
       virtual Processor* clone() const { return new LadderFilter(*this); }
       virtual void process();
+      virtual void syncState(ProcessorState* state);
 
       void computeCoefficients(mopo_float cutoff);
 
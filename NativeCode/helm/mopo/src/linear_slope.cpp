@@ -16,6 +16,7 @@
 
 #include "linear_slope.h"
 
+#include "processor_state.h"
 #include "utils.h"
 
 #include <cmath>
@@ -55,4 +56,8 @@ namespace mopo {
       last_value_ = utils::clamp(last_value_ + increment, last_value_, target);
     output(0)->buffer[i] = last_value_;
   }
+
+  void LinearSlope::syncState(ProcessorState* state) {
+    state->sync(last_value_);
+  }
 } // namespace mopo
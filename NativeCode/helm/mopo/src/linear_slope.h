@@ -41,6 +41,7 @@ namespace mopo {
       }
 
       virtual void process() override;
+      virtual void syncState(ProcessorState* state) override;
       void tick(int i);
 
     private:
@@ -30,6 +30,7 @@ namespace mopo {
     const mopo_float MAX_DB_LOOKUP = 60.0;
     const mopo_float DB_RANGE = MAX_DB_LOOKUP - MIN_DB_LOOKUP;
     const int MAGNITUDE_LOOKUP_RESOLUTION = 2046;
+    const mopo_float MAGNITUDE_LOOKUP_SCALE = MAGNITUDE_LOOKUP_RESOLUTION / DB_RANGE;
 
   } // namespace
 
@@ -44,8 +45,8 @@ namespace mopo {
       }
 
       mopo_float magnitudeLookup(mopo_float decibels) const {
-        mopo_float t = (decibels - MIN_DB_LOOKUP) / DB_RANGE;
-        mopo_float index = MAGNITUDE_LOOKUP_RESOLUTION * utils::clamp(t, 0.0, 1.0);
+        mopo_float index = utils::clamp((decibels - MIN_DB_LOOKUP) * MAGNITUDE_LOOKUP_SCALE,
+                                        0.0, MAGNITUDE_LOOKUP_RESOLUTION);
         int int_index = index;
         mopo_float fraction = index - int_index;
 
@@ -53,6 +54,11 @@ namespace mopo {
                                   magnitude_lookup_[int_index + 1], fraction);
       }
 
+      void magnitudeLookup(mopo_float* dest, const mopo_float* decibels, int size) const {
+        vector_math::lookup(dest, decibels, magnitude_lookup_, MIN_DB_LOOKUP,
+                            MAGNITUDE_LOOKUP_SCALE, MAGNITUDE_LOOKUP_RESOLUTION, size);
+      }
+
     private:
       mopo_float magnitude_lookup_[MAGNITUDE_LOOKUP_RESOLUTION + 2];
   };
@@ -63,6 +69,10 @@ namespace mopo {
         return lookup_.magnitudeLookup(decibels);
       }
 
+      static void magnitudeLookup(mopo_float* dest, const mopo_float* decibels, int size) {
+        lookup_.magnitudeLookup(dest, decibels, size);
+      }
+
     private:
       static const MagnitudeLookupSingleton lookup_;
   };
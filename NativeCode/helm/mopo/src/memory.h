@@ -27,6 +27,8 @@
 
 namespace mopo {
 
+  class ProcessorState;
+
   // A processor utility to store a stream of data for later lookup.
   class Memory {
     public:
@@ -85,6 +87,8 @@ namespace mopo {
 
       void setOffset(int offset) { offset_ = offset; }
 
+      void syncState(ProcessorState* state);
+
       const mopo_float* getPointer(int past) const {
         return memory_ + ((offset_ - past) & bitmask_);
       }
@@ -42,6 +42,11 @@ namespace mopo {
                                   frequency_lookup_[full_cents + 1], fraction_cents);
       }
 
+      void notesLookup(mopo_float* dest, const mopo_float* notes, int size) const {
+        vector_math::lookup(dest, notes, frequency_lookup_, 0.0, CENTS_PER_NOTE,
+                            MAX_CENTS, size);
+      }
+
     private:
       mopo_float frequency_lookup_[MAX_CENTS + 2];
   };
@@ -52,6 +57,10 @@ namespace mopo {
         return lookup_.centsLookup(cents_from_0);
       }
 
+      static void notesLookup(mopo_float* dest, const mopo_float* notes, int size) {
+        lookup_.notesLookup(dest, notes, size);
+      }
+
     private:
       static const MidiLookupSingleton lookup_;
   };
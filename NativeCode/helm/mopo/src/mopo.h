@@ -21,6 +21,7 @@
 #include "alias.h"
 #include "arpeggiator.h"
 #include "bit_crush.h"
+#include "buffer_pool.h"
 #include "biquad_filter.h"
 #include "bypass_router.h"
 #include "circular_queue.h"
@@ -38,9 +39,11 @@
 #include "note_handler.h"
 #include "operators.h"
 #include "oscillator.h"
+#include "polyphase_upsampler.h"
 #include "portamento_slope.h"
 #include "processor.h"
 #include "processor_router.h"
+#include "processor_state.h"
 #include "resonance_lookup.h"
 #include "reverb.h"
 #include "reverb_all_pass.h"
@@ -55,6 +58,7 @@
 #include "trigger_operators.h"
 #include "utils.h"
 #include "value.h"
+#include "vector_math.h"
 #include "voice_handler.h"
 #include "wave.h"
 
@@ -16,6 +16,9 @@
 
 #include "operators.h"
 
+#include "processor_state.h"
+#include "vector_math.h"
+
 #if defined (__APPLE__)
   #include <Accelerate/Accelerate.h>
   #define USE_APPLE_ACCELERATE
@@ -33,8 +36,7 @@ namespace mopo {
   void Bypass::process() {
     MOPO_ASSERT(inputMatchesBufferSize());
 
-    utils::copyBuffer(output()->buffer, input()->source->buffer, buffer_size_);
-
+    output()->buffer = input()->source->buffer;
     output()->triggered = input()->source->triggered;
     output()->trigger_value = input()->source->trigger_value;
     output()->trigger_offset = input()->source->trigger_offset;
@@ -48,11 +50,8 @@ namespace mopo {
                 &min_, &max_,
                 output()->buffer, 1, buffer_size_);
 #else
-    mopo_float* dest = output()->buffer;
-    const mopo_float* source = input()->source->buffer;
-
-    for (int i = 0; i < buffer_size_; ++i)
-      bufferTick(dest, source, i);
+    vector_math::clamp(output()->buffer, input()->source->buffer,
+                       min_, max_, buffer_size_);
 #endif
     processTriggers();
   }
@@ -83,18 +82,23 @@ namespace mopo {
     processTriggers();
   }
 
+  void MidiScale::process() {
+    MidiLookup::notesLookup(output()->buffer, input()->source->buffer, buffer_size_);
+    processTriggers();
+  }
+
+  void MagnitudeScale::process() {
+    MagnitudeLookup::magnitudeLookup(output()->buffer, input()->source->buffer,
+                                     buffer_size_);
+    processTriggers();
+  }
+
   void Add::process() {
     MOPO_ASSERT(inputMatchesBufferSize(0));
     MOPO_ASSERT(inputMatchesBufferSize(1));
 
-    mopo_float* dest = output()->buffer;
-    const mopo_float* source_left = input(0)->source->buffer;
-    const mopo_float* source_right = input(1)->source->buffer;
-
-    VECTORIZE_LOOP
-    for (int i = 0; i < buffer_size_; ++i)
-      bufferTick(dest, source_left, source_right, i);
-
+    vector_math::add(output()->buffer, input(0)->source->buffer,
+                     input(1)->source->buffer, buffer_size_);
     processTriggers();
   }
 
@@ -117,14 +121,8 @@ namespace mopo {
     MOPO_ASSERT(inputMatchesBufferSize(0));
     MOPO_ASSERT(inputMatchesBufferSize(1));
 
-    mopo_float* dest = output()->buffer;
-    const mopo_float* source_left = input(0)->source->buffer;
-    const mopo_float* source_right = input(1)->source->buffer;
-
-    VECTORIZE_LOOP
-    for (int i = 0; i < buffer_size_; ++i)
-      bufferTick(dest, source_left, source_right, i);
-
+    vector_math::multiply(output()->buffer, input(0)->source->buffer,
+                          input(1)->source->buffer, buffer_size_);
     processTriggers();
   }
 
@@ -133,21 +131,22 @@ namespace mopo {
     MOPO_ASSERT(inputMatchesBufferSize(1));
     MOPO_ASSERT(inputMatchesBufferSize(2));
 
-    mopo_float* dest = output()->buffer;
-    const mopo_float* from = input(kFrom)->source->buffer;
-    const mopo_float* to = input(kTo)->source->buffer;
-    const mopo_float* fractional = input(kFractional)->source->buffer;
-
-    VECTORIZE_LOOP
-    for (int i = 0; i < buffer_size_; ++i)
-      bufferTick(dest, from, to, fractional, i);
-
+    vector_math::interpolate(output()->buffer,
+                             input(kFrom)->source->buffer,
+                             input(kTo)->source->buffer,
+                             input(kFractional)->source->buffer, buffer_size_);
     processTriggers();
   }
 
   void BilinearInterpolate::process() {
-    for (int i = 0; i < buffer_size_; ++i)
-      tick(i);
+    vector_math::bilinearInterpolate(output()->buffer,
+                                     input(kTopLeft)->source->buffer,
+                                     input(kTopRight)->source->buffer,
+                                     input(kBottomLeft)->source->buffer,
+                                     input(kBottomRight)->source->buffer,
+                                     input(kXPosition)->source->buffer,
+                                     input(kYPosition)->source->buffer,
+                                     buffer_size_);
     processTriggers();
   }
 
@@ -177,11 +176,7 @@ namespace mopo {
                      output()->buffer, 1,
                      output()->buffer, 1, buffer_size_);
 #else
-          const mopo_float* source = input(i)->source->buffer;
-
-          VECTORIZE_LOOP
-          for (int s = 0; s < buffer_size_; ++s)
-            dest[s] += source[s];
+          vector_math::add(dest, dest, input(i)->source->buffer, buffer_size_);
 #endif
         }
       }
@@ -235,9 +230,7 @@ namespace mopo {
     if (value == dest[0])
       return;
 
-    VECTORIZE_LOOP
-    for (int i = 0; i < buffer_size_; ++i)
-      bufferTick(dest, value, i);
+    vector_math::fill(dest, value, buffer_size_);
     processTriggers();
   }
 
@@ -247,18 +240,9 @@ namespace mopo {
 
     if (input(kTrigger)->source->triggered) {
       int trigger_samples = input(kTrigger)->source->trigger_offset;
-      int i = 0;
-
-      mopo_float val = last_value_;
-      VECTORIZE_LOOP
-      for (; i < trigger_samples; ++i)
-        dest[i] = val;
-
-      val = new_value;
-
-      VECTORIZE_LOOP
-      for (; i < buffer_size_; ++i)
-        dest[i] = val;
+      vector_math::fill(dest, last_value_, trigger_samples);
+      vector_math::fill(dest + trigger_samples, new_value,
+                        buffer_size_ - trigger_samples);
     }
     else if (last_value_ == new_value &&
              new_value == output()->buffer[0] &&
@@ -269,14 +253,14 @@ namespace mopo {
     }
     else {
       mopo_float inc = (new_value - last_value_) / buffer_size_;
-      mopo_float val = last_value_ + inc;
-
-      VECTORIZE_LOOP
-      for (int i = 0; i < buffer_size_; ++i)
-        dest[i] = val + i * inc;
+      vector_math::ramp(dest, last_value_ + inc, inc, buffer_size_);
     }
 
     last_value_ = new_value;
     processTriggers();
   }
+
+  void LinearSmoothBuffer::syncState(ProcessorState* state) {
+    state->sync(last_value_);
+  }
 } // namespace mopo
@@ -212,7 +212,7 @@ namespace mopo {
         dest[i] = MidiLookup::centsLookup(CENTS_PER_NOTE * source[i]);
       }
 
-      PROCESS_TICK_FUNCTION
+      void process() override;
   };
 
   // A processor that will convert a stream of magnitudes to a stream of
@@ -254,7 +254,7 @@ namespace mopo {
         dest[i] = MagnitudeLookup::magnitudeLookup(source[i]);
       }
 
-      PROCESS_TICK_FUNCTION
+      void process() override;
   };
 
   // A processor that will add two streams together.
@@ -265,6 +265,7 @@ namespace mopo {
       virtual Processor* clone() const override { return new Add(*this); }
 
       void process() override;
+      bool rewritesOutputs() const override { return true; }
 
       inline void tick(int i) override {
         bufferTick(output()->buffer, input(0)->source->buffer,
@@ -326,6 +327,7 @@ namespace mopo {
       virtual Processor* clone() const override { return new Multiply(*this); }
 
       void process() override;
+      bool rewritesOutputs() const override { return true; }
 
       inline void tick(int i) override {
         bufferTick(output()->buffer, input(0)->source->buffer,
@@ -356,6 +358,7 @@ namespace mopo {
       }
 
       void process() override;
+      bool rewritesOutputs() const override { return true; }
 
       inline void tick(int i) override {
         bufferTick(output()->buffer, input(kFrom)->source->buffer,
@@ -391,6 +394,7 @@ namespace mopo {
       }
 
       void process() override;
+      bool rewritesOutputs() const override { return true; }
 
       inline void tick(int i) override {
         mopo_float top = utils::interpolate(input(kTopLeft)->at(i),
@@ -495,6 +499,7 @@ namespace mopo {
       }
 
       void process() override;
+      void syncState(ProcessorState* state) override;
 
       inline void tick(int i) override {
         output()->buffer[i] = input()->at(0);
@@ -16,6 +16,8 @@
 
 #include "oscillator.h"
 
+#include "processor_state.h"
+
 #include <cmath>
 
 namespace mopo {
@@ -46,4 +48,8 @@ namespace mopo {
     for (; i < buffer_size_; ++i)
       tick(i);
   }
+
+  void Oscillator::syncState(ProcessorState* state) {
+    state->sync(offset_);
+  }
 } // namespace mopo
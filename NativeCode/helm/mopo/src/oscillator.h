@@ -50,6 +50,7 @@ namespace mopo {
 
       void preprocess();
       void process() override;
+      void syncState(ProcessorState* state) override;
 
       inline void tick(int i) {
         mopo_float frequency = input(kFrequency)->at(i);
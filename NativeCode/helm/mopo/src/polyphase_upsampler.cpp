@@ -0,0 +1,141 @@
+/* Copyright 2013-2017 Matt Tytel
+ *
+ * mopo is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * mopo is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with mopo.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "polyphase_upsampler.h"
+
+#include "utils.h"
+#include "vector_math.h"
+
+#include <cmath>
+#include <cstring>
+
+namespace mopo {
+
+  namespace {
+    // Gives about 80dB of image rejection.
+    const mopo_float KAISER_BETA = 7.86;
+    const mopo_float KAISER_ATTENUATION = 80.0;
+
+    // Zeroth order modified Bessel function of the first kind.
+    mopo_float besselI0(mopo_float value) {
+      mopo_float half_value = 0.5 * value;
+      mopo_float term = 1.0;
+      mopo_float sum = 1.0;
+      for (int k = 1; term > 1e-12 * sum; ++k) {
+        mopo_float factor = half_value / k;
+        term *= factor * factor;
+        sum += term;
+      }
+      return sum;
+    }
+  } // namespace
+
+  PolyphaseUpsampler::PolyphaseUpsampler() {
+    setFactor(1);
+  }
+
+  void PolyphaseUpsampler::setFactor(int factor) {
+    factor_ = utils::iclamp(factor, 1, MAX_FACTOR);
+    reset();
+
+    // The images start at the input's nyquist frequency, so the transition
+    // band ends there and the passband gives up what the filter length can't
+    // cover.
+    int length = factor_ * TAPS_PER_PHASE;
+    mopo_float transition = (KAISER_ATTENUATION - 7.95) / (14.36 * length);
+    mopo_float cutoff = 0.5 / factor_ - 0.5 * transition;
+    mopo_float center = 0.5 * (length - 1);
+    mopo_float window_scale = 1.0 / besselI0(KAISER_BETA);
+
+    mopo_float total = 0.0;
+    for (int i = 0; i < length; ++i) {
+      mopo_float offset = i - center;
+      mopo_float sinc = 2.0 * cutoff;
+      if (offset != 0.0)
+        sinc = sin(2.0 * PI * cutoff * offset) / (PI * offset);
+
+      mopo_float position = offset / center;
+      mopo_float window = window_scale * besselI0(KAISER_BETA * sqrt(1.0 - position * position));
+      coefficients_[i % factor_][TAPS_PER_PHASE - 1 - i / factor_] = sinc * window;
+      total += sinc * window;
+    }
+
+    // Every phase only sees one in _factor_ taps, so the filter needs a gain
+    // of _factor_ to keep the level.
+    mopo_float gain = factor_ / total;
+    for (int p = 0; p < factor_; ++p) {
+      for (int k = 0; k < TAPS_PER_PHASE; ++k)
+        coefficients_[p][k] *= gain;
+    }
+  }
+
+  void PolyphaseUpsampler::reset() {
+    read_position_ = 0;
+    num_queued_ = 0;
+    utils::zeroBuffer(history_, TAPS_PER_PHASE - 1);
+  }
+
+  int PolyphaseUpsampler::inputNeeded(int samples) const {
+    int missing = samples - (num_queued_ - read_position_);
+    if (missing <= 0)
+      return 0;
+    return (missing + factor_ - 1) / factor_;
+  }
+
+  void PolyphaseUpsampler::write(const mopo_float* input, int samples) {
+    MOPO_ASSERT(samples <= MAX_BUFFER_SIZE);
+
+    int left_over = num_queued_ - read_position_;
+    MOPO_ASSERT(left_over + factor_ * samples <= MAX_FACTOR * (MAX_BUFFER_SIZE + 1));
+    memmove(output_, output_ + read_position_, left_over * sizeof(mopo_float));
+    read_position_ = 0;
+    num_queued_ = left_over + factor_ * samples;
+    mopo_float* dest = output_ + left_over;
+
+    if (factor_ == 1) {
+      memcpy(dest, input, samples * sizeof(mopo_float));
+      return;
+    }
+
+    // history_ holds the last TAPS_PER_PHASE - 1 inputs followed by the new
+    // block, so the taps of every output are a contiguous run of it. Phase
+    // coefficients are stored reversed to line up with that run.
+    const int history_size = TAPS_PER_PHASE - 1;
+    memcpy(history_ + history_size, input, samples * sizeof(mopo_float));
+
+    for (int p = 0; p < factor_; ++p) {
+      vector_math::correlate(phase_output_, history_, coefficients_[p], TAPS_PER_PHASE, samples);
+      for (int i = 0; i < samples; ++i)
+        dest[i * factor_ + p] = phase_output_[i];
+    }
+
+    memmove(history_, history_ + samples, history_size * sizeof(mopo_float));
+  }
+
+  const mopo_float* PolyphaseUpsampler::read(int samples) {
+    MOPO_ASSERT(read_position_ + samples <= num_queued_);
+
+    const mopo_float* result = output_ + read_position_;
+    read_position_ += samples;
+    return result;
+  }
+
+  int PolyphaseUpsampler::latency() const {
+    if (factor_ == 1)
+      return 0;
+    return (factor_ * TAPS_PER_PHASE - 1) / 2;
+  }
+} // namespace mopo
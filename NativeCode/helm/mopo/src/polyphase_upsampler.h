@@ -0,0 +1,73 @@
+/* Copyright 2013-2017 Matt Tytel
+ *
+ * mopo is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * mopo is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with mopo.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+#ifndef POLYPHASE_UPSAMPLER_H
+#define POLYPHASE_UPSAMPLER_H
+
+#include "common.h"
+
+namespace mopo {
+
+  // Raises a signal rendered at a whole fraction of the output rate back up
+  // to the output rate. The interpolation filter is a Kaiser windowed sinc
+  // split into one short filter per output phase, so each output sample only
+  // multiplies the taps that line up with real input samples. Each phase
+  // filters a whole block at once with the vector kernels.
+  //
+  // Output is queued, so any number of output samples can be read at a time
+  // as long as enough input was written first.
+  class PolyphaseUpsampler {
+    public:
+      static const int MAX_FACTOR = 4;
+      static const int TAPS_PER_PHASE = 64;
+
+      PolyphaseUpsampler();
+
+      // Designs the filter for an output rate _factor_ times the input rate
+      // and drops any queued output and filter history. A factor of 1 passes
+      // input straight through.
+      void setFactor(int factor);
+      int factor() const { return factor_; }
+
+      void reset();
+
+      // Input samples to write before _samples_ more output can be read.
+      int inputNeeded(int samples) const;
+
+      // Upsamples up to MAX_BUFFER_SIZE input samples onto the queue.
+      void write(const mopo_float* input, int samples);
+
+      // Takes the next _samples_ output samples off the queue. The result
+      // stays valid until the next write.
+      const mopo_float* read(int samples);
+
+      // Output samples the filter delays the signal by.
+      int latency() const;
+
+    private:
+      int factor_;
+      int read_position_;
+      int num_queued_;
+
+      mopo_float coefficients_[MAX_FACTOR][TAPS_PER_PHASE];
+      mopo_float history_[TAPS_PER_PHASE - 1 + MAX_BUFFER_SIZE];
+      mopo_float phase_output_[MAX_BUFFER_SIZE];
+      mopo_float output_[MAX_FACTOR * (MAX_BUFFER_SIZE + 1)];
+  };
+} // namespace mopo
+
+#endif // POLYPHASE_UPSAMPLER_H
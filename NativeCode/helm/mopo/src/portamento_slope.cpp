@@ -16,6 +16,7 @@
 
 #include "portamento_slope.h"
 
+#include "processor_state.h"
 #include "utils.h"
 
 #include <cmath>
@@ -102,4 +103,8 @@ namespace mopo {
     last_value_ += movement * decay;
     output()->buffer[i] = last_value_;
   }
+
+  void PortamentoSlope::syncState(ProcessorState* state) {
+    state->sync(last_value_);
+  }
 } // namespace mopo
@@ -53,6 +53,8 @@ namespace mopo {
       void processTriggers();
       void processBypass(int start);
       virtual void process() override;
+      virtual bool rewritesOutputs() const override { return true; }
+      virtual void syncState(ProcessorState* state) override;
       void tick(int i, mopo_float target, mopo_float increment, mopo_float decay);
 
     private:
@@ -19,6 +19,7 @@
 #define PROCESSOR_H
 
 #include "common.h"
+#include "processor_arena.h"
 
 #include <cstring>
 #include <vector>
@@ -27,19 +28,89 @@ namespace mopo {
 
   class Processor;
   class ProcessorRouter;
+  class ProcessorState;
 
   // An output port from the Processor.
   struct Output {
     Output(int size = MAX_BUFFER_SIZE) {
       owner = 0;
-      buffer = new mopo_float[size];
+      allocateBuffer(size);
       buffer_size = size;
       clearBuffer();
       clearTrigger();
     }
 
+    // Writes into _shared_ from the start, without a buffer of its own.
+    Output(int size, mopo_float* shared) {
+      owner = 0;
+      allocation = 0;
+      own_buffer = shared;
+      buffer = own_buffer;
+      buffer_size = size;
+      clearTrigger();
+    }
+
     virtual ~Output() {
-      delete[] buffer;
+      ProcessorArena::deallocate(allocation);
+    }
+
+    // Outputs and their buffers come from the active ProcessorArena too, so
+    // an output sits next to the processor that writes it.
+    static void* operator new(size_t size) {
+      return ProcessorArena::allocate(size);
+    }
+
+    static void operator delete(void* memory) {
+      ProcessorArena::deallocate(memory);
+    }
+
+    // Audio rate buffers start on a cache line so neighbouring outputs don't
+    // share lines and the inner loops get aligned loads.
+    void allocateBuffer(int size) {
+      if (size <= 1) {
+        allocation = allocateFloats(size);
+        own_buffer = allocation;
+        buffer = own_buffer;
+        return;
+      }
+
+      const size_t line_floats = BUFFER_ALIGNMENT / sizeof(mopo_float);
+      allocation = allocateFloats(size + line_floats - 1);
+      own_buffer = alignBuffer(allocation);
+      buffer = own_buffer;
+    }
+
+    static mopo_float* allocateFloats(size_t size) {
+      return static_cast<mopo_float*>(ProcessorArena::allocate(size * sizeof(mopo_float)));
+    }
+
+    // The buffer this output writes to. That's its allocation unless it was
+    // given a shared one. _buffer_ only points elsewhere while the output is
+    // passing through another output's buffer.
+    mopo_float* ownBuffer() const {
+      return own_buffer;
+    }
+
+    // Writes into shared from now on, or back into a cleared buffer of its
+    // own when shared is null. Shared has to hold at least buffer_size
+    // values. An output frees its own buffer while it shares.
+    void shareBuffer(mopo_float* shared) {
+      if (shared) {
+        ProcessorArena::deallocate(allocation);
+        allocation = 0;
+        own_buffer = shared;
+        buffer = own_buffer;
+      }
+      else if (allocation == 0) {
+        allocateBuffer(buffer_size);
+        clearBuffer();
+      }
+    }
+
+    static mopo_float* alignBuffer(mopo_float* allocation) {
+      size_t address = reinterpret_cast<size_t>(allocation);
+      size_t aligned = (address + BUFFER_ALIGNMENT - 1) & ~(BUFFER_ALIGNMENT - 1);
+      return reinterpret_cast<mopo_float*>(aligned);
     }
 
     void trigger(mopo_float value, int offset = 0) {
@@ -60,7 +131,11 @@ namespace mopo {
         buffer[i] = 0.0;
     }
 
+    static const size_t BUFFER_ALIGNMENT = 64;
+
     mopo_float* buffer;
+    mopo_float* own_buffer;
+    mopo_float* allocation;
     Processor* owner;
 
     int buffer_size;
@@ -94,6 +169,15 @@ namespace mopo {
 
       virtual ~Processor() { }
 
+      // Processors are placed in the active ProcessorArena when there is one.
+      static void* operator new(size_t size) {
+        return ProcessorArena::allocate(size);
+      }
+
+      static void operator delete(void* memory) {
+        ProcessorArena::deallocate(memory);
+      }
+
       // Currently need to override this boiler plate clone.
       // TODO(mtytel): Should probably make a macro for this.
       virtual Processor* clone() const = 0;
@@ -124,6 +208,15 @@ namespace mopo {
           buffer_size_ = 1;
       }
 
+      // Saves or restores whatever this processor carries over from one
+      // buffer to the next. Stateless processors leave this empty.
+      virtual void syncState(ProcessorState*) { }
+
+      // True when process() writes all of every output buffer each time it
+      // runs and never reads back what it wrote last time. Only those
+      // outputs can be moved into a BufferPool's shared buffers.
+      virtual bool rewritesOutputs() const { return false; }
+
       inline bool enabled() const {
         return *enabled_;
       }
@@ -197,6 +290,16 @@ namespace mopo {
         outputs_->operator[](output)->buffer[sample] = value;
       }
 
+      // Copies share their original's ports. Swapping in a separate set lets
+      // a copy render without touching the buffers its original writes to.
+      std::vector<Input*>* inputPorts() const { return inputs_; }
+      std::vector<Output*>* outputPorts() const { return outputs_; }
+
+      void setPorts(std::vector<Input*>* inputs, std::vector<Output*>* outputs) {
+        inputs_ = inputs;
+        outputs_ = outputs;
+      }
+
       // Returns the Input port corresponding to the passed in index.
       inline Input* input(unsigned int index = 0) const {
         MOPO_ASSERT(index < inputs_->size());
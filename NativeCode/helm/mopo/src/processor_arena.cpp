@@ -0,0 +1,125 @@
+/* Copyright 2013-2017 Matt Tytel
+ *
+ * mopo is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * mopo is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with mopo.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "processor_arena.h"
+
+#include <new>
+
+namespace mopo {
+
+  namespace {
+    const size_t ALIGNMENT = 64;
+
+    // Every allocation is prefixed with the chunk it came from, or null when
+    // it came from the heap. The header keeps the object itself aligned.
+    struct alignas(16) AllocationHeader {
+      void* chunk;
+    };
+
+    inline size_t alignUp(size_t size, size_t alignment) {
+      return (size + alignment - 1) & ~(alignment - 1);
+    }
+  } // namespace
+
+  thread_local ProcessorArena* ProcessorArena::active_ = 0;
+
+  ProcessorArena::ProcessorArena(size_t chunk_size) :
+      chunk_size_(chunk_size), current_(0), previous_(active_) {
+    active_ = this;
+  }
+
+  ProcessorArena::~ProcessorArena() {
+    sealCurrent();
+    active_ = previous_;
+  }
+
+  void* ProcessorArena::allocate(size_t size) {
+    if (active_)
+      return active_->allocateFromChunk(size);
+
+    AllocationHeader* header = static_cast<AllocationHeader*>(
+        ::operator new(sizeof(AllocationHeader) + size));
+    header->chunk = 0;
+    return header + 1;
+  }
+
+  void ProcessorArena::deallocate(void* memory) {
+    if (memory == 0)
+      return;
+
+    AllocationHeader* header = static_cast<AllocationHeader*>(memory) - 1;
+    Chunk* chunk = static_cast<Chunk*>(header->chunk);
+    if (chunk == 0) {
+      ::operator delete(header);
+      return;
+    }
+
+    if (chunk->live.fetch_sub(1, std::memory_order_acq_rel) == 1)
+      releaseChunk(chunk);
+  }
+
+  void* ProcessorArena::allocateFromChunk(size_t size) {
+    size_t total = alignUp(sizeof(AllocationHeader) + size, ALIGNMENT);
+
+    if (current_ == 0 || current_->used + total > current_->capacity) {
+      sealCurrent();
+      current_ = createChunk(total > chunk_size_ ? total : chunk_size_);
+    }
+
+    char* start = chunkData(current_) + current_->used;
+    current_->used += total;
+    current_->live.fetch_add(1, std::memory_order_relaxed);
+
+    AllocationHeader* header = reinterpret_cast<AllocationHeader*>(start);
+    header->chunk = current_;
+    return header + 1;
+  }
+
+  void ProcessorArena::sealCurrent() {
+    if (current_ == 0)
+      return;
+
+    if (current_->live.fetch_sub(1, std::memory_order_acq_rel) == 1)
+      releaseChunk(current_);
+    current_ = 0;
+  }
+
+  ProcessorArena::Chunk* ProcessorArena::createChunk(size_t capacity) {
+    size_t header_size = alignUp(sizeof(Chunk), ALIGNMENT);
+    void* memory = ::operator new(header_size + capacity +
+                                 ALIGNMENT + sizeof(void*));
+
+    // Stash the raw allocation just before the aligned chunk header.
+    size_t address = reinterpret_cast<size_t>(memory) + sizeof(void*);
+    Chunk* chunk = new (reinterpret_cast<void*>(alignUp(address, ALIGNMENT))) Chunk;
+    reinterpret_cast<void**>(chunk)[-1] = memory;
+
+    chunk->capacity = capacity;
+    chunk->used = 0;
+    chunk->live.store(1, std::memory_order_relaxed);
+    return chunk;
+  }
+
+  char* ProcessorArena::chunkData(Chunk* chunk) {
+    return reinterpret_cast<char*>(chunk) + alignUp(sizeof(Chunk), ALIGNMENT);
+  }
+
+  void ProcessorArena::releaseChunk(Chunk* chunk) {
+    void* memory = reinterpret_cast<void**>(chunk)[-1];
+    chunk->~Chunk();
+    ::operator delete(memory);
+  }
+} // namespace mopo
@@ -0,0 +1,72 @@
+/* Copyright 2013-2017 Matt Tytel
+ *
+ * mopo is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * mopo is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with mopo.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+#ifndef PROCESSOR_ARENA_H
+#define PROCESSOR_ARENA_H
+
+#include <atomic>
+#include <cstddef>
+
+namespace mopo {
+
+  // Bump allocator for Processor and Output objects and Output buffers. While
+  // an arena is alive on a thread, every one created on that thread is carved
+  // out of large chunks in creation order, so a graph built or cloned inside
+  // an arena ends up laid out in memory in the same order it is processed,
+  // with each processor's outputs and buffers right after it. Chunks are
+  // released once everything inside them has been deleted, so arena owned
+  // objects can outlive the arena itself. Outside of an arena they come from
+  // the normal heap.
+  //
+  // Allocations may be freed on any thread. A chunk is only freed when its
+  // last allocation goes, so a single long lived one keeps its whole chunk
+  // (64 KiB by default) allocated.
+  class ProcessorArena {
+    public:
+      ProcessorArena(size_t chunk_size = DEFAULT_CHUNK_SIZE);
+      ~ProcessorArena();
+
+      static void* allocate(size_t size);
+      static void deallocate(void* memory);
+
+    private:
+      static const size_t DEFAULT_CHUNK_SIZE = 64 * 1024;
+
+      // live counts the Processors in the chunk, plus one while it's still
+      // the arena's current chunk. Whoever drops it to zero frees the chunk.
+      struct Chunk {
+        size_t capacity;
+        size_t used;
+        std::atomic<int> live;
+      };
+
+      void* allocateFromChunk(size_t size);
+      void sealCurrent();
+
+      static Chunk* createChunk(size_t capacity);
+      static char* chunkData(Chunk* chunk);
+      static void releaseChunk(Chunk* chunk);
+
+      size_t chunk_size_;
+      Chunk* current_;
+      ProcessorArena* previous_;
+
+      static thread_local ProcessorArena* active_;
+  };
+} // namespace mopo
+
+#endif // PROCESSOR_ARENA_H
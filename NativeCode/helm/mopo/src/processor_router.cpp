@@ -17,6 +17,7 @@
 #include "processor_router.h"
 
 #include "feedback.h"
+#include "processor_state.h"
 
 #include <algorithm>
 #include <vector>
@@ -26,12 +27,14 @@ namespace mopo {
   ProcessorRouter::ProcessorRouter(int num_inputs, int num_outputs) :
       Processor(num_inputs, num_outputs),
       global_order_(new std::vector<const Processor*>()),
+      global_added_order_(new std::vector<const Processor*>()),
       global_feedback_order_(new std::vector<const Feedback*>()),
       global_changes_(new int(0)), local_changes_(0) {
   }
 
   ProcessorRouter::ProcessorRouter(const ProcessorRouter& original) :
       Processor(original), global_order_(original.global_order_),
+      global_added_order_(original.global_added_order_),
       global_feedback_order_(original.global_feedback_order_),
       global_changes_(original.global_changes_),
       local_changes_(original.local_changes_) {
@@ -96,6 +99,7 @@ namespace mopo {
       processor->destroy();
 
     delete global_order_;
+    delete global_added_order_;
     delete global_feedback_order_;
     delete global_changes_;
     Processor::destroy();
@@ -127,6 +131,28 @@ namespace mopo {
       local_feedback_order_[i]->setBufferSize(buffer_size);
   }
 
+  void ProcessorRouter::syncState(ProcessorState* state) {
+    updateAllProcessors();
+
+    // Idle processors only hold parameter values, which aren't saved.
+    int num_processors = local_order_.size();
+    int num_feedbacks = local_feedback_order_.size();
+    int saved_processors = num_processors;
+    int saved_feedbacks = num_feedbacks;
+    state->sync(saved_processors);
+    state->sync(saved_feedbacks);
+    if (saved_processors != num_processors || saved_feedbacks != num_feedbacks) {
+      state->invalidate();
+      return;
+    }
+
+    for (int i = 0; i < num_processors && state->valid(); ++i)
+      processors_[global_added_order_->at(i)]->syncState(state);
+
+    for (int i = 0; i < num_feedbacks && state->valid(); ++i)
+      local_feedback_order_[i]->syncState(state);
+  }
+
   void ProcessorRouter::addProcessor(Processor* processor) {
     MOPO_ASSERT(processor->router() == 0 || processor->router() == this);
     (*global_changes_)++;
@@ -135,6 +161,7 @@ namespace mopo {
     processor->router(this);
     processor->setBufferSize(getBufferSize());
     global_order_->push_back(processor);
+    global_added_order_->push_back(processor);
     processors_[processor] = processor;
     local_order_.push_back(processor);
 
@@ -157,6 +184,8 @@ namespace mopo {
         std::find(global_order_->begin(), global_order_->end(), processor);
     MOPO_ASSERT(pos != global_order_->end());
     global_order_->erase(pos, pos + 1);
+    global_added_order_->erase(std::find(global_added_order_->begin(),
+                                         global_added_order_->end(), processor));
 
     std::vector<Processor*>::iterator local_pos =
         std::find(local_order_.begin(), local_order_.end(), processor);
@@ -187,6 +216,9 @@ namespace mopo {
 
   void ProcessorRouter::disconnect(const Processor* destination,
                                    const Output* source) {
+    (*global_changes_)++;
+    local_changes_++;
+
     if (isDownstream(destination, source->owner)) {
       // We're fine unless there is a cycle and need to delete a Feedback node.
       for (int i = 0; i < destination->numInputs(); ++i) {
@@ -333,6 +365,53 @@ namespace mopo {
     local_changes_ = *global_changes_;
   }
 
+  void ProcessorRouter::getProcessorCopies(
+      std::vector<std::pair<const Processor*, Processor*>>* copies) {
+    updateAllProcessors();
+
+    size_t num_processors = global_order_->size();
+    for (size_t i = 0; i < num_processors; ++i) {
+      const Processor* next = global_order_->at(i);
+      Processor* copy = processors_[next];
+      copies->push_back(std::make_pair(next, copy));
+
+      ProcessorRouter* router = dynamic_cast<ProcessorRouter*>(copy);
+      if (router)
+        router->getProcessorCopies(copies);
+    }
+
+    size_t num_feedbacks = global_feedback_order_->size();
+    for (size_t i = 0; i < num_feedbacks; ++i) {
+      const Feedback* next = global_feedback_order_->at(i);
+      copies->push_back(std::make_pair(next, feedback_processors_[next]));
+    }
+  }
+
+  unsigned int ProcessorRouter::getLayoutHash(unsigned int hash) const {
+    const unsigned int FNV_PRIME = 16777619;
+
+    size_t num_processors = global_added_order_->size();
+    hash = (hash ^ static_cast<unsigned int>(num_processors)) * FNV_PRIME;
+    for (size_t i = 0; i < num_processors; ++i) {
+      const Processor* next = global_added_order_->at(i);
+      const ProcessorRouter* router = dynamic_cast<const ProcessorRouter*>(next);
+      unsigned int shape[] = {
+        static_cast<unsigned int>(next->numOutputs()),
+        next->isControlRate(),
+        router != nullptr
+      };
+      for (unsigned int value : shape)
+        hash = (hash ^ value) * FNV_PRIME;
+
+      if (router)
+        hash = router->getLayoutHash(hash);
+    }
+
+    size_t num_feedbacks = global_feedback_order_->size();
+    hash = (hash ^ static_cast<unsigned int>(num_feedbacks)) * FNV_PRIME;
+    return hash;
+  }
+
   const Processor* ProcessorRouter::getContext(const Processor* processor)
       const {
     const Processor* context = processor;
@@ -42,6 +42,7 @@ namespace mopo {
       virtual void process() override;
       virtual void setSampleRate(int sample_rate) override;
       virtual void setBufferSize(int buffer_size) override;
+      virtual void syncState(ProcessorState* state) override;
 
       virtual void addProcessor(Processor* processor);
       virtual void addIdleProcessor(Processor* processor);
@@ -59,6 +60,24 @@ namespace mopo {
       virtual ProcessorRouter* getMonoRouter();
       virtual ProcessorRouter* getPolyRouter();
 
+      // Brings this copy up to date with the shared graph and lists every
+      // Processor and Feedback in it, nested routers included, next to the
+      // copy _this_ runs. Copies of the same router list them in the same order.
+      void getProcessorCopies(
+          std::vector<std::pair<const Processor*, Processor*>>* copies);
+
+      // Changes whenever a Processor or connection is added or removed here.
+      int getGraphRevision() const { return *global_changes_; }
+
+      // Hash of the shape of every Processor this router holds, in the order
+      // they were added and with nested routers included, folded into _hash_.
+      // Only output counts and rates go in, so the hash is the same for every
+      // compiler and platform. Inputs hold no state and modulation sums keep
+      // empty ones, so they're left out. Graphs with the same layout sync the same
+      // state, so a saved state can be checked against a graph before any of
+      // it is restored.
+      virtual unsigned int getLayoutHash(unsigned int hash) const;
+
     protected:
       // When we create a cycle into the ProcessorRouter graph, we must insert
       // a Feedback node and add it here.
@@ -79,6 +98,9 @@ namespace mopo {
           getDependencies(const Processor* processor) const;
 
       std::vector<const Processor*>* global_order_;
+      // Processors in the order they were added. Reordering for processing
+      // doesn't touch it, so state is synced in this order.
+      std::vector<const Processor*>* global_added_order_;
       std::vector<Processor*> local_order_;
       std::map<const Processor*, Processor*> processors_;
       std::vector<Processor*> idle_processors_;
@@ -0,0 +1,90 @@
+/* Copyright 2013-2017 Matt Tytel
+ *
+ * mopo is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * mopo is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with mopo.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "processor_state.h"
+
+#include <cstring>
+
+namespace mopo {
+
+  ProcessorState::ProcessorState(char* buffer, int size) :
+      saving_(true), valid_(true), write_buffer_(buffer), read_buffer_(nullptr),
+      capacity_(size), position_(0) { }
+
+  ProcessorState::ProcessorState(const char* buffer, int size) :
+      saving_(false), valid_(true), write_buffer_(nullptr), read_buffer_(buffer),
+      capacity_(size), position_(0) { }
+
+  void ProcessorState::syncBytes(void* data, int size) {
+    if (saving_) {
+      if (write_buffer_ && position_ + size <= capacity_)
+        memcpy(write_buffer_ + position_, data, size);
+      else if (write_buffer_)
+        valid_ = false;
+      position_ += size;
+      return;
+    }
+
+    if (!valid_ || position_ + size > capacity_) {
+      valid_ = false;
+      memset(data, 0, size);
+      return;
+    }
+
+    memcpy(data, read_buffer_ + position_, size);
+    position_ += size;
+  }
+
+  void ProcessorState::syncSparse(mopo_float* values, int count) {
+    if (saving_) {
+      int i = 0;
+      while (i < count) {
+        int zeros = 0;
+        while (i + zeros < count && values[i + zeros] == 0.0)
+          zeros++;
+        i += zeros;
+
+        int start = i;
+        while (i < count && values[i] != 0.0)
+          i++;
+        int non_zeros = i - start;
+
+        sync(zeros);
+        sync(non_zeros);
+        syncArray(values + start, non_zeros);
+      }
+      return;
+    }
+
+    memset(values, 0, count * sizeof(mopo_float));
+    int i = 0;
+    while (i < count && valid_) {
+      int zeros = 0;
+      int non_zeros = 0;
+      sync(zeros);
+      sync(non_zeros);
+      if (zeros < 0 || non_zeros < 0 || zeros + non_zeros > count - i ||
+          zeros + non_zeros == 0) {
+        valid_ = false;
+        return;
+      }
+
+      i += zeros;
+      syncArray(values + i, non_zeros);
+      i += non_zeros;
+    }
+  }
+} // namespace mopo
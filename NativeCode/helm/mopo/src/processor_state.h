@@ -0,0 +1,139 @@
+/* Copyright 2013-2017 Matt Tytel
+ *
+ * mopo is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * mopo is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with mopo.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+#ifndef PROCESSOR_STATE_H
+#define PROCESSOR_STATE_H
+
+#include "circular_queue.h"
+#include "common.h"
+
+#include <map>
+#include <vector>
+
+namespace mopo {
+
+  // Flat buffer holding the runtime state of a processor graph. Processors
+  // describe their state once in syncState() and the same description both
+  // saves and restores it, so the two can't drift apart. The layout follows
+  // processing order, so a state only restores into an identical graph.
+  class ProcessorState {
+    public:
+      // Saves into buffer. With a null buffer only the size is measured.
+      ProcessorState(char* buffer, int size);
+
+      // Restores from buffer.
+      ProcessorState(const char* buffer, int size);
+
+      bool saving() const { return saving_; }
+      bool loading() const { return !saving_; }
+
+      // Bytes written or read so far, or needed when measuring.
+      int size() const { return position_; }
+
+      // False if the buffer was too small, ran out while restoring or didn't
+      // match the graph it's restored into.
+      bool valid() const { return valid_; }
+      void invalidate() { valid_ = false; }
+
+      void syncBytes(void* data, int size);
+
+      template<class T>
+      void sync(T& value) {
+        syncBytes(&value, sizeof(T));
+      }
+
+      template<class T>
+      void syncArray(T* values, int count) {
+        syncBytes(values, count * sizeof(T));
+      }
+
+      // Stores runs of zeros as counts, so silent delay lines take up almost
+      // no space.
+      void syncSparse(mopo_float* values, int count);
+
+      template<class T>
+      void syncVector(std::vector<T>& values) {
+        int size = values.size();
+        sync(size);
+        if (loading()) {
+          if (size < 0 || size > (capacity_ - position_) / static_cast<int>(sizeof(T)))
+            invalidate();
+          values.resize(valid_ ? size : 0);
+        }
+        if (values.size())
+          syncArray(values.data(), values.size());
+      }
+
+      template<class T>
+      void syncQueue(CircularQueue<T>& values) {
+        int size = values.size();
+        sync(size);
+
+        if (saving()) {
+          for (int i = 0; i < size; ++i)
+            sync(values[i]);
+          return;
+        }
+
+        values.clear();
+        if (size < 0 || size > values.capacity()) {
+          invalidate();
+          return;
+        }
+
+        for (int i = 0; i < size; ++i) {
+          T value;
+          sync(value);
+          values.push_back(value);
+        }
+      }
+
+      template<class K, class V>
+      void syncMap(std::map<K, V>& values) {
+        int size = values.size();
+        sync(size);
+
+        if (saving()) {
+          for (auto& entry : values) {
+            K key = entry.first;
+            sync(key);
+            sync(entry.second);
+          }
+          return;
+        }
+
+        values.clear();
+        for (int i = 0; i < size && valid_; ++i) {
+          K key;
+          V value;
+          sync(key);
+          sync(value);
+          values[key] = value;
+        }
+      }
+
+    private:
+      bool saving_;
+      bool valid_;
+      char* write_buffer_;
+      const char* read_buffer_;
+      int capacity_;
+      int position_;
+  };
+} // namespace mopo
+
+#endif // PROCESSOR_STATE_H
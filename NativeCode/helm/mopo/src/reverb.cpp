@@ -17,113 +17,208 @@
 #include "reverb.h"
 
 #include "operators.h"
-#include "reverb_all_pass.h"
-#include "reverb_comb.h"
-#include "reverb_tuning.h"
+#include "processor_state.h"
+#include "utils.h"
+#include "vector_math.h"
 
 namespace mopo {
 
-  Reverb::Reverb() : ProcessorRouter(kNumInputs, 2), current_dry_(0.0), current_wet_(0.0) {
-    static const Value gain(FIXED_GAIN);
-    
-    Bypass* audio_input = new Bypass();
+  namespace {
+    inline mopo_float combTuning(int line) {
+      if (line < NUM_COMB)
+        return COMB_TUNINGS[line];
+      return COMB_TUNINGS[line - NUM_COMB] + STEREO_SPREAD;
+    }
+
+    inline mopo_float allPassTuning(int stage, int channel) {
+      if (channel == 0)
+        return ALL_PASS_TUNINGS[stage];
+      return ALL_PASS_TUNINGS[stage] + STEREO_SPREAD;
+    }
+  } // namespace
+
+  Reverb::Reverb() : ProcessorRouter(kNumInputs, 2),
+                     comb_offset_(0), all_pass_offset_(0),
+                     current_dry_(0.0), current_wet_(0.0) {
     LinearSmoothBuffer* feedback_input = new LinearSmoothBuffer();
     LinearSmoothBuffer* damping_input = new LinearSmoothBuffer();
 
-    registerInput(audio_input->input(), kAudio);
     registerInput(feedback_input->input(), kFeedback);
     registerInput(damping_input->input(), kDamping);
 
-    Multiply* gained_input = new Multiply();
-    gained_input->plug(audio_input, 0);
-    gained_input->plug(&gain, 1);
-
-    addProcessor(audio_input);
-    addProcessor(gained_input);
     addProcessor(feedback_input);
     addProcessor(damping_input);
+    feedback_smooth_ = feedback_input;
+    damping_smooth_ = damping_input;
+
+    allocateMemory();
+    setSampleRate(sample_rate_);
+  }
+
+  Reverb::Reverb(const Reverb& other) : ProcessorRouter(other),
+      comb_offset_(other.comb_offset_), all_pass_offset_(other.all_pass_offset_),
+      current_dry_(0.0), current_wet_(0.0) {
+    feedback_smooth_ = processors_[other.feedback_smooth_];
+    damping_smooth_ = processors_[other.damping_smooth_];
+
+    allocateMemory();
+    memcpy(comb_periods_, other.comb_periods_, sizeof(comb_periods_));
+    min_comb_period_ = other.min_comb_period_;
+    memcpy(all_pass_periods_, other.all_pass_periods_, sizeof(all_pass_periods_));
+  }
 
-    VariableAdd* left_comb_total = new VariableAdd(NUM_COMB);
-    for (int i = 0; i < NUM_COMB; ++i) {
-      ReverbComb* comb = new ReverbComb(1 + mopo::MAX_SAMPLE_RATE * COMB_TUNINGS[i]);
-      Value* time = new cr::Value(COMB_TUNINGS[i]);
-      addIdleProcessor(time);
-      cr::TimeToSamples* samples = new cr::TimeToSamples();
-      samples->plug(time);
-
-      comb->plug(gained_input, ReverbComb::kAudio);
-      comb->plug(samples, ReverbComb::kSampleDelay);
-      comb->plug(feedback_input, ReverbComb::kFeedback);
-      comb->plug(damping_input, ReverbComb::kDamping);
-      left_comb_total->plugNext(comb);
-      addProcessor(samples);
-      addProcessor(comb);
+  Reverb::~Reverb() {
+    delete[] comb_memory_;
+    delete[] comb_block_;
+    delete[] all_pass_memory_;
+  }
+
+  void Reverb::allocateMemory() {
+    mopo_float max_comb = COMB_TUNINGS[0];
+    for (int i = 1; i < NUM_COMB; ++i)
+      max_comb = utils::max(max_comb, COMB_TUNINGS[i]);
+
+    mopo_float max_all_pass = ALL_PASS_TUNINGS[0];
+    for (int i = 1; i < NUM_ALL_PASS; ++i)
+      max_all_pass = utils::max(max_all_pass, ALL_PASS_TUNINGS[i]);
+
+    int comb_size = utils::nextPowerOfTwo(
+        1 + mopo::MAX_SAMPLE_RATE * (max_comb + STEREO_SPREAD));
+    comb_bitmask_ = comb_size - 1;
+    comb_stride_ = comb_size + LINE_PADDING;
+    comb_memory_ = new mopo_float[comb_stride_ * NUM_COMB_LINES];
+    utils::zeroBuffer(comb_memory_, comb_stride_ * NUM_COMB_LINES);
+    utils::zeroBuffer(comb_filtered_, NUM_COMB_LINES);
+    comb_block_ = new mopo_float[NUM_COMB_LINES * MAX_BUFFER_SIZE];
+
+    int all_pass_size = utils::nextPowerOfTwo(
+        1 + mopo::MAX_SAMPLE_RATE * (max_all_pass + STEREO_SPREAD));
+    all_pass_bitmask_ = all_pass_size - 1;
+    all_pass_stride_ = all_pass_size + LINE_PADDING;
+    int all_pass_total = all_pass_stride_ * NUM_ALL_PASS * NUM_ALL_PASS_CHANNELS;
+    all_pass_memory_ = new mopo_float[all_pass_total];
+    utils::zeroBuffer(all_pass_memory_, all_pass_total);
+  }
+
+  void Reverb::setSampleRate(int sample_rate) {
+    ProcessorRouter::setSampleRate(sample_rate);
+
+    min_comb_period_ = MAX_BUFFER_SIZE;
+    for (int i = 0; i < NUM_COMB_LINES; ++i) {
+      comb_periods_[i] = sample_rate * combTuning(i);
+      min_comb_period_ = utils::imin(min_comb_period_, comb_periods_[i]);
     }
 
-    VariableAdd* right_comb_total = new VariableAdd(NUM_COMB);
-    for (int i = 0; i < NUM_COMB; ++i) {
-      mopo_float tuning = COMB_TUNINGS[i] + STEREO_SPREAD;
-      ReverbComb* comb = new ReverbComb(1 + mopo::MAX_SAMPLE_RATE * tuning);
-      Value* time = new cr::Value(tuning);
-      addIdleProcessor(time);
-      cr::TimeToSamples* samples = new cr::TimeToSamples();
-      samples->plug(time);
-
-      comb->plug(gained_input, ReverbComb::kAudio);
-      comb->plug(samples, ReverbComb::kSampleDelay);
-      comb->plug(feedback_input, ReverbComb::kFeedback);
-      comb->plug(damping_input, ReverbComb::kDamping);
-      right_comb_total->plugNext(comb);
-      addProcessor(samples);
-      addProcessor(comb);
+    for (int s = 0; s < NUM_ALL_PASS; ++s) {
+      for (int c = 0; c < NUM_ALL_PASS_CHANNELS; ++c)
+        all_pass_periods_[s][c] = sample_rate * allPassTuning(s, c);
     }
+  }
 
-    addProcessor(left_comb_total);
-    addProcessor(right_comb_total);
+  void Reverb::readLine(mopo_float* dest, const mopo_float* line,
+                        unsigned int start, int samples) const {
+    int first = utils::imin(samples, comb_bitmask_ + 1 - start);
+    vector_math::copy(dest, line + start, first);
+    vector_math::copy(dest + first, line, samples - first);
+  }
 
-    reverb_wet_left_ = left_comb_total;
-    for (int i = 0; i < NUM_ALL_PASS; ++i) {
-      ReverbAllPass* all_pass = new ReverbAllPass(1 + mopo::MAX_SAMPLE_RATE * ALL_PASS_TUNINGS[i]);
-      Value* time = new cr::Value(ALL_PASS_TUNINGS[i]);
-      addIdleProcessor(time);
-      cr::TimeToSamples* samples = new cr::TimeToSamples();
-      samples->plug(time);
+  void Reverb::processCombs(const mopo_float* input, const mopo_float* feedback,
+                            const mopo_float* damping,
+                            mopo_float* dest_left, mopo_float* dest_right,
+                            int samples) {
+    unsigned int write_start = (comb_offset_ + 1) & comb_bitmask_;
+    int first_write = utils::imin(samples, comb_bitmask_ + 1 - write_start);
 
-      all_pass->plug(reverb_wet_left_, ReverbAllPass::kAudio);
-      all_pass->plug(samples, ReverbAllPass::kSampleDelay);
-      all_pass->plug(&utils::value_half, ReverbAllPass::kFeedback);
+    // No line is shorter than _samples_, so every read in this block comes
+    // from an earlier block and the lines can be read and written in bulk.
+    for (int l = 0; l < NUM_COMB_LINES; ++l) {
+      unsigned int read_start = (comb_offset_ - comb_periods_[l]) & comb_bitmask_;
+      readLine(comb_block_ + l * MAX_BUFFER_SIZE, comb_memory_ + l * comb_stride_,
+               read_start, samples);
+    }
+
+    vector_math::fill(dest_left, 0.0, samples);
+    vector_math::fill(dest_right, 0.0, samples);
+    for (int l = 0; l < NUM_COMB; ++l) {
+      vector_math::add(dest_left, dest_left, comb_block_ + l * MAX_BUFFER_SIZE, samples);
+      vector_math::add(dest_right, dest_right,
+                       comb_block_ + (NUM_COMB + l) * MAX_BUFFER_SIZE, samples);
+    }
+
+    // Damping is a one pole filter per line, so it steps through time with
+    // every line in flight at once.
+    mopo_float filtered[NUM_COMB_LINES];
+    memcpy(filtered, comb_filtered_, sizeof(filtered));
+    for (int i = 0; i < samples; ++i) {
+      mopo_float damping_amount = damping[i];
+      for (int l = 0; l < NUM_COMB_LINES; ++l) {
+        mopo_float* block = comb_block_ + l * MAX_BUFFER_SIZE;
+        filtered[l] = utils::interpolate(block[i], filtered[l], damping_amount);
+        block[i] = filtered[l];
+      }
+    }
+    memcpy(comb_filtered_, filtered, sizeof(filtered));
 
-      addProcessor(all_pass);
-      addProcessor(samples);
-      reverb_wet_left_ = all_pass;
+    for (int l = 0; l < NUM_COMB_LINES; ++l) {
+      mopo_float* block = comb_block_ + l * MAX_BUFFER_SIZE;
+      mopo_float* line = comb_memory_ + l * comb_stride_;
+      vector_math::multiply(line + write_start, block, feedback, first_write);
+      vector_math::add(line + write_start, line + write_start, input, first_write);
+      vector_math::multiply(line, block + first_write, feedback + first_write,
+                            samples - first_write);
+      vector_math::add(line, line, input + first_write, samples - first_write);
     }
 
-    reverb_wet_right_ = right_comb_total;
-    for (int i = 0; i < NUM_ALL_PASS; ++i) {
-      mopo_float tuning = ALL_PASS_TUNINGS[i] + STEREO_SPREAD;
-      ReverbAllPass* all_pass = new ReverbAllPass(1 + mopo::MAX_SAMPLE_RATE * tuning);
-      Value* time = new cr::Value(tuning);
-      addIdleProcessor(time);
-      cr::TimeToSamples* samples = new cr::TimeToSamples();
-      samples->plug(time);
-
-      all_pass->plug(reverb_wet_right_, ReverbAllPass::kAudio);
-      all_pass->plug(samples, ReverbAllPass::kSampleDelay);
-      all_pass->plug(&utils::value_half, ReverbAllPass::kFeedback);
-
-      addProcessor(all_pass);
-      addProcessor(samples);
-      reverb_wet_right_ = all_pass;
+    comb_offset_ = (comb_offset_ + samples) & comb_bitmask_;
+  }
+
+  void Reverb::processAllPasses(mopo_float* left, mopo_float* right) {
+    mopo_float* channels[NUM_ALL_PASS_CHANNELS] = { left, right };
+
+    for (int i = 0; i < buffer_size_; ++i) {
+      unsigned int all_pass_write = (all_pass_offset_ + 1) & all_pass_bitmask_;
+      for (int c = 0; c < NUM_ALL_PASS_CHANNELS; ++c) {
+        mopo_float wet = channels[c][i];
+        for (int s = 0; s < NUM_ALL_PASS; ++s) {
+          mopo_float* line = all_pass_memory_ +
+                             (s * NUM_ALL_PASS_CHANNELS + c) * all_pass_stride_;
+          unsigned int spot = (all_pass_offset_ - all_pass_periods_[s][c]) &
+                              all_pass_bitmask_;
+          mopo_float read = line[spot];
+          line[all_pass_write] = wet + read * 0.5;
+          wet = read - wet;
+        }
+        channels[c][i] = wet;
+      }
+      all_pass_offset_ = all_pass_write;
     }
   }
 
+  void Reverb::processLines(const mopo_float* audio,
+                            const mopo_float* feedback, const mopo_float* damping,
+                            mopo_float* dest_left, mopo_float* dest_right) {
+    mopo_float input[MAX_BUFFER_SIZE];
+    for (int i = 0; i < buffer_size_; ++i)
+      input[i] = audio[i] * FIXED_GAIN;
+
+    for (int i = 0; i < buffer_size_; i += min_comb_period_) {
+      int samples = utils::imin(buffer_size_ - i, min_comb_period_);
+      processCombs(input + i, feedback + i, damping + i,
+                   dest_left + i, dest_right + i, samples);
+    }
+    processAllPasses(dest_left, dest_right);
+  }
+
   void Reverb::process() {
     MOPO_ASSERT(inputMatchesBufferSize(kAudio));
 
     ProcessorRouter::process();
     const mopo_float* audio = input(kAudio)->source->buffer;
-    const mopo_float* left_wet_audio = reverb_wet_left_->output()->buffer;
-    const mopo_float* right_wet_audio = reverb_wet_right_->output()->buffer;
+    processLines(audio, feedback_smooth_->output()->buffer,
+                 damping_smooth_->output()->buffer, wet_left_, wet_right_);
+
+    const mopo_float* left_wet_audio = wet_left_;
+    const mopo_float* right_wet_audio = wet_right_;
     mopo_float* dest_left = output(0)->buffer;
     mopo_float* dest_right = output(1)->buffer;
 
@@ -144,4 +239,19 @@ namespace mopo {
     current_dry_ = next_dry;
     current_wet_ = next_wet;
   }
+
+  void Reverb::syncState(ProcessorState* state) {
+    ProcessorRouter::syncState(state);
+
+    state->sync(comb_offset_);
+    state->syncSparse(comb_memory_, comb_stride_ * NUM_COMB_LINES);
+    state->syncArray(comb_filtered_, NUM_COMB_LINES);
+
+    state->sync(all_pass_offset_);
+    state->syncSparse(all_pass_memory_,
+                      all_pass_stride_ * NUM_ALL_PASS * NUM_ALL_PASS_CHANNELS);
+
+    state->sync(current_dry_);
+    state->sync(current_wet_);
+  }
 } // namespace mopo
@@ -19,10 +19,14 @@
 #define REVERB_H
 
 #include "processor_router.h"
+#include "reverb_tuning.h"
 
 namespace mopo {
 
-  // A comb filter with low pass filtering useful in a reverb processor.
+  // A Freeverb style reverb. All comb and all-pass lines for both channels run
+  // in one processor over shared state instead of one processor per line. The
+  // comb lines are read, summed and written a block at a time with the
+  // vector_math kernels.
   class Reverb : public ProcessorRouter {
     public:
       enum Inputs {
@@ -35,15 +39,58 @@ namespace mopo {
       };
 
       Reverb();
-      virtual ~Reverb() { }
+      Reverb(const Reverb& other);
+      virtual ~Reverb();
 
       void process() override;
+      void syncState(ProcessorState* state) override;
+      void setSampleRate(int sample_rate) override;
 
       virtual Processor* clone() const override { return new Reverb(*this); }
 
     protected:
-      Processor* reverb_wet_left_;
-      Processor* reverb_wet_right_;
+      static const int NUM_COMB_LINES = 2 * NUM_COMB;
+      static const int NUM_ALL_PASS_CHANNELS = 2;
+
+      // Lines are power of two sized, so without padding every line would map
+      // to the same cache sets.
+      static const int LINE_PADDING = 24;
+
+      void allocateMemory();
+      void readLine(mopo_float* dest, const mopo_float* line,
+                    unsigned int start, int samples) const;
+      void processCombs(const mopo_float* input, const mopo_float* feedback,
+                        const mopo_float* damping,
+                        mopo_float* dest_left, mopo_float* dest_right,
+                        int samples);
+      void processAllPasses(mopo_float* left, mopo_float* right);
+      void processLines(const mopo_float* audio,
+                        const mopo_float* feedback, const mopo_float* damping,
+                        mopo_float* dest_left, mopo_float* dest_right);
+
+      Processor* feedback_smooth_;
+      Processor* damping_smooth_;
+
+      // Each bank keeps its lines back to back in one allocation. Every line
+      // pushes once per sample so one write offset is shared per bank.
+      mopo_float* comb_memory_;
+      unsigned int comb_stride_;
+      unsigned int comb_bitmask_;
+      unsigned int comb_offset_;
+      int comb_periods_[NUM_COMB_LINES];
+      int min_comb_period_;
+      mopo_float comb_filtered_[NUM_COMB_LINES];
+      // One block of every comb line, MAX_BUFFER_SIZE apart.
+      mopo_float* comb_block_;
+
+      mopo_float* all_pass_memory_;
+      unsigned int all_pass_stride_;
+      unsigned int all_pass_bitmask_;
+      unsigned int all_pass_offset_;
+      int all_pass_periods_[NUM_ALL_PASS][NUM_ALL_PASS_CHANNELS];
+
+      mopo_float wet_left_[MAX_BUFFER_SIZE];
+      mopo_float wet_right_[MAX_BUFFER_SIZE];
 
       mopo_float current_dry_;
       mopo_float current_wet_;
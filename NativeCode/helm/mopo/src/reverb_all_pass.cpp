@@ -16,6 +16,8 @@
 
 #include "reverb_all_pass.h"
 
+#include "processor_state.h"
+
 namespace mopo {
 
   ReverbAllPass::ReverbAllPass(int size) : Processor(ReverbAllPass::kNumInputs, 1) {
@@ -43,4 +45,8 @@ namespace mopo {
     for (int i = 0; i < buffer_size_; ++i)
       tick(i, dest, period, audio_buffer, feedback_buffer);
   }
+
+  void ReverbAllPass::syncState(ProcessorState* state) {
+    memory_->syncState(state);
+  }
 } // namespace mopo
@@ -16,6 +16,8 @@
 
 #include "reverb_comb.h"
 
+#include "processor_state.h"
+
 namespace mopo {
 
   ReverbComb::ReverbComb(int size) : Processor(ReverbComb::kNumInputs, 1) {
@@ -46,4 +48,9 @@ namespace mopo {
     for (int i = 0; i < buffer_size_; ++i)
       tick(i, dest, period, audio_buffer, feedback_buffer, damping_buffer);
   }
+
+  void ReverbComb::syncState(ProcessorState* state) {
+    memory_->syncState(state);
+    state->sync(filtered_sample_);
+  }
 } // namespace mopo
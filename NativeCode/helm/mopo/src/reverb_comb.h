@@ -43,6 +43,7 @@ namespace mopo {
       }
 
       virtual void process() override;
+      virtual void syncState(ProcessorState* state) override;
 
       void tick(int i, mopo_float* dest, int period,
                 const mopo_float* audio_buffer,
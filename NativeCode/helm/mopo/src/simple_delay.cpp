@@ -16,6 +16,8 @@
 
 #include "simple_delay.h"
 
+#include "processor_state.h"
+
 #define MAX_CLEAR_SAMPLES 5000
 
 namespace mopo {
@@ -62,4 +64,8 @@ namespace mopo {
     for (int i = 0; i < buffer_size_; ++i)
       tick(i, dest, audio, period, feedback);
   }
+
+  void SimpleDelay::syncState(ProcessorState* state) {
+    memory_->syncState(state);
+  }
 } // namespace mopo
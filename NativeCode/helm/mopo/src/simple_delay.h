@@ -44,6 +44,8 @@ namespace mopo {
       }
 
       virtual void process() override;
+      virtual bool rewritesOutputs() const override { return true; }
+      virtual void syncState(ProcessorState* state) override;
 
       inline void tick(int i, mopo_float* dest,
                        const mopo_float* audio,
@@ -17,6 +17,7 @@
 #include "smooth_filter.h"
 #include <cmath>
 
+#include "processor_state.h"
 #include "utils.h"
 
 namespace mopo {
@@ -39,6 +40,10 @@ namespace mopo {
     }
   }
 
+  void SmoothFilter::syncState(ProcessorState* state) {
+    state->sync(last_value_);
+  }
+
   namespace cr {
     SmoothFilter::SmoothFilter(mopo_float start_value) :
         Processor(SmoothFilter::kNumInputs, 1, true), last_value_(start_value) { }
@@ -53,5 +58,9 @@ namespace mopo {
       last_value_ = utils::interpolate(target, last_value_, decay);
       output(0)->buffer[0] = last_value_;
     }
+
+    void SmoothFilter::syncState(ProcessorState* state) {
+      state->sync(last_value_);
+    }
   }
 } // namespace mopo
@@ -37,6 +37,7 @@ namespace mopo {
       }
 
       virtual void process() override;
+      virtual void syncState(ProcessorState* state) override;
 
     private:
       mopo_float last_value_;
@@ -58,6 +59,7 @@ namespace mopo {
         }
 
         virtual void process() override;
+        virtual void syncState(ProcessorState* state) override;
         
       private:
         mopo_float last_value_;
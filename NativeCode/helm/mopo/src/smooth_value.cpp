@@ -16,6 +16,8 @@
 
 #include "smooth_value.h"
 
+#include "processor_state.h"
+
 #include <cmath>
 
 #include "utils.h"
@@ -46,6 +48,10 @@ namespace mopo {
     output()->buffer[i] = value_;
   }
 
+  void SmoothValue::syncState(ProcessorState* state) {
+    state->sync(value_);
+  }
+
   namespace cr {
 
     SmoothValue::SmoothValue(mopo_float value) :
@@ -70,5 +76,9 @@ namespace mopo {
     void SmoothValue::computeDecay() {
       decay_ = 1 - exp(-2.0 * PI * SMOOTH_CUTOFF * num_samples_ / sample_rate_);
     }
+
+    void SmoothValue::syncState(ProcessorState* state) {
+      state->sync(value_);
+    }
   } // namespace cr
 } // namespace mopo
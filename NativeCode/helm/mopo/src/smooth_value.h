@@ -31,6 +31,7 @@ namespace mopo {
       }
 
       virtual void process() override;
+      virtual void syncState(ProcessorState* state) override;
 
       virtual void setSampleRate(int sample_rate) override;
 
@@ -59,6 +60,7 @@ namespace mopo {
         }
 
         virtual void process() override;
+        virtual void syncState(ProcessorState* state) override;
 
         virtual void setSampleRate(int sample_rate) override;
         virtual void setBufferSize(int buffer_size) override;
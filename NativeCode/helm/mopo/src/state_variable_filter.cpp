@@ -15,6 +15,7 @@
  */
 
 #include "state_variable_filter.h"
+#include "processor_state.h"
 #include "utils.h"
 
 #include <cmath>
@@ -233,6 +234,8 @@ namespace mopo {
     }
   }
 
+  // Saturating the input a block ahead with vector_math::tanh measured slower
+  // than doing it here, where it overlaps the filter's serial recursion.
   inline void StateVariableFilter::tick(int i, mopo_float* dest, const mopo_float* audio_buffer) {
     mopo_float audio = utils::quickTanh(drive_ * audio_buffer[i]);
 
@@ -279,4 +282,25 @@ namespace mopo {
     last_in_ = last_distort_ = 0.0;
   }
 
+  void StateVariableFilter::syncState(ProcessorState* state) {
+    state->sync(a1_);
+    state->sync(a2_);
+    state->sync(a3_);
+    state->sync(m0_);
+    state->sync(m1_);
+    state->sync(m2_);
+    state->sync(target_m0_);
+    state->sync(target_m1_);
+    state->sync(target_m2_);
+    state->sync(drive_);
+    state->sync(target_drive_);
+    state->sync(ic1eq_a_);
+    state->sync(ic2eq_a_);
+    state->sync(ic1eq_b_);
+    state->sync(ic2eq_b_);
+    state->sync(last_in_);
+    state->sync(last_distort_);
+    state->sync(last_style_);
+    state->sync(last_shelf_);
+  }
 } // namespace mopo
@@ -60,6 +60,8 @@ namespace mopo {
 
       virtual Processor* clone() const { return new StateVariableFilter(*this); }
       virtual void process();
+      virtual bool rewritesOutputs() const { return true; }
+      virtual void syncState(ProcessorState* state);
       void process12db(const mopo_float* audio_buffer, mopo_float* dest);
       void process24db(const mopo_float* audio_buffer, mopo_float* dest);
       void processAllPass(const mopo_float* audio_buffer, mopo_float* dest);
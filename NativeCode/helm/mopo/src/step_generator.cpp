@@ -15,6 +15,7 @@
  */
 
 #include "step_generator.h"
+#include "processor_state.h"
 #include "utils.h"
 
 #include <cmath>
@@ -26,7 +27,7 @@ namespace mopo {
       offset_(0.0), current_step_(0) { }
 
   void StepGenerator::process() {
-    static mopo_float integral;
+    mopo_float integral;
     unsigned int num_steps = static_cast<int>(input(kNumSteps)->at(0));
     num_steps = utils::iclamp(num_steps, 1, max_steps_);
 
@@ -47,7 +48,7 @@ namespace mopo {
   }
 
   void StepGenerator::correctToTime(mopo_float samples) {
-    static mopo_float integral;
+    mopo_float integral;
 
     unsigned int num_steps = static_cast<int>(input(kNumSteps)->at(0));
     num_steps = utils::iclamp(num_steps, 1, max_steps_);
@@ -57,4 +58,9 @@ namespace mopo {
     current_step_ = integral;
     current_step_ = (current_step_ + num_steps) % num_steps;
   }
+
+  void StepGenerator::syncState(ProcessorState* state) {
+    state->sync(offset_);
+    state->sync(current_step_);
+  }
 } // namespace mopo
@@ -47,6 +47,7 @@ namespace mopo {
       }
 
       void process() override;
+      void syncState(ProcessorState* state) override;
       void correctToTime(mopo_float samples);
 
     protected:
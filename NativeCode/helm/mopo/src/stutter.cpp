@@ -15,6 +15,7 @@
  */
 
 #include "stutter.h"
+#include "processor_state.h"
 #include "utils.h"
 
 #define MIN_SOFTNESS 0.00001
@@ -31,8 +32,9 @@ namespace mopo {
   } // namespace
 
   Stutter::Stutter(int size) : Processor(Stutter::kNumInputs, 1),
-      memory_(nullptr), size_(size), offset_(0.0), memory_offset_(0.0), resample_countdown_(0.0),
+      size_(size), offset_(0.0), memory_offset_(0.0), resample_countdown_(0.0),
       last_stutter_period_(0.0), last_amplitude_(0.0), resampling_(true) {
+    memory_ = new Memory(size_);
   }
 
   Stutter::~Stutter() {
@@ -40,8 +42,8 @@ namespace mopo {
   }
 
   Stutter::Stutter(const Stutter& other) : Processor(other) {
-    this->memory_ = nullptr;
     this->size_ = other.size_;
+    this->memory_ = new Memory(size_);
     this->offset_ = other.offset_;
     this->memory_offset_ = 0.0;
     this->resample_countdown_ = other.resample_countdown_;
@@ -53,10 +55,6 @@ namespace mopo {
   void Stutter::process() {
     MOPO_ASSERT(inputMatchesBufferSize(kAudio));
 
-    // A hack to save memory until stutter is used.
-    if (memory_ == nullptr)
-      memory_ = new Memory(size_);
-
     mopo_float max_memory_write = memory_->getSize();
     const mopo_float* audio = input(kAudio)->source->buffer;
     mopo_float* dest = output()->buffer;
@@ -149,4 +147,15 @@ namespace mopo {
     }
     last_stutter_period_ = end_stutter_period;
   }
+
+  void Stutter::syncState(ProcessorState* state) {
+    memory_->syncState(state);
+
+    state->sync(offset_);
+    state->sync(memory_offset_);
+    state->sync(resample_countdown_);
+    state->sync(last_stutter_period_);
+    state->sync(last_amplitude_);
+    state->sync(resampling_);
+  }
 } // namespace mopo
@@ -43,6 +43,8 @@ namespace mopo {
 
       virtual Processor* clone() const override { return new Stutter(*this); }
       virtual void process() override;
+      virtual bool rewritesOutputs() const override { return true; }
+      virtual void syncState(ProcessorState* state) override;
 
     protected:
       void startResampling(mopo_float sample_period) {
@@ -16,6 +16,8 @@
 
 #include "trigger_operators.h"
 
+#include "processor_state.h"
+
 namespace mopo {
 
   TriggerCombiner::TriggerCombiner() : Processor(2, 1) { }
@@ -157,4 +159,17 @@ namespace mopo {
     updateTrigger();
     updateReleased();
   }
+
+  void TriggerWait::syncState(ProcessorState* state) {
+    state->sync(waiting_);
+    state->sync(trigger_value_);
+  }
+
+  void LegatoFilter::syncState(ProcessorState* state) {
+    state->sync(last_value_);
+  }
+
+  void PortamentoFilter::syncState(ProcessorState* state) {
+    state->sync(released_);
+  }
 } // namespace mopo
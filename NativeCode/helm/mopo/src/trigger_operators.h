@@ -48,6 +48,7 @@ namespace mopo {
       }
 
       void process() override;
+      void syncState(ProcessorState* state) override;
 
     private:
       void waitTrigger(mopo_float trigger_value);
@@ -133,6 +134,7 @@ namespace mopo {
       }
 
       void process() override;
+      void syncState(ProcessorState* state) override;
 
     private:
       mopo_float last_value_;
@@ -161,6 +163,7 @@ namespace mopo {
       }
 
       void process() override;
+      void syncState(ProcessorState* state) override;
 
     private:
 
@@ -20,6 +20,7 @@
 
 #include "common.h"
 #include "value.h"
+#include "vector_math.h"
 #include <cmath>
 #include <cstdlib>
 
@@ -234,12 +235,22 @@ namespace mopo {
       return approx * (0.776 + 0.224 * fabs(approx));
     }
 
+    // Folds values past -1 and 1 back in with straight lines.
+    inline mopo_float linearFold(mopo_float value) {
+      mopo_float adjust = 0.25 * value + 0.75;
+      mopo_float range = adjust - floor(adjust);
+      return fabs(2.0 - 4.0 * range) - 1.0;
+    }
+
+    // Folds values past -1 and 1 back in along a sine.
+    inline mopo_float sinFold(mopo_float value) {
+      mopo_float adjust = -0.25 * value + 0.5;
+      mopo_float range = adjust - floor(adjust);
+      return quickSin1(range);
+    }
+
     inline bool isSilent(const mopo_float* buffer, int length) {
-      for (int i = 0; i < length; ++i) {
-        if (!closeToZero(buffer[i]))
-          return false;
-      }
-      return true;
+      return vector_math::isSilent(buffer, length);
     }
 
     inline bool isSilentf(const float* buffer, int length) {
@@ -251,15 +262,13 @@ namespace mopo {
     }
 
     inline mopo_float rms(const mopo_float* buffer, int num) {
-      mopo_float square_total = 0.0;
-      VECTORIZE_LOOP
-      for (int i = 0; i < num; ++i)
-        square_total += buffer[i] * buffer[i];
-
-      return sqrt(square_total / num);
+      return sqrt(vector_math::sumOfSquares(buffer, num) / num);
     }
 
     inline mopo_float peak(const mopo_float* buffer, int num, int skip) {
+      if (skip == 1)
+        return vector_math::peak(buffer, num);
+
       mopo_float peak = 0.0;
       for (int i = 0; i < num; i += skip)
         peak = fmax(peak, fabs(buffer[i]));
@@ -268,9 +277,7 @@ namespace mopo {
     }
 
     inline void zeroBuffer(mopo_float* buffer, int size) {
-      VECTORIZE_LOOP
-      for (int i = 0; i < size; ++i)
-        buffer[i] = 0.0;
+      vector_math::fill(buffer, 0.0, size);
     }
 
     inline void zeroBuffer(int* buffer, int size) {
@@ -279,10 +286,14 @@ namespace mopo {
         buffer[i] = 0;
     }
 
-    inline void copyBuffer(mopo_float* dest, const mopo_float* source, int size) {
+    inline void zeroBufferf(float* buffer, int size) {
       VECTORIZE_LOOP
       for (int i = 0; i < size; ++i)
-        dest[i] = source[i];
+        buffer[i] = 0.0f;
+    }
+
+    inline void copyBuffer(mopo_float* dest, const mopo_float* source, int size) {
+      vector_math::copy(dest, source, size);
     }
 
     inline void copyBufferf(float* dest, const float* source, int size) {
@@ -290,6 +301,28 @@ namespace mopo {
       for (int i = 0; i < size; ++i)
         dest[i] = source[i];
     }
+
+    // While a voice renders, the VoiceHandler points this at the voice's own
+    // random state so the values a voice draws don't depend on which thread
+    // it runs on or which voices ran before it.
+    inline unsigned int*& randomState() {
+      static thread_local unsigned int* state = nullptr;
+      return state;
+    }
+
+    // Same range as rand(), which is used when no voice is rendering.
+    inline int random() {
+      unsigned int* state = randomState();
+      if (state == nullptr)
+        return rand();
+
+      unsigned int x = *state;
+      x ^= x << 13;
+      x ^= x >> 17;
+      x ^= x << 5;
+      *state = x;
+      return (x >> 1) % (RAND_MAX + 1u);
+    }
   } // namespace utils
 } // namespace mopo
 
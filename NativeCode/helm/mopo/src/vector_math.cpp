@@ -0,0 +1,1062 @@
+/* Copyright 2013-2017 Matt Tytel
+ *
+ * mopo is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * mopo is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with mopo.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "vector_math.h"
+
+#include "utils.h"
+
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+  #define MOPO_VECTOR_SSE2
+  #include <emmintrin.h>
+
+  #if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    #define MOPO_VECTOR_AVX2
+    #define AVX2_TARGET __attribute__((target("avx2")))
+    #include <immintrin.h>
+  #elif defined(_MSC_VER)
+    #define MOPO_VECTOR_AVX2
+    #define AVX2_TARGET
+    #include <immintrin.h>
+  #endif
+#endif
+
+#if defined(__ARM_NEON) && (defined(__aarch64__) || defined(_M_ARM64))
+  #define MOPO_VECTOR_NEON
+  #include <arm_neon.h>
+#endif
+
+namespace mopo {
+namespace vector_math {
+
+  namespace scalar {
+    void add(mopo_float* dest, const mopo_float* left,
+             const mopo_float* right, int size) {
+      for (int i = 0; i < size; ++i)
+        dest[i] = left[i] + right[i];
+    }
+
+    void multiply(mopo_float* dest, const mopo_float* left,
+                  const mopo_float* right, int size) {
+      for (int i = 0; i < size; ++i)
+        dest[i] = left[i] * right[i];
+    }
+
+    void correlate(mopo_float* dest, const mopo_float* source,
+                   const mopo_float* coefficients, int num_coefficients, int size) {
+      for (int i = 0; i < size; ++i) {
+        mopo_float total = 0.0;
+        for (int k = 0; k < num_coefficients; ++k)
+          total += coefficients[k] * source[i + k];
+        dest[i] = total;
+      }
+    }
+
+    void interpolate(mopo_float* dest, const mopo_float* from,
+                     const mopo_float* to, const mopo_float* t, int size) {
+      for (int i = 0; i < size; ++i)
+        dest[i] = utils::interpolate(from[i], to[i], t[i]);
+    }
+
+    void bilinearInterpolate(mopo_float* dest,
+                             const mopo_float* top_left,
+                             const mopo_float* top_right,
+                             const mopo_float* bottom_left,
+                             const mopo_float* bottom_right,
+                             const mopo_float* x, const mopo_float* y,
+                             int size) {
+      for (int i = 0; i < size; ++i) {
+        mopo_float top = utils::interpolate(top_left[i], top_right[i], x[i]);
+        mopo_float bottom = utils::interpolate(bottom_left[i], bottom_right[i], x[i]);
+        dest[i] = utils::interpolate(top, bottom, y[i]);
+      }
+    }
+
+    void clamp(mopo_float* dest, const mopo_float* source,
+               mopo_float min, mopo_float max, int size) {
+      for (int i = 0; i < size; ++i)
+        dest[i] = utils::clamp(source[i], min, max);
+    }
+
+    void fill(mopo_float* dest, mopo_float value, int size) {
+      for (int i = 0; i < size; ++i)
+        dest[i] = value;
+    }
+
+    void ramp(mopo_float* dest, mopo_float start, mopo_float increment, int size) {
+      for (int i = 0; i < size; ++i)
+        dest[i] = start + i * increment;
+    }
+
+    void copy(mopo_float* dest, const mopo_float* source, int size) {
+      if (size > 0 && dest != source)
+        memmove(dest, source, size * sizeof(mopo_float));
+    }
+
+    void lookup(mopo_float* dest, const mopo_float* source,
+                const mopo_float* table, mopo_float offset,
+                mopo_float scale, mopo_float max_index, int size) {
+      for (int i = 0; i < size; ++i) {
+        mopo_float index = utils::clamp((source[i] - offset) * scale, 0.0, max_index);
+        int int_index = index;
+        mopo_float fraction = index - int_index;
+        dest[i] = utils::interpolate(table[int_index], table[int_index + 1], fraction);
+      }
+    }
+
+    bool isSilent(const mopo_float* buffer, int size) {
+      for (int i = 0; i < size; ++i) {
+        if (!utils::closeToZero(buffer[i]))
+          return false;
+      }
+      return true;
+    }
+
+    mopo_float sumOfSquares(const mopo_float* buffer, int size) {
+      mopo_float total = 0.0;
+      for (int i = 0; i < size; ++i)
+        total += buffer[i] * buffer[i];
+      return total;
+    }
+
+    mopo_float peak(const mopo_float* buffer, int size) {
+      mopo_float peak = 0.0;
+      for (int i = 0; i < size; ++i)
+        peak = fmax(peak, fabs(buffer[i]));
+      return peak;
+    }
+
+    void tanh(mopo_float* dest, const mopo_float* source, int size) {
+      for (int i = 0; i < size; ++i)
+        dest[i] = utils::quickTanh(source[i]);
+    }
+
+    void linearFold(mopo_float* dest, const mopo_float* source, int size) {
+      for (int i = 0; i < size; ++i)
+        dest[i] = utils::linearFold(source[i]);
+    }
+
+    void sinFold(mopo_float* dest, const mopo_float* source, int size) {
+      for (int i = 0; i < size; ++i)
+        dest[i] = utils::sinFold(source[i]);
+    }
+
+    void scaleInterleaved(float* dest, const float* source,
+                          const mopo_float* left, const mopo_float* right,
+                          int channels, int size) {
+      for (int i = 0; i < size; ++i) {
+        for (int c = 0; c < channels; ++c) {
+          int index = i * channels + c;
+          dest[index] = source[index] * ((c % 2) ? right[i] : left[i]);
+        }
+      }
+    }
+
+    const Kernels kernels = {
+      add, multiply, correlate, interpolate, bilinearInterpolate, clamp, fill, ramp,
+      copy, lookup, isSilent, sumOfSquares, peak, tanh, linearFold, sinFold,
+      scaleInterleaved
+    };
+  } // namespace scalar
+
+#ifdef MOPO_VECTOR_SSE2
+  namespace sse2 {
+    const int kWidth = 2;
+
+    inline __m128d interpolate(__m128d from, __m128d to, __m128d t) {
+      return _mm_add_pd(_mm_mul_pd(t, _mm_sub_pd(to, from)), from);
+    }
+
+    inline __m128d absolute(__m128d value) {
+      return _mm_andnot_pd(_mm_set1_pd(-0.0), value);
+    }
+
+    // Rounds through 32 bit integers, so callers check inRoundingRange first.
+    inline __m128d floor(__m128d value) {
+      __m128d truncated = _mm_cvtepi32_pd(_mm_cvttpd_epi32(value));
+      __m128d above = _mm_cmpgt_pd(truncated, value);
+      return _mm_sub_pd(truncated, _mm_and_pd(above, _mm_set1_pd(1.0)));
+    }
+
+    inline bool inRoundingRange(__m128d value) {
+      __m128d limit = _mm_set1_pd(2147483647.0);
+      return _mm_movemask_pd(_mm_cmplt_pd(absolute(value), limit)) == 0x3;
+    }
+
+    // The same steps as utils::quickTanh.
+    inline __m128d tanh(__m128d value) {
+      __m128d abs_value = absolute(value);
+      __m128d square = _mm_mul_pd(value, value);
+
+      __m128d num = _mm_add_pd(_mm_set1_pd(2.45550750702956),
+                               _mm_mul_pd(_mm_set1_pd(2.45550750702956), abs_value));
+      __m128d num_square = _mm_add_pd(_mm_set1_pd(0.893229853513558),
+                                      _mm_mul_pd(_mm_set1_pd(0.821226666969744), abs_value));
+      num = _mm_mul_pd(value, _mm_add_pd(num, _mm_mul_pd(square, num_square)));
+
+      __m128d den = _mm_mul_pd(_mm_mul_pd(_mm_set1_pd(0.814642734961073), value), abs_value);
+      den = _mm_mul_pd(_mm_add_pd(_mm_set1_pd(2.44506634652299), square),
+                       absolute(_mm_add_pd(value, den)));
+      den = _mm_add_pd(_mm_set1_pd(2.44506634652299), den);
+      return _mm_div_pd(num, den);
+    }
+
+    inline __m128d quickSin1(__m128d phase) {
+      phase = _mm_sub_pd(_mm_set1_pd(0.5), phase);
+      __m128d approx = _mm_mul_pd(phase, _mm_sub_pd(_mm_set1_pd(8.0),
+                                                    _mm_mul_pd(_mm_set1_pd(16.0), absolute(phase))));
+      return _mm_mul_pd(approx, _mm_add_pd(_mm_set1_pd(0.776),
+                                           _mm_mul_pd(_mm_set1_pd(0.224), absolute(approx))));
+    }
+
+    void add(mopo_float* dest, const mopo_float* left,
+             const mopo_float* right, int size) {
+      int i = 0;
+      for (; i + kWidth <= size; i += kWidth)
+        _mm_storeu_pd(dest + i, _mm_add_pd(_mm_loadu_pd(left + i), _mm_loadu_pd(right + i)));
+      scalar::add(dest + i, left + i, right + i, size - i);
+    }
+
+    void multiply(mopo_float* dest, const mopo_float* left,
+                  const mopo_float* right, int size) {
+      int i = 0;
+      for (; i + kWidth <= size; i += kWidth)
+        _mm_storeu_pd(dest + i, _mm_mul_pd(_mm_loadu_pd(left + i), _mm_loadu_pd(right + i)));
+      scalar::multiply(dest + i, left + i, right + i, size - i);
+    }
+
+    void correlate(mopo_float* dest, const mopo_float* source,
+                   const mopo_float* coefficients, int num_coefficients, int size) {
+      int i = 0;
+      for (; i + 2 * kWidth <= size; i += 2 * kWidth) {
+        __m128d first_total = _mm_setzero_pd();
+        __m128d second_total = _mm_setzero_pd();
+        for (int k = 0; k < num_coefficients; ++k) {
+          __m128d coefficient = _mm_set1_pd(coefficients[k]);
+          const mopo_float* taps = source + i + k;
+          first_total = _mm_add_pd(first_total, _mm_mul_pd(coefficient, _mm_loadu_pd(taps)));
+          second_total = _mm_add_pd(second_total,
+                                    _mm_mul_pd(coefficient, _mm_loadu_pd(taps + kWidth)));
+        }
+        _mm_storeu_pd(dest + i, first_total);
+        _mm_storeu_pd(dest + i + kWidth, second_total);
+      }
+      scalar::correlate(dest + i, source + i, coefficients, num_coefficients, size - i);
+    }
+
+    void interpolate(mopo_float* dest, const mopo_float* from,
+                     const mopo_float* to, const mopo_float* t, int size) {
+      int i = 0;
+      for (; i + kWidth <= size; i += kWidth) {
+        __m128d result = interpolate(_mm_loadu_pd(from + i), _mm_loadu_pd(to + i),
+                                     _mm_loadu_pd(t + i));
+        _mm_storeu_pd(dest + i, result);
+      }
+      scalar::interpolate(dest + i, from + i, to + i, t + i, size - i);
+    }
+
+    void bilinearInterpolate(mopo_float* dest,
+                             const mopo_float* top_left,
+                             const mopo_float* top_right,
+                             const mopo_float* bottom_left,
+                             const mopo_float* bottom_right,
+                             const mopo_float* x, const mopo_float* y,
+                             int size) {
+      int i = 0;
+      for (; i + kWidth <= size; i += kWidth) {
+        __m128d x_value = _mm_loadu_pd(x + i);
+        __m128d top = interpolate(_mm_loadu_pd(top_left + i),
+                                  _mm_loadu_pd(top_right + i), x_value);
+        __m128d bottom = interpolate(_mm_loadu_pd(bottom_left + i),
+                                     _mm_loadu_pd(bottom_right + i), x_value);
+        _mm_storeu_pd(dest + i, interpolate(top, bottom, _mm_loadu_pd(y + i)));
+      }
+      scalar::bilinearInterpolate(dest + i, top_left + i, top_right + i,
+                                  bottom_left + i, bottom_right + i,
+                                  x + i, y + i, size - i);
+    }
+
+    void clamp(mopo_float* dest, const mopo_float* source,
+               mopo_float min, mopo_float max, int size) {
+      __m128d min_value = _mm_set1_pd(min);
+      __m128d max_value = _mm_set1_pd(max);
+      int i = 0;
+      for (; i + kWidth <= size; i += kWidth) {
+        __m128d value = _mm_max_pd(_mm_loadu_pd(source + i), min_value);
+        _mm_storeu_pd(dest + i, _mm_min_pd(value, max_value));
+      }
+      scalar::clamp(dest + i, source + i, min, max, size - i);
+    }
+
+    void fill(mopo_float* dest, mopo_float value, int size) {
+      __m128d values = _mm_set1_pd(value);
+      int i = 0;
+      for (; i + kWidth <= size; i += kWidth)
+        _mm_storeu_pd(dest + i, values);
+      scalar::fill(dest + i, value, size - i);
+    }
+
+    void ramp(mopo_float* dest, mopo_float start, mopo_float increment, int size) {
+      __m128d start_value = _mm_set1_pd(start);
+      __m128d increment_value = _mm_set1_pd(increment);
+      __m128d index = _mm_set_pd(1.0, 0.0);
+      __m128d step = _mm_set1_pd(kWidth);
+      int i = 0;
+      for (; i + kWidth <= size; i += kWidth) {
+        _mm_storeu_pd(dest + i, _mm_add_pd(start_value, _mm_mul_pd(index, increment_value)));
+        index = _mm_add_pd(index, step);
+      }
+      for (; i < size; ++i)
+        dest[i] = start + i * increment;
+    }
+
+    void lookup(mopo_float* dest, const mopo_float* source,
+                const mopo_float* table, mopo_float offset,
+                mopo_float scale, mopo_float max_index, int size) {
+      __m128d offset_value = _mm_set1_pd(offset);
+      __m128d scale_value = _mm_set1_pd(scale);
+      __m128d max_value = _mm_set1_pd(max_index);
+      __m128d zero = _mm_setzero_pd();
+      int i = 0;
+      for (; i + kWidth <= size; i += kWidth) {
+        __m128d index = _mm_mul_pd(_mm_sub_pd(_mm_loadu_pd(source + i), offset_value),
+                                   scale_value);
+        index = _mm_min_pd(_mm_max_pd(index, zero), max_value);
+        __m128i int_index = _mm_cvttpd_epi32(index);
+        __m128d fraction = _mm_sub_pd(index, _mm_cvtepi32_pd(int_index));
+
+        int first = _mm_cvtsi128_si32(int_index);
+        int second = _mm_cvtsi128_si32(_mm_shuffle_epi32(int_index, 1));
+        __m128d from = _mm_set_pd(table[second], table[first]);
+        __m128d to = _mm_set_pd(table[second + 1], table[first + 1]);
+        _mm_storeu_pd(dest + i, interpolate(from, to, fraction));
+      }
+      scalar::lookup(dest + i, source + i, table, offset, scale, max_index, size - i);
+    }
+
+    bool isSilent(const mopo_float* buffer, int size) {
+      __m128d epsilon = _mm_set1_pd(EPSILON);
+      int i = 0;
+      for (; i + 2 * kWidth <= size; i += 2 * kWidth) {
+        __m128d first = _mm_cmple_pd(absolute(_mm_loadu_pd(buffer + i)), epsilon);
+        __m128d second = _mm_cmple_pd(absolute(_mm_loadu_pd(buffer + i + kWidth)), epsilon);
+        if (_mm_movemask_pd(_mm_and_pd(first, second)) != 0x3)
+          return false;
+      }
+      return scalar::isSilent(buffer + i, size - i);
+    }
+
+    mopo_float sumOfSquares(const mopo_float* buffer, int size) {
+      __m128d first_total = _mm_setzero_pd();
+      __m128d second_total = _mm_setzero_pd();
+      int i = 0;
+      for (; i + 2 * kWidth <= size; i += 2 * kWidth) {
+        __m128d first = _mm_loadu_pd(buffer + i);
+        __m128d second = _mm_loadu_pd(buffer + i + kWidth);
+        first_total = _mm_add_pd(first_total, _mm_mul_pd(first, first));
+        second_total = _mm_add_pd(second_total, _mm_mul_pd(second, second));
+      }
+
+      mopo_float totals[kWidth];
+      _mm_storeu_pd(totals, _mm_add_pd(first_total, second_total));
+      return totals[0] + totals[1] + scalar::sumOfSquares(buffer + i, size - i);
+    }
+
+    mopo_float peak(const mopo_float* buffer, int size) {
+      // maxpd returns its second operand on NaN, which skips NaNs like fmax.
+      __m128d peak_value = _mm_setzero_pd();
+      int i = 0;
+      for (; i + kWidth <= size; i += kWidth)
+        peak_value = _mm_max_pd(absolute(_mm_loadu_pd(buffer + i)), peak_value);
+
+      mopo_float peaks[kWidth];
+      _mm_storeu_pd(peaks, peak_value);
+      return fmax(fmax(peaks[0], peaks[1]), scalar::peak(buffer + i, size - i));
+    }
+
+    void tanh(mopo_float* dest, const mopo_float* source, int size) {
+      int i = 0;
+      for (; i + kWidth <= size; i += kWidth)
+        _mm_storeu_pd(dest + i, tanh(_mm_loadu_pd(source + i)));
+      scalar::tanh(dest + i, source + i, size - i);
+    }
+
+    void linearFold(mopo_float* dest, const mopo_float* source, int size) {
+      int i = 0;
+      for (; i + kWidth <= size; i += kWidth) {
+        __m128d adjust = _mm_add_pd(_mm_mul_pd(_mm_set1_pd(0.25), _mm_loadu_pd(source + i)),
+                                    _mm_set1_pd(0.75));
+        if (!inRoundingRange(adjust)) {
+          scalar::linearFold(dest + i, source + i, kWidth);
+          continue;
+        }
+
+        __m128d range = _mm_sub_pd(adjust, floor(adjust));
+        __m128d fold = absolute(_mm_sub_pd(_mm_set1_pd(2.0), _mm_mul_pd(_mm_set1_pd(4.0), range)));
+        _mm_storeu_pd(dest + i, _mm_sub_pd(fold, _mm_set1_pd(1.0)));
+      }
+      scalar::linearFold(dest + i, source + i, size - i);
+    }
+
+    void sinFold(mopo_float* dest, const mopo_float* source, int size) {
+      int i = 0;
+      for (; i + kWidth <= size; i += kWidth) {
+        __m128d adjust = _mm_add_pd(_mm_mul_pd(_mm_set1_pd(-0.25), _mm_loadu_pd(source + i)),
+                                    _mm_set1_pd(0.5));
+        if (!inRoundingRange(adjust)) {
+          scalar::sinFold(dest + i, source + i, kWidth);
+          continue;
+        }
+
+        _mm_storeu_pd(dest + i, quickSin1(_mm_sub_pd(adjust, floor(adjust))));
+      }
+      scalar::sinFold(dest + i, source + i, size - i);
+    }
+
+    // Widens four floats, scales each pair, and narrows them back.
+    inline __m128 scale(__m128 samples, __m128d low_gains, __m128d high_gains) {
+      __m128d low = _mm_mul_pd(_mm_cvtps_pd(samples), low_gains);
+      __m128d high = _mm_mul_pd(_mm_cvtps_pd(_mm_movehl_ps(samples, samples)), high_gains);
+      return _mm_movelh_ps(_mm_cvtpd_ps(low), _mm_cvtpd_ps(high));
+    }
+
+    void scaleInterleaved(float* dest, const float* source,
+                          const mopo_float* left, const mopo_float* right,
+                          int channels, int size) {
+      int i = 0;
+      if (channels == 1) {
+        for (; i + 2 * kWidth <= size; i += 2 * kWidth) {
+          __m128 scaled = scale(_mm_loadu_ps(source + i),
+                                _mm_loadu_pd(left + i), _mm_loadu_pd(left + i + kWidth));
+          _mm_storeu_ps(dest + i, scaled);
+        }
+      }
+      else if (channels == 2) {
+        for (; i + kWidth <= size; i += kWidth) {
+          __m128d left_gains = _mm_loadu_pd(left + i);
+          __m128d right_gains = _mm_loadu_pd(right + i);
+          __m128 scaled = scale(_mm_loadu_ps(source + 2 * i),
+                                _mm_unpacklo_pd(left_gains, right_gains),
+                                _mm_unpackhi_pd(left_gains, right_gains));
+          _mm_storeu_ps(dest + 2 * i, scaled);
+        }
+      }
+      else if (channels % 2 == 0) {
+        for (; i < size; ++i) {
+          __m128d gains = _mm_unpacklo_pd(_mm_load_sd(left + i), _mm_load_sd(right + i));
+          int c = i * channels;
+          int end = c + channels;
+          for (; c + 4 <= end; c += 4)
+            _mm_storeu_ps(dest + c, scale(_mm_loadu_ps(source + c), gains, gains));
+
+          if (c < end) {
+            __m128 pair = _mm_loadl_pi(_mm_setzero_ps(), reinterpret_cast<const __m64*>(source + c));
+            _mm_storel_pi(reinterpret_cast<__m64*>(dest + c), scale(pair, gains, gains));
+          }
+        }
+      }
+      scalar::scaleInterleaved(dest + i * channels, source + i * channels,
+                               left + i, right + i, channels, size - i);
+    }
+
+    const Kernels kernels = {
+      add, multiply, correlate, interpolate, bilinearInterpolate, clamp, fill, ramp,
+      scalar::copy, lookup, isSilent, sumOfSquares, peak, tanh, linearFold, sinFold,
+      scaleInterleaved
+    };
+  } // namespace sse2
+#endif
+
+#ifdef MOPO_VECTOR_AVX2
+  namespace avx2 {
+    const int kWidth = 4;
+
+    AVX2_TARGET inline __m256d interpolate(__m256d from, __m256d to, __m256d t) {
+      return _mm256_add_pd(_mm256_mul_pd(t, _mm256_sub_pd(to, from)), from);
+    }
+
+    AVX2_TARGET inline __m256d absolute(__m256d value) {
+      return _mm256_andnot_pd(_mm256_set1_pd(-0.0), value);
+    }
+
+    AVX2_TARGET inline __m256d tanh(__m256d value) {
+      __m256d abs_value = absolute(value);
+      __m256d square = _mm256_mul_pd(value, value);
+
+      __m256d num = _mm256_add_pd(_mm256_set1_pd(2.45550750702956),
+                                  _mm256_mul_pd(_mm256_set1_pd(2.45550750702956), abs_value));
+      __m256d num_square = _mm256_add_pd(_mm256_set1_pd(0.893229853513558),
+                                         _mm256_mul_pd(_mm256_set1_pd(0.821226666969744),
+                                                       abs_value));
+      num = _mm256_mul_pd(value, _mm256_add_pd(num, _mm256_mul_pd(square, num_square)));
+
+      __m256d den = _mm256_mul_pd(_mm256_mul_pd(_mm256_set1_pd(0.814642734961073), value),
+                                  abs_value);
+      den = _mm256_mul_pd(_mm256_add_pd(_mm256_set1_pd(2.44506634652299), square),
+                          absolute(_mm256_add_pd(value, den)));
+      den = _mm256_add_pd(_mm256_set1_pd(2.44506634652299), den);
+      return _mm256_div_pd(num, den);
+    }
+
+    AVX2_TARGET inline __m256d quickSin1(__m256d phase) {
+      phase = _mm256_sub_pd(_mm256_set1_pd(0.5), phase);
+      __m256d approx = _mm256_mul_pd(phase,
+                                     _mm256_sub_pd(_mm256_set1_pd(8.0),
+                                                   _mm256_mul_pd(_mm256_set1_pd(16.0),
+                                                                 absolute(phase))));
+      return _mm256_mul_pd(approx, _mm256_add_pd(_mm256_set1_pd(0.776),
+                                                 _mm256_mul_pd(_mm256_set1_pd(0.224),
+                                                               absolute(approx))));
+    }
+
+    AVX2_TARGET void add(mopo_float* dest, const mopo_float* left,
+                         const mopo_float* right, int size) {
+      int i = 0;
+      for (; i + kWidth <= size; i += kWidth) {
+        __m256d result = _mm256_add_pd(_mm256_loadu_pd(left + i), _mm256_loadu_pd(right + i));
+        _mm256_storeu_pd(dest + i, result);
+      }
+      sse2::add(dest + i, left + i, right + i, size - i);
+    }
+
+    AVX2_TARGET void multiply(mopo_float* dest, const mopo_float* left,
+                              const mopo_float* right, int size) {
+      int i = 0;
+      for (; i + kWidth <= size; i += kWidth) {
+        __m256d result = _mm256_mul_pd(_mm256_loadu_pd(left + i), _mm256_loadu_pd(right + i));
+        _mm256_storeu_pd(dest + i, result);
+      }
+      sse2::multiply(dest + i, left + i, right + i, size - i);
+    }
+
+    AVX2_TARGET void correlate(mopo_float* dest, const mopo_float* source,
+                               const mopo_float* coefficients, int num_coefficients,
+                               int size) {
+      int i = 0;
+      for (; i + 2 * kWidth <= size; i += 2 * kWidth) {
+        __m256d first_total = _mm256_setzero_pd();
+        __m256d second_total = _mm256_setzero_pd();
+        for (int k = 0; k < num_coefficients; ++k) {
+          __m256d coefficient = _mm256_set1_pd(coefficients[k]);
+          const mopo_float* taps = source + i + k;
+          first_total = _mm256_add_pd(first_total,
+                                      _mm256_mul_pd(coefficient, _mm256_loadu_pd(taps)));
+          second_total = _mm256_add_pd(second_total,
+                                       _mm256_mul_pd(coefficient, _mm256_loadu_pd(taps + kWidth)));
+        }
+        _mm256_storeu_pd(dest + i, first_total);
+        _mm256_storeu_pd(dest + i + kWidth, second_total);
+      }
+      sse2::correlate(dest + i, source + i, coefficients, num_coefficients, size - i);
+    }
+
+    AVX2_TARGET void interpolate(mopo_float* dest, const mopo_float* from,
+                                 const mopo_float* to, const mopo_float* t, int size) {
+      int i = 0;
+      for (; i + kWidth <= size; i += kWidth) {
+        __m256d result = interpolate(_mm256_loadu_pd(from + i), _mm256_loadu_pd(to + i),
+                                     _mm256_loadu_pd(t + i));
+        _mm256_storeu_pd(dest + i, result);
+      }
+      sse2::interpolate(dest + i, from + i, to + i, t + i, size - i);
+    }
+
+    AVX2_TARGET void bilinearInterpolate(mopo_float* dest,
+                                         const mopo_float* top_left,
+                                         const mopo_float* top_right,
+                                         const mopo_float* bottom_left,
+                                         const mopo_float* bottom_right,
+                                         const mopo_float* x, const mopo_float* y,
+                                         int size) {
+      int i = 0;
+      for (; i + kWidth <= size; i += kWidth) {
+        __m256d x_value = _mm256_loadu_pd(x + i);
+        __m256d top = interpolate(_mm256_loadu_pd(top_left + i),
+                                  _mm256_loadu_pd(top_right + i), x_value);
+        __m256d bottom = interpolate(_mm256_loadu_pd(bottom_left + i),
+                                     _mm256_loadu_pd(bottom_right + i), x_value);
+        _mm256_storeu_pd(dest + i, interpolate(top, bottom, _mm256_loadu_pd(y + i)));
+      }
+      sse2::bilinearInterpolate(dest + i, top_left + i, top_right + i,
+                                bottom_left + i, bottom_right + i,
+                                x + i, y + i, size - i);
+    }
+
+    AVX2_TARGET void clamp(mopo_float* dest, const mopo_float* source,
+                           mopo_float min, mopo_float max, int size) {
+      __m256d min_value = _mm256_set1_pd(min);
+      __m256d max_value = _mm256_set1_pd(max);
+      int i = 0;
+      for (; i + kWidth <= size; i += kWidth) {
+        __m256d value = _mm256_max_pd(_mm256_loadu_pd(source + i), min_value);
+        _mm256_storeu_pd(dest + i, _mm256_min_pd(value, max_value));
+      }
+      sse2::clamp(dest + i, source + i, min, max, size - i);
+    }
+
+    AVX2_TARGET void fill(mopo_float* dest, mopo_float value, int size) {
+      __m256d values = _mm256_set1_pd(value);
+      int i = 0;
+      for (; i + kWidth <= size; i += kWidth)
+        _mm256_storeu_pd(dest + i, values);
+      sse2::fill(dest + i, value, size - i);
+    }
+
+    AVX2_TARGET void ramp(mopo_float* dest, mopo_float start,
+                          mopo_float increment, int size) {
+      __m256d start_value = _mm256_set1_pd(start);
+      __m256d increment_value = _mm256_set1_pd(increment);
+      __m256d index = _mm256_set_pd(3.0, 2.0, 1.0, 0.0);
+      __m256d step = _mm256_set1_pd(kWidth);
+      int i = 0;
+      for (; i + kWidth <= size; i += kWidth) {
+        __m256d value = _mm256_add_pd(start_value, _mm256_mul_pd(index, increment_value));
+        _mm256_storeu_pd(dest + i, value);
+        index = _mm256_add_pd(index, step);
+      }
+      for (; i < size; ++i)
+        dest[i] = start + i * increment;
+    }
+
+    AVX2_TARGET bool isSilent(const mopo_float* buffer, int size) {
+      __m256d epsilon = _mm256_set1_pd(EPSILON);
+      int i = 0;
+      for (; i + 2 * kWidth <= size; i += 2 * kWidth) {
+        __m256d first = _mm256_cmp_pd(absolute(_mm256_loadu_pd(buffer + i)),
+                                      epsilon, _CMP_LE_OQ);
+        __m256d second = _mm256_cmp_pd(absolute(_mm256_loadu_pd(buffer + i + kWidth)),
+                                       epsilon, _CMP_LE_OQ);
+        if (_mm256_movemask_pd(_mm256_and_pd(first, second)) != 0xf)
+          return false;
+      }
+      return sse2::isSilent(buffer + i, size - i);
+    }
+
+    AVX2_TARGET mopo_float sumOfSquares(const mopo_float* buffer, int size) {
+      __m256d first_total = _mm256_setzero_pd();
+      __m256d second_total = _mm256_setzero_pd();
+      int i = 0;
+      for (; i + 2 * kWidth <= size; i += 2 * kWidth) {
+        __m256d first = _mm256_loadu_pd(buffer + i);
+        __m256d second = _mm256_loadu_pd(buffer + i + kWidth);
+        first_total = _mm256_add_pd(first_total, _mm256_mul_pd(first, first));
+        second_total = _mm256_add_pd(second_total, _mm256_mul_pd(second, second));
+      }
+
+      mopo_float totals[kWidth];
+      _mm256_storeu_pd(totals, _mm256_add_pd(first_total, second_total));
+      mopo_float total = (totals[0] + totals[1]) + (totals[2] + totals[3]);
+      return total + sse2::sumOfSquares(buffer + i, size - i);
+    }
+
+    AVX2_TARGET mopo_float peak(const mopo_float* buffer, int size) {
+      __m256d peak_value = _mm256_setzero_pd();
+      int i = 0;
+      for (; i + kWidth <= size; i += kWidth)
+        peak_value = _mm256_max_pd(absolute(_mm256_loadu_pd(buffer + i)), peak_value);
+
+      mopo_float peaks[kWidth];
+      _mm256_storeu_pd(peaks, peak_value);
+      mopo_float peak = fmax(fmax(peaks[0], peaks[1]), fmax(peaks[2], peaks[3]));
+      return fmax(peak, sse2::peak(buffer + i, size - i));
+    }
+
+    AVX2_TARGET void tanh(mopo_float* dest, const mopo_float* source, int size) {
+      int i = 0;
+      for (; i + kWidth <= size; i += kWidth)
+        _mm256_storeu_pd(dest + i, tanh(_mm256_loadu_pd(source + i)));
+      sse2::tanh(dest + i, source + i, size - i);
+    }
+
+    // Unlike SSE2, AVX has a floor for every value.
+
+    AVX2_TARGET void linearFold(mopo_float* dest, const mopo_float* source, int size) {
+      int i = 0;
+      for (; i + kWidth <= size; i += kWidth) {
+        __m256d adjust = _mm256_add_pd(_mm256_mul_pd(_mm256_set1_pd(0.25),
+                                                     _mm256_loadu_pd(source + i)),
+                                       _mm256_set1_pd(0.75));
+        __m256d range = _mm256_sub_pd(adjust, _mm256_floor_pd(adjust));
+        __m256d fold = absolute(_mm256_sub_pd(_mm256_set1_pd(2.0),
+                                              _mm256_mul_pd(_mm256_set1_pd(4.0), range)));
+        _mm256_storeu_pd(dest + i, _mm256_sub_pd(fold, _mm256_set1_pd(1.0)));
+      }
+      scalar::linearFold(dest + i, source + i, size - i);
+    }
+
+    AVX2_TARGET void sinFold(mopo_float* dest, const mopo_float* source, int size) {
+      int i = 0;
+      for (; i + kWidth <= size; i += kWidth) {
+        __m256d adjust = _mm256_add_pd(_mm256_mul_pd(_mm256_set1_pd(-0.25),
+                                                     _mm256_loadu_pd(source + i)),
+                                       _mm256_set1_pd(0.5));
+        __m256d range = _mm256_sub_pd(adjust, _mm256_floor_pd(adjust));
+        _mm256_storeu_pd(dest + i, quickSin1(range));
+      }
+      scalar::sinFold(dest + i, source + i, size - i);
+    }
+
+    const Kernels kernels = {
+      add, multiply, correlate, interpolate, bilinearInterpolate, clamp, fill, ramp,
+      scalar::copy, sse2::lookup, isSilent, sumOfSquares, peak, tanh, linearFold, sinFold,
+      sse2::scaleInterleaved
+    };
+
+    bool supported() {
+#if defined(_MSC_VER)
+      int info[4];
+      __cpuid(info, 1);
+      bool os_saves_avx = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) &&
+                          (_xgetbv(0) & 0x6) == 0x6;
+      if (!os_saves_avx)
+        return false;
+      __cpuidex(info, 7, 0);
+      return info[1] & (1 << 5);
+#else
+      __builtin_cpu_init();
+      return __builtin_cpu_supports("avx2");
+#endif
+    }
+  } // namespace avx2
+#endif
+
+#ifdef MOPO_VECTOR_NEON
+  namespace neon {
+    const int kWidth = 2;
+
+    inline float64x2_t interpolate(float64x2_t from, float64x2_t to, float64x2_t t) {
+      return vaddq_f64(vmulq_f64(t, vsubq_f64(to, from)), from);
+    }
+
+    inline float64x2_t tanh(float64x2_t value) {
+      float64x2_t abs_value = vabsq_f64(value);
+      float64x2_t square = vmulq_f64(value, value);
+
+      float64x2_t num = vaddq_f64(vdupq_n_f64(2.45550750702956),
+                                  vmulq_f64(vdupq_n_f64(2.45550750702956), abs_value));
+      float64x2_t num_square = vaddq_f64(vdupq_n_f64(0.893229853513558),
+                                         vmulq_f64(vdupq_n_f64(0.821226666969744), abs_value));
+      num = vmulq_f64(value, vaddq_f64(num, vmulq_f64(square, num_square)));
+
+      float64x2_t den = vmulq_f64(vmulq_f64(vdupq_n_f64(0.814642734961073), value), abs_value);
+      den = vmulq_f64(vaddq_f64(vdupq_n_f64(2.44506634652299), square),
+                      vabsq_f64(vaddq_f64(value, den)));
+      den = vaddq_f64(vdupq_n_f64(2.44506634652299), den);
+      return vdivq_f64(num, den);
+    }
+
+    inline float64x2_t quickSin1(float64x2_t phase) {
+      phase = vsubq_f64(vdupq_n_f64(0.5), phase);
+      float64x2_t approx = vmulq_f64(phase, vsubq_f64(vdupq_n_f64(8.0),
+                                                      vmulq_f64(vdupq_n_f64(16.0),
+                                                                vabsq_f64(phase))));
+      return vmulq_f64(approx, vaddq_f64(vdupq_n_f64(0.776),
+                                         vmulq_f64(vdupq_n_f64(0.224), vabsq_f64(approx))));
+    }
+
+    void add(mopo_float* dest, const mopo_float* left,
+             const mopo_float* right, int size) {
+      int i = 0;
+      for (; i + kWidth <= size; i += kWidth)
+        vst1q_f64(dest + i, vaddq_f64(vld1q_f64(left + i), vld1q_f64(right + i)));
+      scalar::add(dest + i, left + i, right + i, size - i);
+    }
+
+    void multiply(mopo_float* dest, const mopo_float* left,
+                  const mopo_float* right, int size) {
+      int i = 0;
+      for (; i + kWidth <= size; i += kWidth)
+        vst1q_f64(dest + i, vmulq_f64(vld1q_f64(left + i), vld1q_f64(right + i)));
+      scalar::multiply(dest + i, left + i, right + i, size - i);
+    }
+
+    void correlate(mopo_float* dest, const mopo_float* source,
+                   const mopo_float* coefficients, int num_coefficients, int size) {
+      int i = 0;
+      for (; i + 2 * kWidth <= size; i += 2 * kWidth) {
+        float64x2_t first_total = vdupq_n_f64(0.0);
+        float64x2_t second_total = vdupq_n_f64(0.0);
+        for (int k = 0; k < num_coefficients; ++k) {
+          float64x2_t coefficient = vdupq_n_f64(coefficients[k]);
+          const mopo_float* taps = source + i + k;
+          first_total = vaddq_f64(first_total, vmulq_f64(coefficient, vld1q_f64(taps)));
+          second_total = vaddq_f64(second_total,
+                                   vmulq_f64(coefficient, vld1q_f64(taps + kWidth)));
+        }
+        vst1q_f64(dest + i, first_total);
+        vst1q_f64(dest + i + kWidth, second_total);
+      }
+      scalar::correlate(dest + i, source + i, coefficients, num_coefficients, size - i);
+    }
+
+    void interpolate(mopo_float* dest, const mopo_float* from,
+                     const mopo_float* to, const mopo_float* t, int size) {
+      int i = 0;
+      for (; i + kWidth <= size; i += kWidth) {
+        float64x2_t result = interpolate(vld1q_f64(from + i), vld1q_f64(to + i),
+                                         vld1q_f64(t + i));
+        vst1q_f64(dest + i, result);
+      }
+      scalar::interpolate(dest + i, from + i, to + i, t + i, size - i);
+    }
+
+    void bilinearInterpolate(mopo_float* dest,
+                             const mopo_float* top_left,
+                             const mopo_float* top_right,
+                             const mopo_float* bottom_left,
+                             const mopo_float* bottom_right,
+                             const mopo_float* x, const mopo_float* y,
+                             int size) {
+      int i = 0;
+      for (; i + kWidth <= size; i += kWidth) {
+        float64x2_t x_value = vld1q_f64(x + i);
+        float64x2_t top = interpolate(vld1q_f64(top_left + i),
+                                      vld1q_f64(top_right + i), x_value);
+        float64x2_t bottom = interpolate(vld1q_f64(bottom_left + i),
+                                         vld1q_f64(bottom_right + i), x_value);
+        vst1q_f64(dest + i, interpolate(top, bottom, vld1q_f64(y + i)));
+      }
+      scalar::bilinearInterpolate(dest + i, top_left + i, top_right + i,
+                                  bottom_left + i, bottom_right + i,
+                                  x + i, y + i, size - i);
+    }
+
+    // The nm variants skip NaNs the same way fmin and fmax do.
+    void clamp(mopo_float* dest, const mopo_float* source,
+               mopo_float min, mopo_float max, int size) {
+      float64x2_t min_value = vdupq_n_f64(min);
+      float64x2_t max_value = vdupq_n_f64(max);
+      int i = 0;
+      for (; i + kWidth <= size; i += kWidth) {
+        float64x2_t value = vmaxnmq_f64(vld1q_f64(source + i), min_value);
+        vst1q_f64(dest + i, vminnmq_f64(value, max_value));
+      }
+      scalar::clamp(dest + i, source + i, min, max, size - i);
+    }
+
+    void fill(mopo_float* dest, mopo_float value, int size) {
+      float64x2_t values = vdupq_n_f64(value);
+      int i = 0;
+      for (; i + kWidth <= size; i += kWidth)
+        vst1q_f64(dest + i, values);
+      scalar::fill(dest + i, value, size - i);
+    }
+
+    void ramp(mopo_float* dest, mopo_float start, mopo_float increment, int size) {
+      const mopo_float first_indices[kWidth] = { 0.0, 1.0 };
+      float64x2_t start_value = vdupq_n_f64(start);
+      float64x2_t increment_value = vdupq_n_f64(increment);
+      float64x2_t index = vld1q_f64(first_indices);
+      float64x2_t step = vdupq_n_f64(kWidth);
+      int i = 0;
+      for (; i + kWidth <= size; i += kWidth) {
+        vst1q_f64(dest + i, vaddq_f64(start_value, vmulq_f64(index, increment_value)));
+        index = vaddq_f64(index, step);
+      }
+      for (; i < size; ++i)
+        dest[i] = start + i * increment;
+    }
+
+    bool isSilent(const mopo_float* buffer, int size) {
+      float64x2_t epsilon = vdupq_n_f64(EPSILON);
+      int i = 0;
+      for (; i + 2 * kWidth <= size; i += 2 * kWidth) {
+        uint64x2_t first = vcleq_f64(vabsq_f64(vld1q_f64(buffer + i)), epsilon);
+        uint64x2_t second = vcleq_f64(vabsq_f64(vld1q_f64(buffer + i + kWidth)), epsilon);
+        uint64x2_t silent = vandq_u64(first, second);
+        if (!vgetq_lane_u64(silent, 0) || !vgetq_lane_u64(silent, 1))
+          return false;
+      }
+      return scalar::isSilent(buffer + i, size - i);
+    }
+
+    mopo_float sumOfSquares(const mopo_float* buffer, int size) {
+      float64x2_t first_total = vdupq_n_f64(0.0);
+      float64x2_t second_total = vdupq_n_f64(0.0);
+      int i = 0;
+      for (; i + 2 * kWidth <= size; i += 2 * kWidth) {
+        float64x2_t first = vld1q_f64(buffer + i);
+        float64x2_t second = vld1q_f64(buffer + i + kWidth);
+        first_total = vaddq_f64(first_total, vmulq_f64(first, first));
+        second_total = vaddq_f64(second_total, vmulq_f64(second, second));
+      }
+
+      float64x2_t total = vaddq_f64(first_total, second_total);
+      return vgetq_lane_f64(total, 0) + vgetq_lane_f64(total, 1) +
+             scalar::sumOfSquares(buffer + i, size - i);
+    }
+
+    mopo_float peak(const mopo_float* buffer, int size) {
+      float64x2_t peak_value = vdupq_n_f64(0.0);
+      int i = 0;
+      for (; i + kWidth <= size; i += kWidth)
+        peak_value = vmaxnmq_f64(peak_value, vabsq_f64(vld1q_f64(buffer + i)));
+
+      mopo_float peak = fmax(vgetq_lane_f64(peak_value, 0), vgetq_lane_f64(peak_value, 1));
+      return fmax(peak, scalar::peak(buffer + i, size - i));
+    }
+
+    void tanh(mopo_float* dest, const mopo_float* source, int size) {
+      int i = 0;
+      for (; i + kWidth <= size; i += kWidth)
+        vst1q_f64(dest + i, tanh(vld1q_f64(source + i)));
+      scalar::tanh(dest + i, source + i, size - i);
+    }
+
+    void linearFold(mopo_float* dest, const mopo_float* source, int size) {
+      int i = 0;
+      for (; i + kWidth <= size; i += kWidth) {
+        float64x2_t adjust = vaddq_f64(vmulq_f64(vdupq_n_f64(0.25), vld1q_f64(source + i)),
+                                       vdupq_n_f64(0.75));
+        float64x2_t range = vsubq_f64(adjust, vrndmq_f64(adjust));
+        float64x2_t fold = vabsq_f64(vsubq_f64(vdupq_n_f64(2.0),
+                                               vmulq_f64(vdupq_n_f64(4.0), range)));
+        vst1q_f64(dest + i, vsubq_f64(fold, vdupq_n_f64(1.0)));
+      }
+      scalar::linearFold(dest + i, source + i, size - i);
+    }
+
+    void sinFold(mopo_float* dest, const mopo_float* source, int size) {
+      int i = 0;
+      for (; i + kWidth <= size; i += kWidth) {
+        float64x2_t adjust = vaddq_f64(vmulq_f64(vdupq_n_f64(-0.25), vld1q_f64(source + i)),
+                                       vdupq_n_f64(0.5));
+        vst1q_f64(dest + i, quickSin1(vsubq_f64(adjust, vrndmq_f64(adjust))));
+      }
+      scalar::sinFold(dest + i, source + i, size - i);
+    }
+
+    // Widens four floats, scales each pair, and narrows them back.
+    inline float32x4_t scale(float32x4_t samples, float64x2_t low_gains,
+                             float64x2_t high_gains) {
+      float64x2_t low = vmulq_f64(vcvt_f64_f32(vget_low_f32(samples)), low_gains);
+      float64x2_t high = vmulq_f64(vcvt_high_f64_f32(samples), high_gains);
+      return vcvt_high_f32_f64(vcvt_f32_f64(low), high);
+    }
+
+    void scaleInterleaved(float* dest, const float* source,
+                          const mopo_float* left, const mopo_float* right,
+                          int channels, int size) {
+      int i = 0;
+      if (channels == 1) {
+        for (; i + 2 * kWidth <= size; i += 2 * kWidth) {
+          float32x4_t scaled = scale(vld1q_f32(source + i),
+                                     vld1q_f64(left + i), vld1q_f64(left + i + kWidth));
+          vst1q_f32(dest + i, scaled);
+        }
+      }
+      else if (channels == 2) {
+        for (; i + kWidth <= size; i += kWidth) {
+          float64x2_t left_gains = vld1q_f64(left + i);
+          float64x2_t right_gains = vld1q_f64(right + i);
+          float32x4_t scaled = scale(vld1q_f32(source + 2 * i),
+                                     vzip1q_f64(left_gains, right_gains),
+                                     vzip2q_f64(left_gains, right_gains));
+          vst1q_f32(dest + 2 * i, scaled);
+        }
+      }
+      else if (channels % 2 == 0) {
+        for (; i < size; ++i) {
+          float64x2_t gains = vsetq_lane_f64(right[i], vdupq_n_f64(left[i]), 1);
+          int c = i * channels;
+          int end = c + channels;
+          for (; c + 4 <= end; c += 4)
+            vst1q_f32(dest + c, scale(vld1q_f32(source + c), gains, gains));
+
+          if (c < end) {
+            float64x2_t pair = vmulq_f64(vcvt_f64_f32(vld1_f32(source + c)), gains);
+            vst1_f32(dest + c, vcvt_f32_f64(pair));
+          }
+        }
+      }
+      scalar::scaleInterleaved(dest + i * channels, source + i * channels,
+                               left + i, right + i, channels, size - i);
+    }
+
+    const Kernels kernels = {
+      add, multiply, correlate, interpolate, bilinearInterpolate, clamp, fill, ramp,
+      scalar::copy, scalar::lookup, isSilent, sumOfSquares, peak, tanh, linearFold, sinFold,
+      scaleInterleaved
+    };
+  } // namespace neon
+#endif
+
+  namespace {
+    const Kernels* kernelsFor(InstructionSet instruction_set) {
+      switch (instruction_set) {
+        case kScalar:
+          return &scalar::kernels;
+#ifdef MOPO_VECTOR_SSE2
+        case kSse2:
+          return &sse2::kernels;
+#endif
+#ifdef MOPO_VECTOR_AVX2
+        case kAvx2:
+          return avx2::supported() ? &avx2::kernels : nullptr;
+#endif
+#ifdef MOPO_VECTOR_NEON
+        case kNeon:
+          return &neon::kernels;
+#endif
+        default:
+          return nullptr;
+      }
+    }
+
+    InstructionSet bestInstructionSet() {
+      for (int i = kNumInstructionSets - 1; i > kScalar; --i) {
+        InstructionSet instruction_set = static_cast<InstructionSet>(i);
+        if (kernelsFor(instruction_set))
+          return instruction_set;
+      }
+      return kScalar;
+    }
+
+    InstructionSet active_instruction_set = kScalar;
+
+    // Kernels start out scalar so anything running during static
+    // initialization is safe, then switch to the best set here.
+    struct KernelSelector {
+      KernelSelector() {
+        setInstructionSet(bestInstructionSet());
+      }
+    };
+
+    const KernelSelector kernel_selector;
+  } // namespace
+
+  const Kernels* active_kernels = &scalar::kernels;
+
+  InstructionSet instructionSet() {
+    return active_instruction_set;
+  }
+
+  bool supportsInstructionSet(InstructionSet instruction_set) {
+    return kernelsFor(instruction_set) != nullptr;
+  }
+
+  bool setInstructionSet(InstructionSet instruction_set) {
+    const Kernels* kernels = kernelsFor(instruction_set);
+    if (kernels == nullptr)
+      return false;
+
+    active_kernels = kernels;
+    active_instruction_set = instruction_set;
+    return true;
+  }
+} // namespace vector_math
+} // namespace mopo
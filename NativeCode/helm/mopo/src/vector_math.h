@@ -0,0 +1,188 @@
+/* Copyright 2013-2017 Matt Tytel
+ *
+ * mopo is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * mopo is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with mopo.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+#ifndef VECTOR_MATH_H
+#define VECTOR_MATH_H
+
+#include "common.h"
+
+namespace mopo {
+
+  // Buffer kernels for the audio rate operators. Each instruction set has its
+  // own implementation and the best one the CPU supports is picked once at
+  // startup. Every kernel except sumOfSquares gives the same bits as the
+  // scalar loop it replaces, as long as the compiler doesn't reassociate
+  // that loop's math. tests/vector_math_test.cpp checks that, and
+  // tests/vector_math_bench.cpp times each kernel.
+  namespace vector_math {
+
+    enum InstructionSet {
+      kScalar,
+      kSse2,
+      kAvx2,
+      kNeon,
+      kNumInstructionSets
+    };
+
+    struct Kernels {
+      void (*add)(mopo_float* dest, const mopo_float* left,
+                  const mopo_float* right, int size);
+      void (*multiply)(mopo_float* dest, const mopo_float* left,
+                       const mopo_float* right, int size);
+      void (*correlate)(mopo_float* dest, const mopo_float* source,
+                        const mopo_float* coefficients, int num_coefficients,
+                        int size);
+      void (*interpolate)(mopo_float* dest, const mopo_float* from,
+                          const mopo_float* to, const mopo_float* t, int size);
+      void (*bilinearInterpolate)(mopo_float* dest,
+                                  const mopo_float* top_left,
+                                  const mopo_float* top_right,
+                                  const mopo_float* bottom_left,
+                                  const mopo_float* bottom_right,
+                                  const mopo_float* x, const mopo_float* y,
+                                  int size);
+      void (*clamp)(mopo_float* dest, const mopo_float* source,
+                    mopo_float min, mopo_float max, int size);
+      void (*fill)(mopo_float* dest, mopo_float value, int size);
+      void (*ramp)(mopo_float* dest, mopo_float start, mopo_float increment,
+                   int size);
+      void (*copy)(mopo_float* dest, const mopo_float* source, int size);
+      void (*lookup)(mopo_float* dest, const mopo_float* source,
+                     const mopo_float* table, mopo_float offset,
+                     mopo_float scale, mopo_float max_index, int size);
+      bool (*isSilent)(const mopo_float* buffer, int size);
+      mopo_float (*sumOfSquares)(const mopo_float* buffer, int size);
+      mopo_float (*peak)(const mopo_float* buffer, int size);
+      void (*tanh)(mopo_float* dest, const mopo_float* source, int size);
+      void (*linearFold)(mopo_float* dest, const mopo_float* source, int size);
+      void (*sinFold)(mopo_float* dest, const mopo_float* source, int size);
+      void (*scaleInterleaved)(float* dest, const float* source,
+                               const mopo_float* left, const mopo_float* right,
+                               int channels, int size);
+    };
+
+    extern const Kernels* active_kernels;
+
+    InstructionSet instructionSet();
+    bool supportsInstructionSet(InstructionSet instruction_set);
+
+    // Returns false and changes nothing if the CPU can't run the set.
+    bool setInstructionSet(InstructionSet instruction_set);
+
+    inline void add(mopo_float* dest, const mopo_float* left,
+                    const mopo_float* right, int size) {
+      active_kernels->add(dest, left, right, size);
+    }
+
+    inline void multiply(mopo_float* dest, const mopo_float* left,
+                         const mopo_float* right, int size) {
+      active_kernels->multiply(dest, left, right, size);
+    }
+
+    // dest[i] = sum of coefficients[k] * source[i + k], which is an FIR
+    // filter with its coefficients reversed. Each output sums its terms in
+    // the order of k. Source needs size + num_coefficients - 1 values.
+    inline void correlate(mopo_float* dest, const mopo_float* source,
+                          const mopo_float* coefficients, int num_coefficients,
+                          int size) {
+      active_kernels->correlate(dest, source, coefficients, num_coefficients, size);
+    }
+
+    // dest = t * (to - from) + from, like utils::interpolate.
+    inline void interpolate(mopo_float* dest, const mopo_float* from,
+                            const mopo_float* to, const mopo_float* t, int size) {
+      active_kernels->interpolate(dest, from, to, t, size);
+    }
+
+    inline void bilinearInterpolate(mopo_float* dest,
+                                    const mopo_float* top_left,
+                                    const mopo_float* top_right,
+                                    const mopo_float* bottom_left,
+                                    const mopo_float* bottom_right,
+                                    const mopo_float* x, const mopo_float* y,
+                                    int size) {
+      active_kernels->bilinearInterpolate(dest, top_left, top_right,
+                                          bottom_left, bottom_right, x, y, size);
+    }
+
+    inline void clamp(mopo_float* dest, const mopo_float* source,
+                      mopo_float min, mopo_float max, int size) {
+      active_kernels->clamp(dest, source, min, max, size);
+    }
+
+    inline void fill(mopo_float* dest, mopo_float value, int size) {
+      active_kernels->fill(dest, value, size);
+    }
+
+    // dest[i] = start + i * increment.
+    inline void ramp(mopo_float* dest, mopo_float start, mopo_float increment,
+                     int size) {
+      active_kernels->ramp(dest, start, increment, size);
+    }
+
+    inline void copy(mopo_float* dest, const mopo_float* source, int size) {
+      active_kernels->copy(dest, source, size);
+    }
+
+    // Linearly interpolated table lookup at
+    // index = clamp((source - offset) * scale, 0, max_index).
+    // The table needs max_index + 2 entries.
+    inline void lookup(mopo_float* dest, const mopo_float* source,
+                       const mopo_float* table, mopo_float offset,
+                       mopo_float scale, mopo_float max_index, int size) {
+      active_kernels->lookup(dest, source, table, offset, scale, max_index, size);
+    }
+
+    inline bool isSilent(const mopo_float* buffer, int size) {
+      return active_kernels->isSilent(buffer, size);
+    }
+
+    // Sums in a different order per instruction set, so the last bits vary.
+    inline mopo_float sumOfSquares(const mopo_float* buffer, int size) {
+      return active_kernels->sumOfSquares(buffer, size);
+    }
+
+    inline mopo_float peak(const mopo_float* buffer, int size) {
+      return active_kernels->peak(buffer, size);
+    }
+
+    // utils::quickTanh of every value.
+    inline void tanh(mopo_float* dest, const mopo_float* source, int size) {
+      active_kernels->tanh(dest, source, size);
+    }
+
+    // utils::linearFold and utils::sinFold of every value.
+    inline void linearFold(mopo_float* dest, const mopo_float* source, int size) {
+      active_kernels->linearFold(dest, source, size);
+    }
+
+    inline void sinFold(mopo_float* dest, const mopo_float* source, int size) {
+      active_kernels->sinFold(dest, source, size);
+    }
+
+    // Scales _size_ frames of interleaved float samples, even channels by
+    // _left_ and odd channels by _right_, rounding each product to float.
+    // Source and dest may be the same memory.
+    inline void scaleInterleaved(float* dest, const float* source,
+                                 const mopo_float* left, const mopo_float* right,
+                                 int channels, int size) {
+      active_kernels->scaleInterleaved(dest, source, left, right, channels, size);
+    }
+  } // namespace vector_math
+} // namespace mopo
+
+#endif // VECTOR_MATH_H
@@ -16,12 +16,21 @@
 
 #include "voice_handler.h"
 
+#include "processor_state.h"
 #include "utils.h"
 
+#include <algorithm>
+#include <set>
+
 namespace mopo {
 
-  Voice::Voice(Processor* processor) : event_sample_(-1),
-      aftertouch_sample_(-1), aftertouch_(0.0), processor_(processor) {
+  namespace {
+    const unsigned int RANDOM_SEED_MULT = 2654435761u;
+  } // namespace
+
+  Voice::Voice(Processor* processor, unsigned int random_seed) :
+      event_sample_(-1), aftertouch_sample_(-1), aftertouch_(0.0),
+      random_state_(random_seed), processor_(processor), worker_(0) {
     state_.event = kVoiceOff;
     state_.note = 0;
     state_.velocity = 0;
@@ -37,7 +46,8 @@ namespace mopo {
 
   VoiceHandler::VoiceHandler(size_t polyphony) :
       ProcessorRouter(kNumInputs, 0), polyphony_(0), sustain_(false),
-      legato_(false), voice_killer_(0), last_played_note_(-1.0) {
+      legato_(false), voice_killer_(0), last_played_note_(-1.0),
+      num_threads_(1) {
     pressed_notes_.reserve(MIDI_SIZE);
     all_voices_.reserve(MAX_POLYPHONY);
     free_voices_.reserve(MAX_POLYPHONY);
@@ -49,6 +59,7 @@ namespace mopo {
 }
 
   VoiceHandler::~VoiceHandler() {
+    clearWorkerPorts();
     voice_router_.destroy();
     global_router_.destroy();
 
@@ -62,35 +73,35 @@ namespace mopo {
       delete output.second;
   }
 
-  void VoiceHandler::prepareVoiceTriggers(Voice* voice) {
-    note_.clearTrigger();
-    last_note_.clearTrigger();
-    note_pressed_.clearTrigger();
-    channel_.clearTrigger();
-    velocity_.clearTrigger();
-    voice_event_.clearTrigger();
-    aftertouch_.clearTrigger();
-    channel_.buffer[0] = voice->state().channel;
+  void VoiceHandler::prepareVoiceTriggers(Voice* voice, Output** triggers) {
+    for (int i = 0; i < kNumVoiceTriggers; ++i)
+      triggers[i]->clearTrigger();
+    triggers[kChannelTrigger]->buffer[0] = voice->state().channel;
 
     if (voice->hasNewEvent()) {
-      voice_event_.trigger(voice->state().event, voice->event_sample());
+      triggers[kVoiceEventTrigger]->trigger(voice->state().event,
+                                            voice->event_sample());
       if (voice->state().event == kVoiceOn) {
-        note_.trigger(voice->state().note, 0);
-        last_note_.trigger(voice->state().last_note, 0);
-        velocity_.trigger(voice->state().velocity, 0);
-        note_pressed_.trigger(voice->state().note_pressed, 0);
-        channel_.trigger(voice->state().channel, 0);
+        triggers[kNoteTrigger]->trigger(voice->state().note, 0);
+        triggers[kLastNoteTrigger]->trigger(voice->state().last_note, 0);
+        triggers[kVelocityTrigger]->trigger(voice->state().velocity, 0);
+        triggers[kNotePressedTrigger]->trigger(voice->state().note_pressed, 0);
+        triggers[kChannelTrigger]->trigger(voice->state().channel, 0);
       }
     }
 
-    if (voice->hasNewAftertouch())
-      aftertouch_.trigger(voice->aftertouch(), voice->aftertouch_sample());
+    if (voice->hasNewAftertouch()) {
+      triggers[kAftertouchTrigger]->trigger(voice->aftertouch(),
+                                            voice->aftertouch_sample());
+    }
 
     voice->clearEvents();
   }
 
   void VoiceHandler::processVoice(Voice* voice) {
+    utils::randomState() = voice->random_state();
     voice->processor()->process();
+    utils::randomState() = nullptr;
   }
 
   void VoiceHandler::clearAccumulatedOutputs() {
@@ -143,14 +154,29 @@ namespace mopo {
       return;
     }
 
+    // Voices are only built off the audio thread, so polyphony can't go past
+    // the ones prepareVoices made.
     int polyphony = static_cast<int>(input(kPolyphony)->at(0));
-    setPolyphony(utils::iclamp(polyphony, 1, polyphony));
+    setPolyphony(utils::iclamp(polyphony, 1, getNumVoices()));
     clearAccumulatedOutputs();
+    MOPO_ASSERT(!workerPortsStale());
+
+    if (num_threads_ > 1 && active_voices_.size() > 1) {
+      processVoicesInParallel();
+      last_num_voices_ = num_voices;
+      return;
+    }
+
+    Output* triggers[kNumVoiceTriggers] = {
+      &voice_event_, &note_, &last_note_, &note_pressed_,
+      &channel_, &velocity_, &aftertouch_
+    };
 
     auto iter = active_voices_.begin();
     while (iter != active_voices_.end()) {
       Voice* voice = *iter;
-      prepareVoiceTriggers(voice);
+      bindVoice(voice, 0);
+      prepareVoiceTriggers(voice, triggers);
       processVoice(voice);
       accumulateOutputs();
 
@@ -186,6 +212,99 @@ namespace mopo {
       all_voices_[i]->processor()->setBufferSize(buffer_size);
   }
 
+  void VoiceHandler::syncState(ProcessorState* state) {
+    global_router_.syncState(state);
+
+    int num_voices = all_voices_.size();
+    state->sync(num_voices);
+    if (state->loading() && (num_voices < 0 || num_voices > MAX_POLYPHONY))
+      state->invalidate();
+
+    if (state->loading() && state->valid()) {
+      // Loading runs off the audio thread, so it can build missing voices.
+      if (getNumVoices() < num_voices)
+        prepareVoices(num_voices);
+    }
+
+    for (int i = 0; i < num_voices && state->valid(); ++i) {
+      Voice* voice = all_voices_[i];
+      state->sync(voice->event_sample_);
+      state->sync(voice->state_);
+      state->sync(voice->key_state_);
+      state->sync(voice->aftertouch_sample_);
+      state->sync(voice->aftertouch_);
+      state->sync(voice->random_state_);
+      voice->processor_->syncState(state);
+    }
+
+    syncVoiceQueue(state, free_voices_, num_voices);
+    syncVoiceQueue(state, active_voices_, num_voices);
+    state->syncQueue(pressed_notes_);
+    state->sync(polyphony_);
+    state->sync(sustain_);
+    state->sync(last_played_note_);
+    state->sync(last_num_voices_);
+
+    if (state->saving())
+      return;
+
+    if (state->valid()) {
+      // Voices beyond the saved ones go back to the free pool.
+      for (int i = num_voices; i < all_voices_.size(); ++i)
+        free_voices_.push_back(all_voices_[i]);
+      return;
+    }
+
+    // Nothing read can be trusted, so every voice is made free again.
+    free_voices_.clear();
+    active_voices_.clear();
+    pressed_notes_.clear();
+    for (int i = 0; i < all_voices_.size(); ++i) {
+      all_voices_[i]->kill();
+      free_voices_.push_back(all_voices_[i]);
+    }
+    sustain_ = false;
+  }
+
+  // The state holds the global processors, then each voice's copy of the
+  // voice router.
+  unsigned int VoiceHandler::getLayoutHash(unsigned int hash) const {
+    return voice_router_.getLayoutHash(global_router_.getLayoutHash(hash));
+  }
+
+  void VoiceHandler::syncVoiceQueue(ProcessorState* state,
+                                    CircularQueue<Voice*>& voices,
+                                    int num_voices) {
+    int size = voices.size();
+    state->sync(size);
+
+    if (state->saving()) {
+      for (int i = 0; i < size; ++i) {
+        int index = 0;
+        while (all_voices_[index] != voices[i])
+          index++;
+        state->sync(index);
+      }
+      return;
+    }
+
+    voices.clear();
+    if (size < 0 || size > num_voices) {
+      state->invalidate();
+      return;
+    }
+
+    for (int i = 0; i < size && state->valid(); ++i) {
+      int index = 0;
+      state->sync(index);
+      if (index < 0 || index >= num_voices) {
+        state->invalidate();
+        return;
+      }
+      voices.push_back(all_voices_[index]);
+    }
+  }
+
   int VoiceHandler::getNumActiveVoices() {
     return active_voices_.size();
   }
@@ -401,11 +520,458 @@ namespace mopo {
     return output;
   }
 
+  const Output* VoiceHandler::getVoiceOutput(const Output* registered) const {
+    for (auto& output : accumulated_outputs_) {
+      if (output.second == registered)
+        return output.first;
+    }
+    for (auto& output : last_voice_outputs_) {
+      if (output.second == registered)
+        return output.first;
+    }
+    return nullptr;
+  }
+
   bool VoiceHandler::isPolyphonic(const Processor* processor) const {
     return processor == &voice_router_;
   }
 
+  void VoiceHandler::prepareVoices(int num_voices) {
+    num_voices = utils::iclamp(num_voices, 1, MAX_POLYPHONY);
+    while (getNumVoices() < num_voices) {
+      Voice* new_voice = createVoice();
+      all_voices_.push_back(new_voice);
+      free_voices_.push_back(new_voice);
+    }
+
+    // Loading the copies also brings each voice's routers up to date, so
+    // they don't clone anything when they next process.
+    updateWorkerPorts();
+    for (Voice* voice : all_voices_)
+      loadVoiceCopies(voice);
+  }
+
   Voice* VoiceHandler::createVoice() {
-    return new Voice(voice_router_.clone());
+    // Keep each voice's processors together and in processing order.
+    ProcessorArena arena;
+    int num_voices = all_voices_.size();
+    unsigned int random_seed = (num_voices + 1) * RANDOM_SEED_MULT;
+    return new Voice(voice_router_.clone(), random_seed);
+  }
+
+  void VoiceHandler::setNumThreads(int num_threads) {
+    num_threads = utils::iclamp(num_threads, 1, MAX_POLYPHONY);
+    if (num_threads == num_threads_)
+      return;
+
+    clearWorkerPorts();
+    worker_pool_.setNumWorkers(num_threads);
+    num_threads_ = num_threads;
+    updateWorkerPorts();
+  }
+
+  void VoiceHandler::processVoicesInParallel() {
+    ordered_voices_.clear();
+    for (Voice* voice : active_voices_)
+      ordered_voices_.push_back(voice);
+
+    int num_voices = ordered_voices_.size();
+    int num_accumulated = accumulated_outputs_.size();
+    MOPO_ASSERT(static_cast<int>(voice_silent_.size()) >= num_voices);
+    MOPO_ASSERT(static_cast<int>(voice_results_.size()) >=
+                num_voices * num_accumulated * MAX_BUFFER_SIZE);
+
+    // Give each worker a run of voices in order. The last run stays on this
+    // thread so the shared outputs end the block holding the last voice, the
+    // same as when voices render one after another.
+    int num_workers = std::min(num_threads_, num_voices);
+    int voice_index = 0;
+    for (int i = 0; i < num_workers; ++i) {
+      int worker = (i + 1) % num_workers;
+      WorkerPorts* ports = worker_ports_[worker];
+      ports->first_voice = voice_index;
+      ports->num_voices = num_voices / num_workers + (i < num_voices % num_workers);
+
+      for (int v = 0; v < ports->num_voices; ++v)
+        bindVoice(ordered_voices_[voice_index + v], worker);
+      voice_index += ports->num_voices;
+    }
+
+    for (int i = 1; i < num_workers; ++i)
+      syncWorkerPorts(worker_ports_[i]);
+
+    worker_pool_.run(renderWorkerVoices, this, num_workers);
+
+    // Sum in voice order so rounding matches rendering on one thread.
+    for (int v = 0; v < num_voices; ++v) {
+      const mopo_float* results = voice_results_.data() +
+                                  v * num_accumulated * MAX_BUFFER_SIZE;
+      for (auto& output : accumulated_outputs_) {
+        int buffer_size = output.first->owner->getBufferSize();
+        mopo_float* dest = output.second->buffer;
+
+        VECTORIZE_LOOP
+        for (int i = 0; i < buffer_size; ++i)
+          dest[i] += results[i];
+        results += MAX_BUFFER_SIZE;
+      }
+
+      Voice* voice = ordered_voices_[v];
+      if (voice_silent_[v] && voice->state().event != kVoiceOn) {
+        free_voices_.push_back(voice);
+        active_voices_.remove(voice);
+      }
+    }
+
+    if (active_voices_.size())
+      writeNonaccumulatedOutputs();
+  }
+
+  void VoiceHandler::renderWorkerVoices(void* voice_handler, int worker) {
+    static_cast<VoiceHandler*>(voice_handler)->renderWorkerVoices(worker);
+  }
+
+  void VoiceHandler::renderWorkerVoices(int worker) {
+    WorkerPorts* ports = worker_ports_[worker];
+    int num_accumulated = ports->accumulated_outputs.size();
+
+    int end = ports->first_voice + ports->num_voices;
+    for (int v = ports->first_voice; v < end; ++v) {
+      Voice* voice = ordered_voices_[v];
+      prepareVoiceTriggers(voice, ports->triggers);
+      processVoice(voice);
+
+      mopo_float* results = voice_results_.data() +
+                            v * num_accumulated * MAX_BUFFER_SIZE;
+      for (Output* output : ports->accumulated_outputs) {
+        int buffer_size = output->owner->getBufferSize();
+        utils::copyBuffer(results, output->buffer, buffer_size);
+        results += MAX_BUFFER_SIZE;
+      }
+
+      const Output* killer = ports->voice_killer;
+      voice_silent_[v] = killer && utils::isSilent(killer->buffer, buffer_size_);
+    }
+  }
+
+  bool VoiceHandler::workerPortsStale() {
+    if (worker_ports_.empty())
+      return true;
+
+    WorkerPorts* prototype_ports = worker_ports_[0];
+    if (prototype_ports->voice_killer != voice_killer_ ||
+        prototype_ports->accumulated_outputs.size() != accumulated_outputs_.size()) {
+      return true;
+    }
+
+    // Routers are listed before the routers nested in them, so we stop at a
+    // changed parent before looking at a child it may have removed.
+    int num_routers = prototype_routers_.size();
+    for (int i = 0; i < num_routers; ++i) {
+      if (prototype_routers_[i]->getGraphRevision() != router_revisions_[i])
+        return true;
+    }
+    return false;
+  }
+
+  void VoiceHandler::updateWorkerPorts() {
+    if (!workerPortsStale())
+      return;
+
+    clearWorkerPorts();
+
+    prototype_copies_.push_back(std::make_pair(&voice_router_, &voice_router_));
+    voice_router_.getProcessorCopies(&prototype_copies_);
+    for (auto& copy : prototype_copies_) {
+      const ProcessorRouter* router =
+          dynamic_cast<const ProcessorRouter*>(copy.first);
+      if (router) {
+        prototype_routers_.push_back(router);
+        router_revisions_.push_back(router->getGraphRevision());
+      }
+    }
+
+    // Voice outputs that are never needed at the same time share buffers.
+    // Worker copies of the outputs share the same way.
+    std::vector<Processor*> order;
+    for (auto& copy : prototype_copies_)
+      order.push_back(copy.second);
+
+    std::set<const Output*> kept;
+    kept.insert(voice_killer_);
+    for (auto& output : accumulated_outputs_)
+      kept.insert(output.first);
+    for (auto& output : last_voice_outputs_)
+      kept.insert(output.first);
+    kept.insert(switchable_outputs_.begin(), switchable_outputs_.end());
+    buffer_pool_.plan(order, kept);
+
+    // Worker zero renders against the prototype's own ports.
+    WorkerPorts* prototype_ports = new WorkerPorts();
+    prototype_ports->owns_ports = false;
+    std::set<const Output*> voice_outputs;
+    for (auto& copy : prototype_copies_) {
+      prototype_ports->inputs.push_back(copy.second->inputPorts());
+      prototype_ports->outputs.push_back(copy.second->outputPorts());
+
+      for (Output* output : *copy.second->outputPorts()) {
+        if (output && voice_outputs.insert(output).second) {
+          int index = prototype_ports->voice_outputs.size();
+          if (voice_output_buffers_.count(output->ownBuffer()) == 0)
+            voice_output_buffers_[output->ownBuffer()] = index;
+          prototype_ports->voice_outputs.push_back(output);
+        }
+      }
+    }
+
+    Output* triggers[kNumVoiceTriggers] = {
+      &voice_event_, &note_, &last_note_, &note_pressed_,
+      &channel_, &velocity_, &aftertouch_
+    };
+    for (int i = 0; i < kNumVoiceTriggers; ++i) {
+      int index = prototype_ports->voice_outputs.size();
+      voice_output_buffers_[triggers[i]->ownBuffer()] = index;
+      prototype_ports->voice_outputs.push_back(triggers[i]);
+      prototype_ports->triggers[i] = triggers[i];
+    }
+
+    // Voices also read outputs from outside the voice graph. Those can be
+    // switched onto a voice output's buffer, so workers read them through
+    // their own stand-ins.
+    std::set<const Output*> outside_sources;
+    for (auto& copy : prototype_copies_) {
+      for (Input* input : *copy.second->inputPorts()) {
+        if (input && voice_output_buffers_.count(input->source->ownBuffer()) == 0)
+          outside_sources.insert(input->source);
+      }
+    }
+    outside_sources_.assign(outside_sources.begin(), outside_sources.end());
+
+    for (auto& output : accumulated_outputs_)
+      prototype_ports->accumulated_outputs.push_back(output.first);
+    prototype_ports->voice_killer = voice_killer_;
+    worker_ports_.push_back(prototype_ports);
+
+    for (int i = 1; i < num_threads_; ++i) {
+      WorkerPorts* ports = new WorkerPorts();
+      createWorkerPorts(ports);
+      worker_ports_.push_back(ports);
+    }
+
+    int num_accumulated = accumulated_outputs_.size();
+    ordered_voices_.reserve(MAX_POLYPHONY);
+    voice_silent_.resize(MAX_POLYPHONY);
+    voice_results_.resize(MAX_POLYPHONY * num_accumulated * MAX_BUFFER_SIZE);
+  }
+
+  void VoiceHandler::createWorkerPorts(WorkerPorts* ports) {
+    WorkerPorts* prototype_ports = worker_ports_[0];
+    ports->owns_ports = true;
+
+    // Keep each worker's outputs and their buffers together.
+    ProcessorArena arena;
+
+    std::map<const Output*, Output*> output_copies;
+    for (Output* output : prototype_ports->voice_outputs) {
+      // Copies of outputs in the buffer pool never get a buffer of their own.
+      int index = ports->voice_outputs.size();
+      int shared = voice_output_buffers_[output->ownBuffer()];
+      Output* copy = nullptr;
+      if (shared == index)
+        copy = new Output(output->buffer_size);
+      else
+        copy = new Output(output->buffer_size, ports->voice_outputs[shared]->ownBuffer());
+      copy->owner = output->owner;
+
+      ports->voice_outputs.push_back(copy);
+      output_copies[output] = copy;
+    }
+
+    for (const Output* source : outside_sources_) {
+      Output* stand_in = new Output(1);
+      stand_in->owner = source->owner;
+      ports->outside_outputs.push_back(stand_in);
+      output_copies[source] = stand_in;
+    }
+
+    auto copyOf = [&](const Output* output) -> const Output* {
+      auto found = output_copies.find(output);
+      return found == output_copies.end() ? output : found->second;
+    };
+
+    std::map<const Input*, Input*> input_copies;
+    for (auto& copy : prototype_copies_) {
+      std::vector<Input*>* inputs = new std::vector<Input*>();
+      for (Input* input : *copy.second->inputPorts()) {
+        if (input == nullptr) {
+          inputs->push_back(nullptr);
+          continue;
+        }
+
+        if (input_copies.count(input) == 0) {
+          input_copies[input] = new Input();
+          input_copies[input]->source = copyOf(input->source);
+        }
+        inputs->push_back(input_copies[input]);
+      }
+      ports->inputs.push_back(inputs);
+
+      std::vector<Output*>* outputs = new std::vector<Output*>();
+      for (Output* output : *copy.second->outputPorts())
+        outputs->push_back(output ? output_copies[output] : nullptr);
+      ports->outputs.push_back(outputs);
+    }
+
+    for (int i = 0; i < kNumVoiceTriggers; ++i)
+      ports->triggers[i] = output_copies[prototype_ports->triggers[i]];
+    for (Output* output : prototype_ports->accumulated_outputs)
+      ports->accumulated_outputs.push_back(const_cast<Output*>(copyOf(output)));
+    ports->voice_killer = copyOf(voice_killer_);
+  }
+
+  void VoiceHandler::deleteWorkerPorts(WorkerPorts* ports) {
+    if (ports->owns_ports) {
+      std::set<Input*> inputs;
+      for (std::vector<Input*>* input_ports : ports->inputs) {
+        inputs.insert(input_ports->begin(), input_ports->end());
+        delete input_ports;
+      }
+      inputs.erase(nullptr);
+      for (Input* input : inputs)
+        delete input;
+
+      for (std::vector<Output*>* output_ports : ports->outputs)
+        delete output_ports;
+      for (Output* output : ports->voice_outputs)
+        delete output;
+      for (Output* output : ports->outside_outputs)
+        delete output;
+    }
+
+    delete ports;
+  }
+
+  void VoiceHandler::clearWorkerPorts() {
+    // Everything goes back on the prototype's ports before the copies go.
+    for (Voice* voice : all_voices_)
+      bindVoice(voice, 0);
+
+    for (WorkerPorts* ports : worker_ports_)
+      deleteWorkerPorts(ports);
+    worker_ports_.clear();
+
+    for (Voice* voice : all_voices_)
+      voice->copies_.clear();
+    prototype_copies_.clear();
+    prototype_routers_.clear();
+    router_revisions_.clear();
+    voice_output_buffers_.clear();
+    outside_sources_.clear();
+    buffer_pool_.release();
+  }
+
+  void VoiceHandler::setSwitchableProcessors(const std::vector<Processor*>& processors) {
+    std::set<const Output*> switchable_outputs;
+    for (Processor* processor : processors) {
+      for (Output* output : *processor->outputPorts()) {
+        if (output && output->owner == processor)
+          switchable_outputs.insert(output);
+      }
+    }
+
+    if (switchable_outputs != switchable_outputs_) {
+      switchable_outputs_ = switchable_outputs;
+      clearWorkerPorts();
+    }
+  }
+
+  void VoiceHandler::enableVoiceProcessors(const std::vector<Processor*>& processors,
+                                           bool enable) {
+    for (Processor* processor : processors) {
+      processor->enable(enable);
+      if (enable)
+        continue;
+
+      for (Output* output : *processor->outputPorts()) {
+        if (output && output->owner == processor) {
+          MOPO_ASSERT(switchable_outputs_.count(output));
+          output->clearBuffer();
+        }
+      }
+    }
+  }
+
+  void VoiceHandler::syncWorkerPorts(WorkerPorts* ports) {
+    const std::vector<Output*>& originals = worker_ports_[0]->voice_outputs;
+    int num_outputs = originals.size();
+
+    for (int i = 0; i < num_outputs; ++i) {
+      const Output* original = originals[i];
+      Output* copy = ports->voice_outputs[i];
+      copy->triggered = original->triggered;
+      copy->trigger_offset = original->trigger_offset;
+      copy->trigger_value = original->trigger_value;
+
+      // Follow outputs that pass through another output's buffer.
+      mopo_float* own_buffer = original->ownBuffer();
+      if (original->buffer == own_buffer)
+        copy->buffer = copy->ownBuffer();
+      else
+        copy->buffer = copyOfBuffer(ports, original->buffer);
+
+      // Running processors rewrite their buffers, but anything switched off
+      // keeps what it last held and that has to match too.
+      if (original->buffer_size == 1 || !willRender(original->owner))
+        utils::copyBuffer(copy->ownBuffer(), own_buffer, original->buffer_size);
+    }
+
+    int num_outside = outside_sources_.size();
+    for (int i = 0; i < num_outside; ++i) {
+      const Output* source = outside_sources_[i];
+      Output* stand_in = ports->outside_outputs[i];
+      stand_in->triggered = source->triggered;
+      stand_in->trigger_offset = source->trigger_offset;
+      stand_in->trigger_value = source->trigger_value;
+      stand_in->buffer = copyOfBuffer(ports, source->buffer);
+    }
+  }
+
+  mopo_float* VoiceHandler::copyOfBuffer(WorkerPorts* ports, mopo_float* buffer) {
+    auto found = voice_output_buffers_.find(buffer);
+    if (found == voice_output_buffers_.end())
+      return buffer;
+    return ports->voice_outputs[found->second]->ownBuffer();
+  }
+
+  bool VoiceHandler::willRender(const Processor* processor) {
+    while (processor && processor != &voice_router_) {
+      if (!processor->enabled())
+        return false;
+      processor = processor->router();
+    }
+    return true;
+  }
+
+  void VoiceHandler::loadVoiceCopies(Voice* voice) {
+    if (!voice->copies_.empty())
+      return;
+
+    ProcessorRouter* router = dynamic_cast<ProcessorRouter*>(voice->processor());
+    voice->copies_.push_back(std::make_pair(&voice_router_, router));
+    router->getProcessorCopies(&voice->copies_);
+    MOPO_ASSERT(voice->copies_.size() == prototype_copies_.size());
+  }
+
+  void VoiceHandler::bindVoice(Voice* voice, int worker) {
+    if (voice->worker_ == worker)
+      return;
+
+    loadVoiceCopies(voice);
+
+    WorkerPorts* ports = worker_ports_[worker];
+    int num_copies = voice->copies_.size();
+    for (int i = 0; i < num_copies; ++i)
+      voice->copies_[i].second->setPorts(ports->inputs[i], ports->outputs[i]);
+    voice->worker_ = worker;
   }
 } // namespace mopo
@@ -18,13 +18,17 @@
 #ifndef VOICE_HANDLER_H
 #define VOICE_HANDLER_H
 
+#include "buffer_pool.h"
 #include "circular_queue.h"
 #include "note_handler.h"
 #include "processor_router.h"
 #include "value.h"
+#include "worker_pool.h"
 
 #include <map>
 #include <list>
+#include <set>
+#include <vector>
 
 namespace mopo {
 
@@ -46,10 +50,11 @@ namespace mopo {
         kNumStates
       };
 
-      Voice(Processor* voice);
+      Voice(Processor* voice, unsigned int random_seed = 1);
       virtual ~Voice();
 
       Processor* processor() { return processor_; }
+      unsigned int* random_state() { return &random_state_; }
       const VoiceState& state() { return state_; }
       const KeyState key_state() { return key_state_; }
       int event_sample() { return event_sample_; }
@@ -114,8 +119,15 @@ namespace mopo {
 
       int aftertouch_sample_;
       mopo_float aftertouch_;
+      unsigned int random_state_;
 
       Processor* processor_;
+
+      // Which worker's ports the processors are using and where they are.
+      int worker_;
+      std::vector<std::pair<const Processor*, Processor*>> copies_;
+
+      friend class VoiceHandler;
   };
 
   class VoiceHandler : public virtual ProcessorRouter, public NoteHandler {
@@ -137,6 +149,8 @@ namespace mopo {
       virtual void process() override;
       virtual void setSampleRate(int sample_rate) override;
       virtual void setBufferSize(int buffer_size) override;
+      virtual void syncState(ProcessorState* state) override;
+      virtual unsigned int getLayoutHash(unsigned int hash) const override;
       int getNumActiveVoices();
       CircularQueue<mopo_float>& getPressedNotes() { return pressed_notes_; }
       bool isNotePlaying(mopo_float note);
@@ -172,6 +186,42 @@ namespace mopo {
 
       void setPolyphony(size_t polyphony);
 
+      // Creates voices up to _num_voices_ and builds every voice's copy of
+      // the voice graph and the worker ports. Whatever changes the voice
+      // graph or raises the polyphony input past getNumVoices() has to call
+      // this before the next process(), which only asserts the ports are
+      // current and never creates voices, so the cloning and allocating
+      // happen on the thread that made the change.
+      void prepareVoices(int num_voices);
+
+      // Voices created so far. Notes past the polyphony still take free ones
+      // while the voices they replace fade out.
+      int getNumVoices() const { return all_voices_.size(); }
+
+      // Spreads the active voices over up to _num_threads_ threads. Each
+      // thread renders against its own copy of the voice ports and the
+      // results are summed in voice order, so the output is the same as
+      // rendering every voice on the calling thread. The ports are rebuilt
+      // here for the new thread count.
+      void setNumThreads(int num_threads);
+      int getNumThreads() const { return num_threads_; }
+
+      // Bytes of audio output buffer rendering one voice touches, before and
+      // after voice outputs that don't overlap share buffers. The shared
+      // figure is what the cache sees.
+      int getVoiceWorkingSetSize() const { return buffer_pool_.workingSetSize(); }
+      int getSharedVoiceWorkingSetSize() const {
+        return buffer_pool_.sharedWorkingSetSize();
+      }
+
+      // Bytes of audio output buffer the voice graph holds, before and after
+      // sharing. Voices render through one set of outputs per thread, so
+      // each thread past the first holds the shared figure again.
+      int getVoiceBufferSize() const { return buffer_pool_.allocatedSize(); }
+      int getSharedVoiceBufferSize() const {
+        return buffer_pool_.sharedAllocatedSize();
+      }
+
       void setVoiceKiller(const Output* killer) {
         voice_killer_ = killer;
       }
@@ -184,19 +234,75 @@ namespace mopo {
         setVoiceKiller(killer->output());
       }
 
+      const Output* getVoiceKiller() const { return voice_killer_; }
+
+      // The voice output behind an output registerOutput returned, or null.
+      const Output* getVoiceOutput(const Output* registered) const;
+
       bool isPolyphonic(const Processor* processor) const override;
 
     protected:
       virtual bool shouldAccumulate(Output* output);
 
+      // Lets these processors, and no others, be turned on and off for every
+      // voice while voices render. Their outputs keep their own buffers, so
+      // switching them needs no new buffer plan. Changing the set rebuilds the
+      // worker ports on the next prepareVoices().
+      void setSwitchableProcessors(const std::vector<Processor*>& processors);
+
+      // Turns switchable voice processors on or off for every voice. Outputs
+      // of processors turned off read as silence.
+      void enableVoiceProcessors(const std::vector<Processor*>& processors, bool enable);
+
     private:
+      enum VoiceTriggers {
+        kVoiceEventTrigger,
+        kNoteTrigger,
+        kLastNoteTrigger,
+        kNotePressedTrigger,
+        kChannelTrigger,
+        kVelocityTrigger,
+        kAftertouchTrigger,
+        kNumVoiceTriggers
+      };
+
+      // One thread's copy of every port in the voice graph.
+      struct WorkerPorts {
+        std::vector<std::vector<Input*>*> inputs;
+        std::vector<std::vector<Output*>*> outputs;
+        std::vector<Output*> voice_outputs;
+        std::vector<Output*> outside_outputs;
+        std::vector<Output*> accumulated_outputs;
+        Output* triggers[kNumVoiceTriggers];
+        const Output* voice_killer;
+        bool owns_ports;
+
+        int first_voice;
+        int num_voices;
+      };
+
       VoiceHandler() { }
 
       Voice* grabVoice();
       Voice* getVoiceToKill();
       Voice* createVoice();
-      void prepareVoiceTriggers(Voice* voice);
+      void syncVoiceQueue(ProcessorState* state, CircularQueue<Voice*>& voices,
+                          int num_voices);
+      void prepareVoiceTriggers(Voice* voice, Output** triggers);
       void processVoice(Voice* voice);
+      void processVoicesInParallel();
+      void renderWorkerVoices(int worker);
+      static void renderWorkerVoices(void* voice_handler, int worker);
+      bool workerPortsStale();
+      void updateWorkerPorts();
+      void createWorkerPorts(WorkerPorts* ports);
+      void deleteWorkerPorts(WorkerPorts* ports);
+      void clearWorkerPorts();
+      void syncWorkerPorts(WorkerPorts* ports);
+      bool willRender(const Processor* processor);
+      mopo_float* copyOfBuffer(WorkerPorts* ports, mopo_float* buffer);
+      void loadVoiceCopies(Voice* voice);
+      void bindVoice(Voice* voice, int worker);
       void clearAccumulatedOutputs();
       void clearNonaccumulatedOutputs();
       void accumulateOutputs();
@@ -227,6 +333,21 @@ namespace mopo {
 
       ProcessorRouter voice_router_;
       ProcessorRouter global_router_;
+
+      int num_threads_;
+      WorkerPool worker_pool_;
+      std::vector<WorkerPorts*> worker_ports_;
+      std::vector<std::pair<const Processor*, Processor*>> prototype_copies_;
+      std::vector<const ProcessorRouter*> prototype_routers_;
+      std::map<const mopo_float*, int> voice_output_buffers_;
+      std::vector<const Output*> outside_sources_;
+      std::vector<int> router_revisions_;
+      BufferPool buffer_pool_;
+      std::set<const Output*> switchable_outputs_;
+
+      std::vector<Voice*> ordered_voices_;
+      std::vector<mopo_float> voice_results_;
+      std::vector<char> voice_silent_;
   };
 } // namespace mopo
 
@@ -251,7 +251,7 @@ namespace mopo {
       }
 
       static inline mopo_float whitenoise() {
-        return (2.0 * rand()) / RAND_MAX - 1;
+        return (2.0 * utils::random()) / RAND_MAX - 1;
       }
 
       static inline mopo_float fullsin(mopo_float t) {
@@ -0,0 +1,162 @@
+/* Copyright 2013-2017 Matt Tytel
+ *
+ * mopo is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * mopo is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with mopo.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "worker_pool.h"
+
+#include "common.h"
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#elif defined(__APPLE__)
+#include <dispatch/dispatch.h>
+#else
+#include <cerrno>
+#include <semaphore.h>
+#endif
+
+namespace mopo {
+
+#if defined(_WIN32)
+  WorkerSemaphore::WorkerSemaphore() {
+    semaphore_ = CreateSemaphore(nullptr, 0, MAXLONG, nullptr);
+  }
+
+  WorkerSemaphore::~WorkerSemaphore() {
+    CloseHandle(static_cast<HANDLE>(semaphore_));
+  }
+
+  void WorkerSemaphore::post() {
+    ReleaseSemaphore(static_cast<HANDLE>(semaphore_), 1, nullptr);
+  }
+
+  void WorkerSemaphore::wait() {
+    WaitForSingleObject(static_cast<HANDLE>(semaphore_), INFINITE);
+  }
+#elif defined(__APPLE__)
+  WorkerSemaphore::WorkerSemaphore() {
+    semaphore_ = dispatch_semaphore_create(0);
+  }
+
+  WorkerSemaphore::~WorkerSemaphore() {
+    dispatch_release(static_cast<dispatch_semaphore_t>(semaphore_));
+  }
+
+  void WorkerSemaphore::post() {
+    dispatch_semaphore_signal(static_cast<dispatch_semaphore_t>(semaphore_));
+  }
+
+  void WorkerSemaphore::wait() {
+    dispatch_semaphore_wait(static_cast<dispatch_semaphore_t>(semaphore_),
+                            DISPATCH_TIME_FOREVER);
+  }
+#else
+  WorkerSemaphore::WorkerSemaphore() {
+    sem_t* semaphore = new sem_t;
+    sem_init(semaphore, 0, 0);
+    semaphore_ = semaphore;
+  }
+
+  WorkerSemaphore::~WorkerSemaphore() {
+    sem_t* semaphore = static_cast<sem_t*>(semaphore_);
+    sem_destroy(semaphore);
+    delete semaphore;
+  }
+
+  void WorkerSemaphore::post() {
+    sem_post(static_cast<sem_t*>(semaphore_));
+  }
+
+  void WorkerSemaphore::wait() {
+    while (sem_wait(static_cast<sem_t*>(semaphore_)) && errno == EINTR)
+      ;
+  }
+#endif
+
+  WorkerPool::WorkerPool() : task_(nullptr), data_(nullptr),
+                             quit_(false), remaining_(0) { }
+
+  WorkerPool::~WorkerPool() {
+    stopThreads();
+  }
+
+  void WorkerPool::setNumWorkers(int num_workers) {
+    MOPO_ASSERT(num_workers >= 1);
+    if (num_workers == numWorkers())
+      return;
+
+    stopThreads();
+    quit_.store(false, std::memory_order_relaxed);
+    for (int i = 1; i < num_workers; ++i)
+      wake_.push_back(new WorkerSemaphore());
+
+    for (int i = 1; i < num_workers; ++i)
+      threads_.push_back(std::thread(&WorkerPool::workerLoop, this, i));
+  }
+
+  void WorkerPool::run(Task task, void* data, int num_workers) {
+    if (num_workers > numWorkers())
+      num_workers = numWorkers();
+
+    if (num_workers <= 1) {
+      task(data, 0);
+      return;
+    }
+
+    task_ = task;
+    data_ = data;
+    remaining_.store(num_workers, std::memory_order_relaxed);
+    for (int i = 1; i < num_workers; ++i)
+      wake_[i - 1]->post();
+
+    task(data, 0);
+
+    // The other workers have about as much work, so usually one of them is
+    // still running and wakes us when the last one finishes.
+    if (remaining_.fetch_sub(1, std::memory_order_acq_rel) != 1)
+      done_.wait();
+  }
+
+  void WorkerPool::stopThreads() {
+    quit_.store(true, std::memory_order_release);
+    for (WorkerSemaphore* wake : wake_)
+      wake->post();
+
+    for (std::thread& thread : threads_)
+      thread.join();
+    threads_.clear();
+
+    for (WorkerSemaphore* wake : wake_)
+      delete wake;
+    wake_.clear();
+  }
+
+  void WorkerPool::workerLoop(int worker) {
+    WorkerSemaphore* wake = wake_[worker - 1];
+    while (true) {
+      // Each wake is for exactly one new task.
+      wake->wait();
+      if (quit_.load(std::memory_order_acquire))
+        return;
+
+      task_(data_, worker);
+      if (remaining_.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        done_.post();
+    }
+  }
+} // namespace mopo
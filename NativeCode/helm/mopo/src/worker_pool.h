@@ -0,0 +1,81 @@
+/* Copyright 2013-2017 Matt Tytel
+ *
+ * mopo is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * mopo is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with mopo.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace mopo {
+
+  // Counting semaphore on the platform's native primitive. post() never
+  // takes a lock, so the audio thread can wake workers without blocking on
+  // one of them.
+  class WorkerSemaphore {
+    public:
+      WorkerSemaphore();
+      ~WorkerSemaphore();
+
+      void post();
+      void wait();
+
+    private:
+      void* semaphore_;
+  };
+
+  // A fixed set of threads that run one task together and hand control back
+  // once every worker has finished. The calling thread always acts as worker
+  // 0 so a pool of one worker never starts a thread.
+  class WorkerPool {
+    public:
+      typedef void (*Task)(void* data, int worker);
+
+      WorkerPool();
+      ~WorkerPool();
+
+      void setNumWorkers(int num_workers);
+      int numWorkers() const { return static_cast<int>(threads_.size()) + 1; }
+
+      // Runs _task_ for workers 0 through _num_workers_ - 1 and returns when
+      // all of them are done. _num_workers_ is capped at numWorkers().
+      // Only wakes the workers it needs and never locks, so it's safe to
+      // call from the audio thread.
+      void run(Task task, void* data, int num_workers);
+
+    private:
+      void stopThreads();
+      void workerLoop(int worker);
+
+      std::vector<std::thread> threads_;
+      // One wake semaphore per worker thread, indexed by worker - 1.
+      std::vector<WorkerSemaphore*> wake_;
+      WorkerSemaphore done_;
+
+      // The task is written before the workers are woken, and posting
+      // their semaphores publishes it to them.
+      Task task_;
+      void* data_;
+      std::atomic<bool> quit_;
+      // Workers, including the caller, still running the current task. The
+      // one that brings it to zero wakes the caller if it's waiting.
+      std::atomic<int> remaining_;
+  };
+} // namespace mopo
+
+#endif // WORKER_POOL_H
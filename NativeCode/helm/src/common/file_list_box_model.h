@@ -39,6 +39,7 @@ class FileListBoxModel : public ListBoxModel {
     void deleteKeyPressed(int lastRowSelected) override;
 
     void rescanFiles(const Array<File>& folders, String search = "*", bool find_files = false);
+    void setFiles(const Array<File>& files) { files_ = files; }
     File getFileAtRow(int row) { return files_[row]; }
     int getIndexOfFile(File file) { return files_.indexOf(file); }
     void setListener(Listener* listener) { listener_ = listener; }
@@ -184,6 +184,16 @@ namespace mopo {
   const wchar_t DEFAULT_KEYBOARD_OCTAVE_DOWN = 'z';
 
   const std::string PATCH_EXTENSION = "helm";
+  const std::string BINARY_PATCH_EXTENSION = "helmb";
+
+  // FNV-1a hash for telling if name tables match between builds. Chains
+  // through hash and includes the terminator so boundaries between names
+  // count.
+  inline unsigned int hashName(const std::string& name, unsigned int hash = 2166136261u) {
+    for (unsigned char c : name)
+      hash = (hash ^ c) * 16777619u;
+    return hash * 16777619u;
+  }
 
   typedef std::map<std::string, Value*> control_map;
   typedef std::pair<Value*, mopo_float> control_change;
@@ -210,7 +220,7 @@ namespace mopo {
     ModulationConnection() : ModulationConnection("", "") { }
 
     ModulationConnection(std::string from, std::string to) :
-        source(from), destination(to) {
+        source(from), destination(to), source_id(-1), destination_id(-1) {
     }
 
     ~ModulationConnection() {
@@ -221,11 +231,18 @@ namespace mopo {
     void resetConnection(const std::string& from, const std::string& to) {
       source = from;
       destination = to;
+      source_id = -1;
+      destination_id = -1;
       modulation_scale.router(nullptr);
     }
 
     std::string source;
     std::string destination;
+
+    // Ids into the engine's modulation registry. -1 until resolved from the
+    // names above; once set they take precedence over the names.
+    int source_id;
+    int destination_id;
     cr::Value amount;
     cr::Multiply modulation_scale;
   };
@@ -277,7 +294,7 @@ namespace mopo {
         return parameter_list[index];
       }
 
-      std::map<std::string, ValueDetails> getAllDetails() const {
+      const std::map<std::string, ValueDetails>& getAllDetails() const {
         return details_lookup_;
       }
 
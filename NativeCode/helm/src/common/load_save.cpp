@@ -25,6 +25,7 @@
 #define LINUX_BANK_DIRECTORY "~/.helm/patches"
 #define EXPORTED_BANK_EXTENSION "helmbank"
 #define DID_PAY_FILE "thank_you.txt"
+#define PATCH_INDEX_FILE "patch_index.cache"
 #define PAY_WAIT_DAYS 4
 
 namespace {
@@ -135,12 +136,7 @@ void LoadSave::initSynth(SynthBase* synth, std::map<std::string, String>& save_i
   save_info["folder_name"] = "";
 }
 
-void LoadSave::varToState(SynthBase* synth,
-                          std::map<std::string, String>& save_info,
-                          var state) {
-  if (!state.isObject())
-    return;
-
+NamedValueSet LoadSave::upgradeState(var state, NamedValueSet& settings_properties) {
   DynamicObject* object_state = state.getDynamicObject();
   NamedValueSet properties = object_state->getProperties();
 
@@ -158,7 +154,7 @@ void LoadSave::varToState(SynthBase* synth,
 
   var settings = properties["settings"];
   DynamicObject* settings_object = settings.getDynamicObject();
-  NamedValueSet settings_properties = settings_object->getProperties();
+  settings_properties = settings_object->getProperties();
   Array<var>* modulations = settings_properties["modulations"].getArray();
 
   // After 0.5.0 mixer was added and osc_mix was removed. And scaling of oscillators was changed.
@@ -324,11 +320,108 @@ void LoadSave::varToState(SynthBase* synth,
     settings_properties.set("beats_per_minute", old_bpm / 60.0);
   }
 
+  return properties;
+}
+
+void LoadSave::varToState(SynthBase* synth,
+                          std::map<std::string, String>& save_info,
+                          var state) {
+  if (!state.isObject())
+    return;
+
+  NamedValueSet settings_properties;
+  NamedValueSet properties = upgradeState(state, settings_properties);
   loadControls(synth, settings_properties);
-  loadModulations(synth, modulations);
+  loadModulations(synth, settings_properties["modulations"].getArray());
   loadSaveState(save_info, properties);
 }
 
+void LoadSave::binaryToState(SynthBase* synth,
+                             std::map<std::string, String>& save_info,
+                             const mopo::BinaryPatch& patch) {
+  const std::map<std::string, mopo::ValueDetails>& details =
+      mopo::Parameters::lookup_.getAllDetails();
+  mopo::control_map controls = synth->getControls();
+
+  std::vector<mopo::Value*> controls_by_index;
+  for (auto& parameter : details) {
+    auto control = controls.find(parameter.first);
+    mopo::Value* value = control == controls.end() ? nullptr : control->second;
+    if (value)
+      value->set(parameter.second.default_value);
+    controls_by_index.push_back(value);
+  }
+
+  for (int i = 0; i < patch.numParameters(); ++i) {
+    int index = patch.parameterIndex(i);
+    if (index >= 0 && controls_by_index[index])
+      controls_by_index[index]->set(patch.values()[i]);
+  }
+
+  synth->clearModulations();
+  for (int i = 0; i < patch.numModulations(); ++i) {
+    mopo::ModulationConnection* connection = synth->getModulationBank().get("", "");
+    patch.resetConnection(i, connection, synth->getEngine());
+    synth->setModulationAmount(connection, patch.modulations()[i].amount);
+  }
+
+  save_info["author"] = patch.metadata(mopo::BinaryPatch::kAuthor);
+  save_info["patch_name"] = patch.metadata(mopo::BinaryPatch::kPatchName);
+  save_info["folder_name"] = patch.metadata(mopo::BinaryPatch::kFolderName);
+}
+
+MemoryBlock LoadSave::varToBinary(var state) {
+  MemoryBlock binary;
+  if (!state.isObject())
+    return binary;
+
+  NamedValueSet settings_properties;
+  NamedValueSet properties = upgradeState(state, settings_properties);
+
+  std::map<std::string, mopo::mopo_float> values;
+  for (auto& parameter : mopo::Parameters::lookup_.getAllDetails()) {
+    if (settings_properties.contains(parameter.first.c_str()))
+      values[parameter.first] = settings_properties[parameter.first.c_str()];
+  }
+
+  std::vector<mopo::BinaryPatch::ModulationSetting> modulations;
+  Array<var>* modulation_array = settings_properties["modulations"].getArray();
+  if (modulation_array) {
+    for (var& modulation : *modulation_array) {
+      DynamicObject* mod = modulation.getDynamicObject();
+      mopo::BinaryPatch::ModulationSetting setting;
+      setting.source = mod->getProperty("source").toString().toStdString();
+      setting.destination = mod->getProperty("destination").toString().toStdString();
+      setting.amount = mod->getProperty("amount");
+      modulations.push_back(setting);
+    }
+  }
+
+  std::string metadata[mopo::BinaryPatch::kNumMetadata];
+  metadata[mopo::BinaryPatch::kPatchName] = properties["patch_name"].toString().toStdString();
+  metadata[mopo::BinaryPatch::kFolderName] = properties["folder_name"].toString().toStdString();
+  metadata[mopo::BinaryPatch::kAuthor] = properties["author"].toString().toStdString();
+  metadata[mopo::BinaryPatch::kLicense] = properties["license"].toString().toStdString();
+  metadata[mopo::BinaryPatch::kSynthVersion] = properties["synth_version"].toString().toStdString();
+
+  // Only used for its modulation ids.
+  static mopo::HelmEngine engine;
+  int size = mopo::BinaryPatch::write(nullptr, 0, values, modulations, metadata, &engine);
+  binary.setSize(size);
+  mopo::BinaryPatch::write(static_cast<char*>(binary.getData()), size,
+                           values, modulations, metadata, &engine);
+  return binary;
+}
+
+bool LoadSave::exportBinaryPatch(File json_patch, File binary_patch) {
+  var parsed_json_state;
+  if (!JSON::parse(json_patch.loadFileAsString(), parsed_json_state).wasOk())
+    return false;
+
+  MemoryBlock binary = varToBinary(parsed_json_state);
+  return binary.getSize() && binary_patch.replaceWithData(binary.getData(), binary.getSize());
+}
+
 String LoadSave::getAuthor(var state) {
   if (!state.isObject())
     return "";
@@ -366,6 +459,10 @@ File LoadSave::getConfigFile() {
   return config_options.getDefaultFile();
 }
 
+File LoadSave::getPatchIndexFile() {
+  return getConfigFile().getSiblingFile(PATCH_INDEX_FILE);
+}
+
 var LoadSave::getConfigVar() {
   File config_file = getConfigFile();
 
@@ -19,6 +19,7 @@
 
 #include "JuceHeader.h"
 
+#include "binary_patch.h"
 #include "helm_engine.h"
 
 class MidiManager;
@@ -60,14 +61,28 @@ class LoadSave {
 
     static void initSynth(SynthBase* synth, std::map<std::string, String>& save_info);
   
+    // Applies the changes between older patch versions and this one. Fills
+    // in the upgraded settings and returns the top level properties.
+    static NamedValueSet upgradeState(var state, NamedValueSet& settings_properties);
+
     static void varToState(SynthBase* synth,
                            std::map<std::string, String>& save_info,
                            var state);
 
+    static void binaryToState(SynthBase* synth,
+                              std::map<std::string, String>& save_info,
+                              const mopo::BinaryPatch& patch);
+
+    // Converts a JSON patch to the binary format. Loading the result gives the
+    // same controls and modulations as loading the JSON.
+    static MemoryBlock varToBinary(var state);
+    static bool exportBinaryPatch(File json_patch, File binary_patch);
+
     static String getAuthor(var state);
     static String getLicense(var state);
 
     static File getConfigFile();
+    static File getPatchIndexFile();
     static var getConfigVar();
     static bool isInstalled();
     static bool wasUpgraded();
@@ -147,3 +147,7 @@ void MidiManager::replaceKeyboardMessages(MidiBuffer& buffer, int num_samples) {
   keyboard_state_->processNextMidiBuffer(buffer, 0, num_samples, true);
 }
 
+void MidiManager::showKeyboardMessages(MidiBuffer& buffer, int num_samples) {
+  keyboard_state_->processNextMidiBuffer(buffer, 0, num_samples, false);
+}
+
@@ -56,6 +56,9 @@ class MidiManager : public MidiInputCallback {
     void removeNextBlockOfMessages(MidiBuffer& buffer, int num_samples);
     void replaceKeyboardMessages(MidiBuffer& buffer, int num_samples);
 
+    // Shows the notes in _buffer_ on the keyboard without adding to it.
+    void showKeyboardMessages(MidiBuffer& buffer, int num_samples);
+
     midi_map getMidiLearnMap() { return midi_learn_map_; }
     void setMidiLearnMap(midi_map midi_learn_map) { midi_learn_map_ = midi_learn_map; }
 
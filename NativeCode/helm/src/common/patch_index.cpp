@@ -0,0 +1,446 @@
+/* Copyright 2013-2017 Matt Tytel
+ *
+ * helm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * helm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with helm.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "patch_index.h"
+
+#include "helm_common.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#define INDEX_MAGIC 0x58495048
+#define INDEX_VERSION 1
+#define STOP_TIMEOUT_MS 2000
+#define MAX_INDEX_STRINGS 10000000
+
+namespace {
+  const uint64 FNV_OFFSET = 0xcbf29ce484222325ULL;
+  const uint64 FNV_PRIME = 0x100000001b3ULL;
+
+  void hashBytes(uint64& hash, const void* data, size_t size) {
+    const uint8* bytes = static_cast<const uint8*>(data);
+    for (size_t i = 0; i < size; ++i) {
+      hash ^= bytes[i];
+      hash *= FNV_PRIME;
+    }
+  }
+
+  void hashString(uint64& hash, const String& value) {
+    hashBytes(hash, value.toRawUTF8(), value.getNumBytesAsUTF8() + 1);
+  }
+
+  // Object properties are hashed separately and summed so the order they
+  // were saved in doesn't matter.
+  void hashVar(uint64& hash, const var& value) {
+    if (DynamicObject* object = value.getDynamicObject()) {
+      const NamedValueSet& properties = object->getProperties();
+      uint64 properties_hash = 0;
+      for (int i = 0; i < properties.size(); ++i) {
+        uint64 property_hash = FNV_OFFSET;
+        hashString(property_hash, properties.getName(i).toString());
+        hashVar(property_hash, *properties.getVarPointerAt(i));
+        properties_hash += property_hash;
+      }
+      hashBytes(hash, &properties_hash, sizeof(properties_hash));
+    }
+    else if (const Array<var>* values = value.getArray()) {
+      int size = values->size();
+      hashBytes(hash, &size, sizeof(size));
+      for (const var& element : *values)
+        hashVar(hash, element);
+    }
+    else if (value.isString())
+      hashString(hash, value.toString());
+    else if (!value.isVoid() && !value.isUndefined()) {
+      double number = value;
+      hashBytes(hash, &number, sizeof(number));
+    }
+  }
+
+  String createSearchText(const PatchIndex::Entry& entry) {
+    return (entry.name + "\n" + entry.author + "\n" + entry.tags.joinIntoString("\n")).toLowerCase();
+  }
+
+  // Byte order of UTF-8 matches the code point order String::compare uses.
+  bool compareSortKeys(const std::pair<const char*, File>& a,
+                       const std::pair<const char*, File>& b) {
+    return strcmp(a.first, b.first) < 0;
+  }
+} // namespace
+
+PatchIndex::PatchIndex(File bank_directory, File index_file) :
+    Thread("Patch Index"), bank_directory_(bank_directory), index_file_(index_file),
+    listener_(nullptr), scan_(0), dirty_(false), ready_(0) { }
+
+PatchIndex::~PatchIndex() {
+  stopThread(STOP_TIMEOUT_MS);
+  cancelPendingUpdate();
+
+  if (dirty_)
+    saveIndexFile();
+}
+
+void PatchIndex::run() {
+  if (!isReady() && loadIndexFile())
+    triggerAsyncUpdate();
+
+  while (!threadShouldExit()) {
+    bool was_ready = isReady();
+    if (update()) {
+      saveIndexFile();
+      triggerAsyncUpdate();
+    }
+    else if (!was_ready)
+      triggerAsyncUpdate();
+
+    wait(-1);
+  }
+}
+
+void PatchIndex::handleAsyncUpdate() {
+  if (listener_)
+    listener_->patchIndexUpdated(this);
+}
+
+void PatchIndex::refresh() {
+  if (isThreadRunning())
+    notify();
+  else
+    startThread();
+}
+
+bool PatchIndex::readEntry(File patch, Entry& entry) {
+  entry.file = patch;
+  entry.modification_time = patch.getLastModificationTime().toMilliseconds();
+  entry.size = patch.getSize();
+  entry.name = patch.getFileNameWithoutExtension();
+  entry.folder = patch.getParentDirectory().getFileName();
+  entry.bank = patch.getParentDirectory().getParentDirectory().getFileName();
+
+  var state;
+  if (!JSON::parse(patch.loadFileAsString(), state).wasOk() || !state.isObject())
+    return false;
+
+  entry.author = state.getProperty("author", "").toString();
+  entry.license = state.getProperty("license", "").toString();
+
+  var tags = state.getProperty("tags", var());
+  if (const Array<var>* tag_array = tags.getArray()) {
+    for (const var& tag : *tag_array)
+      entry.tags.add(tag.toString().trim());
+  }
+  else if (tags.isString())
+    entry.tags.addTokens(tags.toString(), ",", "\"");
+  entry.tags.trim();
+  entry.tags.removeEmptyStrings();
+
+  entry.fingerprint = computeFingerprint(state.getProperty("settings", var()));
+  return true;
+}
+
+int64 PatchIndex::computeFingerprint(const var& settings) {
+  uint64 hash = FNV_OFFSET;
+  hashVar(hash, settings);
+  return static_cast<int64>(hash);
+}
+
+void PatchIndex::addEntry(const Entry& entry) {
+  IndexedPatch patch;
+  patch.entry = entry;
+  patch.sort_key = entry.file.getFullPathName().toLowerCase();
+  patch.search_text = createSearchText(entry);
+  String folder_path = entry.file.getParentDirectory().getFullPathName();
+
+  ScopedLock lock(lock_);
+  patch.folder_id = getFolderId(folder_path);
+  patch.scan = scan_;
+  patches_[entry.file.getFullPathName()] = patch;
+  dirty_ = true;
+}
+
+int PatchIndex::getFolderId(const String& folder_path) {
+  auto found = folder_ids_.find(folder_path);
+  if (found != folder_ids_.end())
+    return found->second;
+
+  int folder_id = static_cast<int>(folder_ids_.size());
+  folder_ids_[folder_path] = folder_id;
+  return folder_id;
+}
+
+bool PatchIndex::update() {
+  int scan = 0;
+  {
+    ScopedLock lock(lock_);
+    scan = ++scan_;
+  }
+
+  bool changed = false;
+  if (bank_directory_.isDirectory()) {
+    DirectoryIterator patches(bank_directory_, true,
+                              String("*.") + mopo::PATCH_EXTENSION, File::findFiles);
+    int64 size = 0;
+    Time modification_time;
+
+    while (patches.next(nullptr, nullptr, &size, &modification_time, nullptr, nullptr)) {
+      if (threadShouldExit())
+        return changed;
+
+      File file = patches.getFile();
+      {
+        ScopedLock lock(lock_);
+        auto found = patches_.find(file.getFullPathName());
+        if (found != patches_.end() &&
+            found->second.entry.modification_time == modification_time.toMilliseconds() &&
+            found->second.entry.size == size) {
+          found->second.scan = scan;
+          continue;
+        }
+      }
+
+      Entry entry;
+      readEntry(file, entry);
+      entry.modification_time = modification_time.toMilliseconds();
+      entry.size = size;
+      addEntry(entry);
+      changed = true;
+    }
+  }
+
+  ScopedLock lock(lock_);
+  for (auto iter = patches_.begin(); iter != patches_.end();) {
+    if (iter->second.scan < scan) {
+      iter = patches_.erase(iter);
+      changed = true;
+    }
+    else
+      ++iter;
+  }
+
+  if (changed)
+    dirty_ = true;
+  ready_ = 1;
+  return changed;
+}
+
+void PatchIndex::updateFile(File patch) {
+  if (!patch.existsAsFile()) {
+    removeFile(patch);
+    return;
+  }
+
+  Entry entry;
+  readEntry(patch, entry);
+  addEntry(entry);
+}
+
+void PatchIndex::removeFile(File patch) {
+  ScopedLock lock(lock_);
+  if (patches_.erase(patch.getFullPathName()))
+    dirty_ = true;
+}
+
+bool PatchIndex::getEntry(File patch, Entry& entry) {
+  int64 modification_time = patch.getLastModificationTime().toMilliseconds();
+  int64 size = patch.getSize();
+
+  ScopedLock lock(lock_);
+  auto found = patches_.find(patch.getFullPathName());
+  if (found == patches_.end() ||
+      found->second.entry.modification_time != modification_time ||
+      found->second.entry.size != size) {
+    return false;
+  }
+
+  entry = found->second.entry;
+  return true;
+}
+
+Array<File> PatchIndex::search(const Array<File>& folders, const String& text) {
+  String query = text.trim().toLowerCase();
+  std::vector<std::vector<std::pair<const char*, File>>> results(folders.size());
+
+  ScopedLock lock(lock_);
+  std::vector<int> folder_order(folder_ids_.size(), -1);
+  for (int i = 0; i < folders.size(); ++i) {
+    auto found = folder_ids_.find(folders[i].getFullPathName());
+    if (found != folder_ids_.end())
+      folder_order[found->second] = i;
+  }
+
+  for (auto& indexed : patches_) {
+    const IndexedPatch& patch = indexed.second;
+    int folder_index = folder_order[patch.folder_id];
+    if (folder_index < 0)
+      continue;
+    if (query.isNotEmpty() && !patch.search_text.contains(query))
+      continue;
+
+    results[folder_index].push_back(std::pair<const char*, File>(patch.sort_key.toRawUTF8(),
+                                                                 patch.entry.file));
+  }
+
+  Array<File> files;
+  for (auto& folder_results : results) {
+    std::sort(folder_results.begin(), folder_results.end(), compareSortKeys);
+    for (auto& result : folder_results)
+      files.add(result.second);
+  }
+  return files;
+}
+
+int PatchIndex::getNumPatches() {
+  ScopedLock lock(lock_);
+  return static_cast<int>(patches_.size());
+}
+
+bool PatchIndex::saveIndexFile() {
+  index_file_.getParentDirectory().createDirectory();
+  TemporaryFile temp_file(index_file_);
+
+  {
+    FileOutputStream stream(temp_file.getFile());
+    if (stream.failedToOpen())
+      return false;
+
+    ScopedLock lock(lock_);
+    stream.writeInt(INDEX_MAGIC);
+    stream.writeInt(INDEX_VERSION);
+    stream.writeString(bank_directory_.getFullPathName());
+
+    // Most patches share one of a few long licenses, so they're stored once.
+    StringArray licenses;
+    HashMap<String, int> license_indices;
+    for (auto& indexed : patches_) {
+      const String& license = indexed.second.entry.license;
+      if (!license_indices.contains(license)) {
+        license_indices.set(license, licenses.size());
+        licenses.add(license);
+      }
+    }
+
+    stream.writeInt(licenses.size());
+    for (String license : licenses)
+      stream.writeString(license);
+
+    stream.writeInt(static_cast<int>(patches_.size()));
+    for (auto& indexed : patches_) {
+      const Entry& entry = indexed.second.entry;
+      stream.writeString(indexed.first);
+      stream.writeInt64(entry.modification_time);
+      stream.writeInt64(entry.size);
+      stream.writeString(entry.author);
+      stream.writeInt(license_indices[entry.license]);
+      stream.writeInt(entry.tags.size());
+      for (String tag : entry.tags)
+        stream.writeString(tag);
+      stream.writeInt64(entry.fingerprint);
+    }
+
+    stream.flush();
+    if (stream.getStatus().failed())
+      return false;
+    dirty_ = false;
+  }
+
+  return temp_file.overwriteTargetFileWithTemporary();
+}
+
+bool PatchIndex::loadIndexFile() {
+  MemoryBlock data;
+  if (!index_file_.loadFileAsData(data))
+    return false;
+
+  MemoryInputStream stream(data, false);
+  if (stream.readInt() != INDEX_MAGIC || stream.readInt() != INDEX_VERSION)
+    return false;
+  if (stream.readString() != bank_directory_.getFullPathName())
+    return false;
+
+  int num_licenses = stream.readInt();
+  if (num_licenses < 0 || num_licenses > MAX_INDEX_STRINGS)
+    return false;
+
+  StringArray licenses;
+  for (int i = 0; i < num_licenses; ++i)
+    licenses.add(stream.readString());
+
+  int num_patches = stream.readInt();
+  if (num_patches < 0 || num_patches > MAX_INDEX_STRINGS)
+    return false;
+
+  std::map<String, IndexedPatch> patches;
+  std::map<String, int> folder_ids;
+  String separator = File::separatorString;
+  String folder_path, folder, bank;
+  int folder_id = -1;
+
+  for (int i = 0; i < num_patches && !stream.isExhausted(); ++i) {
+    IndexedPatch patch;
+    Entry& entry = patch.entry;
+    String path = stream.readString();
+    entry.file = File(path);
+    entry.modification_time = stream.readInt64();
+    entry.size = stream.readInt64();
+    entry.author = stream.readString();
+    entry.license = licenses[stream.readInt()];
+
+    int num_tags = stream.readInt();
+    if (num_tags < 0 || num_tags > MAX_INDEX_STRINGS)
+      return false;
+    for (int t = 0; t < num_tags; ++t)
+      entry.tags.add(stream.readString());
+    entry.fingerprint = stream.readInt64();
+
+    // Patches are saved in path order, so folders come in runs.
+    String patch_folder_path = path.upToLastOccurrenceOf(separator, false, false);
+    if (folder_id < 0 || patch_folder_path != folder_path) {
+      folder_path = patch_folder_path;
+      folder = folder_path.fromLastOccurrenceOf(separator, false, false);
+      bank = folder_path.upToLastOccurrenceOf(separator, false, false)
+                        .fromLastOccurrenceOf(separator, false, false);
+
+      auto found = folder_ids.find(folder_path);
+      if (found == folder_ids.end()) {
+        folder_id = static_cast<int>(folder_ids.size());
+        folder_ids[folder_path] = folder_id;
+      }
+      else
+        folder_id = found->second;
+    }
+
+    entry.name = entry.file.getFileNameWithoutExtension();
+    entry.folder = folder;
+    entry.bank = bank;
+
+    patch.folder_id = folder_id;
+    patch.sort_key = path.toLowerCase();
+    patch.search_text = createSearchText(entry);
+    patches[path] = patch;
+  }
+
+  if (static_cast<int>(patches.size()) != num_patches)
+    return false;
+
+  ScopedLock lock(lock_);
+  for (auto& indexed : patches)
+    indexed.second.scan = scan_;
+  patches_.swap(patches);
+  folder_ids_.swap(folder_ids);
+  ready_ = 1;
+  return true;
+}
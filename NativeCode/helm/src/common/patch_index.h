@@ -0,0 +1,118 @@
+/* Copyright 2013-2017 Matt Tytel
+ *
+ * helm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * helm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with helm.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+#ifndef PATCH_INDEX_H
+#define PATCH_INDEX_H
+
+#include "JuceHeader.h"
+
+#include <map>
+
+// Metadata of every patch in the bank directory. Searches run against the
+// copy in memory and the index is cached on disk, so the browser opens
+// without parsing every patch. A background thread brings it up to date by
+// checking modification times and only parses patches that changed.
+class PatchIndex : public Thread, public AsyncUpdater {
+  public:
+    struct Entry {
+      Entry() : modification_time(0), size(0), fingerprint(0) { }
+
+      File file;
+      int64 modification_time;
+      int64 size;
+      String name;
+      String author;
+      String license;
+      String folder;
+      String bank;
+      StringArray tags;
+
+      // Hash of the patch settings, equal for patches that sound the same.
+      int64 fingerprint;
+    };
+
+    class Listener {
+      public:
+        virtual ~Listener() { }
+
+        // Called on the message thread after a background update.
+        virtual void patchIndexUpdated(PatchIndex* index) = 0;
+    };
+
+    PatchIndex(File bank_directory, File index_file);
+    ~PatchIndex();
+
+    void run() override;
+    void handleAsyncUpdate() override;
+
+    // False until the cached index was loaded or the first update finished.
+    bool isReady() const { return ready_.get(); }
+
+    bool loadIndexFile();
+    bool saveIndexFile();
+
+    // Rescans the bank directory on the calling thread. Returns true if any
+    // patch was added, changed or removed.
+    bool update();
+
+    // Runs update() on the background thread and notifies the listener if
+    // anything changed. The first refresh loads the cached index first.
+    void refresh();
+
+    void updateFile(File patch);
+    void removeFile(File patch);
+
+    // Returns false if the patch isn't indexed or changed since.
+    bool getEntry(File patch, Entry& entry);
+
+    // Patches in the given folders whose name, author or tags contain text,
+    // ordered by folder and then path.
+    Array<File> search(const Array<File>& folders, const String& text);
+
+    int getNumPatches();
+    void setListener(Listener* listener) { listener_ = listener; }
+
+    static bool readEntry(File patch, Entry& entry);
+    static int64 computeFingerprint(const var& settings);
+
+  private:
+    struct IndexedPatch {
+      Entry entry;
+      int folder_id;
+      String sort_key;
+      String search_text;
+      int scan;
+    };
+
+    void addEntry(const Entry& entry);
+    int getFolderId(const String& folder_path);
+
+    File bank_directory_;
+    File index_file_;
+    Listener* listener_;
+
+    CriticalSection lock_;
+    std::map<String, IndexedPatch> patches_;
+    std::map<String, int> folder_ids_;
+    int scan_;
+    bool dirty_;
+    Atomic<int> ready_;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PatchIndex)
+};
+
+#endif // PATCH_INDEX_H
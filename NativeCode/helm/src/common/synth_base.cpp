@@ -17,11 +17,14 @@
 #include "synth_base.h"
 
 #include "load_save.h"
-#include "startup.h"
 #include "synth_gui_interface.h"
+#ifndef HELM_HEADLESS
+#include "startup.h"
+#endif
 #include "utils.h"
 
 #define OUTPUT_WINDOW_MIN_NOTE 16.0
+#define KEYBOARD_MESSAGES_BYTES 4096
 
 SynthBase::SynthBase() {
   controls_ = engine_.getControls();
@@ -36,8 +39,14 @@ SynthBase::SynthBase() {
   memory_reset_period_ = mopo::MEMORY_RESOLUTION;
   memory_input_offset_ = 0;
   memory_index_ = 0;
+  output_memory_readers_ = 0;
+  keyboard_messages_.ensureSize(KEYBOARD_MESSAGES_BYTES);
 
+  // Headless builds never touch the user's patch folders or config file, so
+  // there's no MIDI learn map and nothing on disk to check at load.
+#ifndef HELM_HEADLESS
   Startup::doStartupChecks(midi_manager_);
+#endif
 }
 
 void SynthBase::valueChanged(const std::string& name, mopo::mopo_float value) {
@@ -51,9 +60,13 @@ void SynthBase::valueChangedInternal(const std::string& name, mopo::mopo_float v
 
 void SynthBase::valueChangedThroughMidi(const std::string& name, mopo::mopo_float value) {
   controls_[name]->set(value);
-  ValueChangedCallback* callback = new ValueChangedCallback(this, name, value);
+  if (name == "polyphony")
+    engine_.prepareVoices();
   setValueNotifyHost(name, value);
+#ifndef HELM_HEADLESS
+  ValueChangedCallback* callback = new ValueChangedCallback(this, name, value);
   callback->post();
+#endif
 }
 
 void SynthBase::patchChangedThroughMidi(File patch) {
@@ -66,8 +79,10 @@ void SynthBase::patchChangedThroughMidi(File patch) {
 
 void SynthBase::valueChangedExternal(const std::string& name, mopo::mopo_float value) {
   valueChanged(name, value);
+#ifndef HELM_HEADLESS
   ValueChangedCallback* callback = new ValueChangedCallback(this, name, value);
   callback->post();
+#endif
 }
 
 void SynthBase::changeModulationAmount(const std::string& source,
@@ -152,21 +167,49 @@ var SynthBase::saveToVar(String author) {
 void SynthBase::loadInitPatch() {
   getCriticalSection().enter();
   LoadSave::initSynth(this, save_info_);
+  engine_.prepareVoices();
   getCriticalSection().exit();
 }
 
 void SynthBase::loadFromVar(juce::var state) {
   getCriticalSection().enter();
   LoadSave::varToState(this, save_info_, state);
+  engine_.prepareVoices();
+  getCriticalSection().exit();
+}
+
+bool SynthBase::loadFromBinaryFile(File patch) {
+  MemoryMappedFile mapped_patch(patch, MemoryMappedFile::readOnly);
+  mopo::BinaryPatch binary_patch;
+  if (!binary_patch.read(static_cast<const char*>(mapped_patch.getData()),
+                         mapped_patch.getSize())) {
+    return false;
+  }
+
+  getCriticalSection().enter();
+  LoadSave::binaryToState(this, save_info_, binary_patch);
+  engine_.prepareVoices();
   getCriticalSection().exit();
+  return true;
 }
 
 bool SynthBase::loadFromFile(File patch) {
-  var parsed_json_state;
-  if (patch.exists() && JSON::parse(patch.loadFileAsString(), parsed_json_state).wasOk()) {
+  if (!patch.exists())
+    return false;
+
+  bool loaded = false;
+  if (patch.hasFileExtension(String(mopo::BINARY_PATCH_EXTENSION)))
+    loaded = loadFromBinaryFile(patch);
+  else {
+    var parsed_json_state;
+    loaded = JSON::parse(patch.loadFileAsString(), parsed_json_state).wasOk();
+    if (loaded)
+      loadFromVar(parsed_json_state);
+  }
+
+  if (loaded) {
     active_file_ = patch;
     File parent = patch.getParentDirectory();
-    loadFromVar(parsed_json_state);
     setFolderName(parent.getFileNameWithoutExtension());
     setPatchName(patch.getFileNameWithoutExtension());
 
@@ -238,47 +281,75 @@ void SynthBase::processAudio(AudioSampleBuffer* buffer, int channels, int sample
     }
   }
 
-  updateMemoryOutput(samples, engine_output_left, engine_output_right);
+  if (output_memory_readers_ > 0)
+    updateMemoryOutput(samples, engine_output_left, engine_output_right);
 }
 
-void SynthBase::processMidi(MidiBuffer& midi_messages, int start_sample, int end_sample) {
+void SynthBase::processMidi(MidiBuffer& midi_messages) {
   MidiBuffer::Iterator midi_iter(midi_messages);
   MidiMessage midi_message;
   int midi_sample = 0;
-  bool process_all = end_sample == 0;
-  while (midi_iter.getNextEvent(midi_message, midi_sample)) {
-    if (process_all || (midi_sample >= start_sample && midi_sample < end_sample))
-      midi_manager_->processMidiMessage(midi_message, midi_sample - start_sample);
+  while (midi_iter.getNextEvent(midi_message, midi_sample))
+    midi_manager_->processMidiMessage(midi_message, midi_sample);
+}
+
+int SynthBase::processMidi(MidiCursor& cursor, int start_sample, int end_sample) {
+  for (; cursor.has_event && cursor.sample < end_sample; cursor.next()) {
+    const MidiMessage& message = cursor.message;
+    bool control = message.isController() || message.isPitchWheel();
+    if (control && cursor.sample > start_sample)
+      return cursor.sample;
+
+    // Events from before the block start with it.
+    int offset = std::max(0, cursor.sample - start_sample);
+    midi_manager_->processMidiMessage(message, offset);
   }
+  return end_sample;
 }
 
 void SynthBase::processKeyboardEvents(MidiBuffer& buffer, int num_samples) {
-  MidiBuffer keyboard_messages;
-  midi_manager_->replaceKeyboardMessages(keyboard_messages, num_samples);
-  midi_manager_->replaceKeyboardMessages(buffer, num_samples);
+  keyboard_messages_.clear();
+  midi_manager_->replaceKeyboardMessages(keyboard_messages_, num_samples);
+  midi_manager_->showKeyboardMessages(buffer, num_samples);
 
-  processMidi(keyboard_messages);
+  processMidi(keyboard_messages_);
 }
 
 void SynthBase::processControlChanges() {
   mopo::control_change change;
-  while (getNextControlChange(change))
+  bool polyphony_changed = false;
+  while (getNextControlChange(change)) {
     change.first->set(change.second);
+    polyphony_changed = polyphony_changed || change.first == controls_["polyphony"];
+  }
+
+  // The engine only builds voices for the polyphony it can reach.
+  if (polyphony_changed)
+    engine_.prepareVoices();
 }
 
 void SynthBase::processModulationChanges() {
   mopo::modulation_change change;
+  bool graph_changed = false;
   while (getNextModulationChange(change)) {
     mopo::ModulationConnection* connection = change.first;
     mopo::mopo_float amount = change.second;
     connection->amount.set(amount);
 
     bool active = engine_.isModulationActive(connection);
-    if (active && amount == 0.0)
+    if (active && amount == 0.0) {
       engine_.disconnectModulation(connection);
-    else if (!active && amount)
+      graph_changed = true;
+    }
+    else if (!active && amount) {
       engine_.connectModulation(connection);
+      graph_changed = true;
+    }
   }
+
+  // The engine only renders voices through ports built for the current graph.
+  if (graph_changed)
+    engine_.prepareVoices();
 }
 
 void SynthBase::updateMemoryOutput(int samples, const mopo::mopo_float* left,
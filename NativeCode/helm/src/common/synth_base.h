@@ -24,6 +24,7 @@
 #include "helm_engine.h"
 #include "memory.h"
 #include "midi_manager.h"
+#include <atomic>
 #include <string>
 
 class SynthGuiInterface;
@@ -78,6 +79,10 @@ class SynthBase : public MidiManager::Listener {
     mopo::HelmEngine* getEngine() { return &engine_; }
     MidiKeyboardState* getKeyboardState() { return keyboard_state_; }
     const float* getOutputMemory() { return output_memory_; }
+
+    // The oscilloscope memory is only written while something is reading it.
+    void addOutputMemoryReader() { output_memory_readers_++; }
+    void removeOutputMemoryReader() { output_memory_readers_--; }
     mopo::ModulationConnectionBank& getModulationBank() { return modulation_bank_; }
 
     struct ValueChangedCallback : public CallbackMessage {
@@ -96,6 +101,7 @@ class SynthBase : public MidiManager::Listener {
     virtual SynthGuiInterface* getGuiInterface() = 0;
     var saveToVar(String author);
     void loadFromVar(var state);
+    bool loadFromBinaryFile(File patch);
     mopo::ModulationConnection* getConnection(const std::string& source,
                                               const std::string& destination);
 
@@ -107,8 +113,27 @@ class SynthBase : public MidiManager::Listener {
       return modulation_change_queue_.try_dequeue(change);
     }
 
+    // Reads a block's MIDI from the start once, however many sub-blocks the
+    // block renders in.
+    struct MidiCursor {
+      MidiCursor(const MidiBuffer& buffer) : iterator(buffer) { next(); }
+
+      void next() { has_event = iterator.getNextEvent(message, sample); }
+
+      MidiBuffer::Iterator iterator;
+      MidiMessage message;
+      int sample;
+      bool has_event;
+    };
+
     void processAudio(AudioSampleBuffer* buffer, int channels, int samples, int offset);
-    void processMidi(MidiBuffer& buffer, int start_sample = 0, int end_sample = 0);
+    void processMidi(MidiBuffer& buffer);
+
+    // Dispatches the cursor's events before _end_sample_ to the sub-block
+    // starting at _start_sample_ and returns where that sub-block ends. A
+    // controller or pitch wheel event inside it ends it early so the change
+    // starts on its own sample at the start of the next sub-block.
+    int processMidi(MidiCursor& cursor, int start_sample, int end_sample);
     void processKeyboardEvents(MidiBuffer& buffer, int num_samples);
     void processControlChanges();
     void processModulationChanges();
@@ -128,6 +153,9 @@ class SynthBase : public MidiManager::Listener {
     mopo::mopo_float memory_reset_period_;
     mopo::mopo_float memory_input_offset_;
     int memory_index_;
+    std::atomic<int> output_memory_readers_;
+
+    MidiBuffer keyboard_messages_;
 
     std::map<std::string, String> save_info_;
     mopo::control_map controls_;
@@ -17,9 +17,27 @@
 #ifndef SYNTH_GUI_INTERFACE_H
 #define SYNTH_GUI_INTERFACE_H
 
-#include "full_interface.h"
 #include "synth_base.h"
 
+#ifdef HELM_HEADLESS
+
+// Headless builds have no editor, so nothing implements this and
+// getGuiInterface() always returns nullptr. The no-op calls only let the
+// shared synth code compile without the interface sources.
+class SynthGuiInterface {
+  public:
+    virtual ~SynthGuiInterface() { }
+
+    void updateFullGui() { }
+    void updateGuiControl(const std::string& name, mopo::mopo_float value) { }
+    void notifyChange() { }
+    void notifyFresh() { }
+};
+
+#else
+
+#include "full_interface.h"
+
 class SynthGuiInterface {
   public:
     SynthGuiInterface(SynthBase* synth, bool use_gui = true);
@@ -42,4 +60,6 @@ class SynthGuiInterface {
     ScopedPointer<FullInterface> gui_;
 };
 
+#endif // HELM_HEADLESS
+
 #endif // SYNTH_GUI_INTERFACE_H
@@ -85,6 +85,10 @@ PatchBrowser::PatchBrowser() : Overlay("patch_browser") {
   bank_locations.add(bank_dir);
   banks_model_->rescanFiles(bank_locations);
 
+  patch_index_ = new PatchIndex(bank_dir, LoadSave::getPatchIndexFile());
+  patch_index_->setListener(this);
+  patch_index_->refresh();
+
   banks_view_ = new ListBox("banks", banks_model_);
   banks_view_->setMultipleSelectionEnabled(false);
   banks_view_->setClickingTogglesRowSelection(true);
@@ -285,6 +289,7 @@ void PatchBrowser::visibilityChanged() {
   if (isVisible()) {
     search_box_->setText("");
     search_box_->grabKeyboardFocus();
+    patch_index_->refresh();
 
     bool is_cc = license_.contains("creativecommons");
     cc_license_link_->setVisible(isPatchSelected() && is_cc);
@@ -329,6 +334,7 @@ void PatchBrowser::textEditorEscapeKeyPressed(TextEditor& editor) {
 }
 
 void PatchBrowser::fileSaved(File saved_file) {
+  patch_index_->updateFile(saved_file);
   patches_view_->deselectAllRows();
   folders_view_->deselectAllRows();
   banks_view_->deselectAllRows();
@@ -338,9 +344,15 @@ void PatchBrowser::fileSaved(File saved_file) {
 }
 
 void PatchBrowser::fileDeleted(File saved_file) {
+  patch_index_->removeFile(saved_file);
+  patch_index_->refresh();
   scanAll();
 }
 
+void PatchBrowser::patchIndexUpdated(PatchIndex* index) {
+  scanPatches();
+}
+
 void PatchBrowser::buttonClicked(Button* clicked_button) {
   if (clicked_button == save_as_button_ && save_section_)
     save_section_->setVisible(true);
@@ -355,6 +367,7 @@ void PatchBrowser::buttonClicked(Button* clicked_button) {
     setVisible(false);
   else if (clicked_button == import_bank_button_) {
     LoadSave::importBank();
+    patch_index_->refresh();
     scanAll();
   }
   else if (clicked_button == export_bank_button_) {
@@ -455,15 +468,23 @@ bool PatchBrowser::loadFromFile(File& patch) {
 }
 
 void PatchBrowser::setPatchInfo(File& patch) {
-  var parsed_json_state;
-  if (patch.exists() && JSON::parse(patch.loadFileAsString(), parsed_json_state).wasOk()) {
+  PatchIndex::Entry entry;
+  if (patch_index_->getEntry(patch, entry)) {
+    author_ = entry.author;
+    license_ = entry.license;
+  }
+  else {
+    var parsed_json_state;
+    if (!patch.exists() || !JSON::parse(patch.loadFileAsString(), parsed_json_state).wasOk())
+      return;
+
     author_ = LoadSave::getAuthor(parsed_json_state);
     license_ = LoadSave::getLicense(parsed_json_state);
-
-    bool is_cc = license_.contains("creativecommons");
-    cc_license_link_->setVisible(is_cc);
-    gpl_license_link_->setVisible(!is_cc);
   }
+
+  bool is_cc = license_.contains("creativecommons");
+  cc_license_link_->setVisible(is_cc);
+  gpl_license_link_->setVisible(!is_cc);
 }
 
 void PatchBrowser::setSaveSection(SaveSection* save_section) {
@@ -502,8 +523,12 @@ void PatchBrowser::scanPatches() {
   Array<File> folders = getFoldersToScan(folders_view_, folders_model_);
   Array<File> patches_selected = getSelectedFolders(patches_view_, patches_model_);
 
-  String search = "*" + search_box_->getText() + "*." + mopo::PATCH_EXTENSION;
-  patches_model_->rescanFiles(folders, search, true);
+  if (patch_index_->isReady())
+    patches_model_->setFiles(patch_index_->search(folders, search_box_->getText()));
+  else {
+    String search = "*" + search_box_->getText() + "*." + mopo::PATCH_EXTENSION;
+    patches_model_->rescanFiles(folders, search, true);
+  }
   patches_view_->updateContent();
   setSelectedRows(patches_view_, patches_model_, patches_selected);
 }
@@ -22,6 +22,7 @@
 #include "delete_section.h"
 #include "file_list_box_model.h"
 #include "overlay.h"
+#include "patch_index.h"
 #include "save_section.h"
 
 class PatchBrowser : public Overlay,
@@ -30,7 +31,8 @@ class PatchBrowser : public Overlay,
                      public KeyListener,
                      public ButtonListener,
                      public SaveSection::Listener,
-                     public DeleteSection::Listener {
+                     public DeleteSection::Listener,
+                     public PatchIndex::Listener {
   public:
     class PatchSelectedListener {
       public:
@@ -56,6 +58,8 @@ class PatchBrowser : public Overlay,
     void fileSaved(File saved_file) override;
     void fileDeleted(File deleted_file) override;
 
+    void patchIndexUpdated(PatchIndex* index) override;
+
     void buttonClicked(Button* clicked_button) override;
 
     bool isPatchSelected();
@@ -91,6 +95,7 @@ class PatchBrowser : public Overlay,
     ScopedPointer<FileListBoxModel> patches_model_;
 
     ScopedPointer<TextEditor> search_box_;
+    ScopedPointer<PatchIndex> patch_index_;
 
     PatchSelectedListener* listener_;
     ScopedPointer<HyperlinkButton> cc_license_link_;
@@ -27,6 +27,7 @@ HelmEditor::HelmEditor(HelmPlugin& helm) : AudioProcessorEditor(&helm), SynthGui
 
   addAndMakeVisible(gui_);
   gui_->setOutputMemory(helm.getOutputMemory());
+  helm.addOutputMemoryReader();
   gui_->animate(LoadSave::shouldAnimateWidgets());
 
   constrainer_.setMinimumSize(2 * mopo::DEFAULT_WINDOW_WIDTH / 3,
@@ -42,6 +43,10 @@ HelmEditor::HelmEditor(HelmPlugin& helm) : AudioProcessorEditor(&helm), SynthGui
   repaint();
 }
 
+HelmEditor::~HelmEditor() {
+  helm_.removeOutputMemoryReader();
+}
+
 void HelmEditor::paint(Graphics& g) {
   g.fillAll(Colours::white);
 }
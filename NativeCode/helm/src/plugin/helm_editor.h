@@ -25,6 +25,7 @@
 class HelmEditor : public AudioProcessorEditor, public SynthGuiInterface {
   public:
     HelmEditor(HelmPlugin&);
+    ~HelmEditor();
 
     // AudioProcessorEditor
     void paint(Graphics&) override;
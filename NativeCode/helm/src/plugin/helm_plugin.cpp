@@ -16,8 +16,11 @@
 
 #include "helm_plugin.h"
 #include "helm_common.h"
-#include "helm_editor.h"
 #include "load_save.h"
+#include "synth_gui_interface.h"
+#ifndef HELM_HEADLESS
+#include "helm_editor.h"
+#endif
 
 #define PITCH_WHEEL_RESOLUTION 0x3fff
 #define MAX_BUFFER_PROCESS 256
@@ -28,7 +31,11 @@ HelmPlugin::HelmPlugin() {
 
   current_program_ = 0;
 
+  // Headless instances are driven by host state, not the patch banks, so
+  // they skip scanning them.
+#ifndef HELM_HEADLESS
   loadPatches();
+#endif
 
   for (auto control : controls_) {
     ValueBridge* bridge = new ValueBridge(control.first, control.second);
@@ -44,10 +51,14 @@ HelmPlugin::~HelmPlugin() {
 }
 
 SynthGuiInterface* HelmPlugin::getGuiInterface() {
+#ifdef HELM_HEADLESS
+  return nullptr;
+#else
   AudioProcessorEditor* editor = getActiveEditor();
   if (editor)
     return dynamic_cast<SynthGuiInterface*>(editor);
   return nullptr;
+#endif
 }
 
 void HelmPlugin::beginChangeGesture(const std::string& name) {
@@ -173,25 +184,32 @@ void HelmPlugin::processBlock(AudioSampleBuffer& buffer, MidiBuffer& midi_messag
   processControlChanges();
   processModulationChanges();
 
-  MidiBuffer keyboard_messages = midi_messages;
-  processKeyboardEvents(keyboard_messages, total_samples);
+  processKeyboardEvents(midi_messages, total_samples);
 
+  MidiCursor midi_cursor(midi_messages);
   for (int sample_offset = 0; sample_offset < total_samples;) {
-    int num_samples = std::min<int>(total_samples - sample_offset, MAX_BUFFER_PROCESS);
+    int end_sample = std::min<int>(total_samples, sample_offset + MAX_BUFFER_PROCESS);
+    end_sample = processMidi(midi_cursor, sample_offset, end_sample);
+    processAudio(&buffer, num_channels, end_sample - sample_offset, sample_offset);
 
-    processMidi(midi_messages, sample_offset, sample_offset + num_samples);
-    processAudio(&buffer, num_channels, num_samples, sample_offset);
-
-    sample_offset += num_samples;
+    sample_offset = end_sample;
   }
 }
 
 bool HelmPlugin::hasEditor() const {
+#ifdef HELM_HEADLESS
+  return false;
+#else
   return true;
+#endif
 }
 
 AudioProcessorEditor* HelmPlugin::createEditor() {
+#ifdef HELM_HEADLESS
+  return nullptr;
+#else
   return new HelmEditor(*this);
+#endif
 }
 
 void HelmPlugin::parameterChanged(std::string name, mopo::mopo_float value) {
@@ -57,6 +57,7 @@ HelmEditor::HelmEditor(bool use_gui) : SynthGuiInterface(this, use_gui) {
     setLookAndFeel(DefaultLookAndFeel::instance());
     addAndMakeVisible(gui_);
     gui_->setOutputMemory(getOutputMemory());
+    addOutputMemoryReader();
     float window_size = LoadSave::loadWindowSize();
     setSize(window_size * mopo::DEFAULT_WINDOW_WIDTH, window_size * mopo::DEFAULT_WINDOW_HEIGHT);
 
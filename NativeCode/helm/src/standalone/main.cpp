@@ -161,6 +161,10 @@ class HelmApplication : public JUCEApplication {
         std::cout << getApplicationName() << " " << getApplicationVersion() << newLine;
         quit();
       }
+      else if (command.contains(" --export-binary ")) {
+        exportBinaryPatch(getCommandLineParameterArray());
+        quit();
+      }
       else if (command.contains(" --help ") || command.contains(" -h ")) {
         std::cout << "Usage:" << newLine;
         std::cout << "  " << getApplicationName().toLowerCase() << " [OPTION...]" << newLine << newLine;
@@ -169,7 +173,8 @@ class HelmApplication : public JUCEApplication {
         std::cout << "  -h, --help                          Show help options" << newLine << newLine;
         std::cout << "Application Options:" << newLine;
         std::cout << "  -v, --version                       Show version information and exit" << newLine;
-        std::cout << "  --headless                          Run without graphical interface." << newLine << newLine;
+        std::cout << "  --headless                          Run without graphical interface." << newLine;
+        std::cout << "  --export-binary PATCH [OUTPUT]      Convert a patch to the binary format and exit" << newLine << newLine;
         quit();
       }
       else {
@@ -186,6 +191,20 @@ class HelmApplication : public JUCEApplication {
       }
     }
 
+    void exportBinaryPatch(const StringArray& args) {
+      int index = args.indexOf("--export-binary");
+      File working_directory = File::getCurrentWorkingDirectory();
+      File patch = working_directory.getChildFile(args[index + 1].unquoted());
+      File output = patch.withFileExtension(String(mopo::BINARY_PATCH_EXTENSION));
+      if (args[index + 2] != "" && args[index + 2][0] != '-')
+        output = working_directory.getChildFile(args[index + 2].unquoted());
+
+      if (!patch.existsAsFile() || !LoadSave::exportBinaryPatch(patch, output)) {
+        std::cerr << "Couldn't convert " << patch.getFullPathName() << newLine;
+        setApplicationReturnValue(1);
+      }
+    }
+
     bool loadFromCommandLine(const String& command_line) {
       String file_path = command_line;
       if (file_path[0] == '"' && file_path[file_path.length() - 1] == '"')
@@ -0,0 +1,206 @@
+/* Copyright 2013-2017 Matt Tytel
+ *
+ * helm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * helm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with helm.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "binary_patch.h"
+
+#include "helm_engine.h"
+
+#include <cstdint>
+#include <cstring>
+
+namespace {
+  const int PATCH_MAGIC = 0x424d4c48;
+  const int PATCH_VERSION = 1;
+
+  // Returns the string after the one at string, or null if it runs past end.
+  const char* nextString(const char* string, const char* end) {
+    if (string == nullptr || string >= end)
+      return nullptr;
+
+    const char* terminator = static_cast<const char*>(memchr(string, 0, end - string));
+    return terminator ? terminator + 1 : nullptr;
+  }
+
+  const std::map<std::string, mopo::ValueDetails>& parameterDetails() {
+    return mopo::Parameters::lookup_.getAllDetails();
+  }
+} // namespace
+
+namespace mopo {
+
+  BinaryPatch::BinaryPatch() : header_(nullptr), values_(nullptr), modulations_(nullptr),
+                               modulation_names_(nullptr) {
+    for (int i = 0; i < kNumMetadata; ++i)
+      metadata_[i] = "";
+  }
+
+  bool BinaryPatch::read(const char* buffer, int size) {
+    if (buffer == nullptr || size < static_cast<int>(sizeof(Header)) ||
+        reinterpret_cast<uintptr_t>(buffer) % sizeof(mopo_float)) {
+      return false;
+    }
+
+    const Header* header = reinterpret_cast<const Header*>(buffer);
+    if (header->magic != PATCH_MAGIC || header->version != PATCH_VERSION ||
+        header->num_parameters < 0 || header->num_modulations < 0 ||
+        header->strings_size <= 0 || header->size > size) {
+      return false;
+    }
+
+    int64_t expected_size = sizeof(Header);
+    expected_size += static_cast<int64_t>(header->num_parameters) * sizeof(mopo_float);
+    expected_size += static_cast<int64_t>(header->num_modulations) * sizeof(Modulation);
+    expected_size += header->strings_size;
+    if (expected_size != header->size)
+      return false;
+
+    const char* values = buffer + sizeof(Header);
+    const char* modulations = values + header->num_parameters * sizeof(mopo_float);
+    const char* strings = modulations + header->num_modulations * sizeof(Modulation);
+    const char* strings_end = strings + header->strings_size;
+    if (strings_end[-1])
+      return false;
+
+    const char* metadata[kNumMetadata];
+    const char* string = strings;
+    for (int i = 0; i < kNumMetadata; ++i) {
+      metadata[i] = string;
+      string = nextString(string, strings_end);
+    }
+
+    const char* parameter_names = string;
+    for (int i = 0; i < header->num_parameters; ++i)
+      string = nextString(string, strings_end);
+
+    const char* modulation_names = string;
+    for (int i = 0; i < 2 * header->num_modulations; ++i)
+      string = nextString(string, strings_end);
+
+    if (string == nullptr)
+      return false;
+
+    header_ = header;
+    values_ = reinterpret_cast<const mopo_float*>(values);
+    modulations_ = reinterpret_cast<const Modulation*>(modulations);
+    modulation_names_ = modulation_names;
+    for (int i = 0; i < kNumMetadata; ++i)
+      metadata_[i] = metadata[i];
+
+    parameter_indices_.clear();
+    if (header->parameter_layout == parameterLayout())
+      return true;
+
+    // Written by a build with other parameters, so match them up by name.
+    const std::map<std::string, ValueDetails>& details = parameterDetails();
+    std::map<std::string, int> indices;
+    int index = 0;
+    for (auto& parameter : details)
+      indices[parameter.first] = index++;
+
+    const char* name = parameter_names;
+    for (int i = 0; i < header->num_parameters; ++i) {
+      auto found = indices.find(name);
+      parameter_indices_.push_back(found == indices.end() ? -1 : found->second);
+      name = nextString(name, strings_end);
+    }
+    return true;
+  }
+
+  int BinaryPatch::parameterIndex(int index) const {
+    if (parameter_indices_.empty())
+      return index;
+    return parameter_indices_[index];
+  }
+
+  void BinaryPatch::resetConnection(int index, ModulationConnection* connection,
+                                    const HelmEngine* engine) const {
+    const char* source = modulation_names_;
+    for (int i = 0; i < 2 * index; ++i)
+      source += strlen(source) + 1;
+    const char* destination = source + strlen(source) + 1;
+
+    connection->resetConnection(source, destination);
+    if (header_->modulation_layout == engine->getModulationLayout()) {
+      connection->source_id = modulations_[index].source_id;
+      connection->destination_id = modulations_[index].destination_id;
+    }
+  }
+
+  int BinaryPatch::write(char* buffer, int size,
+                         const std::map<std::string, mopo_float>& values,
+                         const std::vector<ModulationSetting>& modulations,
+                         const std::string* metadata, const HelmEngine* engine) {
+    const std::map<std::string, ValueDetails>& details = parameterDetails();
+
+    std::string strings;
+    for (int i = 0; i < kNumMetadata; ++i)
+      strings.append(metadata[i].c_str(), metadata[i].size() + 1);
+    for (auto& parameter : details)
+      strings.append(parameter.first.c_str(), parameter.first.size() + 1);
+    for (const ModulationSetting& modulation : modulations) {
+      strings.append(modulation.source.c_str(), modulation.source.size() + 1);
+      strings.append(modulation.destination.c_str(), modulation.destination.size() + 1);
+    }
+
+    Header header;
+    header.magic = PATCH_MAGIC;
+    header.version = PATCH_VERSION;
+    header.parameter_layout = parameterLayout();
+    header.modulation_layout = engine->getModulationLayout();
+    header.num_parameters = details.size();
+    header.num_modulations = modulations.size();
+    header.strings_size = strings.size();
+    header.size = sizeof(Header) + header.num_parameters * sizeof(mopo_float) +
+                  header.num_modulations * sizeof(Modulation) + header.strings_size;
+
+    if (buffer == nullptr || header.size > size)
+      return header.size;
+
+    char* position = buffer;
+    memcpy(position, &header, sizeof(Header));
+    position += sizeof(Header);
+
+    for (auto& parameter : details) {
+      auto value = values.find(parameter.first);
+      mopo_float stored = value == values.end() ? parameter.second.default_value : value->second;
+      memcpy(position, &stored, sizeof(mopo_float));
+      position += sizeof(mopo_float);
+    }
+
+    for (const ModulationSetting& setting : modulations) {
+      Modulation modulation;
+      modulation.source_id = engine->getModulationSourceId(setting.source);
+      modulation.destination_id = engine->getModulationDestinationId(setting.destination);
+      modulation.amount = setting.amount;
+      memcpy(position, &modulation, sizeof(Modulation));
+      position += sizeof(Modulation);
+    }
+
+    memcpy(position, strings.data(), strings.size());
+    return header.size;
+  }
+
+  unsigned int BinaryPatch::parameterLayout() {
+    static const unsigned int layout = [] {
+      unsigned int hash = hashName("");
+      for (auto& parameter : parameterDetails())
+        hash = hashName(parameter.first, hash);
+      return hash;
+    }();
+
+    return layout;
+  }
+} // namespace mopo
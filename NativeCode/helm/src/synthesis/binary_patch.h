@@ -0,0 +1,124 @@
+/* Copyright 2013-2017 Matt Tytel
+ *
+ * helm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * helm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with helm.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+#ifndef BINARY_PATCH_H
+#define BINARY_PATCH_H
+
+#include "mopo.h"
+#include "helm_common.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace mopo {
+  class HelmEngine;
+
+  // Compact patch format that is read in place, so a file can be used
+  // straight from a memory map without parsing or copying. Fields are native
+  // endian and aligned:
+  //
+  //   Header
+  //   mopo_float values[num_parameters]        in Parameters index order
+  //   Modulation modulations[num_modulations]  ids from the engine registry
+  //   char strings[strings_size]               NUL terminated
+  //
+  // The strings are the metadata, then every parameter name, then the source
+  // and destination name of every modulation. They're only used to load
+  // files written by a build with a different parameter or modulation layout.
+  class BinaryPatch {
+    public:
+      enum Metadata {
+        kPatchName,
+        kFolderName,
+        kAuthor,
+        kLicense,
+        kSynthVersion,
+        kNumMetadata
+      };
+
+      struct Header {
+        int magic;
+        int version;
+        int size;
+        unsigned int parameter_layout;
+        unsigned int modulation_layout;
+        int num_parameters;
+        int num_modulations;
+        int strings_size;
+      };
+
+      struct Modulation {
+        int source_id;
+        int destination_id;
+        mopo_float amount;
+      };
+
+      struct ModulationSetting {
+        std::string source;
+        std::string destination;
+        mopo_float amount;
+      };
+
+      BinaryPatch();
+
+      // Points the patch into buffer, which has to stay alive while the patch
+      // is used and be aligned for mopo_float. Returns false if the buffer
+      // isn't a complete patch of this version.
+      bool read(const char* buffer, int size);
+
+      int numParameters() const { return header_->num_parameters; }
+      const mopo_float* values() const { return values_; }
+      int numModulations() const { return header_->num_modulations; }
+      const Modulation* modulations() const { return modulations_; }
+
+      const char* metadata(Metadata type) const { return metadata_[type]; }
+
+      // Index of stored value index in this build's Parameters order, or -1
+      // if this build has no such parameter.
+      int parameterIndex(int index) const;
+
+      // Points connection at modulation index. Ids are used directly when
+      // the engine has the same modulation layout, otherwise the names are.
+      void resetConnection(int index, ModulationConnection* connection,
+                           const HelmEngine* engine) const;
+
+      // Writes a patch and returns its size. Only writes when it fits in
+      // size, so a null buffer measures. Parameters missing from values get
+      // their default like a JSON patch load does.
+      static int write(char* buffer, int size,
+                       const std::map<std::string, mopo_float>& values,
+                       const std::vector<ModulationSetting>& modulations,
+                       const std::string* metadata, const HelmEngine* engine);
+
+      // Hash of the parameter names in index order.
+      static unsigned int parameterLayout();
+
+    private:
+      const Header* header_;
+      const mopo_float* values_;
+      const Modulation* modulations_;
+      const char* metadata_[kNumMetadata];
+      const char* modulation_names_;
+
+      // Stored value index to Parameters index. Only filled in when the
+      // layouts differ.
+      std::vector<int> parameter_indices_;
+  };
+} // namespace mopo
+
+#endif // BINARY_PATCH_H
@@ -0,0 +1,291 @@
+/* Copyright 2013-2017 Matt Tytel
+ *
+ * helm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * helm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with helm.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "branch_finder.h"
+
+#include "fixed_point_oscillator.h"
+#include "helm_oscillators.h"
+#include "noise_oscillator.h"
+#include "value_switch.h"
+
+#include <algorithm>
+
+namespace mopo {
+
+  namespace {
+    const Output* selectedSource(const ValueSwitch* value_switch) {
+      int source = utils::iclamp(value_switch->value(), 0, value_switch->numInputs() - 1);
+      return value_switch->input(source)->source;
+    }
+
+    bool isMultiply(const Processor* processor) {
+      return dynamic_cast<const Multiply*>(processor) ||
+             dynamic_cast<const cr::Multiply*>(processor);
+    }
+
+    bool isAdd(const Processor* processor) {
+      return dynamic_cast<const Add*>(processor) ||
+             dynamic_cast<const cr::Add*>(processor) ||
+             dynamic_cast<const VariableAdd*>(processor) ||
+             dynamic_cast<const cr::VariableAdd*>(processor);
+    }
+
+    // Processors whose output is zero whenever their first input is.
+    bool keepsZero(const Processor* processor) {
+      return dynamic_cast<const Square*>(processor) ||
+             dynamic_cast<const cr::Square*>(processor) ||
+             dynamic_cast<const SampleAndHoldBuffer*>(processor);
+    }
+
+    // Inputs that silence every output of _processor_ when they're all zero.
+    std::vector<std::vector<int>> gainInputs(const Processor* processor) {
+      if (processor->numOutputs() != 1)
+        return { };
+      if (isMultiply(processor))
+        return { { 0 }, { 1 } };
+      if (dynamic_cast<const FixedPointOscillator*>(processor))
+        return { { FixedPointOscillator::kAmplitude } };
+      if (dynamic_cast<const NoiseOscillator*>(processor))
+        return { { NoiseOscillator::kAmplitude } };
+      if (dynamic_cast<const HelmOscillators*>(processor)) {
+        return { { HelmOscillators::kOscillator1Amplitude,
+                   HelmOscillators::kOscillator2Amplitude } };
+      }
+      return { };
+    }
+
+    void addCondition(std::vector<const Value*>* controls, int* smoothing_blocks,
+                      const std::vector<const Value*>& more_controls, int more_smoothing) {
+      for (const Value* control : more_controls) {
+        if (std::find(controls->begin(), controls->end(), control) == controls->end())
+          controls->push_back(control);
+      }
+      *smoothing_blocks = std::max(*smoothing_blocks, more_smoothing);
+    }
+  } // namespace
+
+  BranchFinder::BranchFinder(ProcessorRouter* engine, VoiceHandler* voice_handler,
+                             const std::set<const ValueSwitch*>& modulation_switches) :
+      engine_(engine), voice_handler_(voice_handler),
+      modulation_switches_(modulation_switches) { }
+
+  void BranchFinder::find() {
+    processors_.clear();
+    managed_.clear();
+    unheard_mono_.clear();
+    unheard_voice_.clear();
+    branches_.clear();
+
+    std::vector<std::pair<const Processor*, Processor*>> copies;
+    engine_->getProcessorCopies(&copies);
+    voice_handler_->getMonoRouter()->getProcessorCopies(&copies);
+    voice_handler_->getPolyRouter()->getProcessorCopies(&copies);
+    for (auto& copy : copies) {
+      processors_.push_back(copy.second);
+
+      // Switches turn these on and off themselves.
+      const ValueSwitch* value_switch = dynamic_cast<const ValueSwitch*>(copy.second);
+      if (value_switch) {
+        for (Processor* processor : value_switch->getProcessors())
+          managed_.insert(processor);
+      }
+    }
+
+    std::set<const Processor*> heard = findHeard(nullptr);
+    const ProcessorRouter* poly_router = voice_handler_->getPolyRouter();
+    for (Processor* processor : processors_) {
+      if (!canTurnOff(processor) || heard.count(processor))
+        continue;
+
+      if (processor->router() == poly_router)
+        unheard_voice_.push_back(processor);
+      else
+        unheard_mono_.push_back(processor);
+    }
+
+    for (Processor* processor : processors_) {
+      if (processor->router() != poly_router || !canTurnOff(processor) ||
+          heard.count(processor) == 0) {
+        continue;
+      }
+
+      for (const std::vector<int>& inputs : gainInputs(processor))
+        findBranch(processor, inputs, heard);
+    }
+  }
+
+  BranchFinder::ZeroCondition BranchFinder::findZeroCondition(const Output* output) {
+    ZeroCondition condition;
+    condition.provable = false;
+    condition.smoothing_blocks = 0;
+    if (output == nullptr || output->owner == nullptr)
+      return condition;
+
+    Processor* owner = output->owner;
+    const ValueSwitch* value_switch = dynamic_cast<const ValueSwitch*>(owner);
+    if (value_switch) {
+      // Other switches can change source while voices play.
+      if (modulation_switches_.count(value_switch) &&
+          output == value_switch->output(ValueSwitch::kSwitch)) {
+        return findZeroCondition(selectedSource(value_switch));
+      }
+      return condition;
+    }
+
+    const Value* value = dynamic_cast<const Value*>(owner);
+    if (value) {
+      if (owner->connectedInputs() == 0) {
+        condition.provable = true;
+        condition.controls.push_back(value);
+      }
+      return condition;
+    }
+
+    if (isAdd(owner)) {
+      for (int i = 0; i < owner->numInputs(); ++i) {
+        ZeroCondition input_condition = findZeroCondition(owner->input(i)->source);
+        if (!input_condition.provable)
+          return input_condition;
+        addCondition(&condition.controls, &condition.smoothing_blocks,
+                     input_condition.controls, input_condition.smoothing_blocks);
+      }
+      condition.provable = owner->numInputs() > 0;
+      return condition;
+    }
+
+    if (isMultiply(owner)) {
+      for (int i = 0; i < owner->numInputs(); ++i) {
+        ZeroCondition input_condition = findZeroCondition(owner->input(i)->source);
+        if (input_condition.provable)
+          return input_condition;
+      }
+      return condition;
+    }
+
+    if (keepsZero(owner))
+      return findZeroCondition(owner->input(0)->source);
+
+    // Ramps from the last block's value, so it reaches zero a block late.
+    if (dynamic_cast<const LinearSmoothBuffer*>(owner)) {
+      condition = findZeroCondition(owner->input(LinearSmoothBuffer::kValue)->source);
+      condition.smoothing_blocks++;
+    }
+    return condition;
+  }
+
+  // Routers, processors inside nested routers and whatever has no outputs
+  // are read by something outside the graph, or are themselves the work.
+  bool BranchFinder::isRoot(const Processor* processor) {
+    const ProcessorRouter* router = processor->router();
+    bool top_level = router == engine_ || router == voice_handler_->getMonoRouter() ||
+                     router == voice_handler_->getPolyRouter();
+
+    return !top_level || processor->numOutputs() == 0 ||
+           dynamic_cast<const ProcessorRouter*>(processor) ||
+           dynamic_cast<const NoteHandler*>(processor);
+  }
+
+  bool BranchFinder::canTurnOff(const Processor* processor) {
+    return !isRoot(processor) && dynamic_cast<const Value*>(processor) == nullptr &&
+           managed_.count(processor) == 0;
+  }
+
+  // Everything heard if _silent_'s outputs are zero and it reads nothing.
+  std::set<const Processor*> BranchFinder::findHeard(const Processor* silent) {
+    std::set<const Processor*> heard;
+    std::vector<const Processor*> reading;
+
+    auto hear = [&](const Output* output) {
+      if (output == nullptr)
+        return;
+
+      const Processor* owner = output->owner;
+      if (owner == voice_handler_) {
+        output = voice_handler_->getVoiceOutput(output);
+        owner = output ? output->owner : nullptr;
+      }
+      if (owner && heard.insert(owner).second)
+        reading.push_back(owner);
+    };
+
+    for (int i = 0; i < engine_->numOutputs(); ++i)
+      hear(engine_->output(i));
+    hear(voice_handler_->getVoiceKiller());
+
+    for (const Processor* processor : processors_) {
+      if (isRoot(processor) && heard.insert(processor).second)
+        reading.push_back(processor);
+    }
+    for (const Processor* processor : extra_roots_) {
+      if (heard.insert(processor).second)
+        reading.push_back(processor);
+    }
+
+    while (!reading.empty()) {
+      const Processor* processor = reading.back();
+      reading.pop_back();
+      if (processor == silent)
+        continue;
+
+      const ValueSwitch* value_switch = dynamic_cast<const ValueSwitch*>(processor);
+      if (value_switch && modulation_switches_.count(value_switch)) {
+        hear(selectedSource(value_switch));
+        continue;
+      }
+
+      for (int i = 0; i < processor->numInputs(); ++i) {
+        const Input* input = processor->input(i);
+        if (input)
+          hear(input->source);
+      }
+    }
+    return heard;
+  }
+
+  void BranchFinder::findBranch(Processor* gain, std::vector<int> gain_inputs,
+                                const std::set<const Processor*>& heard) {
+    Branch branch;
+    branch.smoothing_blocks = 0;
+    for (int index : gain_inputs) {
+      ZeroCondition condition = findZeroCondition(gain->input(index)->source);
+      if (!condition.provable)
+        return;
+      addCondition(&branch.controls, &branch.smoothing_blocks,
+                   condition.controls, condition.smoothing_blocks);
+    }
+
+    // Checking the controls every block is only worth it when the branch
+    // has audio rate work in it.
+    std::set<const Processor*> heard_anyway = findHeard(gain);
+    const ProcessorRouter* poly_router = voice_handler_->getPolyRouter();
+    bool renders_audio = false;
+    for (Processor* processor : processors_) {
+      if (processor->router() != poly_router || heard.count(processor) == 0 ||
+          !canTurnOff(processor)) {
+        continue;
+      }
+
+      if (processor == gain || heard_anyway.count(processor) == 0) {
+        branch.processors.push_back(processor);
+        renders_audio = renders_audio ||
+                        (!processor->isControlRate() && !isMultiply(processor));
+      }
+    }
+
+    if (renders_audio)
+      branches_.push_back(branch);
+  }
+} // namespace mopo
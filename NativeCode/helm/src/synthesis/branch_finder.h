@@ -0,0 +1,101 @@
+/* Copyright 2013-2017 Matt Tytel
+ *
+ * helm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * helm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with helm.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+#ifndef BRANCH_FINDER_H
+#define BRANCH_FINDER_H
+
+#include "mopo.h"
+
+#include <set>
+#include <vector>
+
+namespace mopo {
+  class ValueSwitch;
+
+  // Reads a patch's graph for processors that can't be heard, so they can be
+  // turned off until the patch changes.
+  //
+  // A processor is heard when something heard reads it. The engine's
+  // outputs, the voice killer, routers, processors inside nested routers and
+  // any extra roots are always heard. Modulation switches only read the
+  // source they've selected, so modulation sources nothing is connected to
+  // and the sums behind unmodulated controls go unheard.
+  //
+  // Gains in the voice graph, the inputs of a Multiply and the amplitudes of
+  // the sub and noise oscillators, are branch points. When a gain reads a
+  // chain of controls that hold it at zero, the gain's processor and what only
+  // it reads can be turned off while those controls stay at zero.
+  class BranchFinder {
+    public:
+      // Voice processors that can't be heard while every control is zero.
+      // Smoothing between the controls and the gain takes up to
+      // _smoothing_blocks_ blocks to reach zero after they do.
+      struct Branch {
+        std::vector<const Value*> controls;
+        std::vector<Processor*> processors;
+        int smoothing_blocks;
+      };
+
+      // _modulation_switches_ are the switches that only change when
+      // modulations are connected or disconnected.
+      BranchFinder(ProcessorRouter* engine, VoiceHandler* voice_handler,
+                   const std::set<const ValueSwitch*>& modulation_switches);
+
+      // Something outside the routers, like an arpeggiator, reads _root_'s
+      // inputs.
+      void addRoot(Processor* root) { extra_roots_.push_back(root); }
+
+      void find();
+
+      const std::vector<Processor*>& getUnheardMonoProcessors() const {
+        return unheard_mono_;
+      }
+      const std::vector<Processor*>& getUnheardVoiceProcessors() const {
+        return unheard_voice_;
+      }
+      const std::vector<Branch>& getBranches() const { return branches_; }
+
+    private:
+      // Controls that all have to be zero for an output to be zero.
+      struct ZeroCondition {
+        bool provable;
+        std::vector<const Value*> controls;
+        int smoothing_blocks;
+      };
+
+      ZeroCondition findZeroCondition(const Output* output);
+      bool isRoot(const Processor* processor);
+      bool canTurnOff(const Processor* processor);
+      std::set<const Processor*> findHeard(const Processor* silent);
+      void findBranch(Processor* gain, std::vector<int> gain_inputs,
+                      const std::set<const Processor*>& heard);
+
+      ProcessorRouter* engine_;
+      VoiceHandler* voice_handler_;
+      std::set<const ValueSwitch*> modulation_switches_;
+      std::vector<Processor*> extra_roots_;
+
+      std::vector<Processor*> processors_;
+      std::set<const Processor*> managed_;
+
+      std::vector<Processor*> unheard_mono_;
+      std::vector<Processor*> unheard_voice_;
+      std::vector<Branch> branches_;
+  };
+} // namespace mopo
+
+#endif // BRANCH_FINDER_H
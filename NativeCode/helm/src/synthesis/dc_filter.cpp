@@ -16,6 +16,8 @@
 
 #include "dc_filter.h"
 
+#include "processor_state.h"
+
 namespace mopo {
 
   DcFilter::DcFilter() : Processor(DcFilter::kNumInputs, 1) {
@@ -45,4 +47,8 @@ namespace mopo {
     past_in_ = past_out_ = 0.0;
   }
 
+  void DcFilter::syncState(ProcessorState* state) {
+    state->sync(past_in_);
+    state->sync(past_out_);
+  }
 } // namespace mopo
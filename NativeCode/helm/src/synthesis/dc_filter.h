@@ -37,6 +37,7 @@ namespace mopo {
 
       virtual Processor* clone() const { return new DcFilter(*this); }
       virtual void process();
+      virtual void syncState(ProcessorState* state);
 
       void computeCoefficients() {
         coefficient_ = 1.0 - COEFFICIENT_TO_SR_CONSTANT / getSampleRate();
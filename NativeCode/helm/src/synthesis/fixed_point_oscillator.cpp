@@ -16,9 +16,24 @@
 
 #include "fixed_point_oscillator.h"
 
+#include "processor_state.h"
+
 namespace mopo {
 
-  FixedPointOscillator::FixedPointOscillator() : Processor(kNumInputs, 1), phase_(0) { }
+  namespace {
+    // Reads _to_ blended toward _from_ by _fade_, so a block that moves to
+    // another level starts out on the level the last block used.
+    inline mopo_float fadedWave(const float* from, const float* to,
+                                unsigned int phase, mopo_float fade) {
+      mopo_float to_value = FixedPointWave::interpretWave(to, phase);
+      if (from == to)
+        return to_value;
+      return to_value + fade * (FixedPointWave::interpretWave(from, phase) - to_value);
+    }
+  } // namespace
+
+  FixedPointOscillator::FixedPointOscillator() : Processor(kNumInputs, 1),
+      phase_(0), last_wave_buffer_(nullptr) { }
 
   void FixedPointOscillator::process() {
     const mopo_float* amplitude = input(kAmplitude)->source->buffer;
@@ -30,6 +45,7 @@ namespace mopo {
 
     if (amplitude[0] == 0.0 && amplitude[buffer_size_ - 1] == 0.0) {
       phase_ += phase_inc * buffer_size_;
+      last_wave_buffer_ = nullptr;
       utils::zeroBuffer(dest, buffer_size_);
       return;
     }
@@ -39,13 +55,18 @@ namespace mopo {
 
     int waveform = static_cast<int>(input(kWaveform)->source->buffer[0] + 0.5);
     waveform = mopo::utils::iclamp(waveform, 0, FixedPointWaveLookup::kWhiteNoise - 1);
-    mopo_float* wave_buffer = FixedPointWave::getBuffer(waveform, 2.0 * phase_inc);
+    const float* wave_buffer = FixedPointWave::getBuffer(waveform, 2.0 * phase_inc);
+    const float* fade_buffer = last_wave_buffer_ ? last_wave_buffer_ : wave_buffer;
+    last_wave_buffer_ = wave_buffer;
+    mopo_float fade_inc = 1.0 / buffer_size_;
 
     mopo_float first_adjust = bool(shuffle) * 2.0 / shuffle;
     mopo_float second_adjust = 1.0 / (1.0 - 0.5 * shuffle);
 
-    if (input(kReset)->source->triggered)
+    if (input(kReset)->source->triggered) {
       phase_ = 0;
+      fade_buffer = wave_buffer;
+    }
 
     int i = 0;
     unsigned int buffer_size = buffer_size_;
@@ -57,7 +78,8 @@ namespace mopo {
         for (; i < samples; ++i) {
           phase_ += phase_inc;
           current_phase = phase_ * first_adjust;
-          mopo_float wave_read = FixedPointWave::interpretWave(wave_buffer, current_phase);
+          mopo_float fade = 1.0 - (i + 1) * fade_inc;
+          mopo_float wave_read = fadedWave(fade_buffer, wave_buffer, current_phase, fade);
           dest[i] = amplitude[i] * wave_read;
         }
       }
@@ -67,9 +89,14 @@ namespace mopo {
       for (; i < samples; ++i) {
         phase_ += phase_inc;
         current_phase = (phase_ - shuffle_index) * second_adjust;
-        mopo_float wave_read = FixedPointWave::interpretWave(wave_buffer, current_phase);
+        mopo_float fade = 1.0 - (i + 1) * fade_inc;
+        mopo_float wave_read = fadedWave(fade_buffer, wave_buffer, current_phase, fade);
         dest[i] = amplitude[i] * wave_read;
       }
     }
   }
+
+  void FixedPointOscillator::syncState(ProcessorState* state) {
+    state->sync(phase_);
+  }
 } // namespace mopo
@@ -39,10 +39,13 @@ namespace mopo {
       FixedPointOscillator();
 
       virtual void process();
+      virtual bool rewritesOutputs() const { return true; }
+      virtual void syncState(ProcessorState* state);
       virtual Processor* clone() const { return new FixedPointOscillator(*this); }
 
     protected:
       unsigned int phase_;
+      const float* last_wave_buffer_;
   };
 } // namespace mopo
 
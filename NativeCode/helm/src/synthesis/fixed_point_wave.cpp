@@ -19,160 +19,139 @@
 namespace mopo {
 
   FixedPointWaveLookup::FixedPointWaveLookup() {
-    preprocessSin();
-    preprocessTriangle();
-    preprocessSquare();
-    preprocessUpSaw();
-    preprocessDownSaw();
-    preprocessStep<3>(three_step_);
-    preprocessStep<4>(four_step_);
-    preprocessStep<8>(eight_step_);
-    preprocessPyramid<3>(three_pyramid_);
-    preprocessPyramid<5>(five_pyramid_);
-    preprocessPyramid<9>(nine_pyramid_);
-
-    wave_type waves[kNumFixedPointWaveforms] =
-        { sin_, triangle_, square_, down_saw_, up_saw_,
-          three_step_, four_step_, eight_step_,
-          three_pyramid_, five_pyramid_, nine_pyramid_ };
-
-    memcpy(waves_, waves, kNumFixedPointWaveforms * sizeof(wave_type));
-  }
-
-  void FixedPointWaveLookup::preprocessSin() {
-    for (int h = 0; h < HARMONICS + 1; ++h) {
-      for (int i = 0; i < FIXED_LOOKUP_SIZE; ++i)
-        sin_[h][i] = sin((2 * PI * i) / FIXED_LOOKUP_SIZE);
+    for (int i = 0; i < FIXED_LOOKUP_SIZE; ++i)
+      sin_[i] = sin((2 * PI * i) / FIXED_LOOKUP_SIZE);
+
+    for (int r = 0; r < MAX_RATIO; ++r) {
+      int l = 0;
+      while (l < LEVELS - 1 && harmonics(l + 1) <= r)
+        l++;
+      ratio_levels_[r] = l;
     }
 
-    preprocessDiffs(sin_);
+    mopo_float triangle[FIXED_LOOKUP_SIZE];
+    mopo_float square[FIXED_LOOKUP_SIZE];
+    mopo_float up_saw[FIXED_LOOKUP_SIZE];
+    mopo_float buffer[FIXED_LOOKUP_SIZE];
+    utils::zeroBuffer(triangle, FIXED_LOOKUP_SIZE);
+    utils::zeroBuffer(square, FIXED_LOOKUP_SIZE);
+    utils::zeroBuffer(up_saw, FIXED_LOOKUP_SIZE);
+
+    // Each level has every harmonic of the level below it, so the basic
+    // waves are built up one level at a time.
+    int last_harmonics = 0;
+    for (int l = 0; l < LEVELS; ++l) {
+      int level_harmonics = harmonics(l);
+      addTriangleHarmonics(triangle, last_harmonics, level_harmonics);
+      addSquareHarmonics(square, last_harmonics, level_harmonics);
+      addUpSawHarmonics(up_saw, last_harmonics, level_harmonics);
+      last_harmonics = level_harmonics;
+
+      store(kSin, l, sin_);
+      store(kTriangle, l, triangle);
+      store(kSquare, l, square);
+      store(kDownSaw, l, up_saw, -1.0);
+      store(kUpSaw, l, up_saw);
+
+      computeStep(buffer, up_saw, level_harmonics, 3);
+      store(kThreeStep, l, buffer);
+      computeStep(buffer, up_saw, level_harmonics, 4);
+      store(kFourStep, l, buffer);
+      computeStep(buffer, up_saw, level_harmonics, 8);
+      store(kEightStep, l, buffer);
+
+      computePyramid(buffer, square, 3);
+      store(kThreePyramid, l, buffer);
+      computePyramid(buffer, square, 5);
+      store(kFivePyramid, l, buffer);
+      computePyramid(buffer, square, 9);
+      store(kNinePyramid, l, buffer);
+    }
   }
 
-  void FixedPointWaveLookup::preprocessTriangle() {
-    for (int i = 0; i < FIXED_LOOKUP_SIZE; ++i) {
-      triangle_[0][i] = Wave::triangle((1.0 * i) / FIXED_LOOKUP_SIZE);
-
-      int p = i;
-      mopo_float scale = 8.0 / (PI * PI);
-      triangle_[HARMONICS][i] = scale * sin_[0][p];
+  void FixedPointWaveLookup::addTriangleHarmonics(mopo_float* dest, int from, int to) {
+    mopo_float scale = 8.0 / (PI * PI);
 
-      for (int h = 1; h < HARMONICS; ++h) {
-        p = (p + i) % FIXED_LOOKUP_SIZE;
-        triangle_[HARMONICS - h][i] = triangle_[HARMONICS - h + 1][i];
-        mopo_float harmonic = scale * sin_[0][p] / ((h + 1) * (h + 1));
+    for (int i = 0; i < FIXED_LOOKUP_SIZE; ++i) {
+      for (int h = from; h < to; ++h) {
+        int p = ((h + 1) * i) % FIXED_LOOKUP_SIZE;
+        mopo_float harmonic = scale * sin_[p] / ((h + 1) * (h + 1));
 
         if (h % 4 == 0)
-          triangle_[HARMONICS - h][i] += harmonic;
+          dest[i] += harmonic;
         else if (h % 2 == 0)
-          triangle_[HARMONICS - h][i] -= harmonic;
+          dest[i] -= harmonic;
       }
     }
-
-    preprocessDiffs(triangle_);
   }
 
-  void FixedPointWaveLookup::preprocessSquare() {
-    for (int i = 0; i < FIXED_LOOKUP_SIZE; ++i) {
-      square_[0][i] = Wave::square((1.0 * i) / FIXED_LOOKUP_SIZE);
-
-      int p = i;
-      mopo_float scale = 4.0 / PI;
-      square_[HARMONICS][i] = scale * sin_[0][p];
+  void FixedPointWaveLookup::addSquareHarmonics(mopo_float* dest, int from, int to) {
+    mopo_float scale = 4.0 / PI;
 
-      for (int h = 1; h < HARMONICS; ++h) {
-        p = (p + i) % FIXED_LOOKUP_SIZE;
-        square_[HARMONICS - h][i] = square_[HARMONICS - h + 1][i];
+    for (int i = 0; i < FIXED_LOOKUP_SIZE; ++i) {
+      for (int h = from; h < to; ++h) {
+        int p = ((h + 1) * i) % FIXED_LOOKUP_SIZE;
 
         if (h % 2 == 0)
-          square_[HARMONICS - h][i] += scale * sin_[0][p] / (h + 1);
+          dest[i] += scale * sin_[p] / (h + 1);
       }
     }
-
-    preprocessDiffs(square_);
   }
 
-  void FixedPointWaveLookup::preprocessDownSaw() {
-    for (int h = 0; h < HARMONICS + 1; ++h) {
-      for (int i = 0; i < FIXED_LOOKUP_SIZE; ++i)
-        down_saw_[h][i] = -up_saw_[h][i];
-    }
-
-    preprocessDiffs(down_saw_);
-  }
+  void FixedPointWaveLookup::addUpSawHarmonics(mopo_float* dest, int from, int to) {
+    mopo_float scale = 2.0 / PI;
 
-  void FixedPointWaveLookup::preprocessUpSaw() {
     for (int i = 0; i < FIXED_LOOKUP_SIZE; ++i) {
-      up_saw_[0][i] = Wave::upsaw((1.0 * i) / FIXED_LOOKUP_SIZE);
-
       int index = (i + (FIXED_LOOKUP_SIZE / 2)) % FIXED_LOOKUP_SIZE;
-      int p = i;
-      mopo_float scale = 2.0 / PI;
-      up_saw_[HARMONICS][index] = scale * sin_[0][p];
 
-      for (int h = 1; h < HARMONICS; ++h) {
-        p = (p + i) % FIXED_LOOKUP_SIZE;
-        mopo_float harmonic = scale * sin_[0][p] / (h + 1);
+      for (int h = from; h < to; ++h) {
+        int p = ((h + 1) * i) % FIXED_LOOKUP_SIZE;
+        mopo_float harmonic = scale * sin_[p] / (h + 1);
 
         if (h % 2 == 0)
-          up_saw_[HARMONICS - h][index] = up_saw_[HARMONICS - h + 1][index] + harmonic;
+          dest[index] += harmonic;
         else
-          up_saw_[HARMONICS - h][index] = up_saw_[HARMONICS - h + 1][index] - harmonic;
+          dest[index] -= harmonic;
       }
     }
-
-    preprocessDiffs(up_saw_);
   }
 
-  template<size_t steps>
-  void FixedPointWaveLookup::preprocessStep(wave_type buffer) {
-    static int num_steps = steps;
-    static const mopo_float step_size = num_steps / (num_steps - 1.0);
-
-    for (int h = 0; h < HARMONICS + 1; ++h) {
-      int base_num_harmonics = HARMONICS + 1 - h;
-      int harmony_num_harmonics = base_num_harmonics / num_steps;
-      int harmony_h = HARMONICS + 1 - harmony_num_harmonics;
+  void FixedPointWaveLookup::computeStep(mopo_float* dest, const mopo_float* up_saw,
+                                         int harmonics, int steps) {
+    mopo_float step_size = steps / (steps - 1.0);
 
-      for (int i = 0; i < FIXED_LOOKUP_SIZE; ++i) {
-        buffer[h][i] = step_size * up_saw_[h][i];
+    mopo_float harmony[FIXED_LOOKUP_SIZE];
+    utils::zeroBuffer(harmony, FIXED_LOOKUP_SIZE);
+    addUpSawHarmonics(harmony, 0, harmonics / steps);
 
-        if (harmony_num_harmonics) {
-          int harm_index = (num_steps * i) % FIXED_LOOKUP_SIZE;
-          buffer[h][i] += step_size * down_saw_[harmony_h][harm_index] / num_steps;
-        }
-      }
+    for (int i = 0; i < FIXED_LOOKUP_SIZE; ++i) {
+      int harm_index = (steps * i) % FIXED_LOOKUP_SIZE;
+      dest[i] = step_size * (up_saw[i] - harmony[harm_index] / steps);
     }
-
-    preprocessDiffs(buffer);
   }
 
-  template<size_t steps>
-  void FixedPointWaveLookup::preprocessPyramid(wave_type buffer) {
-    static const int squares = steps - 1;
-    static const int offset = 3 * FIXED_LOOKUP_SIZE / 4;
+  void FixedPointWaveLookup::computePyramid(mopo_float* dest, const mopo_float* square, int steps) {
+    int squares = steps - 1;
+    int offset = 3 * FIXED_LOOKUP_SIZE / 4;
 
-    for (int h = 0; h < HARMONICS + 1; ++h) {
-      for (int i = 0; i < FIXED_LOOKUP_SIZE; ++i) {
-        buffer[h][i] = 0;
+    for (int i = 0; i < FIXED_LOOKUP_SIZE; ++i) {
+      dest[i] = 0.0;
 
-        for (size_t s = 0; s < squares; ++s) {
-          int square_offset = (s * FIXED_LOOKUP_SIZE) / (2 * squares);
-          int phase = (i + offset + square_offset) % FIXED_LOOKUP_SIZE;
-          buffer[h][i] += square_[h][phase] / squares;
-        }
+      for (int s = 0; s < squares; ++s) {
+        int square_offset = (s * FIXED_LOOKUP_SIZE) / (2 * squares);
+        int phase = (i + offset + square_offset) % FIXED_LOOKUP_SIZE;
+        dest[i] += square[phase] / squares;
       }
     }
-
-    preprocessDiffs(buffer);
   }
 
-  void FixedPointWaveLookup::preprocessDiffs(wave_type wave) {
-    for (int h = 0; h < HARMONICS + 1; ++h) {
-      for (int i = 0; i < FIXED_LOOKUP_SIZE - 1; ++i)
-        wave[h][i + FIXED_LOOKUP_SIZE] = FRACTIONAL_MULT * (wave[h][i + 1] - wave[h][i]);
-
-      mopo_float last_delta = wave[h][0] - wave[h][FIXED_LOOKUP_SIZE - 1];
-      wave[h][2 * FIXED_LOOKUP_SIZE - 1] = FRACTIONAL_MULT * last_delta;
+  void FixedPointWaveLookup::store(int waveform, int level, const mopo_float* buffer,
+                                   mopo_float scale) {
+    float* dest = levels_[waveform][level];
+    for (int i = 0; i < FIXED_LOOKUP_SIZE; ++i) {
+      mopo_float next = buffer[(i + 1) % FIXED_LOOKUP_SIZE];
+      dest[2 * i] = scale * buffer[i];
+      dest[2 * i + 1] = scale * FRACTIONAL_MULT * (next - buffer[i]);
     }
   }
 
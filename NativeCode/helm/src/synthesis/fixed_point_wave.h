@@ -21,6 +21,7 @@
 #include "common.h"
 #include "wave.h"
 #include "utils.h"
+#include <algorithm>
 #include <climits>
 #include <cmath>
 #include <cstdlib>
@@ -28,6 +29,10 @@
 
 namespace mopo {
 
+  // Band limited copies of every waveform spaced a half octave apart: 1, 2,
+  // 3, 4, 6, 8, 12 ... 512 harmonics. Each sample is stored as a float next
+  // to its scaled difference to the next sample, so one level is 8 KB and all
+  // levels of a waveform fit in 144 KB.
   class FixedPointWaveLookup {
     public:
       enum Type {
@@ -54,69 +59,56 @@ namespace mopo {
       constexpr static const int FRACTIONAL_MASK = FRACTIONAL_SIZE - 1;
       constexpr static const mopo_float FRACTIONAL_MULT = 1.0 / FRACTIONAL_SIZE;
 
-      static const int HARMONICS = 63;
-
-      typedef mopo_float (*wave_type)[2 * FIXED_LOOKUP_SIZE];
+      static const int LEVELS = 18;
+      static const int MAX_RATIO = 1024;
 
       FixedPointWaveLookup();
 
-      void preprocessSin();
-      void preprocessTriangle();
-      void preprocessSquare();
-      void preprocessDownSaw();
-      void preprocessUpSaw();
-      template<size_t steps>
-      void preprocessStep(wave_type buffer);
-      template<size_t steps>
-      void preprocessPyramid(wave_type buffer);
-      void preprocessDiffs(wave_type wave);
-
-      mopo_float sin_[HARMONICS + 1][2 * FIXED_LOOKUP_SIZE];
-      mopo_float triangle_[HARMONICS + 1][2 * FIXED_LOOKUP_SIZE];
-      mopo_float square_[HARMONICS + 1][2 * FIXED_LOOKUP_SIZE];
-      mopo_float down_saw_[HARMONICS + 1][2 * FIXED_LOOKUP_SIZE];
-      mopo_float up_saw_[HARMONICS + 1][2 * FIXED_LOOKUP_SIZE];
-      mopo_float three_step_[HARMONICS + 1][2 * FIXED_LOOKUP_SIZE];
-      mopo_float four_step_[HARMONICS + 1][2 * FIXED_LOOKUP_SIZE];
-      mopo_float eight_step_[HARMONICS + 1][2 * FIXED_LOOKUP_SIZE];
-      mopo_float three_pyramid_[HARMONICS + 1][2 * FIXED_LOOKUP_SIZE];
-      mopo_float five_pyramid_[HARMONICS + 1][2 * FIXED_LOOKUP_SIZE];
-      mopo_float nine_pyramid_[HARMONICS + 1][2 * FIXED_LOOKUP_SIZE];
-
-      wave_type waves_[kNumFixedPointWaveforms];
-  };
-
-  class FixedPointWave {
-    public:
-      static inline mopo_float harmonicWave(int waveform, unsigned int t, int harmonic) {
-        return lookup_.waves_[waveform][harmonic][getIndex(t)];
+      // Number of harmonics in a level.
+      static inline int harmonics(int level) {
+        if (level == 0)
+          return 1;
+        if (level % 2)
+          return 1 << ((level + 1) / 2);
+        return 3 << (level / 2 - 1);
       }
 
-      static inline mopo_float wave(int waveform, unsigned int t, int phase_inc) {
-        return lookup_.waves_[waveform][getHarmonicIndex(phase_inc)][getIndex(t)];
+      // The level with the most harmonics that are all at or below _ratio_.
+      inline int level(int ratio) const {
+        return ratio_levels_[std::min(ratio, MAX_RATIO - 1)];
       }
 
-      static inline mopo_float wave(int waveform, unsigned int t) {
-        unsigned int index = getIndex(t);
-        return lookup_.waves_[waveform][0][index];
+      const float* buffer(int waveform, int level) const {
+        return levels_[waveform][level];
       }
 
-      static inline mopo_float* getBuffer(int waveform, int phase_inc) {
-        int clamped_inc = mopo::utils::iclamp(phase_inc, 1, INT_MAX);
-        return lookup_.waves_[waveform][getHarmonicIndex(clamped_inc)];
-      }
+    protected:
+      // Add harmonics _from_ + 1 through _to_ of a waveform to _dest_.
+      void addTriangleHarmonics(mopo_float* dest, int from, int to);
+      void addSquareHarmonics(mopo_float* dest, int from, int to);
+      void addUpSawHarmonics(mopo_float* dest, int from, int to);
+
+      void computeStep(mopo_float* dest, const mopo_float* up_saw, int harmonics, int steps);
+      void computePyramid(mopo_float* dest, const mopo_float* square, int steps);
+      void store(int waveform, int level, const mopo_float* buffer, mopo_float scale = 1.0);
+
+      mopo_float sin_[FIXED_LOOKUP_SIZE];
+      char ratio_levels_[MAX_RATIO];
+      float levels_[kWhiteNoise][LEVELS][2 * FIXED_LOOKUP_SIZE];
+  };
 
-      static inline int getHarmonicIndex(int phase_inc) {
-        int ratio = INT_MAX / phase_inc;
-        return mopo::utils::iclamp(FixedPointWaveLookup::HARMONICS + 1 - ratio,
-                                   0, FixedPointWaveLookup::HARMONICS - 1);
+  class FixedPointWave {
+    public:
+      // The level for a phase increment with every harmonic below nyquist.
+      static inline const float* getBuffer(int waveform, int phase_inc) {
+        int clamped_inc = mopo::utils::iclamp(phase_inc, 1, INT_MAX);
+        return lookup_.buffer(waveform, lookup_.level(INT_MAX / clamped_inc));
       }
 
-      static inline mopo_float interpretWave(const mopo_float* buffer, unsigned int t) {
-        int index = getIndex(t);
-        mopo_float mult = getFractional(t);
-        mopo_float inc = mult * buffer[index + FixedPointWaveLookup::FIXED_LOOKUP_SIZE];
-        return buffer[index] + inc;
+      static inline float interpretWave(const float* buffer, unsigned int t) {
+        int index = 2 * getIndex(t);
+        float fraction = getFractional(t);
+        return buffer[index] + fraction * buffer[index + 1];
       }
 
       static inline unsigned int getIndex(unsigned int t) {
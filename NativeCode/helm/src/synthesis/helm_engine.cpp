@@ -16,18 +16,32 @@
 
 #include "helm_engine.h"
 
+#include "branch_finder.h"
 #include "dc_filter.h"
 #include "helm_lfo.h"
 #include "helm_voice_handler.h"
 #include "peak_meter.h"
+#include "processor_state.h"
 #include "value_switch.h"
 
+#include <cstring>
+
 #ifdef __APPLE__
 #include <fenv.h>
 #endif
 
 #define MAX_DELAY_SAMPLES 300000
 
+namespace {
+  const int STATE_MAGIC = 0x534d4c48;
+  const int STATE_VERSION = 3;
+  const unsigned int STATE_LAYOUT_SEED = 2166136261u;
+
+  // Magic, version, sample rate, graph layout hash and total size.
+  const int STATE_HEADER_SIZE = 5;
+  const int STATE_SIZE_INDEX = 4;
+} // namespace
+
 namespace mopo {
 
   HelmEngine::HelmEngine() : was_playing_arp_(false) {
@@ -45,6 +59,10 @@ namespace mopo {
     fesetenv(FE_DFL_DISABLE_SSE_DENORMS_ENV);
 #endif
 
+    // Lay the graph out in the order it's built, each processor's outputs and
+    // buffers next to it.
+    ProcessorArena arena;
+
     Output* beats_per_second = createMonoModControl("beats_per_minute", true);
     cr::LowerBound* beats_per_second_clamped = new cr::LowerBound(0.0);
     beats_per_second_clamped->plug(beats_per_second);
@@ -55,7 +73,6 @@ namespace mopo {
 
     voice_handler_ = new HelmVoiceHandler(beats_per_second_clamped->output());
     addSubmodule(voice_handler_);
-    voice_handler_->setPolyphony(32);
     voice_handler_->plug(polyphony, VoiceHandler::kPolyphony);
 
     // Monophonic LFO 1.
@@ -283,28 +300,86 @@ namespace mopo {
     registerOutput(clamp_right->output());
 
     HelmModule::init();
+    buildModulationRegistry();
+    prepareVoices();
+  }
+
+  void HelmEngine::buildModulationRegistry() {
+    mod_layout_ = hashName("");
+    for (auto& source : getModulationSources()) {
+      mod_source_ids_[source.first] = mod_source_lookup_.size();
+      mod_source_lookup_.push_back(source.second);
+      mod_layout_ = hashName(source.first, mod_layout_);
+    }
+
+    std::vector<std::string> destination_names;
+    for (auto& mod : getMonoModulations())
+      destination_names.push_back(mod.first);
+    for (auto& mod : getPolyModulations())
+      destination_names.push_back(mod.first);
+
+    for (const std::string& name : destination_names) {
+      mod_layout_ = hashName(name, mod_layout_);
+
+      ModulationDestination destination;
+      destination.mono_destination = getMonoModulationDestination(name);
+      destination.poly_destination = getPolyModulationDestination(name);
+      destination.mono_switch = getMonoModulationSwitch(name);
+      destination.poly_switch = getPolyModulationSwitch(name);
+      MOPO_ASSERT(destination.mono_destination && destination.mono_switch);
+
+      if (mod_destination_ids_.count(name) == 0)
+        mod_destination_ids_[name] = mod_destination_lookup_.size();
+      mod_destination_lookup_.push_back(destination);
+    }
+  }
+
+  int HelmEngine::getModulationSourceId(const std::string& name) const {
+    auto id = mod_source_ids_.find(name);
+    if (id == mod_source_ids_.end())
+      return -1;
+    return id->second;
+  }
+
+  int HelmEngine::getModulationDestinationId(const std::string& name) const {
+    auto id = mod_destination_ids_.find(name);
+    if (id == mod_destination_ids_.end())
+      return -1;
+    return id->second;
+  }
+
+  bool HelmEngine::resolveModulation(ModulationConnection* connection) {
+    if (connection->source_id < 0)
+      connection->source_id = getModulationSourceId(connection->source);
+    if (connection->destination_id < 0)
+      connection->destination_id = getModulationDestinationId(connection->destination);
+
+    return connection->source_id >= 0 &&
+           connection->source_id < getNumModulationSourceIds() &&
+           connection->destination_id >= 0 &&
+           connection->destination_id < getNumModulationDestinationIds();
   }
 
   void HelmEngine::connectModulation(ModulationConnection* connection) {
-    Output* source = getModulationSource(connection->source);
-    bool source_poly = source->owner->isPolyphonic();
-    MOPO_ASSERT(source != nullptr);
+    if (!resolveModulation(connection))
+      return;
 
-    Processor* destination = getModulationDestination(connection->destination, source_poly);
-    MOPO_ASSERT(destination != nullptr);
+    Output* source = mod_source_lookup_[connection->source_id];
+    bool source_poly = source->owner->isPolyphonic();
 
-    ValueSwitch* mono_mod_switch = getMonoModulationSwitch(connection->destination);
-    MOPO_ASSERT(mono_mod_switch != nullptr);
+    const ModulationDestination& lookup = mod_destination_lookup_[connection->destination_id];
+    Processor* destination = lookup.mono_destination;
+    if (source_poly && lookup.poly_destination)
+      destination = lookup.poly_destination;
 
     connection->modulation_scale.plug(source, 0);
     connection->modulation_scale.plug(&connection->amount, 1);
     source->owner->router()->addProcessor(&connection->modulation_scale);
     destination->plugNext(&connection->modulation_scale);
 
-    mono_mod_switch->set(1);
-    ValueSwitch* poly_mod_switch = getPolyModulationSwitch(connection->destination);
-    if (poly_mod_switch)
-      poly_mod_switch->set(1);
+    lookup.mono_switch->set(1);
+    if (lookup.poly_switch)
+      lookup.poly_switch->set(1);
 
     mod_connections_.insert(connection);
   }
@@ -320,24 +395,23 @@ namespace mopo {
   }
 
   void HelmEngine::disconnectModulation(ModulationConnection* connection) {
-    Output* source = getModulationSource(connection->source);
+    MOPO_ASSERT(mod_connections_.count(connection));
+    Output* source = mod_source_lookup_[connection->source_id];
     bool source_poly = source->owner->isPolyphonic();
 
-    Processor* destination = getModulationDestination(connection->destination, source_poly);
-    Processor* mono_destination = getMonoModulationDestination(connection->destination);
-    Processor* poly_destination = getPolyModulationDestination(connection->destination);
-    MOPO_ASSERT(destination != nullptr);
+    const ModulationDestination& lookup = mod_destination_lookup_[connection->destination_id];
+    Processor* destination = lookup.mono_destination;
+    if (source_poly && lookup.poly_destination)
+      destination = lookup.poly_destination;
 
     destination->unplug(&connection->modulation_scale);
 
-    if (mono_destination->connectedInputs() == 1 &&
-        (poly_destination == nullptr || poly_destination->connectedInputs() == 0)) {
-      ValueSwitch* mono_mod_switch = getMonoModulationSwitch(connection->destination);
-      mono_mod_switch->set(0);
-
-      ValueSwitch* poly_mod_switch = getPolyModulationSwitch(connection->destination);
-      if (poly_mod_switch)
-        poly_mod_switch->set(0);
+    if (lookup.mono_destination->connectedInputs() == 1 &&
+        (lookup.poly_destination == nullptr ||
+         lookup.poly_destination->connectedInputs() == 0)) {
+      lookup.mono_switch->set(0);
+      if (lookup.poly_switch)
+        lookup.poly_switch->set(0);
     }
 
     source->owner->router()->removeProcessor(&connection->modulation_scale);
@@ -352,6 +426,53 @@ namespace mopo {
     return voice_handler_->getLastActiveNote();
   }
 
+  void HelmEngine::setVoiceThreads(int num_threads) {
+    voice_handler_->setNumThreads(num_threads);
+    prepareVoices();
+  }
+
+  int HelmEngine::getNumVoices() const {
+    return voice_handler_->getNumVoices();
+  }
+
+  // Modulated polyphony can reach anywhere in its range.
+  int HelmEngine::getReachablePolyphony() {
+    if (mono_mod_destinations_["polyphony"]->connectedInputs() > 1)
+      return Parameters::getDetails("polyphony").max;
+    return controls_["polyphony"]->value();
+  }
+
+  // Reads the patch's graph again for what can't be heard, since connecting
+  // and disconnecting modulations changes it.
+  void HelmEngine::turnOffUnheard() {
+    std::set<const ValueSwitch*> modulation_switches;
+    for (const ModulationDestination& destination : mod_destination_lookup_) {
+      modulation_switches.insert(destination.mono_switch);
+      if (destination.poly_switch)
+        modulation_switches.insert(destination.poly_switch);
+    }
+
+    BranchFinder finder(this, voice_handler_, modulation_switches);
+    finder.addRoot(arpeggiator_);
+    finder.find();
+
+    for (Processor* processor : unheard_)
+      processor->enable(true);
+    unheard_ = finder.getUnheardMonoProcessors();
+    for (Processor* processor : unheard_)
+      processor->enable(false);
+
+    voice_handler_->setSilentBranches(finder.getUnheardVoiceProcessors(),
+                                      finder.getBranches());
+  }
+
+  // A stolen voice fades out on its own while a free one takes its note, so
+  // each playing voice can need another beside it.
+  void HelmEngine::prepareVoices(int polyphony) {
+    turnOffUnheard();
+    voice_handler_->prepareVoices(2 * std::max(polyphony, getReachablePolyphony()));
+  }
+
   void HelmEngine::process() {
     bool playing_arp = arp_on_->value();
     if (was_playing_arp_ != playing_arp)
@@ -428,4 +549,46 @@ namespace mopo {
   void HelmEngine::sustainOff() {
     voice_handler_->sustainOff();
   }
+
+  void HelmEngine::syncState(ProcessorState* state) {
+    arpeggiator_->syncState(state);
+    ProcessorRouter::syncState(state);
+    state->sync(was_playing_arp_);
+  }
+
+  int HelmEngine::saveState(char* buffer, int size) {
+    ProcessorState state(buffer, size);
+    int header[] = { STATE_MAGIC, STATE_VERSION, getSampleRate(),
+                     static_cast<int>(getLayoutHash(STATE_LAYOUT_SEED)), 0 };
+    state.syncArray(header, STATE_HEADER_SIZE);
+    syncState(&state);
+
+    // The total is only known now, so fill it in last.
+    int total = state.size();
+    if (buffer && total <= size)
+      memcpy(buffer + STATE_SIZE_INDEX * sizeof(int), &total, sizeof(int));
+    return total;
+  }
+
+  bool HelmEngine::loadState(const char* buffer, int size) {
+    ProcessorState state(buffer, size);
+    int header[STATE_HEADER_SIZE];
+    state.syncArray(header, STATE_HEADER_SIZE);
+
+    // Check everything that can be checked before touching any processor.
+    if (!state.valid() || header[0] != STATE_MAGIC || header[1] != STATE_VERSION ||
+        header[2] != getSampleRate() ||
+        header[3] != static_cast<int>(getLayoutHash(STATE_LAYOUT_SEED)) ||
+        header[STATE_SIZE_INDEX] < state.size() || header[STATE_SIZE_INDEX] > size) {
+      return false;
+    }
+
+    syncState(&state);
+    if (state.valid())
+      return true;
+
+    // A partial restore can leave notes in any state, so release them.
+    allNotesOff();
+    return false;
+  }
 } // namespace mopo
@@ -30,6 +30,14 @@ namespace mopo {
   class Value;
   class ValueSwitch;
 
+  // Everything a modulation connection needs to reach one destination.
+  struct ModulationDestination {
+    Processor* mono_destination;
+    Processor* poly_destination;
+    ValueSwitch* mono_switch;
+    ValueSwitch* poly_switch;
+  };
+
   // The overall helm engine. All audio processing is contained in here.
   class HelmEngine : public HelmModule, public NoteHandler {
     public:
@@ -39,6 +47,7 @@ namespace mopo {
       void init() override;
 
       void process() override;
+      void syncState(ProcessorState* state) override;
       void setBufferSize(int buffer_size) override;
       void setSampleRate(int sample_rate) override;
     
@@ -49,6 +58,39 @@ namespace mopo {
       void disconnectModulation(ModulationConnection* connection);
       int getNumActiveVoices();
       mopo_float getLastActiveNote() const;
+      void setVoiceThreads(int num_threads);
+
+      // Builds what graph changes like new modulations need, turns off what
+      // the patch can't hear, and builds voices enough for the most polyphony
+      // the patch can reach or _polyphony_ if that's more. Call it after
+      // connecting or disconnecting modulations, and before a polyphony past
+      // getNumVoices() reaches the engine, on the thread that made the
+      // changes. process() never builds voices itself.
+      void prepareVoices(int polyphony = 0);
+      int getNumVoices() const;
+
+      // Runtime state of the DSP graph: voices, envelopes, filters, delay
+      // lines, oscillator phases and sequencer positions. Parameters and
+      // modulation routing aren't included. saveState returns the size needed
+      // and only writes when that fits. loadState only accepts states from an
+      // engine with the same patch structure and sample rate.
+      int saveState(char* buffer, int size);
+      bool loadState(const char* buffer, int size);
+
+      // Dense modulation ids. Sources are numbered in name order, destinations
+      // in name order of the mono readouts followed by the poly readouts.
+      int getModulationSourceId(const std::string& name) const;
+      int getModulationDestinationId(const std::string& name) const;
+      int getNumModulationSourceIds() const { return mod_source_lookup_.size(); }
+      int getNumModulationDestinationIds() const {
+        return mod_destination_lookup_.size();
+      }
+
+      // Hash of the names behind every id, equal for engines with the same ids.
+      unsigned int getModulationLayout() const { return mod_layout_; }
+
+      // The voice handler, for inspecting how voices render.
+      const HelmVoiceHandler* getVoiceHandler() const { return voice_handler_; }
 
       // Keyboard events.
       void allNotesOff(int sample = 0) override;
@@ -80,7 +122,20 @@ namespace mopo {
       PeakMeter* peak_meter_;
       StepGenerator* step_sequencer_;
 
+      void buildModulationRegistry();
+      bool resolveModulation(ModulationConnection* connection);
+      int getReachablePolyphony();
+      void turnOffUnheard();
+
       std::set<ModulationConnection*> mod_connections_;
+
+      std::vector<Output*> mod_source_lookup_;
+      std::vector<ModulationDestination> mod_destination_lookup_;
+      std::map<std::string, int> mod_source_ids_;
+      std::map<std::string, int> mod_destination_ids_;
+      unsigned int mod_layout_;
+
+      std::vector<Processor*> unheard_;
   };
 } // namespace mopo
 
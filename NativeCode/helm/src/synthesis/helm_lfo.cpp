@@ -16,6 +16,7 @@
 
 #include "helm_lfo.h"
 #include "common.h"
+#include "processor_state.h"
 #include "utils.h"
 
 #include <cmath>
@@ -24,7 +25,7 @@ namespace mopo {
 
   namespace {
     mopo_float randomLfoValue() {
-      return 2.0 * rand() / RAND_MAX - 1.0;
+      return 2.0 * utils::random() / RAND_MAX - 1.0;
     }
   } // namespace
 
@@ -80,4 +81,10 @@ namespace mopo {
     mopo_float integral;
     offset_ = utils::mod(offset_, &integral);
   }
+
+  void HelmLfo::syncState(ProcessorState* state) {
+    state->sync(offset_);
+    state->sync(last_random_value_);
+    state->sync(current_random_value_);
+  }
 } // namespace mopo
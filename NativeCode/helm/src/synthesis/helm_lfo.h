@@ -46,6 +46,7 @@ namespace mopo {
 
       virtual Processor* clone() const override { return new HelmLfo(*this); }
       void process() override;
+      void syncState(ProcessorState* state) override;
       void correctToTime(mopo_float samples);
 
     protected:
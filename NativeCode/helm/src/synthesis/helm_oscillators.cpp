@@ -17,9 +17,20 @@
 #include "helm_oscillators.h"
 
 #include "detune_lookup.h"
+#include "processor_state.h"
 
 #define RAND_DECAY 0.999
 
+namespace {
+  bool isZero(const mopo::mopo_float* buffer, int size) {
+    for (int i = 0; i < size; ++i) {
+      if (buffer[i] != 0.0)
+        return false;
+    }
+    return true;
+  }
+} // namespace
+
 namespace mopo {
   const mopo_float HelmOscillators::scales[] = {
       1.0, 1.0,
@@ -44,6 +55,8 @@ namespace mopo {
       oscillator2_phases_[v] = 0;
       wave_buffers1_[v] = nullptr;
       wave_buffers2_[v] = nullptr;
+      last_wave_buffers1_[v] = nullptr;
+      last_wave_buffers2_[v] = nullptr;
       detune_diffs1_[v] = 0;
       detune_diffs2_[v] = 0;
     }
@@ -110,14 +123,19 @@ namespace mopo {
     }
   }
 
-  void HelmOscillators::prepareBuffers(mopo_float** wave_buffers,
+  void HelmOscillators::prepareBuffers(const float** wave_buffers,
+                                       const float** last_wave_buffers,
                                        const int* detune_diffs,
                                        const int* oscillator_phase_diffs,
-                                       int waveform) {
-    for (int v = 0; v < MAX_UNISON; ++v) {
+                                       int waveform, int voices) {
+    for (int v = 0; v < voices; ++v) {
       int phase_diff = detune_diffs[v] + oscillator_phase_diffs[0];
+      last_wave_buffers[v] = wave_buffers[v];
       wave_buffers[v] = FixedPointWave::getBuffer(waveform, phase_diff);
     }
+
+    for (int v = voices; v < MAX_UNISON; ++v)
+      wave_buffers[v] = nullptr;
   }
 
   void HelmOscillators::processInitial() {
@@ -140,8 +158,10 @@ namespace mopo {
     wave1 = utils::iclamp(wave1, 0, FixedPointWaveLookup::kWhiteNoise - 1);
     wave2 = utils::iclamp(wave2, 0, FixedPointWaveLookup::kWhiteNoise - 1);
 
-    prepareBuffers(wave_buffers1_, detune_diffs1_, oscillator1_phase_diffs_, wave1);
-    prepareBuffers(wave_buffers2_, detune_diffs2_, oscillator2_phase_diffs_, wave2);
+    prepareBuffers(wave_buffers1_, last_wave_buffers1_, detune_diffs1_,
+                   oscillator1_phase_diffs_, wave1, voices1);
+    prepareBuffers(wave_buffers2_, last_wave_buffers2_, detune_diffs2_,
+                   oscillator2_phase_diffs_, wave2, voices2);
   }
 
   void HelmOscillators::processCrossMod() {
@@ -185,8 +205,13 @@ namespace mopo {
     int voices1 = utils::iclamp(input(kUnisonVoices1)->source->buffer[0], 1, MAX_UNISON);
     int voices2 = utils::iclamp(input(kUnisonVoices2)->source->buffer[0], 1, MAX_UNISON);
 
-    utils::zeroBuffer(oscillator1_totals_, buffer_size_);
-    utils::zeroBuffer(oscillator2_totals_, buffer_size_);
+    // Unison voices of an oscillator that's silent for the whole block can't
+    // be heard, so only their phases move on.
+    bool play1 = !isZero(input(kOscillator1Amplitude)->source->buffer, buffer_size_);
+    bool play2 = !isZero(input(kOscillator2Amplitude)->source->buffer, buffer_size_);
+
+    utils::zeroBufferf(oscillator1_totals_, buffer_size_);
+    utils::zeroBufferf(oscillator2_totals_, buffer_size_);
 
     int j = 0;
     if (input(kReset)->source->triggered) {
@@ -202,43 +227,84 @@ namespace mopo {
       tickInitialVoices(j);
 
     for (int v = 1; v < voices1; ++v) {
-      const mopo_float* wave_buffer = wave_buffers1_[v];
+      const float* wave_buffer = wave_buffers1_[v];
       unsigned int start_phase = oscillator1_phases_[v];
       int detune = detune_diffs1_[v];
 
       int i = 0;
       if (input(kReset)->source->triggered) {
         int trigger_offset = input(kReset)->source->trigger_offset;
-        for (; i < trigger_offset; ++i)
+        for (; play1 && i < trigger_offset; ++i)
           tickVoice1(i, v, wave_buffer, start_phase, detune);
 
-        oscillator1_phases_[v] = (UINT_MAX / RAND_MAX) * rand();
+        oscillator1_phases_[v] = (UINT_MAX / RAND_MAX) * utils::random();
       }
 
-      for (; i < buffer_size_; ++i)
+      for (; play1 && i < buffer_size_; ++i)
         tickVoice1(i, v, wave_buffer, start_phase, detune);
     }
 
     for (int v = 1; v < voices2; ++v) {
-      const mopo_float* wave_buffer = wave_buffers2_[v];
+      const float* wave_buffer = wave_buffers2_[v];
       unsigned int start_phase = oscillator2_phases_[v];
       int detune = detune_diffs2_[v];
 
       int i = 0;
       if (input(kReset)->source->triggered) {
         int trigger_offset = input(kReset)->source->trigger_offset;
-        for (; i < trigger_offset; ++i)
+        for (; play2 && i < trigger_offset; ++i)
           tickVoice2(i, v, wave_buffer, start_phase, detune);
 
-        oscillator2_phases_[v] = (UINT_MAX / RAND_MAX) * rand();
+        oscillator2_phases_[v] = (UINT_MAX / RAND_MAX) * utils::random();
       }
-      for (; i < buffer_size_; ++i)
+      for (; play2 && i < buffer_size_; ++i)
         tickVoice2(i, v, wave_buffer, start_phase, detune);
     }
 
+    if (!input(kReset)->source->triggered)
+      fadeLevels(voices1, voices2, play1, play2);
+
     finishVoices(voices1, voices2);
   }
 
+  void HelmOscillators::fadeVoice(float* totals, const float* from, const float* to,
+                                  const int* cross_mods, const int* phase_diffs,
+                                  unsigned int start_phase, int detune) {
+    mopo_float fade_inc = 1.0 / buffer_size_;
+    for (int i = 0; i < buffer_size_; ++i) {
+      int phase = cross_mods[i] + start_phase + i * detune + phase_diffs[i];
+      mopo_float fade = 1.0 - (i + 1) * fade_inc;
+      mopo_float from_value = FixedPointWave::interpretWave(from, phase);
+      mopo_float to_value = FixedPointWave::interpretWave(to, phase);
+      totals[i] += fade * (from_value - to_value);
+    }
+  }
+
+  // A unison voice that moved to another level since the last block was
+  // rendered with the new level. Adding the difference to the old level and
+  // fading it out over the block keeps the switch from clicking.
+  void HelmOscillators::fadeLevels(int voices1, int voices2, bool play1, bool play2) {
+    for (int v = 0; play1 && v < voices1; ++v) {
+      const float* from = last_wave_buffers1_[v];
+      if (from == nullptr || from == wave_buffers1_[v])
+        continue;
+
+      const int* cross_mods = v ? oscillator1_cross_mods_ : oscillator2_cross_mods_;
+      fadeVoice(oscillator1_totals_, from, wave_buffers1_[v], cross_mods,
+                oscillator1_phase_diffs_, oscillator1_phases_[v], v ? detune_diffs1_[v] : 0);
+    }
+
+    for (int v = 0; play2 && v < voices2; ++v) {
+      const float* from = last_wave_buffers2_[v];
+      if (from == nullptr || from == wave_buffers2_[v])
+        continue;
+
+      const int* cross_mods = v ? oscillator2_cross_mods_ : oscillator1_cross_mods_;
+      fadeVoice(oscillator2_totals_, from, wave_buffers2_[v], cross_mods,
+                oscillator2_phase_diffs_, oscillator2_phases_[v], v ? detune_diffs2_[v] : 0);
+    }
+  }
+
   void HelmOscillators::finishVoices(int voices1, int voices2) {
     mopo_float scale1 = scales[voices1];
     mopo_float scale2 = scales[voices2];
@@ -246,8 +312,8 @@ namespace mopo {
     mopo_float* dest = output()->buffer;
     const mopo_float* amp1 = input(kOscillator1Amplitude)->source->buffer;
     const mopo_float* amp2 = input(kOscillator2Amplitude)->source->buffer;
-    const mopo_float* oscillator1_totals = oscillator1_totals_;
-    const mopo_float* oscillator2_totals = oscillator2_totals_;
+    const float* oscillator1_totals = oscillator1_totals_;
+    const float* oscillator2_totals = oscillator2_totals_;
 
     VECTORIZE_LOOP
     for (int j = 0; j < buffer_size_; ++j)
@@ -272,4 +338,13 @@ namespace mopo {
     processCrossMod();
     processVoices();
   }
+
+  void HelmOscillators::syncState(ProcessorState* state) {
+    state->sync(oscillator1_phase_base_);
+    state->sync(oscillator2_phase_base_);
+    state->sync(oscillator1_phases_);
+    state->sync(oscillator2_phases_);
+    state->sync(oscillator1_cross_mods_[0]);
+    state->sync(oscillator2_cross_mods_[0]);
+  }
 } // namespace mopo
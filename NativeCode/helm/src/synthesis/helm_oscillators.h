@@ -49,6 +49,8 @@ namespace mopo {
       HelmOscillators();
 
       virtual void process();
+      virtual bool rewritesOutputs() const { return true; }
+      virtual void syncState(ProcessorState* state);
       virtual Processor* clone() const { return new HelmOscillators(*this); }
 
       Output* getOscillator1Output() { return output(0); }
@@ -61,14 +63,19 @@ namespace mopo {
                                int oscillator_diff,
                                bool harmonize, mopo_float detune,
                                int voices);
-      void prepareBuffers(mopo_float** wave_buffers,
+      void prepareBuffers(const float** wave_buffers,
+                          const float** last_wave_buffers,
                           const int* detune_diffs,
                           const int* oscillator_phase_diffs,
-                          int waveform);
+                          int waveform, int voices);
 
       void processInitial();
       void processCrossMod();
       void processVoices();
+      void fadeVoice(float* totals, const float* from, const float* to,
+                     const int* cross_mods, const int* phase_diffs,
+                     unsigned int start_phase, int detune);
+      void fadeLevels(int voices1, int voices2, bool play1, bool play2);
       void finishVoices(int voices1, int voices2);
 
       inline void tickCrossMod(int i, const mopo_float cross_mod,
@@ -92,14 +99,14 @@ namespace mopo {
         oscillator2_totals_[i] += FixedPointWave::interpretWave(wave_buffers2_[0], phase2);
       }
 
-      inline void tickVoice1(int i, int voice, const mopo_float* wave_buffer,
+      inline void tickVoice1(int i, int voice, const float* wave_buffer,
                              unsigned int start_phase, int detune) {
         int phase = oscillator1_cross_mods_[i] + start_phase +
                     i * detune + oscillator1_phase_diffs_[i];
         oscillator1_totals_[i] += FixedPointWave::interpretWave(wave_buffer, phase);
       }
 
-      inline void tickVoice2(int i, int voice, const mopo_float* wave_buffer,
+      inline void tickVoice2(int i, int voice, const float* wave_buffer,
                              unsigned int start_phase, int detune) {
         int phase = oscillator2_cross_mods_[i] + start_phase +
                     i * detune + oscillator2_phase_diffs_[i];
@@ -108,8 +115,8 @@ namespace mopo {
 
       inline void tickOut(int i, mopo_float* dest,
                           const mopo_float* amp1, const mopo_float* amp2,
-                          const mopo_float* oscillator1_totals,
-                          const mopo_float* oscillator2_totals,
+                          const float* oscillator1_totals,
+                          const float* oscillator2_totals,
                           mopo_float scale1, mopo_float scale2) {
         mopo_float mixed = amp1[i] * scale1 * oscillator1_totals[i] +
                            amp2[i] * scale2 * oscillator2_totals[i];
@@ -120,16 +127,20 @@ namespace mopo {
       int oscillator1_cross_mods_[MAX_BUFFER_SIZE + 1];
       int oscillator2_cross_mods_[MAX_BUFFER_SIZE + 1];
 
-      mopo_float oscillator1_totals_[MAX_BUFFER_SIZE];
-      mopo_float oscillator2_totals_[MAX_BUFFER_SIZE];
+      // Unison voices add up in single precision like the wave tables they
+      // read, which keeps the per voice loops free of conversions.
+      float oscillator1_totals_[MAX_BUFFER_SIZE];
+      float oscillator2_totals_[MAX_BUFFER_SIZE];
 
       unsigned int oscillator1_phase_base_;
       unsigned int oscillator2_phase_base_;
       unsigned int oscillator1_phases_[MAX_UNISON];
       unsigned int oscillator2_phases_[MAX_UNISON];
 
-      mopo_float* wave_buffers1_[MAX_UNISON];
-      mopo_float* wave_buffers2_[MAX_UNISON];
+      const float* wave_buffers1_[MAX_UNISON];
+      const float* wave_buffers2_[MAX_UNISON];
+      const float* last_wave_buffers1_[MAX_UNISON];
+      const float* last_wave_buffers2_[MAX_UNISON];
       int detune_diffs1_[MAX_UNISON];
       int detune_diffs2_[MAX_UNISON];
       int oscillator1_phase_diffs_[MAX_BUFFER_SIZE];
@@ -38,16 +38,9 @@ namespace mopo {
 
   namespace {
     struct FormantValues {
-      cr::Value gain;
-      cr::Value resonance;
-      cr::Value midi_cutoff;
-    };
-
-    static const cr::Value formant_filter_types[NUM_FORMANTS] = {
-      cr::Value(BiquadFilter::kGainedBandPass),
-      cr::Value(BiquadFilter::kGainedBandPass),
-      cr::Value(BiquadFilter::kGainedBandPass),
-      cr::Value(BiquadFilter::kGainedBandPass)
+      mopo_float gain;
+      mopo_float resonance;
+      mopo_float midi_cutoff;
     };
 
     static const Value formant_a_decibels(-4.0f);
@@ -57,43 +50,43 @@ namespace mopo {
     static const Value formant_u_decibels(-2.0f);
 
     static const FormantValues formant_a[NUM_FORMANTS] = {
-      {cr::Value(24), cr::Value(10), cr::Value(75.7552343327)},
-      {cr::Value(18), cr::Value(12), cr::Value(84.5454706023)},
-      {cr::Value(17), cr::Value(16), cr::Value(100.08500317)},
-      {cr::Value(16), cr::Value(16), cr::Value(101.645729657)},
+      {24, 10, 75.7552343327},
+      {18, 12, 84.5454706023},
+      {17, 16, 100.08500317},
+      {16, 16, 101.645729657},
     };
 
     static const FormantValues formant_e[NUM_FORMANTS] = {
-      {cr::Value(24), cr::Value(10), cr::Value(67.349957715)},
-      {cr::Value(10), cr::Value(12), cr::Value(92.39951181)},
-      {cr::Value(12), cr::Value(16), cr::Value(99.7552343327)},
-      {cr::Value(10), cr::Value(16), cr::Value(103.349957715)},
+      {24, 10, 67.349957715},
+      {10, 12, 92.39951181},
+      {12, 16, 99.7552343327},
+      {10, 16, 103.349957715},
     };
 
     static const FormantValues formant_i[NUM_FORMANTS] = {
-      {cr::Value(24), cr::Value(13), cr::Value(61.7825925179)},
-      {cr::Value(9), cr::Value(12), cr::Value(94.049554095)},
-      {cr::Value(6), cr::Value(16), cr::Value(101.03821678)},
-      {cr::Value(4), cr::Value(16), cr::Value(103.618371471)},
+      {24, 13, 61.7825925179},
+      {9, 12, 94.049554095},
+      {6, 16, 101.03821678},
+      {4, 16, 103.618371471},
     };
 
     static const FormantValues formant_o[NUM_FORMANTS] = {
-      {cr::Value(24), cr::Value(11), cr::Value(67.349957715)},
-      {cr::Value(14), cr::Value(12), cr::Value(79.349957715)},
-      {cr::Value(12), cr::Value(16), cr::Value(99.7552343327)},
-      {cr::Value(12), cr::Value(16), cr::Value(101.03821678)},
+      {24, 11, 67.349957715},
+      {14, 12, 79.349957715},
+      {12, 16, 99.7552343327},
+      {12, 16, 101.03821678},
     };
 
     static const FormantValues formant_u[NUM_FORMANTS] = {
-      {cr::Value(24), cr::Value(11), cr::Value(65.0382167797)},
-      {cr::Value(4), cr::Value(12), cr::Value(74.3695077237)},
-      {cr::Value(7), cr::Value(16), cr::Value(100.408607741)},
-      {cr::Value(10), cr::Value(16), cr::Value(101.645729657)},
+      {24, 11, 65.0382167797},
+      {4, 12, 74.3695077237},
+      {7, 16, 100.408607741},
+      {10, 16, 101.645729657},
     };
   } // namespace
 
   HelmVoiceHandler::HelmVoiceHandler(Output* beats_per_second) :
-      ProcessorRouter(VoiceHandler::kNumInputs, 0), VoiceHandler(MAX_POLYPHONY),
+      ProcessorRouter(VoiceHandler::kNumInputs, 0), VoiceHandler(1),
       beats_per_second_(beats_per_second) {
     output_ = new Multiply();
     registerOutput(output_->output());
@@ -545,59 +538,20 @@ namespace mopo {
     Output* formant_x = createPolyModControl("formant_x", true);
     Output* formant_y = createPolyModControl("formant_y", true);
 
+    formant_filter_->plug(formant_x, FormantManager::kXPosition);
+    formant_filter_->plug(formant_y, FormantManager::kYPosition);
+
     for (int i = 0; i < NUM_FORMANTS; ++i) {
-      BilinearInterpolate* formant_gain = new BilinearInterpolate();
-      formant_gain->setControlRate();
-      BilinearInterpolate* formant_q = new BilinearInterpolate();
-      formant_q->setControlRate();
-      BilinearInterpolate* formant_midi = new BilinearInterpolate();
-      formant_midi->setControlRate();
-
-      formant_gain->plug(&formant_a[i].gain, BilinearInterpolate::kTopLeft);
-      formant_gain->plug(&formant_o[i].gain, BilinearInterpolate::kTopRight);
-      formant_gain->plug(&formant_i[i].gain, BilinearInterpolate::kBottomLeft);
-      formant_gain->plug(&formant_e[i].gain, BilinearInterpolate::kBottomRight);
-
-      formant_q->plug(&formant_a[i].resonance, BilinearInterpolate::kTopLeft);
-      formant_q->plug(&formant_o[i].resonance, BilinearInterpolate::kTopRight);
-      formant_q->plug(&formant_i[i].resonance, BilinearInterpolate::kBottomLeft);
-      formant_q->plug(&formant_e[i].resonance, BilinearInterpolate::kBottomRight);
-
-      formant_midi->plug(&formant_a[i].midi_cutoff, BilinearInterpolate::kTopLeft);
-      formant_midi->plug(&formant_o[i].midi_cutoff, BilinearInterpolate::kTopRight);
-      formant_midi->plug(&formant_i[i].midi_cutoff, BilinearInterpolate::kBottomLeft);
-      formant_midi->plug(&formant_e[i].midi_cutoff, BilinearInterpolate::kBottomRight);
-
-      formant_gain->plug(formant_x, BilinearInterpolate::kXPosition);
-      formant_q->plug(formant_x, BilinearInterpolate::kXPosition);
-      formant_midi->plug(formant_x, BilinearInterpolate::kXPosition);
-
-      formant_gain->plug(formant_y, BilinearInterpolate::kYPosition);
-      formant_q->plug(formant_y, BilinearInterpolate::kYPosition);
-      formant_midi->plug(formant_y, BilinearInterpolate::kYPosition);
-
-      cr::MagnitudeScale* formant_magnitude = new cr::MagnitudeScale();
-      formant_magnitude->plug(formant_gain);
-
-      cr::MidiScale* formant_frequency = new cr::MidiScale();
-      formant_frequency->plug(formant_midi);
-
-      formant_filter_->getFormant(i)->plug(&formant_filter_types[i], BiquadFilter::kType);
-      formant_filter_->getFormant(i)->plug(formant_magnitude, BiquadFilter::kGain);
-      formant_filter_->getFormant(i)->plug(formant_q, BiquadFilter::kResonance);
-      formant_filter_->getFormant(i)->plug(formant_frequency, BiquadFilter::kCutoff);
-
-      addProcessor(formant_gain);
-      addProcessor(formant_magnitude);
-      addProcessor(formant_q);
-      addProcessor(formant_midi);
-      addProcessor(formant_frequency);
-
-      formant_on->addProcessor(formant_gain);
-      formant_on->addProcessor(formant_magnitude);
-      formant_on->addProcessor(formant_q);
-      formant_on->addProcessor(formant_midi);
-      formant_on->addProcessor(formant_frequency);
+      const FormantValues* corners[FormantManager::kNumCorners] = {
+        &formant_a[i], &formant_o[i], &formant_i[i], &formant_e[i]
+      };
+
+      formant_filter_->setType(i, BiquadFilter::kGainedBandPass);
+      for (int c = 0; c < FormantManager::kNumCorners; ++c) {
+        formant_filter_->setCorner(i, static_cast<FormantManager::Corner>(c),
+                                   corners[c]->gain, corners[c]->resonance,
+                                   corners[c]->midi_cutoff);
+      }
     }
 
     BilinearInterpolate* formant_decibels = new BilinearInterpolate();
@@ -747,6 +701,7 @@ namespace mopo {
 
   void HelmVoiceHandler::process() {
     setLegato(legato_->output()->buffer[0]);
+    updateSilentBranches();
     VoiceHandler::process();
     note_retriggered_.clearTrigger();
 
@@ -756,6 +711,78 @@ namespace mopo {
     }
   }
 
+  void HelmVoiceHandler::setSilentBranches(const std::vector<Processor*>& unheard,
+                                           const std::vector<BranchFinder::Branch>& branches) {
+    enableVoiceProcessors(switchable_, true);
+    switchable_.clear();
+    silent_counts_.clear();
+    silent_branches_.clear();
+
+    std::map<Processor*, int> indices;
+    auto indexOf = [&](Processor* processor) {
+      auto found = indices.find(processor);
+      if (found != indices.end())
+        return found->second;
+
+      int index = switchable_.size();
+      indices[processor] = index;
+      switchable_.push_back(processor);
+      silent_counts_.push_back(0);
+      return index;
+    };
+
+    for (Processor* processor : unheard)
+      silent_counts_[indexOf(processor)]++;
+
+    for (const BranchFinder::Branch& branch : branches) {
+      SilentBranch silent_branch;
+      silent_branch.controls = branch.controls;
+      for (Processor* processor : branch.processors)
+        silent_branch.processors.push_back(indexOf(processor));
+      silent_branch.smoothing_blocks = branch.smoothing_blocks;
+      silent_branch.zero_blocks = 0;
+      silent_branch.silent = false;
+      silent_branches_.push_back(silent_branch);
+    }
+
+    setSwitchableProcessors(switchable_);
+    turning_on_.reserve(switchable_.size());
+    turning_off_.reserve(switchable_.size());
+    enableVoiceProcessors(unheard, false);
+  }
+
+  void HelmVoiceHandler::updateSilentBranches() {
+    turning_on_.clear();
+    turning_off_.clear();
+
+    for (SilentBranch& branch : silent_branches_) {
+      bool zero = true;
+      for (const Value* control : branch.controls) {
+        const Output* output = control->output();
+        zero = zero && control->value() == 0.0 &&
+               utils::isSilent(output->buffer, output->buffer_size);
+      }
+
+      // Going silent waits for smoothed gains to ramp down.
+      branch.zero_blocks = zero ? branch.zero_blocks + 1 : 0;
+      bool silent = branch.zero_blocks > branch.smoothing_blocks;
+      if (silent == branch.silent)
+        continue;
+
+      branch.silent = silent;
+      for (int index : branch.processors) {
+        int& count = silent_counts_[index];
+        if (silent && count++ == 0)
+          turning_off_.push_back(switchable_[index]);
+        else if (!silent && --count == 0)
+          turning_on_.push_back(switchable_[index]);
+      }
+    }
+
+    enableVoiceProcessors(turning_on_, true);
+    enableVoiceProcessors(turning_off_, false);
+  }
+
   void HelmVoiceHandler::noteOn(mopo_float note, mopo_float velocity, int sample, int channel) {
     if (getPressedNotes().size() < polyphony() || legato_->value() == 0.0)
       note_retriggered_.trigger(note, sample);
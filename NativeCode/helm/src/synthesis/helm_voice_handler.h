@@ -21,13 +21,13 @@
 #include "mopo.h"
 #include "helm_common.h"
 #include "helm_module.h"
+#include "branch_finder.h"
 
 #include <vector>
 
 namespace mopo {
   class BypassRouter;
   class Delay;
-  class Distortion;
   class Envelope;
   class Filter;
   class FormantManager;
@@ -63,6 +63,12 @@ namespace mopo {
       // HelmModule
       output_map& getPolyModulations() override;
 
+      // Turns _unheard_ off for good and each branch's processors off while
+      // its controls are zero, replacing whatever the last call set up. Call
+      // it before prepareVoices().
+      void setSilentBranches(const std::vector<Processor*>& unheard,
+                             const std::vector<BranchFinder::Branch>& branches);
+
     private:
       // Create the portamento, legato, amplifier envelope and other processors
       // that effect how voices start and turn into other notes.
@@ -79,6 +85,18 @@ namespace mopo {
 
       void setupPolyModulationReadouts();
 
+      // A branch's processors by index into switchable_, and how many blocks
+      // its controls have been zero.
+      struct SilentBranch {
+        std::vector<const Value*> controls;
+        std::vector<int> processors;
+        int smoothing_blocks;
+        int zero_blocks;
+        bool silent;
+      };
+
+      void updateSilentBranches();
+
       Output* beats_per_second_;
 
       Processor* note_from_center_;
@@ -94,7 +112,6 @@ namespace mopo {
       Envelope* extra_envelope_;
 
       Value* legato_;
-      Distortion* distorted_filter_;
       FormantManager* formant_filter_;
       Envelope* filter_envelope_;
       BypassRouter* formant_container_;
@@ -104,6 +121,14 @@ namespace mopo {
       Multiply* output_;
 
       output_map poly_readouts_;
+
+      // Processors the branches turn off, and how many silent branches each
+      // one is in. Unheard processors count one more for good.
+      std::vector<Processor*> switchable_;
+      std::vector<int> silent_counts_;
+      std::vector<SilentBranch> silent_branches_;
+      std::vector<Processor*> turning_on_;
+      std::vector<Processor*> turning_off_;
   };
 } // namespace mopo
 
@@ -16,6 +16,8 @@
 
 #include "noise_oscillator.h"
 
+#include "processor_state.h"
+
 namespace mopo {
 
   NoiseOscillator::NoiseOscillator() : Processor(kNumInputs, 1) {
@@ -27,7 +29,7 @@ namespace mopo {
     mopo_float* dest = output()->buffer;
 
     if (amplitude == 0.0) {
-      if (dest[0] != 0.0 || dest[buffer_size_ - 1 != 0.0])
+      if (dest[0] != 0.0 || dest[buffer_size_ - 1] != 0.0)
         utils::zeroBuffer(dest, buffer_size_);
       return;
     }
@@ -38,9 +40,13 @@ namespace mopo {
       for (; i < trigger_offset; ++i)
         tick(i, dest, amplitude);
 
-      current_noise_value_ = rand() / mopo_float(RAND_MAX);
+      current_noise_value_ = utils::random() / mopo_float(RAND_MAX);
     }
     for (; i < buffer_size_; ++i)
       tick(i, dest, amplitude);
   }
+
+  void NoiseOscillator::syncState(ProcessorState* state) {
+    state->sync(current_noise_value_);
+  }
 } // namespace mopo
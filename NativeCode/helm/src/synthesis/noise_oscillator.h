@@ -36,6 +36,7 @@ namespace mopo {
       NoiseOscillator();
 
       virtual void process();
+      virtual void syncState(ProcessorState* state);
       virtual Processor* clone() const { return new NoiseOscillator(*this); }
 
     protected:
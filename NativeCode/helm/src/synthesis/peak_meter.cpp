@@ -15,6 +15,7 @@
  */
 
 #include "peak_meter.h"
+#include "processor_state.h"
 #include "utils.h"
 
 #define PEAK_DECAY 0.00003
@@ -45,4 +46,9 @@ namespace mopo {
     output()->buffer[0] = current_peak_left_;
     output()->buffer[1] = current_peak_right_;
   }
+
+  void PeakMeter::syncState(ProcessorState* state) {
+    state->sync(current_peak_left_);
+    state->sync(current_peak_right_);
+  }
 } // namespace mopo
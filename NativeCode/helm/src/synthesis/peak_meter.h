@@ -28,6 +28,7 @@ namespace mopo {
 
       virtual Processor* clone() const override { return new PeakMeter(*this); }
       void process() override;
+      void syncState(ProcessorState* state) override;
 
     protected:
       mopo_float current_peak_left_;
@@ -16,6 +16,9 @@
 
 #include "trigger_random.h"
 
+#include "processor_state.h"
+#include "utils.h"
+
 #include <cstdlib>
 
 namespace mopo {
@@ -24,8 +27,12 @@ namespace mopo {
 
   void TriggerRandom::process() {
     if (input()->source->triggered)
-      value_ = 2.0 * rand() / RAND_MAX - 1.0;
+      value_ = 2.0 * utils::random() / RAND_MAX - 1.0;
 
     output()->buffer[0] = value_;
   }
+
+  void TriggerRandom::syncState(ProcessorState* state) {
+    state->sync(value_);
+  }
 } // namespace mopo
@@ -35,6 +35,7 @@ namespace mopo {
 
       virtual Processor* clone() const { return new TriggerRandom(*this); }
       virtual void process();
+      virtual void syncState(ProcessorState* state);
 
     private:
       mopo_float value_;
@@ -39,6 +39,9 @@ namespace mopo {
 
       void addProcessor(Processor* processor) { processors_.push_back(processor); }
 
+      // Processors turned on by any source but the first.
+      const std::vector<Processor*>& getProcessors() const { return processors_; }
+
     private:
       void setSource(int source);
 
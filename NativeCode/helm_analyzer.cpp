@@ -0,0 +1,220 @@
+/* Copyright 2017 Matt Tytel */
+
+#include "helm_analyzer.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace Helm {
+
+  HelmAnalyzer::HelmAnalyzer() {
+    scope_decimation_ = 1;
+
+    for (int i = 0; i < kFftSize; ++i) {
+      fft_window_[i] = 0.5f - 0.5f * cos((2.0 * mopo::PI * i) / kFftSize);
+
+      int reverse = 0;
+      for (int bit = 0; bit < kFftBits; ++bit)
+        reverse |= ((i >> bit) & 1) << (kFftBits - 1 - bit);
+      fft_reverse_[i] = reverse;
+    }
+
+    for (int i = 0; i < kFftSize / 2; ++i) {
+      fft_cos_[i] = cos((2.0 * mopo::PI * i) / kFftSize);
+      fft_sin_[i] = sin((2.0 * mopo::PI * i) / kFftSize);
+    }
+
+    reset();
+  }
+
+  void HelmAnalyzer::reset() {
+    scope_phase_ = 0;
+    scope_write_ = 0;
+    fft_write_ = 0;
+    fft_pending_ = 0;
+    level_samples_ = 0;
+
+    for (int i = 0; i < 2; ++i) {
+      sum_squares_[i] = 0.0;
+      peaks_[i] = 0.0f;
+    }
+
+    for (int i = 0; i < kScopeSize; ++i) {
+      scope_ring_[i] = 0.0f;
+      scope_[i].store(0.0f);
+    }
+    for (int i = 0; i < kFftSize; ++i)
+      fft_ring_[i] = 0.0f;
+
+    for (int i = 0; i < kSpectrumSize; ++i)
+      spectrum_[i].store(0.0f);
+    for (int i = 0; i < kNumLevels; ++i)
+      levels_[i].store(0.0f);
+    for (int i = 0; i < kNumTypes; ++i)
+      versions_[i].store(0);
+  }
+
+  void HelmAnalyzer::setSampleRate(int sample_rate) {
+    scope_decimation_ = std::max(1, sample_rate / kScopeSampleRate);
+    scope_phase_ = 0;
+  }
+
+  void HelmAnalyzer::process(const mopo::mopo_float* left, const mopo::mopo_float* right,
+                             int samples, int types) {
+    if (types & (1 << kLevels)) {
+      double left_squares = 0.0;
+      double right_squares = 0.0;
+      float left_peak = peaks_[0];
+      float right_peak = peaks_[1];
+      for (int i = 0; i < samples; ++i) {
+        left_squares += left[i] * left[i];
+        right_squares += right[i] * right[i];
+        left_peak = std::max<float>(left_peak, fabs(left[i]));
+        right_peak = std::max<float>(right_peak, fabs(right[i]));
+      }
+
+      sum_squares_[0] += left_squares;
+      sum_squares_[1] += right_squares;
+      peaks_[0] = left_peak;
+      peaks_[1] = right_peak;
+      level_samples_ += samples;
+    }
+
+    if (types & (1 << kScope)) {
+      int i = scope_phase_;
+      for (; i < samples; i += scope_decimation_) {
+        scope_ring_[scope_write_] = 0.5f * (left[i] + right[i]);
+        scope_write_ = (scope_write_ + 1) % kScopeSize;
+      }
+      scope_phase_ = i - samples;
+    }
+
+    if (types & (1 << kSpectrum)) {
+      for (int i = 0; i < samples; ++i) {
+        fft_ring_[fft_write_] = 0.5f * (left[i] + right[i]);
+        fft_write_ = (fft_write_ + 1) & (kFftSize - 1);
+      }
+      fft_pending_ += samples;
+    }
+  }
+
+  void HelmAnalyzer::publish(int types) {
+    if ((types & (1 << kLevels)) && level_samples_) {
+      beginWrite(kLevels);
+      levels_[0].store(sqrt(sum_squares_[0] / level_samples_), std::memory_order_relaxed);
+      levels_[1].store(sqrt(sum_squares_[1] / level_samples_), std::memory_order_relaxed);
+      levels_[2].store(peaks_[0], std::memory_order_relaxed);
+      levels_[3].store(peaks_[1], std::memory_order_relaxed);
+      endWrite(kLevels);
+
+      sum_squares_[0] = sum_squares_[1] = 0.0;
+      peaks_[0] = peaks_[1] = 0.0f;
+      level_samples_ = 0;
+    }
+
+    if (types & (1 << kScope)) {
+      beginWrite(kScope);
+      for (int i = 0; i < kScopeSize; ++i) {
+        int index = (scope_write_ + i) % kScopeSize;
+        scope_[i].store(scope_ring_[index], std::memory_order_relaxed);
+      }
+      endWrite(kScope);
+    }
+
+    // Spectrum frames overlap by half so a frame is only computed once enough
+    // new audio has come in.
+    if ((types & (1 << kSpectrum)) && fft_pending_ >= kFftSize / 2) {
+      computeSpectrum();
+      fft_pending_ = 0;
+    }
+  }
+
+  void HelmAnalyzer::computeSpectrum() {
+    for (int i = 0; i < kFftSize; ++i) {
+      int index = (fft_write_ + i) & (kFftSize - 1);
+      fft_real_[fft_reverse_[i]] = fft_window_[i] * fft_ring_[index];
+      fft_imaginary_[i] = 0.0f;
+    }
+
+    for (int size = 2; size <= kFftSize; size *= 2) {
+      int half = size / 2;
+      int step = kFftSize / size;
+
+      for (int start = 0; start < kFftSize; start += size) {
+        for (int j = 0; j < half; ++j) {
+          float c = fft_cos_[j * step];
+          float s = fft_sin_[j * step];
+          int a = start + j;
+          int b = a + half;
+
+          float real = fft_real_[b] * c + fft_imaginary_[b] * s;
+          float imaginary = fft_imaginary_[b] * c - fft_real_[b] * s;
+          fft_real_[b] = fft_real_[a] - real;
+          fft_imaginary_[b] = fft_imaginary_[a] - imaginary;
+          fft_real_[a] += real;
+          fft_imaginary_[a] += imaginary;
+        }
+      }
+    }
+
+    // Hann window sums to half the frame, so this scales a full scale sine
+    // to a magnitude of one.
+    const float scale = 4.0f / kFftSize;
+    VECTORIZE_LOOP
+    for (int i = 0; i < kSpectrumSize; ++i) {
+      float real = fft_real_[i];
+      float imaginary = fft_imaginary_[i];
+      fft_real_[i] = scale * sqrtf(real * real + imaginary * imaginary);
+    }
+
+    beginWrite(kSpectrum);
+    for (int i = 0; i < kSpectrumSize; ++i)
+      spectrum_[i].store(fft_real_[i], std::memory_order_relaxed);
+    endWrite(kSpectrum);
+  }
+
+  void HelmAnalyzer::beginWrite(Type type) {
+    unsigned int version = versions_[type].load(std::memory_order_relaxed);
+    versions_[type].store(version + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+  }
+
+  void HelmAnalyzer::endWrite(Type type) {
+    versions_[type].fetch_add(1, std::memory_order_release);
+  }
+
+  int HelmAnalyzer::read(Type type, float* buffer, int size) const {
+    const std::atomic<float>* source = nullptr;
+    int available = 0;
+    if (type == kLevels) {
+      source = levels_;
+      available = kNumLevels;
+    }
+    else if (type == kScope) {
+      source = scope_;
+      available = kScopeSize;
+    }
+    else if (type == kSpectrum) {
+      source = spectrum_;
+      available = kSpectrumSize;
+    }
+    else
+      return 0;
+
+    int count = std::max(0, std::min(size, available));
+
+    // Readers retry if the audio thread published while they were copying.
+    while (true) {
+      unsigned int before = versions_[type].load(std::memory_order_acquire);
+      if (before & 1)
+        continue;
+
+      for (int i = 0; i < count; ++i)
+        buffer[i] = source[i].load(std::memory_order_relaxed);
+
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (versions_[type].load(std::memory_order_relaxed) == before)
+        return count;
+    }
+  }
+} // namespace Helm
@@ -0,0 +1,80 @@
+/* Copyright 2017 Matt Tytel */
+
+#pragma once
+#ifndef HELM_ANALYZER_H
+#define HELM_ANALYZER_H
+
+#include "common.h"
+
+#include <atomic>
+
+namespace Helm {
+
+  // Measures the engine output for visualizers. Only the analysis types a
+  // caller asks for are computed on the audio thread, and the results are
+  // published so any thread can read them without locking.
+  class HelmAnalyzer {
+    public:
+      enum Type {
+        kLevels,
+        kScope,
+        kSpectrum,
+        kNumTypes
+      };
+
+      // Levels are left rms, right rms, left peak, right peak.
+      const static int kNumLevels = 4;
+      const static int kScopeSize = 512;
+      const static int kScopeSampleRate = 22000;
+      const static int kFftBits = 10;
+      const static int kFftSize = 1 << kFftBits;
+      const static int kSpectrumSize = kFftSize / 2;
+
+      HelmAnalyzer();
+
+      void setSampleRate(int sample_rate);
+
+      // Drops everything measured so far, as if newly made.
+      void reset();
+
+      // Audio thread. types is a bit mask of (1 << Type) values.
+      void process(const mopo::mopo_float* left, const mopo::mopo_float* right,
+                   int samples, int types);
+      void publish(int types);
+
+      // Any thread. Copies up to size values of the last published data and
+      // returns how many were written.
+      int read(Type type, float* buffer, int size) const;
+
+    private:
+      void computeSpectrum();
+      void beginWrite(Type type);
+      void endWrite(Type type);
+
+      int scope_decimation_;
+      int scope_phase_;
+      int scope_write_;
+      float scope_ring_[kScopeSize];
+
+      int fft_write_;
+      int fft_pending_;
+      float fft_ring_[kFftSize];
+      float fft_window_[kFftSize];
+      float fft_real_[kFftSize];
+      float fft_imaginary_[kFftSize];
+      float fft_cos_[kFftSize / 2];
+      float fft_sin_[kFftSize / 2];
+      int fft_reverse_[kFftSize];
+
+      double sum_squares_[2];
+      float peaks_[2];
+      int level_samples_;
+
+      std::atomic<unsigned int> versions_[kNumTypes];
+      std::atomic<float> levels_[kNumLevels];
+      std::atomic<float> scope_[kScopeSize];
+      std::atomic<float> spectrum_[kSpectrumSize];
+  };
+} // namespace Helm
+
+#endif // HELM_ANALYZER_H
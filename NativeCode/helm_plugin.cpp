@@ -2,22 +2,32 @@
 
 #define NOMINMAX
 
+#include "binary_patch.h"
+#include "helm_analyzer.h"
 #include "helm_engine.h"
 #include "helm_sequencer.h"
+#include "helm_transport.h"
+#include "polyphase_upsampler.h"
+#include "realtime_check.h"
+#include "realtime_gate.h"
+#include "vector_math.h"
 #include "AudioPluginUtil.h"
 #include "concurrentqueue.h"
 
+#include <atomic>
+#include <cstdint>
+
 namespace Helm {
   const int MAX_CHARACTERS = 15;
   const int MAX_CHANNELS = 16;
   const int MAX_NOTES = 128;
   const int MAX_MODULATIONS = 16;
+  const int MAX_SCHEDULED_VALUES = 256;
   const int VALUES_PER_MODULATION = 3;
-  const int MAX_UNITY_CHANNELS = 2;
+  const int MAX_UNITY_CHANNELS = 8;
   const int MAX_UNITY_BUFFER_SIZE = 2048;
   const float MODULATION_RANGE = 1000000.0f;
   const double SIXTEENTHS_PER_BEAT = 4.0;
-  const double SECONDS_PER_MINUTE = 60.0;
 
   const std::map<std::string, std::string> REPLACE_STRINGS = {
     {"stutter_resample", "stutter_resamp"}
@@ -28,37 +38,102 @@ namespace Helm {
     kNumParams
   };
 
+  // A parameter change landing sample_offset samples into the next processed
+  // block, reaching its value linearly over ramp_samples.
+  struct ValueEvent {
+    int index;
+    float value;
+    int sample_offset;
+    int ramp_samples;
+  };
+
+  struct ValueRamp {
+    mopo::Value* value;
+    float start;
+    float end;
+    int elapsed;
+    int length;
+  };
+
+  // A new amount for the modulation at index that is already connected.
+  struct ModulationEvent {
+    int index;
+    float amount;
+  };
+
   struct EffectData {
     int num_parameters;
     int num_synth_parameters;
     HelmSequencer::Note* sequencer_events[MAX_NOTES];
+    HelmSequencer::Note* sequencer_active[MAX_NOTES];
     mopo::ModulationConnection* modulations[MAX_MODULATIONS];
     moodycamel::ConcurrentQueue<std::pair<float, float>> note_events;
-    moodycamel::ConcurrentQueue<std::pair<int, float>> value_events;
+    moodycamel::ConcurrentQueue<ValueEvent> value_events;
+    moodycamel::ConcurrentQueue<ModulationEvent> modulation_events;
+    ValueEvent scheduled_values[MAX_SCHEDULED_VALUES];
+    int num_scheduled_values;
+    ValueRamp value_ramps[MAX_SCHEDULED_VALUES];
+    int num_value_ramps;
     float* parameters;
     mopo::Value** value_lookup;
     std::pair<float, float>* range_lookup;
     int instance_id;
+    int sample_rate;
+    int requested_rate_divider;
+    int rate_divider;
     mopo::HelmEngine synth_engine;
+    mopo::PolyphaseUpsampler upsamplers[2];
+    // API threads hold the mutex to take turns and close the gate while they
+    // change the engine. The audio thread renders silence if it finds the
+    // gate closed instead of waiting.
     AudioHelm::Mutex mutex;
-    double current_beat;
-    double last_global_beat_sync;
+    RealtimeGate engine_gate;
+    HelmTransport::Window beat_window;
+    unsigned int beat_generation;
+    // Seeks this instance has applied, and where its sequencer notes last
+    // played to. Seeks land on the next block it renders, even if it was
+    // paused or silent when the transport jumped.
+    unsigned int beat_seeks;
+    double sequencer_beat;
+    // Set while a sequencer edit has held notes back from sequencer_held_beat.
+    bool sequencer_held;
+    double sequencer_held_beat;
     bool active;
     bool silent;
+    int control_interval;
     float send_data[MAX_UNITY_CHANNELS * MAX_UNITY_BUFFER_SIZE];
     int num_send_channels;
+    HelmAnalyzer analyzer;
   };
 
   AudioHelm::Mutex instance_mutex;
   int instance_counter = 0;
-  double bpm = 120.0;
-  double global_beat = 0.0;
-  bool global_pause = false;
+  HelmTransport transport;
+  std::atomic<int> buffer_receivers[MAX_CHANNELS + 1] = {};
+  std::atomic<int> analysis_receivers[MAX_CHANNELS + 1][HelmAnalyzer::kNumTypes] = {};
   std::map<int, EffectData*> instance_map;
 
+  // Sequencer edits hold the mutex and close the gate like engine changes.
   AudioHelm::Mutex sequencer_mutex;
+  RealtimeGate sequencer_gate;
   std::map<HelmSequencer*, bool> sequencer_lookup;
 
+  // Released instances go back in the pool until it holds pool_capacity.
+  // Prewarming raises the capacity to what was asked for.
+  const int DEFAULT_POOL_CAPACITY = 4;
+  AudioHelm::Mutex pool_mutex;
+  std::vector<EffectData*> instance_pool;
+  int pool_capacity = DEFAULT_POOL_CAPACITY;
+  std::map<int, std::vector<char>> initial_states;
+
+  // Receivers are added and removed from script threads while the audio
+  // thread reads them, so never let a count drop below zero.
+  void removeReceiver(std::atomic<int>* receivers) {
+    int count = receivers->load(std::memory_order_relaxed);
+    while (count > 0 && !receivers->compare_exchange_weak(count, count - 1))
+      ;
+  }
+
   std::string getValueName(std::string full_name) {
     std::string name = full_name;
     for (auto replace : REPLACE_STRINGS) {
@@ -71,7 +146,7 @@ namespace Helm {
   }
 
   int InternalRegisterEffectDefinition(UnityAudioEffectDefinition& definition) {
-    std::map<std::string, mopo::ValueDetails> parameters = mopo::Parameters::lookup_.getAllDetails();
+    const std::map<std::string, mopo::ValueDetails>& parameters = mopo::Parameters::lookup_.getAllDetails();
 
     int num_synth_params = parameters.size();
     int num_modulation_params = MAX_MODULATIONS * VALUES_PER_MODULATION;
@@ -82,8 +157,8 @@ namespace Helm {
     RegisterParameter(definition, "Channel", "", 0.0f, MAX_CHANNELS, 0.0f, 1.0f, 1.0f, kChannel);
 
     int index = kNumParams;
-    for (auto parameter : parameters) {
-      mopo::ValueDetails& details = parameter.second;
+    for (auto& parameter : parameters) {
+      const mopo::ValueDetails& details = parameter.second;
       std::string name = getValueName(details.name);
       std::string units = details.display_units.substr(0, MAX_CHARACTERS);
       RegisterParameter(definition, name.c_str(), units.c_str(),
@@ -111,51 +186,281 @@ namespace Helm {
     return num_synth_params + kNumParams + num_modulation_params;
   }
 
-  void initializeValueLookup(mopo::Value** lookup, std::pair<float, float>* range_lookup,
-                             mopo::control_map& controls, int num_params) {
-    std::map<std::string, mopo::ValueDetails> parameters = mopo::Parameters::lookup_.getAllDetails();
+  // Parameter defaults, ranges and names are the same for every instance so
+  // they are built once per process and shared.
+  struct ParameterTables {
+    int num_parameters;
+    int polyphony_index;
+    float* default_values;
+    std::pair<float, float>* range_lookup;
+    std::vector<std::string> names;
+  };
 
-    for (int i = 0; i < num_params; ++i) {
-      lookup[i] = 0;
-    }
+  const ParameterTables& getParameterTables() {
+    static ParameterTables tables = [] {
+      const std::map<std::string, mopo::ValueDetails>& parameters =
+          mopo::Parameters::lookup_.getAllDetails();
+
+      ParameterTables result;
+      result.num_parameters = parameters.size() + kNumParams + MAX_MODULATIONS * VALUES_PER_MODULATION;
+      result.default_values = new float[result.num_parameters];
+      InitParametersFromDefinitions(InternalRegisterEffectDefinition, result.default_values);
+
+      result.range_lookup = new std::pair<float, float>[result.num_parameters];
+      result.names.resize(result.num_parameters);
+      result.polyphony_index = -1;
+      int index = kNumParams;
+      for (auto& parameter : parameters) {
+        const mopo::ValueDetails& details = parameter.second;
+        result.names[index] = details.name;
+        if (details.name == "polyphony")
+          result.polyphony_index = index;
+        result.range_lookup[index].first = details.min;
+        result.range_lookup[index].second = details.max;
+        index++;
+      }
+      return result;
+    }();
 
-    int index = kNumParams;
-    for (auto parameter : parameters) {
-      mopo::ValueDetails& details = parameter.second;
-      lookup[index] = controls[details.name];
-      range_lookup[index].first = details.min;
-      range_lookup[index].second = details.max;
-      index++;
+    return tables;
+  }
+
+  void initializeValueLookup(mopo::Value** lookup, mopo::control_map& controls, int num_params) {
+    const ParameterTables& tables = getParameterTables();
+
+    for (int i = 0; i < num_params; ++i) {
+      if (tables.names[i].empty())
+        lookup[i] = 0;
+      else
+        lookup[i] = controls[tables.names[i]];
     }
   }
 
-  UNITY_AUDIODSP_RESULT UNITY_AUDIODSP_CALLBACK CreateCallback(UnityAudioEffectState* state) {
+  EffectData* createEffectData() {
+    const ParameterTables& tables = getParameterTables();
+
     EffectData* effect_data = new EffectData;
     memset(effect_data->sequencer_events, 0, sizeof(HelmSequencer::Note*) * MAX_NOTES);
+    memset(effect_data->sequencer_active, 0, sizeof(HelmSequencer::Note*) * MAX_NOTES);
 
-    effect_data->num_synth_parameters = mopo::Parameters::lookup_.getAllDetails().size();
-    int num_params = effect_data->num_synth_parameters + kNumParams + MAX_MODULATIONS * VALUES_PER_MODULATION;
+    int num_params = tables.num_parameters;
     effect_data->num_parameters = num_params;
+    effect_data->num_synth_parameters = num_params - kNumParams - MAX_MODULATIONS * VALUES_PER_MODULATION;
 
     effect_data->parameters = new float[num_params];
-    InitParametersFromDefinitions(InternalRegisterEffectDefinition, effect_data->parameters);
+    memcpy(effect_data->parameters, tables.default_values, num_params * sizeof(float));
 
     effect_data->value_lookup = new mopo::Value*[num_params];
-    effect_data->range_lookup = new std::pair<float, float>[num_params];
+    effect_data->range_lookup = tables.range_lookup;
     mopo::control_map controls = effect_data->synth_engine.getControls();
-    initializeValueLookup(effect_data->value_lookup, effect_data->range_lookup, controls, num_params);
+    initializeValueLookup(effect_data->value_lookup, controls, num_params);
 
     for (int i = 0; i < MAX_MODULATIONS; ++i)
       effect_data->modulations[i] = new mopo::ModulationConnection();
 
-    effect_data->synth_engine.setSampleRate(state->samplerate);
+    effect_data->sample_rate = 0;
+    effect_data->requested_rate_divider = 1;
+    effect_data->rate_divider = 1;
     effect_data->active = false;
     effect_data->silent = false;
-    effect_data->current_beat = 0.0;
-    effect_data->last_global_beat_sync = 0.0;
+    effect_data->control_interval = mopo::MAX_BUFFER_SIZE;
+    effect_data->num_scheduled_values = 0;
+    effect_data->num_value_ramps = 0;
+    effect_data->beat_generation = 0;
+    effect_data->beat_seeks = 0;
+    effect_data->sequencer_beat = 0.0;
+    effect_data->sequencer_held = false;
+    effect_data->sequencer_held_beat = 0.0;
     effect_data->num_send_channels = 0;
     memset(effect_data->send_data, 0, MAX_UNITY_CHANNELS * MAX_UNITY_BUFFER_SIZE * sizeof(float));
+    return effect_data;
+  }
+
+  // Work per sample a reduced rate saves, in units of one oscillator voice.
+  // Below the minimum the upsamplers cost more than the engine samples saved.
+  const int VOICE_BASE_WORK = 2;
+  const int EFFECT_WORK = 10;
+  const int MIN_REDUCED_RATE_WORK = 24;
+
+  // Whether the loaded patch does enough work per sample to pay for the
+  // upsamplers: its polyphony times the oscillator voices each note plays,
+  // and the reverb and delay.
+  bool reducedRatePays(EffectData* data) {
+    mopo::control_map controls = data->synth_engine.getControls();
+    int voice_work = VOICE_BASE_WORK + controls["osc_1_unison_voices"]->value() +
+                     controls["osc_2_unison_voices"]->value();
+    int work = controls["polyphony"]->value() * voice_work;
+    work += EFFECT_WORK * (controls["reverb_on"]->value() + controls["delay_on"]->value());
+    return work >= MIN_REDUCED_RATE_WORK;
+  }
 
+  // The largest divider up to the requested one that gives a whole sample
+  // rate, or 1 when the patch is too light to pay for the upsamplers.
+  int rateDivider(EffectData* data, int sample_rate) {
+    if (!reducedRatePays(data))
+      return 1;
+
+    int divider = data->requested_rate_divider;
+    while (sample_rate % divider)
+      divider--;
+    return divider;
+  }
+
+  // The engine runs at the host rate divided by rateDivider. The upsamplers
+  // bring its output back up to the host rate. Changing the engine's rate can
+  // rebuild voices, so this only runs when an instance is created or reset, a
+  // divider is requested or a patch is loaded, never on the audio thread.
+  void setSampleRate(EffectData* data, int sample_rate) {
+    int divider = rateDivider(data, sample_rate);
+    data->rate_divider = divider;
+    data->synth_engine.setSampleRate(sample_rate / divider);
+    data->upsamplers[0].setFactor(divider);
+    data->upsamplers[1].setFactor(divider);
+    data->analyzer.setSampleRate(sample_rate);
+    data->sample_rate = sample_rate;
+  }
+
+  void deleteEffectData(EffectData* data) {
+    delete[] data->parameters;
+    delete[] data->value_lookup;
+
+    for (int i = 0; i < MAX_MODULATIONS; ++i) {
+      if (data->synth_engine.isModulationActive(data->modulations[i]))
+        data->synth_engine.disconnectModulation(data->modulations[i]);
+      delete data->modulations[i];
+    }
+
+    delete data;
+  }
+
+  // State of a new engine running at _sample_rate_. Restoring it puts a
+  // released engine's voices, envelopes and delay lines back where they
+  // started. Call with pool_mutex held.
+  const std::vector<char>& getInitialState(int sample_rate) {
+    std::vector<char>& state = initial_states[sample_rate];
+    if (state.empty()) {
+      mopo::HelmEngine engine;
+      engine.setSampleRate(sample_rate);
+      state.resize(engine.saveState(nullptr, 0));
+      engine.saveState(state.data(), state.size());
+    }
+    return state;
+  }
+
+  // Value of every control in a new engine, indexed like value_lookup. These
+  // aren't always the Unity parameter defaults.
+  const std::vector<mopo::mopo_float>& getInitialValues() {
+    static std::vector<mopo::mopo_float> values = [] {
+      const ParameterTables& tables = getParameterTables();
+      mopo::HelmEngine engine;
+      mopo::control_map controls = engine.getControls();
+      std::vector<mopo::Value*> lookup(tables.num_parameters);
+      initializeValueLookup(lookup.data(), controls, tables.num_parameters);
+
+      std::vector<mopo::mopo_float> result(tables.num_parameters, 0.0);
+      for (int i = 0; i < tables.num_parameters; ++i) {
+        if (lookup[i])
+          result[i] = lookup[i]->value();
+      }
+      return result;
+    }();
+    return values;
+  }
+
+  // Puts a released instance back the way createEffectData made it so it can
+  // be handed out again. Returns false if the engine couldn't be restored, and
+  // then it should be deleted instead.
+  bool resetEffectData(EffectData* data) {
+    const ParameterTables& tables = getParameterTables();
+    mopo::HelmEngine& engine = data->synth_engine;
+
+    for (int i = 0; i < MAX_MODULATIONS; ++i) {
+      mopo::ModulationConnection* connection = data->modulations[i];
+      if (engine.isModulationActive(connection))
+        engine.disconnectModulation(connection);
+      connection->resetConnection("", "");
+      connection->amount.set(0.0);
+    }
+    engine.setVoiceThreads(1);
+
+    const std::vector<mopo::mopo_float>& initial_values = getInitialValues();
+    memcpy(data->parameters, tables.default_values, data->num_parameters * sizeof(float));
+    for (int i = 0; i < data->num_parameters; ++i) {
+      if (data->value_lookup[i])
+        data->value_lookup[i]->set(initial_values[i]);
+    }
+
+    std::pair<float, float> note_event;
+    while (data->note_events.try_dequeue(note_event))
+      ;
+    ValueEvent value_event;
+    while (data->value_events.try_dequeue(value_event))
+      ;
+    ModulationEvent modulation_event;
+    while (data->modulation_events.try_dequeue(modulation_event))
+      ;
+    data->num_scheduled_values = 0;
+    data->num_value_ramps = 0;
+    memset(data->sequencer_events, 0, sizeof(HelmSequencer::Note*) * MAX_NOTES);
+    memset(data->sequencer_active, 0, sizeof(HelmSequencer::Note*) * MAX_NOTES);
+
+    data->requested_rate_divider = 1;
+    if (data->sample_rate)
+      setSampleRate(data, data->sample_rate);
+    data->analyzer.reset();
+
+    data->active = false;
+    data->silent = false;
+    data->control_interval = mopo::MAX_BUFFER_SIZE;
+    data->beat_generation = 0;
+    data->beat_seeks = 0;
+    data->sequencer_beat = 0.0;
+    data->sequencer_held = false;
+    data->sequencer_held_beat = 0.0;
+    data->num_send_channels = 0;
+    memset(data->send_data, 0, MAX_UNITY_CHANNELS * MAX_UNITY_BUFFER_SIZE * sizeof(float));
+
+    engine.allNotesOff();
+    AudioHelm::MutexScopeLock mutex_lock(pool_mutex);
+    const std::vector<char>& state = getInitialState(engine.getSampleRate());
+    return engine.loadState(state.data(), state.size());
+  }
+
+  // Keeps _data_ for the next instance if the pool has room.
+  void recycleEffectData(EffectData* data) {
+    bool has_room = false;
+    {
+      AudioHelm::MutexScopeLock mutex_lock(pool_mutex);
+      has_room = static_cast<int>(instance_pool.size()) < pool_capacity;
+    }
+
+    if (has_room && resetEffectData(data)) {
+      AudioHelm::MutexScopeLock mutex_lock(pool_mutex);
+      instance_pool.push_back(data);
+    }
+    else
+      deleteEffectData(data);
+  }
+
+  EffectData* grabEffectData() {
+    {
+      AudioHelm::MutexScopeLock mutex_lock(pool_mutex);
+      if (instance_pool.size()) {
+        EffectData* effect_data = instance_pool.back();
+        instance_pool.pop_back();
+        return effect_data;
+      }
+    }
+
+    return createEffectData();
+  }
+
+  UNITY_AUDIODSP_RESULT UNITY_AUDIODSP_CALLBACK CreateCallback(UnityAudioEffectState* state) {
+    EffectData* effect_data = grabEffectData();
+    if (effect_data->sample_rate != static_cast<int>(state->samplerate))
+      setSampleRate(effect_data, state->samplerate);
+
+    effect_data->beat_seeks = transport.seeks();
     state->effectdata = effect_data;
     AudioHelm::MutexScopeLock mutex_instance_lock(instance_mutex);
     effect_data->instance_id = instance_counter;
@@ -171,26 +476,37 @@ namespace Helm {
   UNITY_AUDIODSP_RESULT UNITY_AUDIODSP_CALLBACK ReleaseCallback(UnityAudioEffectState* state) {
     EffectData* data = state->GetEffectData<EffectData>();
     data->mutex.Lock();
+    data->engine_gate.close();
 
     AudioHelm::MutexScopeLock mutex_instance_lock(instance_mutex);
     data->synth_engine.allNotesOff();
     clearInstance(data->instance_id);
 
+    data->engine_gate.open();
     data->mutex.Unlock();
 
-    delete[] data->parameters;
-    delete[] data->value_lookup;
-    delete[] data->range_lookup;
+    recycleEffectData(data);
+    return UNITY_AUDIODSP_OK;
+  }
 
-    for (int i = 0; i < MAX_MODULATIONS; ++i) {
-      if (data->synth_engine.isModulationActive(data->modulations[i]))
-        data->synth_engine.disconnectModulation(data->modulations[i]);
-      delete data->modulations[i];
-    }
+  // Voices are only built for the polyphony a patch can reach, so a change
+  // raising it builds them before the audio thread sees the new value.
+  void prepareValue(EffectData* data, int index, float value) {
+    if (index != getParameterTables().polyphony_index)
+      return;
 
-    delete data;
+    GateScopeLock gate_lock(data->mutex, data->engine_gate);
+    if (value > data->synth_engine.getNumVoices())
+      data->synth_engine.prepareVoices(value);
+  }
 
-    return UNITY_AUDIODSP_OK;
+  // Applies new amounts for connected modulations. The audio thread calls it
+  // every block, and API threads before they change a connection, since the
+  // amounts still queued are older than the change.
+  void processQueuedModulations(EffectData* data) {
+    ModulationEvent event;
+    while (data->modulation_events.try_dequeue(event))
+      data->modulations[event.index]->amount.set(event.amount);
   }
 
   UNITY_AUDIODSP_RESULT UNITY_AUDIODSP_CALLBACK SetFloatParameterCallback(
@@ -202,8 +518,10 @@ namespace Helm {
 
     data->parameters[index] = value;
 
-    if (data->value_lookup[index])
-      data->value_events.enqueue(std::pair<int, float>(index, value));
+    if (data->value_lookup[index]) {
+      prepareValue(data, index, value);
+      data->value_events.enqueue({index, value, 0, 0});
+    }
 
     int modulation_start = kNumParams + data->num_synth_parameters;
     if (index >= modulation_start) {
@@ -214,47 +532,32 @@ namespace Helm {
       int mod_type = mod_param % VALUES_PER_MODULATION;
 
       mopo::ModulationConnection* connection = data->modulations[mod_index];
+      bool active = data->synth_engine.isModulationActive(connection);
+      bool connect = mod_type == 2 && value != 0.0f;
 
-      if (mod_type == 0) {
-        if (data->synth_engine.isModulationActive(connection))
-          data->synth_engine.disconnectModulation(connection);
-
-        int source_index = value;
-        mopo::output_map sources = data->synth_engine.getModulationSources();
-        auto source = sources.begin();
-        std::advance(source, source_index);
-        connection->source = source->first;
+      // A new amount for a connected modulation leaves the graph alone.
+      if (active && connect) {
+        data->modulation_events.enqueue({mod_index, value});
+        return UNITY_AUDIODSP_OK;
       }
-      else if (mod_type == 1) {
-        if (data->synth_engine.isModulationActive(connection))
-          data->synth_engine.disconnectModulation(connection);
 
-        mopo::output_map monoMods = data->synth_engine.getMonoModulations();
-        int dest_index = value;
-        if (dest_index < monoMods.size()) {
-          auto mod = monoMods.begin();
-          std::advance(mod, dest_index);
-          connection->destination = mod->first;
-        }
-        else {
-          dest_index -= monoMods.size();
-          mopo::output_map polyMods = data->synth_engine.getPolyModulations();
-          auto mod = polyMods.begin();
-          std::advance(mod, dest_index);
-          connection->destination = mod->first;
-        }
+      GateScopeLock gate_lock(data->mutex, data->engine_gate, active || connect);
+      if (active) {
+        processQueuedModulations(data);
+        data->synth_engine.disconnectModulation(connection);
       }
-      else {
-        if (value == 0.0f) {
-          if (data->synth_engine.isModulationActive(connection))
-            data->synth_engine.disconnectModulation(connection);
-        }
-        else {
-          connection->amount.set(value);
-          if (!data->synth_engine.isModulationActive(connection))
-            data->synth_engine.connectModulation(connection);
-        }
+
+      if (mod_type == 0)
+        connection->source_id = value;
+      else if (mod_type == 1)
+        connection->destination_id = value;
+      else if (connect) {
+        connection->amount.set(value);
+        data->synth_engine.connectModulation(connection);
       }
+
+      if (active || connect)
+        data->synth_engine.prepareVoices();
     }
     return UNITY_AUDIODSP_OK;
   }
@@ -274,8 +577,24 @@ namespace Helm {
     return UNITY_AUDIODSP_OK;
   }
 
+  // Reads the last published analysis. Data is only computed while a receiver
+  // is registered for the instance's channel with HelmAddAnalysisReceiver.
   int UNITY_AUDIODSP_CALLBACK GetFloatBufferCallback(UnityAudioEffectState* state, const char* name,
                                                      float* buffer, int numsamples) {
+    EffectData* data = state->GetEffectData<EffectData>();
+
+    HelmAnalyzer::Type type;
+    if (strcmp(name, "levels") == 0)
+      type = HelmAnalyzer::kLevels;
+    else if (strcmp(name, "scope") == 0)
+      type = HelmAnalyzer::kScope;
+    else if (strcmp(name, "spectrum") == 0)
+      type = HelmAnalyzer::kSpectrum;
+    else
+      return UNITY_AUDIODSP_ERR_UNSUPPORTED;
+
+    int written = data->analyzer.read(type, buffer, numsamples);
+    memset(buffer + written, 0, (numsamples - written) * sizeof(float));
     return UNITY_AUDIODSP_OK;
   }
 
@@ -283,21 +602,12 @@ namespace Helm {
     return SIXTEENTHS_PER_BEAT * beat;
   }
 
-  inline double timeToBeat(double time, int sample_rate) {
-    return (bpm / SECONDS_PER_MINUTE) * time;
-  }
-
-  inline double timeToSixteenth(double time, int sample_rate) {
-    return beatToSixteenth(timeToBeat(time, sample_rate));
-  }
-
   double wrap(double value, double length, int& num_wraps) {
     num_wraps = value / length;
     return value - num_wraps * length;
   }
 
   void processNotes(EffectData* data, HelmSequencer* sequencer, double current_beat, double end_beat) {
-    AudioHelm::MutexScopeLock mutex_lock(sequencer_mutex);
     double sequencer_start_beat = sequencer->start_beat();
 
     if (sequencer_start_beat >= end_beat)
@@ -336,25 +646,137 @@ namespace Helm {
     }
   }
 
-  void processAudio(mopo::HelmEngine& engine,
-                    float* in_buffer, float* out_buffer,
-                    int in_channels, int out_channels, int samples, int offset) {
+  // Position of _beat_ in the sequencer's notes, or -1 before it starts.
+  double sequencerPosition(HelmSequencer* sequencer, double beat) {
+    if (beat < sequencer->start_beat())
+      return -1.0;
+
+    double position = beatToSixteenth(beat);
+    if (sequencer->loop()) {
+      int num_wraps = 0;
+      position = wrap(position, sequencer->length(), num_wraps);
+    }
+    return position;
+  }
+
+  bool containsNote(HelmSequencer::Note** notes, HelmSequencer::Note* note) {
+    for (int i = 0; notes[i]; ++i) {
+      if (notes[i] == note)
+        return true;
+    }
+    return false;
+  }
+
+  // Releases notes held at _from_beat_ and starts notes that should already
+  // be sounding at _to_beat_. Notes held across both keep playing.
+  void seekNotes(EffectData* data, HelmSequencer* sequencer, double from_beat, double to_beat) {
+    double from = sequencerPosition(sequencer, from_beat);
+    double to = sequencerPosition(sequencer, to_beat);
+
+    HelmSequencer::Note** held = data->sequencer_events;
+    HelmSequencer::Note** active = data->sequencer_active;
+    held[0] = nullptr;
+    active[0] = nullptr;
+    if (from >= 0.0)
+      sequencer->getActiveNotes(held, from);
+    if (to >= 0.0)
+      sequencer->getActiveNotes(active, to);
+
+    for (int i = 0; held[i]; ++i) {
+      if (!containsNote(active, held[i]))
+        data->synth_engine.noteOff(held[i]->midi_note);
+    }
+
+    // Notes ending right at the new position are released by the next block.
+    for (int i = 0; active[i]; ++i) {
+      if (!containsNote(held, active[i]) && active[i]->time_off > to)
+        data->synth_engine.noteOn(active[i]->midi_note, active[i]->velocity);
+    }
+
+    if (to >= 0.0)
+      sequencer->updatePosition(to);
+  }
+
+  void seekSequencerNotes(EffectData* data, double from_beat, double to_beat) {
+    for (auto sequencer : sequencer_lookup) {
+      if (sequencer.second && sequencer.first->channel() == data->parameters[kChannel])
+        seekNotes(data, sequencer.first, from_beat, to_beat);
+    }
+  }
+
+  // Plays sequencer notes between the beats. While an API thread edits the
+  // sequencers their notes are held back, and the first sub-block that can
+  // read them again plays everything from where they were held.
+  void playSequencerNotes(EffectData* data, double start_beat, double end_beat) {
+    GateScopeEnter sequencer_scope(sequencer_gate);
+    if (!sequencer_scope.entered()) {
+      if (!data->sequencer_held) {
+        data->sequencer_held = true;
+        data->sequencer_held_beat = start_beat;
+      }
+      return;
+    }
+
+    if (data->sequencer_held) {
+      start_beat = std::min(start_beat, data->sequencer_held_beat);
+      data->sequencer_held = false;
+    }
+    processSequencerNotes(data, start_beat, end_beat);
+  }
+
+  void runEngine(mopo::HelmEngine& engine, int samples, double bpm) {
     if (engine.getBufferSize() != samples)
       engine.setBufferSize(samples);
 
     engine.setBpm(bpm);
     engine.process();
+  }
+
+  // Renders _samples_ samples at the host rate into _left_ and _right_. At a
+  // reduced internal rate the engine only runs when the upsamplers have run
+  // out of queued output, for as few samples as covers the rest.
+  void renderEngine(EffectData* data, int samples, double bpm,
+                    const mopo::mopo_float** left, const mopo::mopo_float** right) {
+    mopo::HelmEngine& engine = data->synth_engine;
+    if (data->rate_divider == 1) {
+      runEngine(engine, samples, bpm);
+      *left = engine.output(0)->buffer;
+      *right = engine.output(1)->buffer;
+      return;
+    }
+
+    int engine_samples = data->upsamplers[0].inputNeeded(samples);
+    if (engine_samples) {
+      runEngine(engine, engine_samples, bpm);
+      data->upsamplers[0].write(engine.output(0)->buffer, engine_samples);
+      data->upsamplers[1].write(engine.output(1)->buffer, engine_samples);
+    }
+    *left = data->upsamplers[0].read(samples);
+    *right = data->upsamplers[1].read(samples);
+  }
+
+  void processAudio(const mopo::mopo_float* engine_output_left,
+                    const mopo::mopo_float* engine_output_right,
+                    float* in_buffer, float* out_buffer,
+                    int in_channels, int out_channels, int samples, int offset) {
+    in_buffer += offset * in_channels;
+    out_buffer += offset * out_channels;
+
+    // Matching layouts interleave through a vector kernel, which scales each
+    // sample by the input before writing it, even in place.
+    if (in_channels == out_channels) {
+      mopo::vector_math::scaleInterleaved(out_buffer, in_buffer, engine_output_left,
+                                          engine_output_right, out_channels, samples);
+      return;
+    }
 
-    const mopo::mopo_float* engine_output_left = engine.output(0)->buffer;
-    const mopo::mopo_float* engine_output_right = engine.output(1)->buffer;
     for (int channel = 0; channel < out_channels; ++channel) {
       const mopo::mopo_float* synth_output = (channel % 2) ? engine_output_right : engine_output_left;
       int in_channel = channel % in_channels;
 
       for (int i = 0; i < samples; ++i) {
-        int sample = i + offset;
-        float mult = in_buffer[sample * in_channels + in_channel];
-        out_buffer[sample * out_channels + channel] = mult * synth_output[i];
+        float mult = in_buffer[i * in_channels + in_channel];
+        out_buffer[i * out_channels + channel] = mult * synth_output[i];
       }
     }
   }
@@ -369,64 +791,196 @@ namespace Helm {
     }
   }
 
+  void startValueEvent(EffectData* data, const ValueEvent& event) {
+    mopo::Value* value = data->value_lookup[event.index];
+
+    // A new event replaces any ramp still running on the same parameter.
+    for (int i = 0; i < data->num_value_ramps; ++i) {
+      if (data->value_ramps[i].value == value) {
+        data->value_ramps[i] = data->value_ramps[--data->num_value_ramps];
+        break;
+      }
+    }
+
+    if (event.ramp_samples <= 0 || data->num_value_ramps >= MAX_SCHEDULED_VALUES) {
+      value->set(event.value);
+      return;
+    }
+
+    ValueRamp& ramp = data->value_ramps[data->num_value_ramps++];
+    ramp.value = value;
+    ramp.start = value->value();
+    ramp.end = event.value;
+    ramp.elapsed = 0;
+    ramp.length = event.ramp_samples;
+  }
+
   void processQueuedFloatChanges(EffectData* data) {
-    std::pair<int, float> event;
-    while (data->value_events.try_dequeue(event))
-      data->value_lookup[event.first]->set(event.second);
+    ValueEvent event;
+    while (data->value_events.try_dequeue(event)) {
+      if (event.sample_offset <= 0 || data->num_scheduled_values >= MAX_SCHEDULED_VALUES)
+        startValueEvent(data, event);
+      else
+        data->scheduled_values[data->num_scheduled_values++] = event;
+    }
+  }
+
+  // Starts every scheduled event due by sample and returns the offset of the
+  // next one still pending, or end if there is none before it.
+  int processScheduledValues(EffectData* data, int sample, int end) {
+    int next = end;
+    int kept = 0;
+    for (int i = 0; i < data->num_scheduled_values; ++i) {
+      ValueEvent event = data->scheduled_values[i];
+      if (event.sample_offset <= sample)
+        startValueEvent(data, event);
+      else {
+        next = std::min(next, event.sample_offset);
+        data->scheduled_values[kept++] = event;
+      }
+    }
+    data->num_scheduled_values = kept;
+    return next;
+  }
+
+  // Moves ramps to where they should be at the end of the next samples.
+  void processValueRamps(EffectData* data, int samples) {
+    int i = 0;
+    while (i < data->num_value_ramps) {
+      ValueRamp& ramp = data->value_ramps[i];
+      ramp.elapsed = std::min(ramp.elapsed + samples, ramp.length);
+      float t = (1.0f * ramp.elapsed) / ramp.length;
+      ramp.value->set(ramp.start + t * (ramp.end - ramp.start));
+
+      if (ramp.elapsed >= ramp.length)
+        ramp = data->value_ramps[--data->num_value_ramps];
+      else
+        ++i;
+    }
+  }
+
+  void finishScheduledValues(EffectData* data, int num_samples) {
+    for (int i = 0; i < data->num_scheduled_values; ++i)
+      data->scheduled_values[i].sample_offset -= num_samples;
+  }
+
+  // Moves parameter changes past a block that isn't rendered, so values and
+  // ramps don't stall while an instance is paused or silent.
+  void skipScheduledValues(EffectData* data, int num_samples) {
+    processQueuedFloatChanges(data);
+    processValueRamps(data, num_samples);
+    processScheduledValues(data, num_samples - 1, num_samples);
+    finishScheduledValues(data, num_samples);
   }
 
   UNITY_AUDIODSP_RESULT UNITY_AUDIODSP_CALLBACK ProcessCallback(
       UnityAudioEffectState* state,
       float* in_buffer, float* out_buffer, unsigned int num_samples,
       int in_channels, int out_channels) {
+    RealtimeScope realtime_scope;
     EffectData* data = state->GetEffectData<EffectData>();
 
-    double last_beat = data->current_beat;
-    double delta_time = (1.0 * num_samples) / state->samplerate;
-    double delta_beat = timeToBeat(delta_time, state->samplerate);
-    double next_beat = last_beat + delta_beat;
-    if (!global_pause) {
-      if (data->last_global_beat_sync != global_beat) {
-        next_beat = global_beat + delta_beat;
-        delta_beat = next_beat - last_beat;
-        data->last_global_beat_sync = global_beat;
-      }
+    // Every instance processing this tick plays the same beats.
+    const HelmTransport::Window& window = data->beat_window;
+    transport.advance(&data->beat_window, state->currdsptick, num_samples, state->samplerate,
+                      &data->beat_generation);
 
-      data->current_beat = next_beat;
+    // While an API thread changes the engine the block is silent, and
+    // everything queued for the engine waits for the next one.
+    GateScopeEnter engine_scope(data->engine_gate);
+    if (!engine_scope.entered()) {
+      memset(out_buffer, 0, num_samples * out_channels * sizeof(float));
+      return UNITY_AUDIODSP_OK;
     }
 
     bool silent = mopo::utils::isSilentf(in_buffer, num_samples * out_channels);
     if (state->flags & UnityAudioEffectStateFlags_IsPaused || silent) {
       data->active = false;
+      data->sequencer_held = false;
       memset(out_buffer, 0, num_samples * out_channels * sizeof(float));
+
+      processQueuedModulations(data);
+      skipScheduledValues(data, num_samples);
       return UNITY_AUDIODSP_OK;
     }
 
     data->active = true;
 
-    int synth_samples = num_samples > mopo::MAX_BUFFER_SIZE ? mopo::MAX_BUFFER_SIZE : num_samples;
-    AudioHelm::MutexScopeLock mutex_lock(data->mutex);
+    processQueuedModulations(data);
     processQueuedFloatChanges(data);
 
-    for (int b = 0; b < num_samples; b += synth_samples) {
-      int current_samples = std::min<int>(synth_samples, num_samples - b);
+    if (window.seeks != data->beat_seeks) {
+      GateScopeEnter sequencer_scope(sequencer_gate);
+      if (sequencer_scope.entered()) {
+        seekSequencerNotes(data, data->sequencer_beat, window.start_beat);
+        data->beat_seeks = window.seeks;
+        data->sequencer_held = false;
+      }
+    }
 
-      double start_beat = last_beat + (delta_beat * b) / num_samples;
-      double end_beat = last_beat + (delta_beat * (b + current_samples)) / num_samples;
-      if (b + synth_samples >= num_samples)
-        end_beat = next_beat;
+    // A seek a sequencer edit held back lands on the next block instead.
+    bool seek_held = window.seeks != data->beat_seeks;
+    if (!seek_held)
+      data->sequencer_beat = window.end_beat;
+
+    // The engine updates its control rate processors once per process call,
+    // so the sub-block length is the control tick interval.
+    int synth_samples = std::min<int>(num_samples, data->control_interval);
+
+    // Only keep a copy of the output around if something will read it. When
+    // silenced, render straight into that copy instead of the Unity buffer.
+    int total_samples = num_samples * out_channels;
+    bool fits_send = total_samples <= MAX_UNITY_CHANNELS * MAX_UNITY_BUFFER_SIZE;
+    int channel = data->parameters[kChannel];
+    bool send = fits_send && channel >= 0 && channel <= MAX_CHANNELS && buffer_receivers[channel].load(std::memory_order_relaxed) > 0;
+    float* render_buffer = out_buffer;
+    if (data->silent && fits_send)
+      render_buffer = data->send_data;
+
+    int analysis_types = 0;
+    if (channel >= 0 && channel <= MAX_CHANNELS) {
+      for (int i = 0; i < HelmAnalyzer::kNumTypes; ++i) {
+        if (analysis_receivers[channel][i].load(std::memory_order_relaxed) > 0)
+          analysis_types |= 1 << i;
+      }
+    }
 
-      if (end_beat > start_beat && !global_pause)
-        processSequencerNotes(data, start_beat, end_beat);
+    // Sub-blocks also end wherever a scheduled parameter change lands.
+    for (int b = 0; b < static_cast<int>(num_samples);) {
+      int next_event = processScheduledValues(data, b, num_samples);
+      int current_samples = std::min<int>(synth_samples, next_event - b);
+      processValueRamps(data, current_samples);
+
+      double start_beat = window.beatAt(b);
+      double end_beat = window.beatAt(b + current_samples);
+      if (end_beat > start_beat && !window.paused && !seek_held)
+        playSequencerNotes(data, start_beat, end_beat);
       processQueuedNotes(data);
-      processAudio(data->synth_engine, in_buffer, out_buffer, in_channels, out_channels, current_samples, b);
-    }
 
-    data->num_send_channels = out_channels;
-    memcpy(data->send_data, out_buffer, num_samples * out_channels * sizeof(float));
+      const mopo::mopo_float* left = nullptr;
+      const mopo::mopo_float* right = nullptr;
+      renderEngine(data, current_samples, window.bpmAt(b), &left, &right);
+      processAudio(left, right, in_buffer, render_buffer, in_channels, out_channels, current_samples, b);
+
+      if (analysis_types)
+        data->analyzer.process(left, right, current_samples, analysis_types);
+      b += current_samples;
+    }
+    finishScheduledValues(data, num_samples);
+    if (analysis_types)
+      data->analyzer.publish(analysis_types);
+
+    if (render_buffer == data->send_data)
+      data->num_send_channels = out_channels;
+    else if (send) {
+      memcpy(data->send_data, out_buffer, total_samples * sizeof(float));
+      data->num_send_channels = out_channels;
+    }
+    else
+      data->num_send_channels = 0;
 
     if (data->silent)
-      memset(out_buffer, 0, num_samples * out_channels * sizeof(float));
+      memset(out_buffer, 0, total_samples * sizeof(float));
 
     return UNITY_AUDIODSP_OK;
   }
@@ -484,7 +1038,7 @@ namespace Helm {
     for (auto synth : instance_map) {
       EffectData* data = synth.second;
       if (((int)data->parameters[kChannel]) == channel) {
-        AudioHelm::MutexScopeLock mutex_lock(synth.second->mutex);
+        GateScopeLock gate_lock(synth.second->mutex, synth.second->engine_gate);
         std::pair<float, float> event;
 
         while (synth.second->note_events.try_dequeue(event))
@@ -521,22 +1075,45 @@ namespace Helm {
     }
   }
 
+  bool enqueueValueEvent(EffectData* data, ValueEvent event) {
+    if (event.index < kNumParams || event.index >= data->num_parameters)
+      return false;
+
+    event.value = mopo::utils::clamp(event.value, data->range_lookup[event.index].first,
+                                                  data->range_lookup[event.index].second);
+    data->parameters[event.index] = event.value;
+    if (data->value_lookup[event.index]) {
+      prepareValue(data, event.index, event.value);
+      data->value_events.enqueue(event);
+    }
+    return true;
+  }
+
   extern "C" UNITY_AUDIODSP_EXPORT_API bool HelmSetParameterValue(int channel, int index, float value) {
     if (index < kNumParams)
       return false;
 
     bool success = true;
+    for (auto synth : instance_map) {
+      EffectData* data = synth.second;
+      if (((int)data->parameters[kChannel]) == channel && data->active)
+        success = enqueueValueEvent(data, {index, value, 0, 0}) && success;
+    }
+    return success;
+  }
+
+  extern "C" UNITY_AUDIODSP_EXPORT_API bool HelmScheduleParameterValues(int channel, int num_events,
+                                                                        const int* indices,
+                                                                        const float* values,
+                                                                        const int* sample_offsets,
+                                                                        const int* ramp_samples) {
+    bool success = true;
     for (auto synth : instance_map) {
       EffectData* data = synth.second;
       if (((int)data->parameters[kChannel]) == channel && data->active) {
-        if (index >= data->num_parameters)
-          success = false;
-        else {
-          float clamped_value = mopo::utils::clamp(value, data->range_lookup[index].first,
-                                                          data->range_lookup[index].second);
-          data->parameters[index] = clamped_value;
-          if (data->value_lookup[index])
-            data->value_events.enqueue(std::pair<int, float>(index, clamped_value));
+        for (int i = 0; i < num_events; ++i) {
+          ValueEvent event = { indices[i], values[i], sample_offsets[i], ramp_samples[i] };
+          success = enqueueValueEvent(data, event) && success;
         }
       }
     }
@@ -547,13 +1124,15 @@ namespace Helm {
     for (auto synth : instance_map) {
       EffectData* data = synth.second;
       if (((int)data->parameters[kChannel]) == channel && data->active) {
-        AudioHelm::MutexScopeLock mutex_lock(data->mutex);
+        GateScopeLock gate_lock(data->mutex, data->engine_gate);
+        processQueuedModulations(data);
 
         for (int i = 0; i < MAX_MODULATIONS; ++i) {
           mopo::ModulationConnection* connection = data->modulations[i];
           if (data->synth_engine.isModulationActive(connection))
             data->synth_engine.disconnectModulation(connection);
         }
+        data->synth_engine.prepareVoices();
       }
     }
   }
@@ -570,13 +1149,100 @@ namespace Helm {
       if (((int)data->parameters[kChannel]) == channel && data->active) {
         AudioHelm::MutexScopeLock mutex_lock(data->mutex);
 
+        // Only the amount changes when the same source and destination are
+        // already connected.
         mopo::ModulationConnection* connection = data->modulations[index];
-        connection->source = source;
-        connection->destination = dest;
+        bool active = data->synth_engine.isModulationActive(connection);
+        if (active && connection->source == source && connection->destination == dest) {
+          data->modulation_events.enqueue({index, amount});
+          continue;
+        }
+
+        GateScopeLock gate_lock(data->mutex, data->engine_gate);
+        processQueuedModulations(data);
+        if (active)
+          data->synth_engine.disconnectModulation(connection);
+
+        connection->resetConnection(source, dest);
         connection->amount.set(amount);
         data->synth_engine.connectModulation(connection);
+        data->synth_engine.prepareVoices();
+      }
+    }
+  }
+
+  void loadPatch(EffectData* data, const mopo::BinaryPatch& patch) {
+    GateScopeLock gate_lock(data->mutex, data->engine_gate);
+
+    // Changes still waiting to be applied are older than the patch.
+    ValueEvent event;
+    while (data->value_events.try_dequeue(event))
+      ;
+    ModulationEvent modulation_event;
+    while (data->modulation_events.try_dequeue(modulation_event))
+      ;
+    data->num_scheduled_values = 0;
+    data->num_value_ramps = 0;
+
+    const mopo::mopo_float* values = patch.values();
+    for (int i = 0; i < patch.numParameters(); ++i) {
+      int index = patch.parameterIndex(i);
+      if (index < 0)
+        continue;
+
+      index += kNumParams;
+      float value = mopo::utils::clamp(values[i],
+                                       static_cast<mopo::mopo_float>(data->range_lookup[index].first),
+                                       static_cast<mopo::mopo_float>(data->range_lookup[index].second));
+      data->parameters[index] = value;
+      if (data->value_lookup[index])
+        data->value_lookup[index]->set(value);
+    }
+
+    for (int i = 0; i < MAX_MODULATIONS; ++i) {
+      mopo::ModulationConnection* connection = data->modulations[i];
+      if (data->synth_engine.isModulationActive(connection))
+        data->synth_engine.disconnectModulation(connection);
+    }
+
+    int num_modulations = std::min(patch.numModulations(), MAX_MODULATIONS);
+    for (int i = 0; i < num_modulations; ++i) {
+      mopo::ModulationConnection* connection = data->modulations[i];
+      patch.resetConnection(i, connection, &data->synth_engine);
+      connection->amount.set(patch.modulations()[i].amount);
+      data->synth_engine.connectModulation(connection);
+    }
+    data->synth_engine.prepareVoices();
+
+    if (data->sample_rate && rateDivider(data, data->sample_rate) != data->rate_divider)
+      setSampleRate(data, data->sample_rate);
+  }
+
+  // Loads a binary patch into every instance on the channel in one step. The
+  // buffer is read in place. Returns false if it isn't a valid patch or no
+  // instance was loaded.
+  extern "C" UNITY_AUDIODSP_EXPORT_API bool HelmLoadPatch(int channel, const char* buffer, int size) {
+    // Managed arrays aren't guaranteed to be aligned for the values.
+    std::vector<mopo::mopo_float> aligned;
+    if (reinterpret_cast<uintptr_t>(buffer) % sizeof(mopo::mopo_float) && size > 0) {
+      aligned.resize((size + sizeof(mopo::mopo_float) - 1) / sizeof(mopo::mopo_float));
+      memcpy(aligned.data(), buffer, size);
+      buffer = reinterpret_cast<const char*>(aligned.data());
+    }
+
+    mopo::BinaryPatch patch;
+    if (!patch.read(buffer, size))
+      return false;
+
+    bool loaded = false;
+    for (auto synth : instance_map) {
+      EffectData* data = synth.second;
+      if (((int)data->parameters[kChannel]) == channel && data->active) {
+        loadPatch(data, patch);
+        loaded = true;
       }
     }
+    return loaded;
   }
 
   extern "C" UNITY_AUDIODSP_EXPORT_API void HelmSilence(int channel, bool silent) {
@@ -587,6 +1253,84 @@ namespace Helm {
     }
   }
 
+  extern "C" UNITY_AUDIODSP_EXPORT_API void HelmSetControlInterval(int channel, int samples) {
+    int interval = std::max(1, std::min<int>(samples, mopo::MAX_BUFFER_SIZE));
+
+    for (auto synth : instance_map) {
+      EffectData* data = synth.second;
+      if (((int)data->parameters[kChannel]) == channel) {
+        GateScopeLock gate_lock(data->mutex, data->engine_gate);
+        data->control_interval = interval;
+      }
+    }
+  }
+
+  // Renders instances on the channel at their sample rate divided by
+  // _divider_, up to 4, and upsamples the result. Patches lose everything
+  // above the reduced nyquist frequency in exchange for running the synth
+  // that many times fewer samples. Patches too light to pay for the
+  // upsampling keep the host rate, checked again on each patch load.
+  extern "C" UNITY_AUDIODSP_EXPORT_API void HelmSetSampleRateDivider(int channel, int divider) {
+    // A copy, because std::min takes a reference the class constant can't give.
+    int max_divider = mopo::PolyphaseUpsampler::MAX_FACTOR;
+    divider = std::max(1, std::min(divider, max_divider));
+
+    for (auto synth : instance_map) {
+      EffectData* data = synth.second;
+      if (((int)data->parameters[kChannel]) == channel) {
+        GateScopeLock gate_lock(data->mutex, data->engine_gate);
+        data->requested_rate_divider = divider;
+        if (data->sample_rate)
+          setSampleRate(data, data->sample_rate);
+      }
+    }
+  }
+
+  extern "C" UNITY_AUDIODSP_EXPORT_API int HelmSaveState(int channel, char* buffer, int size) {
+    for (auto synth : instance_map) {
+      EffectData* data = synth.second;
+      if (((int)data->parameters[kChannel]) == channel && data->active) {
+        GateScopeLock gate_lock(data->mutex, data->engine_gate);
+        return data->synth_engine.saveState(buffer, size);
+      }
+    }
+    return 0;
+  }
+
+  extern "C" UNITY_AUDIODSP_EXPORT_API bool HelmLoadState(int channel, const char* buffer, int size) {
+    bool loaded = false;
+    for (auto synth : instance_map) {
+      EffectData* data = synth.second;
+      if (((int)data->parameters[kChannel]) == channel && data->active) {
+        GateScopeLock gate_lock(data->mutex, data->engine_gate);
+        if (!data->synth_engine.loadState(buffer, size))
+          return false;
+        loaded = true;
+      }
+    }
+    return loaded;
+  }
+
+  extern "C" UNITY_AUDIODSP_EXPORT_API void HelmSetVoiceThreads(int channel, int num_threads) {
+    for (auto synth : instance_map) {
+      EffectData* data = synth.second;
+      if (((int)data->parameters[kChannel]) == channel) {
+        GateScopeLock gate_lock(data->mutex, data->engine_gate);
+        data->synth_engine.setVoiceThreads(num_threads);
+      }
+    }
+  }
+
+  extern "C" UNITY_AUDIODSP_EXPORT_API void HelmAddBufferReceiver(int channel) {
+    if (channel >= 0 && channel <= MAX_CHANNELS)
+      buffer_receivers[channel]++;
+  }
+
+  extern "C" UNITY_AUDIODSP_EXPORT_API void HelmRemoveBufferReceiver(int channel) {
+    if (channel >= 0 && channel <= MAX_CHANNELS)
+      removeReceiver(&buffer_receivers[channel]);
+  }
+
   extern "C" UNITY_AUDIODSP_EXPORT_API void HelmGetBufferData(int channel, float* buffer, int samples, int channels) {
     for (auto synth : instance_map) {
       EffectData* data = synth.second;
@@ -610,6 +1354,29 @@ namespace Helm {
     }
   }
 
+  extern "C" UNITY_AUDIODSP_EXPORT_API void HelmAddAnalysisReceiver(int channel, int type) {
+    if (channel >= 0 && channel <= MAX_CHANNELS && type >= 0 && type < HelmAnalyzer::kNumTypes)
+      analysis_receivers[channel][type]++;
+  }
+
+  extern "C" UNITY_AUDIODSP_EXPORT_API void HelmRemoveAnalysisReceiver(int channel, int type) {
+    if (channel >= 0 && channel <= MAX_CHANNELS && type >= 0 && type < HelmAnalyzer::kNumTypes)
+      removeReceiver(&analysis_receivers[channel][type]);
+  }
+
+  extern "C" UNITY_AUDIODSP_EXPORT_API int HelmGetAnalysisData(int channel, int type,
+                                                               float* buffer, int size) {
+    if (type < 0 || type >= HelmAnalyzer::kNumTypes)
+      return 0;
+
+    for (auto synth : instance_map) {
+      EffectData* data = synth.second;
+      if (((int)data->parameters[kChannel]) == channel && data->active)
+        return data->analyzer.read(static_cast<HelmAnalyzer::Type>(type), buffer, size);
+    }
+    return 0;
+  }
+
   extern "C" UNITY_AUDIODSP_EXPORT_API float HelmGetParameterMinimum(int index) {
     return mopo::Parameters::lookup_.getDetails(index - 1).min;
   }
@@ -669,40 +1436,77 @@ namespace Helm {
 
   extern "C" UNITY_AUDIODSP_EXPORT_API HelmSequencer* CreateSequencer() {
     HelmSequencer* sequencer = new HelmSequencer();
-    AudioHelm::MutexScopeLock mutex_lock(sequencer_mutex);
+    GateScopeLock gate_lock(sequencer_mutex, sequencer_gate);
     sequencer_lookup[sequencer] = false;
     return sequencer;
   }
 
+  extern "C" UNITY_AUDIODSP_EXPORT_API void HelmPrewarmInstances(int num_instances, int sample_rate) {
+    getParameterTables();
+    {
+      AudioHelm::MutexScopeLock mutex_lock(pool_mutex);
+      pool_capacity = std::max(pool_capacity, num_instances);
+    }
+
+    while (true) {
+      {
+        AudioHelm::MutexScopeLock mutex_lock(pool_mutex);
+        if (static_cast<int>(instance_pool.size()) >= num_instances)
+          return;
+      }
+
+      EffectData* effect_data = createEffectData();
+      setSampleRate(effect_data, sample_rate);
+
+      AudioHelm::MutexScopeLock mutex_lock(pool_mutex);
+      instance_pool.push_back(effect_data);
+    }
+  }
+
+  extern "C" UNITY_AUDIODSP_EXPORT_API void HelmReleasePrewarmedInstances() {
+    std::vector<EffectData*> pool;
+    {
+      AudioHelm::MutexScopeLock mutex_lock(pool_mutex);
+      pool.swap(instance_pool);
+      initial_states.clear();
+      // Instances released from here on are deleted.
+      pool_capacity = 0;
+    }
+
+    for (EffectData* effect_data : pool)
+      deleteEffectData(effect_data);
+  }
+
   extern "C" UNITY_AUDIODSP_EXPORT_API void SetBeatTime(double beat) {
-    global_beat = beat;
+    transport.syncBeat(beat);
   }
 
   extern "C" UNITY_AUDIODSP_EXPORT_API void Pause(bool pause) {
-    global_pause = pause;
+    transport.setPause(pause);
   }
 
   extern "C" UNITY_AUDIODSP_EXPORT_API void DeleteSequencer(HelmSequencer* sequencer) {
-    sequencer_mutex.Lock();
-    sequencer_lookup.erase(sequencer);
-    sequencer_mutex.Unlock();
+    {
+      GateScopeLock gate_lock(sequencer_mutex, sequencer_gate);
+      sequencer_lookup.erase(sequencer);
+    }
     delete sequencer;
   }
 
   extern "C" UNITY_AUDIODSP_EXPORT_API void EnableSequencer(HelmSequencer* sequencer, bool enable) {
-    AudioHelm::MutexScopeLock mutex_lock(sequencer_mutex);
+    GateScopeLock gate_lock(sequencer_mutex, sequencer_gate);
     sequencer_lookup[sequencer] = enable;
   }
 
   extern "C" UNITY_AUDIODSP_EXPORT_API HelmSequencer::Note* CreateNote(
       HelmSequencer* sequencer, int note, float velocity, float start, float end) {
-    AudioHelm::MutexScopeLock mutex_lock(sequencer_mutex);
+    GateScopeLock gate_lock(sequencer_mutex, sequencer_gate);
     return sequencer->addNote(note, velocity, start, end);
   }
 
   extern "C" UNITY_AUDIODSP_EXPORT_API void DeleteNote(
       HelmSequencer* sequencer, HelmSequencer::Note* note) {
-    AudioHelm::MutexScopeLock mutex_lock(sequencer_mutex);
+    GateScopeLock gate_lock(sequencer_mutex, sequencer_gate);
     if (sequencer->isNotePlaying(note))
       HelmNoteOff(sequencer->channel(), note->midi_note);
 
@@ -711,7 +1515,7 @@ namespace Helm {
 
   extern "C" UNITY_AUDIODSP_EXPORT_API void ChangeNoteStart(
       HelmSequencer* sequencer, HelmSequencer::Note* note, float new_start) {
-    AudioHelm::MutexScopeLock mutex_lock(sequencer_mutex);
+    GateScopeLock gate_lock(sequencer_mutex, sequencer_gate);
     bool wasPlaying = sequencer->isNotePlaying(note);
     sequencer->changeNoteStart(note, new_start);
 
@@ -721,7 +1525,7 @@ namespace Helm {
 
   extern "C" UNITY_AUDIODSP_EXPORT_API void ChangeNoteEnd(
       HelmSequencer* sequencer, HelmSequencer::Note* note, float new_end) {
-    AudioHelm::MutexScopeLock mutex_lock(sequencer_mutex);
+    GateScopeLock gate_lock(sequencer_mutex, sequencer_gate);
     bool wasPlaying = sequencer->isNotePlaying(note);
     sequencer->changeNoteEnd(note, new_end);
 
@@ -732,7 +1536,7 @@ namespace Helm {
   extern "C" UNITY_AUDIODSP_EXPORT_API void ChangeNoteValues(
       HelmSequencer* sequencer, HelmSequencer::Note* note,
       int new_midi_key, float new_start, float new_end, float new_velocity) {
-    AudioHelm::MutexScopeLock mutex_lock(sequencer_mutex);
+    GateScopeLock gate_lock(sequencer_mutex, sequencer_gate);
     bool wasPlaying = sequencer->isNotePlaying(note);
     sequencer->changeNoteKey(note, new_midi_key);
     sequencer->changeNoteStart(note, new_start);
@@ -749,7 +1553,7 @@ namespace Helm {
 
   extern "C" UNITY_AUDIODSP_EXPORT_API void ChangeNoteKey(
       HelmSequencer* sequencer, HelmSequencer::Note* note, int midi_key) {
-    AudioHelm::MutexScopeLock mutex_lock(sequencer_mutex);
+    GateScopeLock gate_lock(sequencer_mutex, sequencer_gate);
     if (sequencer->isNotePlaying(note))
       HelmNoteOff(sequencer->channel(), note->midi_note);
 
@@ -758,7 +1562,7 @@ namespace Helm {
 
   extern "C" UNITY_AUDIODSP_EXPORT_API bool ChangeSequencerChannel(
       HelmSequencer* sequencer, int channel) {
-    AudioHelm::MutexScopeLock mutex_lock(sequencer_mutex);
+    GateScopeLock gate_lock(sequencer_mutex, sequencer_gate);
     sequencer->setChannel(channel);
 
     for (auto sequencer : sequencer_lookup) {
@@ -769,25 +1573,38 @@ namespace Helm {
   }
 
   extern "C" UNITY_AUDIODSP_EXPORT_API void SetSequencerStart(HelmSequencer* sequencer, double start_beat) {
-    AudioHelm::MutexScopeLock mutex_lock(sequencer_mutex);
+    GateScopeLock gate_lock(sequencer_mutex, sequencer_gate);
     sequencer->setStartBeat(start_beat);
   }
 
   extern "C" UNITY_AUDIODSP_EXPORT_API void ChangeSequencerLength(HelmSequencer* sequencer, float length) {
-    AudioHelm::MutexScopeLock mutex_lock(sequencer_mutex);
+    GateScopeLock gate_lock(sequencer_mutex, sequencer_gate);
     sequencer->setLength(length);
   }
 
   extern "C" UNITY_AUDIODSP_EXPORT_API void LoopSequencer(HelmSequencer* sequencer, bool loop) {
-    AudioHelm::MutexScopeLock mutex_lock(sequencer_mutex);
+    GateScopeLock gate_lock(sequencer_mutex, sequencer_gate);
     sequencer->loop(loop);
   }
 
+#ifdef HELM_REALTIME_CHECK
+  extern "C" UNITY_AUDIODSP_EXPORT_API int HelmGetRealtimeViolations() {
+    return getRealtimeViolations();
+  }
+#endif
+
   extern "C" UNITY_AUDIODSP_EXPORT_API void SetBpm(float new_bpm) {
-    bpm = new_bpm;
+    transport.setBpm(new_bpm);
+  }
+
+  // Starts moving the tempo to _new_bpm_ at _dsp_time_ (AudioSettings.dspTime)
+  // and gets there linearly over _ramp_seconds_.
+  extern "C" UNITY_AUDIODSP_EXPORT_API void HelmScheduleBpm(double dsp_time, float new_bpm,
+                                                            double ramp_seconds) {
+    transport.scheduleTempo(dsp_time, new_bpm, ramp_seconds);
   }
 
   extern "C" UNITY_AUDIODSP_EXPORT_API float GetBpm() {
-    return bpm;
+    return transport.bpm();
   }
 }
@@ -2,6 +2,9 @@
 
 #include "helm_sequencer.h"
 
+#include <algorithm>
+#include <limits>
+
 #define kDefaultNumSixteenths 16
 
 namespace Helm {
@@ -12,6 +15,7 @@ namespace Helm {
     start_beat_ = 0.0;
     num_sixteenths_ = kDefaultNumSixteenths;
     current_position_ = 0.0;
+    index_leaves_ = 0;
   }
 
   HelmSequencer::~HelmSequencer() {
@@ -28,13 +32,13 @@ namespace Helm {
     note->time_on = start;
     note->time_off = end;
 
-    on_events_[std::pair<double, int>(start, midi_note)] = note;
+    addOnEvent(note);
     off_events_[std::pair<double, int>(end, midi_note)] = note;
     return note;
   }
 
   void HelmSequencer::deleteNote(Note* note) {
-    on_events_.erase(std::pair<double, int>(note->time_on, note->midi_note));
+    removeOnEvent(note);
     off_events_.erase(std::pair<double, int>(note->time_off, note->midi_note));
     delete note;
   }
@@ -44,22 +48,23 @@ namespace Helm {
   }
 
   void HelmSequencer::changeNoteStart(Note* note, double start) {
-    on_events_.erase(std::pair<double, int>(note->time_on, note->midi_note));
+    removeOnEvent(note);
     note->time_on = start;
-    on_events_[std::pair<double, int>(start, note->midi_note)] = note;
+    addOnEvent(note);
   }
 
   void HelmSequencer::changeNoteEnd(Note* note, double end) {
     off_events_.erase(std::pair<double, int>(note->time_off, note->midi_note));
     note->time_off = end;
     off_events_[std::pair<double, int>(end, note->midi_note)] = note;
+    updateIndexEnds(findInIndex(note), 1);
   }
 
   void HelmSequencer::changeNoteKey(Note* note, int midi_key) {
-    on_events_.erase(std::pair<double, int>(note->time_on, note->midi_note));
+    removeOnEvent(note);
     off_events_.erase(std::pair<double, int>(note->time_off, note->midi_note));
     note->midi_note = midi_key;
-    on_events_[std::pair<double, int>(note->time_on, midi_key)] = note;
+    addOnEvent(note);
     off_events_[std::pair<double, int>(note->time_off, midi_key)] = note;
   }
 
@@ -91,4 +96,110 @@ namespace Helm {
   void HelmSequencer::getNoteOffs(Note** notes, double start, double end) {
     getNoteEvents(notes, off_events_, start, end);
   }
+
+  int HelmSequencer::getActiveNotes(Note** notes, double position) {
+    // Only notes before this point in start order have started.
+    auto first_unstarted = std::lower_bound(
+        index_notes_.begin(), index_notes_.end(), position,
+        [](const Note* note, double time) { return note->time_on < time; });
+    int num_started = first_unstarted - index_notes_.begin();
+
+    int num_notes = 0;
+    if (num_started)
+      collectActiveNotes(notes, num_notes, 1, 0, index_leaves_, num_started, position);
+    notes[num_notes] = nullptr;
+    return num_notes;
+  }
+
+  void HelmSequencer::addOnEvent(Note* note) {
+    Note*& on_event = on_events_[std::pair<double, int>(note->time_on, note->midi_note)];
+    if (on_event)
+      removeFromIndex(on_event);
+    on_event = note;
+    addToIndex(note);
+  }
+
+  void HelmSequencer::removeOnEvent(const Note* note) {
+    auto on_event = on_events_.find(std::pair<double, int>(note->time_on, note->midi_note));
+    if (on_event == on_events_.end())
+      return;
+
+    removeFromIndex(on_event->second);
+    on_events_.erase(on_event);
+  }
+
+  int HelmSequencer::findInIndex(const Note* note) const {
+    auto position = std::lower_bound(index_notes_.begin(), index_notes_.end(), note,
+                                     [](const Note* left, const Note* right) {
+      if (left->time_on != right->time_on)
+        return left->time_on < right->time_on;
+      return left->midi_note < right->midi_note;
+    });
+    return position - index_notes_.begin();
+  }
+
+  void HelmSequencer::addToIndex(Note* note) {
+    int index = findInIndex(note);
+    index_notes_.insert(index_notes_.begin() + index, note);
+    updateIndexEnds(index, index_notes_.size() - index);
+  }
+
+  void HelmSequencer::removeFromIndex(const Note* note) {
+    int index = findInIndex(note);
+    if (index >= static_cast<int>(index_notes_.size()) || index_notes_[index] != note)
+      return;
+
+    index_notes_.erase(index_notes_.begin() + index);
+    // One past the end too, so the leaf the last note moved out of is cleared.
+    updateIndexEnds(index, index_notes_.size() + 1 - index);
+  }
+
+  void HelmSequencer::updateIndexEnds(int first, int count) {
+    int num_notes = index_notes_.size();
+    if (num_notes > index_leaves_) {
+      int leaves = std::max(1, index_leaves_);
+      while (leaves < num_notes)
+        leaves *= 2;
+
+      index_leaves_ = leaves;
+      index_notes_.reserve(leaves);
+      index_ends_.assign(2 * leaves, -std::numeric_limits<double>::infinity());
+      first = 0;
+      count = num_notes;
+    }
+
+    int last = std::min(first + count, index_leaves_);
+    if (first >= last)
+      return;
+
+    for (int i = first; i < last; ++i) {
+      if (i < num_notes)
+        index_ends_[index_leaves_ + i] = index_notes_[i]->time_off;
+      else
+        index_ends_[index_leaves_ + i] = -std::numeric_limits<double>::infinity();
+    }
+
+    int low = (index_leaves_ + first) / 2;
+    int high = (index_leaves_ + last - 1) / 2;
+    for (; low > 0; low /= 2, high /= 2) {
+      for (int i = low; i <= high; ++i)
+        index_ends_[i] = std::max(index_ends_[2 * i], index_ends_[2 * i + 1]);
+    }
+  }
+
+  void HelmSequencer::collectActiveNotes(Note** notes, int& num_notes, int node,
+                                         int node_start, int node_end, int num_started,
+                                         double position) {
+    if (num_notes >= kMaxNotes || node_start >= num_started || index_ends_[node] < position)
+      return;
+
+    if (node >= index_leaves_) {
+      notes[num_notes++] = index_notes_[node - index_leaves_];
+      return;
+    }
+
+    int middle = (node_start + node_end) / 2;
+    collectActiveNotes(notes, num_notes, 2 * node, node_start, middle, num_started, position);
+    collectActiveNotes(notes, num_notes, 2 * node + 1, middle, node_end, num_started, position);
+  }
 }
@@ -5,6 +5,7 @@
 #define HELM_SEQUENCER_H
 
 #include <map>
+#include <vector>
 
 namespace Helm {
 
@@ -34,6 +35,11 @@ namespace Helm {
       void getNoteEvents(Note** notes, event_map& events, double start, double end);
       void getNoteOns(Note* notes[kMaxNotes], double start, double end);
       void getNoteOffs(Note* notes[kMaxNotes], double start, double end);
+
+      // Notes that have started before _position_ and haven't ended before
+      // it, the same test as isNotePlaying. Fills up to kMaxNotes, null
+      // terminated, and returns how many were found.
+      int getActiveNotes(Note* notes[kMaxNotes], double position);
       double length() { return num_sixteenths_; }
       int channel() { return channel_; }
       double start_beat() { return start_beat_; }
@@ -49,6 +55,18 @@ namespace Helm {
       }
 
     private:
+      // Every change to on_events_ goes through these so the index matches it.
+      void addOnEvent(Note* note);
+      void removeOnEvent(const Note* note);
+      int findInIndex(const Note* note) const;
+      void addToIndex(Note* note);
+      void removeFromIndex(const Note* note);
+      // Refreshes _count_ leaves from _first_ and the nodes above them.
+      void updateIndexEnds(int first, int count);
+      void collectActiveNotes(Note** notes, int& num_notes, int node,
+                              int node_start, int node_end, int num_started,
+                              double position);
+
       int channel_;
       bool loop_;
       event_map on_events_;
@@ -56,6 +74,13 @@ namespace Helm {
       double num_sixteenths_;
       double start_beat_;
       double current_position_;
+
+      // Notes in start order, with a max tree over their end times so active
+      // notes can be found without scanning. Kept up to date by every edit,
+      // so queries on the audio thread never rebuild or allocate.
+      int index_leaves_;
+      std::vector<Note*> index_notes_;
+      std::vector<double> index_ends_;
   };
 
 } // Helm
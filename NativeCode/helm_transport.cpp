@@ -0,0 +1,216 @@
+/* Copyright 2017 Matt Tytel */
+
+#include "helm_transport.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace Helm {
+
+  namespace {
+    const double SECONDS_PER_MINUTE = 60.0;
+    const double DEFAULT_BPM = 120.0;
+  } // namespace
+
+  int HelmTransport::Window::findSegment(int sample) const {
+    int segment = num_segments_ - 1;
+    while (segment > 0 && segments_[segment].start > sample)
+      segment--;
+    return segment;
+  }
+
+  double HelmTransport::Window::beatAt(int sample) const {
+    if (sample >= samples)
+      return end_beat;
+
+    const Segment& segment = segments_[findSegment(sample)];
+    double delta = sample - segment.start;
+    double beat = segment.beat + (segment.bpm + 0.5 * segment.slope * delta) *
+                                 delta * beats_per_bpm_sample_;
+    return start_beat + stretch_ * beat;
+  }
+
+  double HelmTransport::Window::bpmAt(int sample) const {
+    const Segment& segment = segments_[findSegment(sample)];
+    return segment.bpm + segment.slope * (sample - segment.start);
+  }
+
+  HelmTransport::HelmTransport() : sequence_(0), bpm_(DEFAULT_BPM), sync_beat_(0.0),
+                                   pause_(false), seeks_(0), time_(0.0), beat_(0.0), last_sync_beat_(0.0),
+                                   current_bpm_(DEFAULT_BPM), ramp_target_(DEFAULT_BPM),
+                                   ramp_remaining_(0), num_pending_(0) {
+    window_.tick = ~0ULL;
+    window_.generation = 0;
+    window_.samples = 0;
+    window_.paused = false;
+    window_.seeks = 0;
+    window_.start_beat = 0.0;
+    window_.end_beat = 0.0;
+    window_.beats_per_bpm_sample_ = 0.0;
+    window_.stretch_ = 1.0;
+    window_.num_segments_ = 1;
+    window_.segments_[0] = { 0, 0.0, DEFAULT_BPM, 0.0 };
+  }
+
+  void HelmTransport::setBpm(double bpm) {
+    bpm_.store(bpm, std::memory_order_relaxed);
+    tempo_changes_.enqueue({ -1.0, bpm, 0.0 });
+  }
+
+  void HelmTransport::scheduleTempo(double time, double bpm, double ramp) {
+    tempo_changes_.enqueue({ time, bpm, ramp });
+  }
+
+  void HelmTransport::syncBeat(double beat) {
+    sync_beat_.store(beat, std::memory_order_relaxed);
+  }
+
+  void HelmTransport::setPause(bool pause) {
+    pause_.store(pause, std::memory_order_relaxed);
+  }
+
+  void HelmTransport::advance(Window* window, unsigned long long tick, int samples,
+                              int sample_rate, unsigned int* last_generation) {
+    // sequence_ is odd while a window is being written. Whoever moves it off
+    // an even value computes the window; everyone else copies it and checks
+    // nothing was written underneath them.
+    while (true) {
+      unsigned int sequence = sequence_.load(std::memory_order_acquire);
+      if (sequence & 1)
+        continue;
+
+      *window = window_;
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (sequence_.load(std::memory_order_relaxed) != sequence)
+        continue;
+
+      if (window->generation && window->tick == tick && window->generation != *last_generation) {
+        *last_generation = window->generation;
+        return;
+      }
+
+      if (sequence_.compare_exchange_strong(sequence, sequence + 1, std::memory_order_acquire)) {
+        computeWindow(tick, samples, sample_rate);
+        sequence_.store(sequence + 2, std::memory_order_release);
+      }
+    }
+  }
+
+  void HelmTransport::takeTempoChanges() {
+    TempoChange change;
+    while (tempo_changes_.try_dequeue(change)) {
+      if (num_pending_ >= kMaxTempoChanges)
+        num_pending_--;
+
+      // Keep pending changes sorted by time, first in first out on ties.
+      int index = num_pending_++;
+      for (; index > 0 && pending_[index - 1].time > change.time; --index)
+        pending_[index] = pending_[index - 1];
+      pending_[index] = change;
+    }
+  }
+
+  void HelmTransport::startTempoChange(const TempoChange& change, int sample_rate) {
+    ramp_target_ = change.bpm;
+    ramp_remaining_ = std::max<int>(0, lround(change.ramp * sample_rate));
+    if (ramp_remaining_ == 0)
+      current_bpm_ = change.bpm;
+  }
+
+  int HelmTransport::changeOffset(const TempoChange& change, int sample_rate) const {
+    return std::max<int>(0, lround((change.time - time_) * sample_rate));
+  }
+
+  void HelmTransport::computeWindow(unsigned long long tick, int samples, int sample_rate) {
+    if (tick != window_.tick)
+      time_ = (1.0 * tick) / sample_rate;
+
+    takeTempoChanges();
+
+    Window& window = window_;
+    window.tick = tick;
+    window.generation++;
+    window.samples = samples;
+    window.beats_per_bpm_sample_ = 1.0 / (SECONDS_PER_MINUTE * sample_rate);
+    window.num_segments_ = 0;
+
+    // Split the tick wherever a tempo change starts or a ramp ends.
+    double beats = 0.0;
+    int sample = 0;
+    while (sample < samples || window.num_segments_ == 0) {
+      int first_change = 0;
+      for (; first_change < num_pending_; ++first_change) {
+        if (changeOffset(pending_[first_change], sample_rate) > sample)
+          break;
+        startTempoChange(pending_[first_change], sample_rate);
+      }
+      num_pending_ -= first_change;
+      for (int i = 0; i < num_pending_; ++i)
+        pending_[i] = pending_[i + first_change];
+
+      int end = samples;
+      if (window.num_segments_ < kMaxSegments - 1) {
+        if (num_pending_)
+          end = std::min(end, changeOffset(pending_[0], sample_rate));
+        if (ramp_remaining_)
+          end = std::min(end, sample + ramp_remaining_);
+      }
+
+      double slope = 0.0;
+      if (ramp_remaining_)
+        slope = (ramp_target_ - current_bpm_) / ramp_remaining_;
+
+      Window::Segment& segment = window.segments_[window.num_segments_++];
+      segment.start = sample;
+      segment.beat = beats;
+      segment.bpm = current_bpm_;
+      segment.slope = slope;
+
+      int delta = end - sample;
+      beats += (current_bpm_ + 0.5 * slope * delta) * delta * window.beats_per_bpm_sample_;
+      if (delta >= ramp_remaining_) {
+        if (ramp_remaining_)
+          current_bpm_ = ramp_target_;
+        ramp_remaining_ = 0;
+      }
+      else {
+        current_bpm_ += slope * delta;
+        ramp_remaining_ -= delta;
+      }
+      sample = end;
+    }
+
+    time_ += (1.0 * samples) / sample_rate;
+    bpm_.store(current_bpm_, std::memory_order_relaxed);
+
+    window.paused = pause_.load(std::memory_order_relaxed);
+    window.start_beat = beat_;
+    window.stretch_ = 0.0;
+    if (window.paused) {
+      window.end_beat = beat_;
+      return;
+    }
+
+    // Small syncs stretch this tick to correct drift. Anything larger is a
+    // jump, so the tick starts at the new beat instead.
+    double end_beat = beat_ + beats;
+    double sync_beat = sync_beat_.load(std::memory_order_relaxed);
+    if (sync_beat != last_sync_beat_) {
+      last_sync_beat_ = sync_beat;
+      if (fabs(sync_beat - beat_) > kSeekBeats) {
+        window.seeks++;
+        window.start_beat = sync_beat;
+        seeks_.store(window.seeks, std::memory_order_relaxed);
+      }
+      end_beat = sync_beat + beats;
+    }
+
+    if (beats > 0.0)
+      window.stretch_ = (end_beat - window.start_beat) / beats;
+    else
+      end_beat = window.start_beat;
+
+    window.end_beat = end_beat;
+    beat_ = end_beat;
+  }
+} // namespace Helm
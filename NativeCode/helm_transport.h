@@ -0,0 +1,120 @@
+/* Copyright 2017 Matt Tytel */
+
+#pragma once
+#ifndef HELM_TRANSPORT_H
+#define HELM_TRANSPORT_H
+
+#include "concurrentqueue.h"
+
+#include <atomic>
+
+namespace Helm {
+
+  // The clock every instance and sequencer plays against. Any thread can
+  // change the tempo, schedule tempo ramps, sync the beat or pause. The first
+  // instance to process a DSP tick works out the beats that tick covers and
+  // publishes them, and every other instance processing the same tick reads
+  // that window instead of keeping its own clock.
+  class HelmTransport {
+    public:
+      const static int kMaxSegments = 16;
+      const static int kMaxTempoChanges = 64;
+
+      // Beat syncs that move the clock further than this are seeks, not drift.
+      static constexpr double kSeekBeats = 0.25;
+
+      // The beats one DSP tick covers. Tempo is linear within each segment,
+      // so beats are exact at any sample inside a tempo ramp.
+      class Window {
+        public:
+          double beatAt(int sample) const;
+          double bpmAt(int sample) const;
+
+          unsigned long long tick;
+          unsigned int generation;
+          int samples;
+          bool paused;
+          // Number of times a sync has jumped the clock, including this tick.
+          unsigned int seeks;
+          double start_beat;
+          double end_beat;
+
+        private:
+          struct Segment {
+            int start;
+            double beat;
+            double bpm;
+            double slope;
+          };
+
+          int findSegment(int sample) const;
+
+          double beats_per_bpm_sample_;
+          double stretch_;
+          int num_segments_;
+          Segment segments_[kMaxSegments];
+
+          friend class HelmTransport;
+      };
+
+      HelmTransport();
+
+      // Any thread. Changes the tempo at the start of the next tick.
+      void setBpm(double bpm);
+      double bpm() const { return bpm_.load(std::memory_order_relaxed); }
+
+      // Any thread. Starts moving to _bpm_ at DSP time _time_ in seconds and
+      // gets there linearly over _ramp_ seconds.
+      void scheduleTempo(double time, double bpm, double ramp);
+
+      // Any thread. Where the beat should be at the start of the next tick.
+      void syncBeat(double beat);
+      void setPause(bool pause);
+      bool paused() const { return pause_.load(std::memory_order_relaxed); }
+
+      // Seeks published so far. A new instance starts from here so it only
+      // reacts to seeks that happen after it exists.
+      unsigned int seeks() const { return seeks_.load(std::memory_order_relaxed); }
+
+      // Audio thread. Copies the window for DSP tick _tick_ into _window_,
+      // working it out if this is the first call for that tick.
+      // _last_generation_ is the window the caller read last, so a caller
+      // that's already seen the tick's window moves the clock on even if the
+      // host doesn't advance its tick counter.
+      void advance(Window* window, unsigned long long tick, int samples, int sample_rate,
+                   unsigned int* last_generation);
+
+    private:
+      struct TempoChange {
+        double time;
+        double bpm;
+        double ramp;
+      };
+
+      void computeWindow(unsigned long long tick, int samples, int sample_rate);
+      void takeTempoChanges();
+      void startTempoChange(const TempoChange& change, int sample_rate);
+      int changeOffset(const TempoChange& change, int sample_rate) const;
+
+      std::atomic<unsigned int> sequence_;
+      Window window_;
+
+      moodycamel::ConcurrentQueue<TempoChange> tempo_changes_;
+      std::atomic<double> bpm_;
+      std::atomic<double> sync_beat_;
+      std::atomic<bool> pause_;
+      std::atomic<unsigned int> seeks_;
+
+      // Only touched by whoever is computing the window.
+      double time_;
+      double beat_;
+      double last_sync_beat_;
+      double current_bpm_;
+      double ramp_target_;
+      int ramp_remaining_;
+      int num_pending_;
+      TempoChange pending_[kMaxTempoChanges];
+  };
+} // namespace Helm
+
+#endif // HELM_TRANSPORT_H
@@ -0,0 +1,138 @@
+/* Copyright 2017 Matt Tytel */
+
+#include "realtime_check.h"
+
+#ifdef HELM_REALTIME_CHECK
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+#if defined(__linux__) || defined(__APPLE__)
+#include <execinfo.h>
+#include <unistd.h>
+#define HELM_BACKTRACE 1
+#endif
+
+#ifdef __GLIBC__
+extern "C" {
+  void* __libc_malloc(size_t size);
+  void* __libc_calloc(size_t count, size_t size);
+  void* __libc_realloc(void* pointer, size_t size);
+  void __libc_free(void* pointer);
+}
+#endif
+
+namespace {
+  const int MAX_STACK_FRAMES = 64;
+
+  thread_local int realtime_depth = 0;
+  thread_local bool reporting = false;
+  std::atomic<int> violations(0);
+
+  // Operators new and delete report themselves, so they skip the check in
+  // the allocator underneath.
+  void* allocate(size_t size) {
+#ifdef __GLIBC__
+    return __libc_malloc(size);
+#else
+    return malloc(size);
+#endif
+  }
+
+  void deallocate(void* pointer) {
+#ifdef __GLIBC__
+    __libc_free(pointer);
+#else
+    free(pointer);
+#endif
+  }
+} // namespace
+
+namespace Helm {
+
+  RealtimeScope::RealtimeScope() {
+    realtime_depth++;
+  }
+
+  RealtimeScope::~RealtimeScope() {
+    realtime_depth--;
+  }
+
+  void checkRealtime(const char* operation) {
+    if (realtime_depth == 0 || reporting)
+      return;
+
+    // Printing the report can allocate too, which isn't another violation.
+    reporting = true;
+    violations++;
+    fprintf(stderr, "Helm real-time violation: %s\n", operation);
+#ifdef HELM_BACKTRACE
+    void* frames[MAX_STACK_FRAMES];
+    int num_frames = backtrace(frames, MAX_STACK_FRAMES);
+    backtrace_symbols_fd(frames, num_frames, STDERR_FILENO);
+#endif
+    reporting = false;
+  }
+
+  int getRealtimeViolations() {
+    return violations;
+  }
+} // namespace Helm
+
+// glibc allows replacing the allocator itself, which also catches C code.
+#ifdef __GLIBC__
+extern "C" {
+  void* malloc(size_t size) {
+    Helm::checkRealtime("malloc");
+    return __libc_malloc(size);
+  }
+
+  void* calloc(size_t count, size_t size) {
+    Helm::checkRealtime("calloc");
+    return __libc_calloc(count, size);
+  }
+
+  void* realloc(void* pointer, size_t size) {
+    Helm::checkRealtime("realloc");
+    return __libc_realloc(pointer, size);
+  }
+
+  void free(void* pointer) {
+    if (pointer)
+      Helm::checkRealtime("free");
+    __libc_free(pointer);
+  }
+}
+#endif
+
+void* operator new(std::size_t size) {
+  Helm::checkRealtime("operator new");
+  void* pointer = allocate(size);
+  if (pointer == nullptr)
+    throw std::bad_alloc();
+  return pointer;
+}
+
+void* operator new[](std::size_t size) {
+  Helm::checkRealtime("operator new[]");
+  void* pointer = allocate(size);
+  if (pointer == nullptr)
+    throw std::bad_alloc();
+  return pointer;
+}
+
+void operator delete(void* pointer) noexcept {
+  if (pointer)
+    Helm::checkRealtime("operator delete");
+  deallocate(pointer);
+}
+
+void operator delete[](void* pointer) noexcept {
+  if (pointer)
+    Helm::checkRealtime("operator delete[]");
+  deallocate(pointer);
+}
+
+#endif // HELM_REALTIME_CHECK
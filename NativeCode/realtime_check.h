@@ -0,0 +1,32 @@
+/* Copyright 2017 Matt Tytel */
+
+#pragma once
+#ifndef REALTIME_CHECK_H
+#define REALTIME_CHECK_H
+
+namespace Helm {
+
+  // Debug builds made with HELM_REALTIME_CHECK defined report every memory
+  // allocation, free and mutex lock a thread makes while it's inside a
+  // RealtimeScope, with a stack trace on stderr. Otherwise this compiles
+  // away to nothing.
+  class RealtimeScope {
+    public:
+#ifdef HELM_REALTIME_CHECK
+      RealtimeScope();
+      ~RealtimeScope();
+#else
+      RealtimeScope() { }
+#endif
+  };
+
+#ifdef HELM_REALTIME_CHECK
+  // Reports a violation if the calling thread is inside a RealtimeScope.
+  void checkRealtime(const char* operation);
+
+  // Number of violations reported so far by every thread.
+  int getRealtimeViolations();
+#endif
+} // namespace Helm
+
+#endif // REALTIME_CHECK_H
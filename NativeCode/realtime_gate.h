@@ -0,0 +1,96 @@
+/* Copyright 2017 Matt Tytel */
+
+#pragma once
+#ifndef REALTIME_GATE_H
+#define REALTIME_GATE_H
+
+#include "AudioPluginUtil.h"
+
+#include <atomic>
+#include <thread>
+
+namespace Helm {
+
+  // Guards something the audio thread reads and other threads change, without
+  // the audio thread ever waiting. The audio thread tries to enter and skips
+  // its work when a writer has the gate closed. A writer closes it and waits
+  // for the audio threads already inside to leave, which takes at most a block.
+  class RealtimeGate {
+    public:
+      RealtimeGate() : closed_(0), readers_(0) { }
+
+      // Audio threads. Returns false while the gate is closed.
+      bool tryEnter() {
+        readers_++;
+        if (closed_.load() == 0)
+          return true;
+
+        readers_--;
+        return false;
+      }
+
+      void leave() {
+        readers_--;
+      }
+
+      // Writers, one at a time. A thread can close the gate more than once.
+      void close() {
+        closed_++;
+        while (readers_.load())
+          std::this_thread::yield();
+      }
+
+      void open() {
+        closed_--;
+      }
+
+    private:
+      // Both sides change their own count and then read the other's, and all
+      // of it is sequentially consistent, so they can't both get in.
+      std::atomic<int> closed_;
+      std::atomic<int> readers_;
+  };
+
+  // Keeps the audio thread out of what _gate_ guards for the scope. Writers
+  // hold _mutex_ so they go one at a time.
+  class GateScopeLock {
+    public:
+      GateScopeLock(AudioHelm::Mutex& mutex, RealtimeGate& gate, bool condition = true) :
+          mutex_(condition ? &mutex : nullptr), gate_(gate) {
+        if (mutex_) {
+          mutex_->Lock();
+          gate_.close();
+        }
+      }
+
+      ~GateScopeLock() {
+        if (mutex_) {
+          gate_.open();
+          mutex_->Unlock();
+        }
+      }
+
+    private:
+      AudioHelm::Mutex* mutex_;
+      RealtimeGate& gate_;
+  };
+
+  // Tries to enter _gate_ from the audio thread for the scope.
+  class GateScopeEnter {
+    public:
+      GateScopeEnter(RealtimeGate& gate) : gate_(gate), entered_(gate.tryEnter()) { }
+
+      ~GateScopeEnter() {
+        if (entered_)
+          gate_.leave();
+      }
+
+      bool entered() const { return entered_; }
+
+    private:
+      RealtimeGate& gate_;
+      bool entered_;
+  };
+} // namespace Helm
+
+#endif // REALTIME_GATE_H
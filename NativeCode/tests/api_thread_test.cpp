@@ -0,0 +1,143 @@
+/* Copyright 2017 Matt Tytel */
+
+// Loads patches, changes modulations, polyphony and voice threads, and edits
+// sequencer notes from a second thread while the audio thread plays. Fails if
+// the audio thread allocates, frees or takes a lock, or renders a sample that
+// isn't finite.
+
+#include "binary_patch.h"
+#include "helm_engine.h"
+#include "plugin_host.h"
+#include "preset_reader.h"
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <thread>
+
+using namespace Helm;
+
+namespace {
+  const char* PRESET_DIRECTORY = "../Assets/AudioHelm/Presets";
+  const int SAMPLE_RATE = 44100;
+  const int CHANNEL = 0;
+  const int BUFFER_SIZE = 256;
+  const int BLOCKS = 2000;
+  const int MIN_CHANGES = 64;
+  const int NUM_PATCHES = 16;
+  const int NUM_NOTES = 8;
+  const int MAX_VOICE_THREADS = 3;
+  const int LOWEST_NOTE = 48;
+  const float SEQUENCE_LENGTH = 16.0f;
+
+  // Parameters are registered after the plugin's own, in name order.
+  int parameterIndex(const std::string& name) {
+    int index = 1;
+    for (auto& parameter : mopo::Parameters::lookup_.getAllDetails()) {
+      if (parameter.first == name)
+        return index;
+      index++;
+    }
+    return -1;
+  }
+
+  void changeFromApiThread(const std::vector<std::vector<char>>* patches,
+                           HelmSequencer* sequencer, const std::atomic<bool>* done,
+                           std::atomic<int>* changes) {
+    int polyphony_index = parameterIndex("polyphony");
+    std::vector<HelmSequencer::Note*> notes;
+
+    for (int i = 0; !done->load(); ++i) {
+      const std::vector<char>& patch = (*patches)[i % patches->size()];
+      HelmLoadPatch(CHANNEL, patch.data(), patch.size());
+      HelmSetParameterValue(CHANNEL, polyphony_index, 1 + i % mopo::MAX_POLYPHONY);
+      if (i % 4 == 0)
+        HelmSetVoiceThreads(CHANNEL, 1 + (i / 4) % MAX_VOICE_THREADS);
+
+      HelmAddModulation(CHANNEL, 0, "mod_wheel", "cutoff", 0.5f);
+      for (int a = 1; a < 8; ++a)
+        HelmAddModulation(CHANNEL, 0, "mod_wheel", "cutoff", 0.5f / a);
+      if (i % 3 == 0)
+        HelmClearModulations(CHANNEL);
+
+      float start = i % static_cast<int>(SEQUENCE_LENGTH);
+      notes.push_back(CreateNote(sequencer, LOWEST_NOTE + i % NUM_NOTES, 1.0f, start, start + 1.0f));
+      if (notes.size() > NUM_NOTES) {
+        DeleteNote(sequencer, notes.front());
+        notes.erase(notes.begin());
+      }
+      changes->fetch_add(1);
+      // Leaves the audio thread time to play between changes.
+      std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+
+    for (HelmSequencer::Note* note : notes)
+      DeleteNote(sequencer, note);
+  }
+} // namespace
+
+int main() {
+  mopo::HelmEngine engine;
+  std::vector<std::vector<char>> patches;
+  for (const std::string& path : PresetReader::findPresets(PRESET_DIRECTORY)) {
+    std::string text;
+    PresetReader::Preset preset;
+    if (PresetReader::readFile(path, &text) && PresetReader::parse(text, &preset))
+      patches.push_back(PresetReader::toBinaryPatch(preset, &engine));
+    if (patches.size() >= NUM_PATCHES)
+      break;
+  }
+  if (patches.empty()) {
+    printf("FAIL no presets found in %s\n", PRESET_DIRECTORY);
+    return 1;
+  }
+
+  PluginHost host(SAMPLE_RATE, CHANNEL);
+  // Instances only take patches once they've rendered a block.
+  host.process(BUFFER_SIZE);
+
+  HelmSequencer* sequencer = CreateSequencer();
+  ChangeSequencerChannel(sequencer, CHANNEL);
+  sequencer->setLength(SEQUENCE_LENGTH);
+  EnableSequencer(sequencer, true);
+
+  std::atomic<bool> done(false);
+  std::atomic<int> changes(0);
+  std::thread api_thread(changeFromApiThread, &patches, sequencer, &done, &changes);
+
+  int violations = HelmGetRealtimeViolations();
+  bool finite = true;
+  // Plays until the API thread has made enough changes too, and gives it the
+  // processor between blocks the way a host's audio callback would.
+  for (int b = 0; b < BLOCKS || changes.load() < MIN_CHANGES; ++b) {
+    if (b % 8 == 0)
+      HelmNoteOn(CHANNEL, LOWEST_NOTE + (b / 8) % NUM_NOTES, 1.0f);
+    if (b % 8 == 4)
+      HelmNoteOff(CHANNEL, LOWEST_NOTE + (b / 8) % NUM_NOTES);
+
+    host.process(BUFFER_SIZE);
+    for (float sample : host.output())
+      finite = finite && std::isfinite(sample);
+    std::this_thread::yield();
+  }
+  violations = HelmGetRealtimeViolations() - violations;
+
+  done = true;
+  api_thread.join();
+  DeleteSequencer(sequencer);
+
+  int failures = 0;
+  if (violations) {
+    printf("FAIL the audio thread allocated or locked %d times\n", violations);
+    failures++;
+  }
+  if (!finite) {
+    printf("FAIL rendered samples that aren't finite\n");
+    failures++;
+  }
+
+  if (failures == 0)
+    printf("pass\n");
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,137 @@
+/* Copyright 2017 Matt Tytel */
+
+// Builds the same graphs of chained processors twice: once inside a
+// ProcessorArena and once on a heap that's been fragmented by allocations
+// made in between, the way a long running host's heap is. Prints how many
+// 4 KiB pages and 64 byte lines the processors, outputs and buffers are spread
+// over, and the best time of several runs to process every graph.
+
+#include "operators.h"
+#include "processor_router.h"
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <set>
+#include <vector>
+
+using namespace mopo;
+
+namespace {
+  const int NUM_GRAPHS = 16;
+  const int GRAPH_SIZE = 256;
+  const int ITERATIONS = 200;
+  const int RUNS = 9;
+  const size_t PAGE_SIZE = 4096;
+  const size_t LINE_SIZE = 64;
+  const size_t MAX_FILLER_SIZE = 4096;
+
+  typedef std::chrono::steady_clock Clock;
+
+  struct Graphs {
+    std::vector<ProcessorRouter*> routers;
+    std::vector<Processor*> processors;
+  };
+
+  // Each graph adds a constant to its input GRAPH_SIZE times over. Between
+  // processors, _filler_ allocates and keeps blocks of random sizes.
+  Graphs build(const Output* constant, std::vector<char*>* filler, std::mt19937* random) {
+    std::uniform_int_distribution<size_t> filler_size(1, MAX_FILLER_SIZE);
+    Graphs graphs;
+
+    for (int g = 0; g < NUM_GRAPHS; ++g) {
+      ProcessorRouter* router = new ProcessorRouter();
+      const Output* previous = constant;
+      for (int i = 0; i < GRAPH_SIZE; ++i) {
+        Add* add = new Add();
+        add->plug(previous, 0);
+        add->plug(constant, 1);
+        router->addProcessor(add);
+        graphs.processors.push_back(add);
+        previous = add->output();
+
+        if (filler)
+          filler->push_back(new char[filler_size(*random)]);
+      }
+      router->setBufferSize(MAX_BUFFER_SIZE);
+      graphs.routers.push_back(router);
+    }
+    return graphs;
+  }
+
+  void destroy(Graphs* graphs) {
+    for (ProcessorRouter* router : graphs->routers)
+      delete router;
+  }
+
+  void countFootprint(const Graphs& graphs, size_t* pages, size_t* lines) {
+    std::set<size_t> page_set;
+    std::set<size_t> line_set;
+    auto add = [&](const void* start, size_t size) {
+      size_t address = reinterpret_cast<size_t>(start);
+      for (size_t a = address; a < address + size; a += LINE_SIZE / 2) {
+        page_set.insert(a / PAGE_SIZE);
+        line_set.insert(a / LINE_SIZE);
+      }
+    };
+
+    for (const Processor* processor : graphs.processors) {
+      add(processor, sizeof(Add));
+      const Output* output = processor->output();
+      add(output, sizeof(Output));
+      add(output->buffer, output->buffer_size * sizeof(mopo_float));
+    }
+    *pages = page_set.size();
+    *lines = line_set.size();
+  }
+
+  double bestMicroseconds(const Graphs& graphs) {
+    double best = 0.0;
+    for (int r = 0; r < RUNS; ++r) {
+      auto start = Clock::now();
+      for (int i = 0; i < ITERATIONS; ++i) {
+        for (ProcessorRouter* router : graphs.routers)
+          router->process();
+      }
+      auto end = Clock::now();
+      double time = std::chrono::duration<double, std::micro>(end - start).count() / ITERATIONS;
+      if (r == 0 || time < best)
+        best = time;
+    }
+    return best;
+  }
+
+  void report(const char* name, const Graphs& graphs) {
+    size_t pages = 0;
+    size_t lines = 0;
+    countFootprint(graphs, &pages, &lines);
+    printf("%-16s %8d pages %8d lines %10.2f us per block\n", name,
+           static_cast<int>(pages), static_cast<int>(lines), bestMicroseconds(graphs));
+  }
+} // namespace
+
+int main() {
+  Value constant(0.5);
+  constant.setBufferSize(MAX_BUFFER_SIZE);
+  constant.process();
+
+  std::mt19937 random(1);
+  std::vector<char*> filler;
+  Graphs heap = build(constant.output(), &filler, &random);
+
+  Graphs arena;
+  {
+    ProcessorArena processor_arena;
+    arena = build(constant.output(), nullptr, &random);
+  }
+
+  printf("%d graphs of %d processors\n", NUM_GRAPHS, GRAPH_SIZE);
+  report("fragmented heap", heap);
+  report("arena", arena);
+
+  destroy(&heap);
+  destroy(&arena);
+  for (char* block : filler)
+    delete[] block;
+  return 0;
+}
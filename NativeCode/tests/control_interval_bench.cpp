@@ -0,0 +1,82 @@
+/* Copyright 2017 Matt Tytel */
+
+// Times a plugin instance rendering a held chord in large Unity blocks at
+// each control tick interval, and prints the CPU per second of audio and the
+// cost over ticking once per MAX_BUFFER_SIZE samples.
+
+#include "helm_engine.h"
+#include "plugin_host.h"
+
+#include <chrono>
+#include <cstdio>
+
+using namespace Helm;
+
+namespace {
+  const int SAMPLE_RATE = 44100;
+  const int CHANNEL = 0;
+  const int BUFFER_SIZE = 1024;
+  const int BLOCKS = 400;
+  const int RELEASE_BLOCKS = 8;
+  const int RUNS = 3;
+  const int NUM_NOTES = 8;
+  const int LOWEST_NOTE = 48;
+  const int INTERVALS[] = { 8, 16, 32, 64, 128, mopo::MAX_BUFFER_SIZE };
+
+  typedef std::chrono::steady_clock Clock;
+
+  // Parameters are registered after the plugin's own, in name order.
+  int parameterIndex(const std::string& name) {
+    int index = 1;
+    for (auto& parameter : mopo::Parameters::lookup_.getAllDetails()) {
+      if (parameter.first == name)
+        return index;
+      index++;
+    }
+    return -1;
+  }
+
+  // Renders the chord from silence and returns the milliseconds it took.
+  double renderChord(PluginHost* host) {
+    HelmAllNotesOff(CHANNEL);
+    for (int i = 0; i < RELEASE_BLOCKS; ++i)
+      host->process(BUFFER_SIZE);
+    for (int n = 0; n < NUM_NOTES; ++n)
+      HelmNoteOn(CHANNEL, LOWEST_NOTE + 2 * n, 0.8f);
+
+    auto start = Clock::now();
+    for (int i = 0; i < BLOCKS; ++i)
+      host->process(BUFFER_SIZE);
+    auto end = Clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+  }
+} // namespace
+
+int main() {
+  PluginHost host(SAMPLE_RATE, CHANNEL);
+  host.process(BUFFER_SIZE);
+  HelmSetParameterValue(CHANNEL, parameterIndex("polyphony"), NUM_NOTES);
+  host.process(BUFFER_SIZE);
+
+  double audio_seconds = (1.0 * BLOCKS * BUFFER_SIZE) / SAMPLE_RATE;
+  printf("%d held voices, %d blocks of %d samples, %.1f s of audio\n",
+         NUM_NOTES, BLOCKS, BUFFER_SIZE, audio_seconds);
+
+  const int num_intervals = sizeof(INTERVALS) / sizeof(INTERVALS[0]);
+  double times[num_intervals];
+  for (int i = 0; i < num_intervals; ++i) {
+    HelmSetControlInterval(CHANNEL, INTERVALS[i]);
+    for (int r = 0; r < RUNS; ++r) {
+      double time = renderChord(&host);
+      if (r == 0 || time < times[i])
+        times[i] = time;
+    }
+  }
+
+  double coarsest = times[num_intervals - 1];
+  for (int i = 0; i < num_intervals; ++i) {
+    printf("interval %3d %8.1f ms, %5.1f ms per second of audio (%5.2fx)\n",
+           INTERVALS[i], times[i], times[i] / audio_seconds, times[i] / coarsest);
+  }
+  return 0;
+}
@@ -0,0 +1,142 @@
+/* Copyright 2017 Matt Tytel */
+
+// Times a chord of held voices with a static patch and with modulations
+// connected, and prints the CPU per held voice. Then times running only the
+// voice graph's control rate processors once per voice, which is the most
+// that skipping unchanged control rate work could save, and only reading
+// every input of those processors, which is the least a check for changed
+// inputs has to do.
+
+#include "helm_engine.h"
+#include "helm_voice_handler.h"
+
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+using namespace mopo;
+
+namespace {
+  const int SAMPLE_RATE = 44100;
+  const int NUM_NOTES = 8;
+  const int LOWEST_NOTE = 48;
+  const int BLOCKS = 256;
+  const int RUNS = 9;
+
+  const char* MODULATIONS[][2] = {
+    { "poly_lfo", "cutoff" },
+    { "mod_envelope", "osc_1_transpose" },
+    { "aftertouch", "resonance" },
+    { "poly_lfo", "osc_2_tune" },
+  };
+
+  typedef std::chrono::steady_clock Clock;
+
+  template<typename Work>
+  double bestMicroseconds(Work work) {
+    double best = 0.0;
+    for (int r = 0; r < RUNS; ++r) {
+      auto start = Clock::now();
+      for (int i = 0; i < BLOCKS; ++i)
+        work();
+      auto end = Clock::now();
+      double time = std::chrono::duration<double, std::micro>(end - start).count() / BLOCKS;
+      if (r == 0 || time < best)
+        best = time;
+    }
+    return best;
+  }
+
+  // Microseconds per held voice per block.
+  double timeHeldVoices(HelmEngine* engine) {
+    for (int n = 0; n < NUM_NOTES; ++n)
+      engine->noteOn(LOWEST_NOTE + 2 * n, 0.8);
+    for (int i = 0; i < BLOCKS; ++i)
+      engine->process();
+
+    double time = bestMicroseconds([=]() { engine->process(); });
+    engine->allNotesOff();
+    return time / NUM_NOTES;
+  }
+
+  struct ControlRateTimes {
+    int num_processors;
+    double process;
+    double check;
+  };
+
+  // Microseconds to run a voice's control rate processors once, and to read
+  // each of their inputs once.
+  ControlRateTimes timeControlRate(HelmEngine* engine) {
+    HelmVoiceHandler* voice_handler = const_cast<HelmVoiceHandler*>(engine->getVoiceHandler());
+    std::vector<std::pair<const Processor*, Processor*>> copies;
+    voice_handler->getPolyRouter()->getProcessorCopies(&copies);
+
+    std::vector<Processor*> control_rate;
+    for (auto& copy : copies) {
+      Processor* processor = copy.second;
+      if (processor->isControlRate() && !dynamic_cast<ProcessorRouter*>(processor))
+        control_rate.push_back(processor);
+    }
+
+    ControlRateTimes times;
+    times.num_processors = control_rate.size();
+    times.process = bestMicroseconds([&]() {
+      for (Processor* processor : control_rate)
+        processor->process();
+    });
+
+    volatile mopo_float sink = 0.0;
+    times.check = bestMicroseconds([&]() {
+      mopo_float sum = 0.0;
+      for (Processor* processor : control_rate) {
+        for (int i = 0; i < processor->numInputs(); ++i)
+          sum += processor->input(i)->at(0);
+      }
+      sink = sum;
+    });
+    return times;
+  }
+
+  void printTimes(const char* name, double voice, const ControlRateTimes& times) {
+    printf("%-10s %6.2f us per voice, %3d control rate processors: "
+           "running %5.2f us (%4.1f%%), reading inputs %5.2f us (%4.1f%%)\n",
+           name, voice, times.num_processors,
+           times.process, 100.0 * times.process / voice,
+           times.check, 100.0 * times.check / voice);
+  }
+
+  void setUp(HelmEngine* engine) {
+    engine->setSampleRate(SAMPLE_RATE);
+    engine->setBufferSize(MAX_BUFFER_SIZE);
+    engine->getControls()["polyphony"]->set(NUM_NOTES);
+    engine->prepareVoices();
+  }
+} // namespace
+
+int main() {
+  HelmEngine static_engine;
+  setUp(&static_engine);
+  double static_voice = timeHeldVoices(&static_engine);
+
+  HelmEngine modulated_engine;
+  std::vector<ModulationConnection*> connections;
+  for (auto& modulation : MODULATIONS) {
+    ModulationConnection* connection = new ModulationConnection(modulation[0], modulation[1]);
+    connection->amount.set(0.5);
+    modulated_engine.connectModulation(connection);
+    connections.push_back(connection);
+  }
+  setUp(&modulated_engine);
+  double modulated_voice = timeHeldVoices(&modulated_engine);
+
+  printf("%d held voices, %d samples per block\n", NUM_NOTES, MAX_BUFFER_SIZE);
+  printTimes("static", static_voice, timeControlRate(&static_engine));
+  printTimes("modulated", modulated_voice, timeControlRate(&modulated_engine));
+
+  for (ModulationConnection* connection : connections) {
+    modulated_engine.disconnectModulation(connection);
+    delete connection;
+  }
+  return 0;
+}
@@ -0,0 +1,176 @@
+/* Copyright 2017 Matt Tytel */
+
+// Prints how far the distortion kernels are from their references for each
+// instruction set the CPU supports, and times Distortion::process for every
+// distortion type with each set. tanh is checked against std::tanh, the folds
+// against the same folds computed with floor and std::sin in long double.
+// tests/vector_math_test.cpp checks the sets give the same bits.
+
+#include "distortion.h"
+#include "utils.h"
+#include "value.h"
+#include "vector_math.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+using namespace mopo;
+
+namespace {
+  const char* INSTRUCTION_SET_NAMES[vector_math::kNumInstructionSets] = {
+    "scalar", "sse2", "avx2", "neon"
+  };
+  const char* TYPE_NAMES[Distortion::kNumTypes] = {
+    "soft clip", "hard clip", "linear fold", "sine fold"
+  };
+
+  const int SIZE = MAX_BUFFER_SIZE;
+  const int ACCURACY_BLOCKS = 4000;
+  const int ITERATIONS = 20000;
+  const int RUNS = 9;
+  const mopo_float DRIVE = 4.0;
+  const mopo_float MIX = 0.8;
+
+  typedef std::chrono::steady_clock Clock;
+
+  enum Kernel {
+    kTanh,
+    kLinearFold,
+    kSinFold,
+    kNumKernels
+  };
+
+  struct Check {
+    const char* name;
+    Kernel kernel;
+    mopo_float range;
+  };
+
+  const Check CHECKS[] = {
+    { "tanh |x| <= 3", kTanh, 3.0 },
+    { "tanh |x| <= 20", kTanh, 20.0 },
+    { "linearFold |x| <= 20", kLinearFold, 20.0 },
+    { "sinFold |x| <= 20", kSinFold, 20.0 },
+  };
+
+  long double reference(Kernel kernel, mopo_float value) {
+    long double x = value;
+    if (kernel == kTanh)
+      return std::tanh(x);
+
+    if (kernel == kLinearFold) {
+      long double adjust = 0.25L * x + 0.75L;
+      long double range = adjust - std::floor(adjust);
+      return std::fabs(2.0L - 4.0L * range) - 1.0L;
+    }
+
+    long double adjust = -0.25L * x + 0.5L;
+    long double range = adjust - std::floor(adjust);
+    return std::sin(2.0L * 3.14159265358979323846L * (0.5L - range));
+  }
+
+  void run(Kernel kernel, mopo_float* dest, const mopo_float* source) {
+    switch (kernel) {
+      case kTanh: vector_math::tanh(dest, source, SIZE); break;
+      case kLinearFold: vector_math::linearFold(dest, source, SIZE); break;
+      case kSinFold: vector_math::sinFold(dest, source, SIZE); break;
+      default: break;
+    }
+  }
+
+  // Largest error over ACCURACY_BLOCKS random blocks.
+  double maxError(const Check& check) {
+    std::mt19937 random_generator(17);
+    std::uniform_real_distribution<mopo_float> distribution(-check.range, check.range);
+
+    mopo_float source[SIZE];
+    mopo_float dest[SIZE];
+    double max_error = 0.0;
+    for (int b = 0; b < ACCURACY_BLOCKS; ++b) {
+      for (int i = 0; i < SIZE; ++i)
+        source[i] = distribution(random_generator);
+
+      run(check.kernel, dest, source);
+
+      for (int i = 0; i < SIZE; ++i) {
+        double error = std::fabs(static_cast<long double>(dest[i]) -
+                                 reference(check.kernel, source[i]));
+        max_error = std::max(max_error, error);
+      }
+    }
+    return max_error;
+  }
+
+  double processNanoseconds(Distortion::Type type) {
+    Value on(1.0);
+    Value type_value(type);
+    Value drive(DRIVE);
+    Value mix(MIX);
+    Output audio;
+    for (int i = 0; i < SIZE; ++i)
+      audio.buffer[i] = sin(i * 0.05);
+
+    Distortion distortion;
+    distortion.plug(&audio, Distortion::kAudio);
+    distortion.plug(&on, Distortion::kOn);
+    distortion.plug(&type_value, Distortion::kType);
+    distortion.plug(&drive, Distortion::kDrive);
+    distortion.plug(&mix, Distortion::kMix);
+    distortion.setBufferSize(SIZE);
+
+    double best = 0.0;
+    for (int r = 0; r < RUNS; ++r) {
+      auto start = Clock::now();
+      for (int i = 0; i < ITERATIONS; ++i)
+        distortion.process();
+      auto end = Clock::now();
+
+      double time = std::chrono::duration<double, std::nano>(end - start).count();
+      time /= 1.0 * ITERATIONS * SIZE;
+      if (r == 0 || time < best)
+        best = time;
+    }
+    return best;
+  }
+
+  void printHeader(const char* title) {
+    printf("%-24s", title);
+    for (int i = 0; i < vector_math::kNumInstructionSets; ++i) {
+      if (vector_math::supportsInstructionSet(static_cast<vector_math::InstructionSet>(i)))
+        printf("%12s", INSTRUCTION_SET_NAMES[i]);
+    }
+    printf("\n");
+  }
+} // namespace
+
+int main() {
+  vector_math::InstructionSet best_set = vector_math::instructionSet();
+
+  printHeader("max error");
+  for (const Check& check : CHECKS) {
+    printf("%-24s", check.name);
+    for (int i = 0; i < vector_math::kNumInstructionSets; ++i) {
+      if (vector_math::setInstructionSet(static_cast<vector_math::InstructionSet>(i)))
+        printf("%12.2e", maxError(check));
+    }
+    printf("\n");
+  }
+
+  printf("\n");
+  printHeader("ns/sample");
+  for (int type = 0; type < Distortion::kNumTypes; ++type) {
+    printf("%-24s", TYPE_NAMES[type]);
+    for (int i = 0; i < vector_math::kNumInstructionSets; ++i) {
+      if (!vector_math::setInstructionSet(static_cast<vector_math::InstructionSet>(i)))
+        continue;
+      printf("%12.3f", processNanoseconds(static_cast<Distortion::Type>(type)));
+    }
+    printf("\n");
+  }
+
+  vector_math::setInstructionSet(best_set);
+  return 0;
+}
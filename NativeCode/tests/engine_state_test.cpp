@@ -0,0 +1,79 @@
+/* Copyright 2017 Matt Tytel */
+
+// Checks HelmEngine::saveState and loadState: rendering after a restore
+// matches rendering after the save, a state still loads after a modulation
+// is added and removed again, and a graph with an extra modulation refuses it.
+
+#include "helm_common.h"
+#include "helm_engine.h"
+
+#include <cstdio>
+#include <vector>
+
+using namespace mopo;
+
+namespace {
+  const int SAMPLE_RATE = 44100;
+  const int BLOCKS = 64;
+
+  std::vector<mopo_float> render(HelmEngine* engine) {
+    std::vector<mopo_float> rendered;
+    for (int i = 0; i < BLOCKS; ++i) {
+      engine->process();
+      const mopo_float* left = engine->output(0)->buffer;
+      rendered.insert(rendered.end(), left, left + engine->getBufferSize());
+    }
+    return rendered;
+  }
+
+  std::vector<char> save(HelmEngine* engine) {
+    std::vector<char> state(engine->saveState(nullptr, 0));
+    engine->saveState(state.data(), state.size());
+    return state;
+  }
+} // namespace
+
+int main() {
+  HelmEngine engine;
+  engine.setSampleRate(SAMPLE_RATE);
+  engine.setBufferSize(MAX_BUFFER_SIZE);
+  engine.getControls()["delay_on"]->set(1.0);
+  engine.getControls()["stutter_on"]->set(1.0);
+
+  engine.noteOn(48.0);
+  engine.noteOn(55.0);
+  render(&engine);
+
+  std::vector<char> state = save(&engine);
+  std::vector<mopo_float> expected = render(&engine);
+  int failures = 0;
+
+  if (!engine.loadState(state.data(), state.size()) || render(&engine) != expected) {
+    printf("FAIL rendering after a restore differed from rendering after the save\n");
+    failures++;
+  }
+
+  ModulationConnection connection("mod_wheel", "cutoff");
+  engine.connectModulation(&connection);
+  engine.prepareVoices();
+  if (engine.loadState(state.data(), state.size())) {
+    printf("FAIL a state loaded into a graph with an extra modulation\n");
+    failures++;
+  }
+
+  engine.disconnectModulation(&connection);
+  engine.prepareVoices();
+  if (!engine.loadState(state.data(), state.size()) || render(&engine) != expected) {
+    printf("FAIL a state didn't restore after a modulation was added and removed\n");
+    failures++;
+  }
+
+  if (engine.loadState(state.data(), state.size() / 2)) {
+    printf("FAIL a truncated state loaded\n");
+    failures++;
+  }
+
+  if (failures == 0)
+    printf("pass\n");
+  return failures ? 1 : 0;
+}
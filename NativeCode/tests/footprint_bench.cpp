@@ -0,0 +1,91 @@
+/* Copyright 2017 Matt Tytel */
+
+// Creates plugin instances with the pool empty and prints the time and
+// resident memory each one costs, then how much more memory they take once
+// they've played a stuttering chord. Build with -DHELM_HEADLESS to measure
+// the headless plugin's lazily backed voice memory.
+
+#include "helm_engine.h"
+#include "plugin_host.h"
+
+#include <chrono>
+#include <cstdio>
+#include <sys/resource.h>
+
+using namespace Helm;
+
+namespace {
+  const int SAMPLE_RATE = 44100;
+  const int CHANNEL = 0;
+  const int BUFFER_SIZE = 512;
+  const int NUM_INSTANCES = 8;
+  const int PLAY_BLOCKS = 64;
+  const int NUM_NOTES = 4;
+  const int LOWEST_NOTE = 48;
+
+  typedef std::chrono::steady_clock Clock;
+
+  // Parameters are registered after the plugin's own, in name order.
+  int parameterIndex(const std::string& name) {
+    int index = 1;
+    for (auto& parameter : mopo::Parameters::lookup_.getAllDetails()) {
+      if (parameter.first == name)
+        return index;
+      index++;
+    }
+    return -1;
+  }
+
+  // The instances are never freed while measuring, so the peak resident size
+  // is the current one.
+  double residentMegabytes() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    return usage.ru_maxrss / (1024.0 * 1024.0);
+#else
+    return usage.ru_maxrss / 1024.0;
+#endif
+  }
+} // namespace
+
+int main() {
+  // An empty pool that won't keep released instances.
+  HelmReleasePrewarmedInstances();
+
+#ifdef HELM_HEADLESS
+  printf("headless build, %d instances\n", NUM_INSTANCES);
+#else
+  printf("plugin build, %d instances\n", NUM_INSTANCES);
+#endif
+
+  double start_memory = residentMegabytes();
+  auto start = Clock::now();
+  PluginHost* hosts[NUM_INSTANCES];
+  for (int i = 0; i < NUM_INSTANCES; ++i)
+    hosts[i] = new PluginHost(SAMPLE_RATE, CHANNEL + i);
+  double create_time = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+  double created_memory = residentMegabytes();
+
+  // Each instance plays on its own channel so notes reach only it.
+  int stutter_index = parameterIndex("stutter_on");
+  for (int i = 0; i < NUM_INSTANCES; ++i) {
+    hosts[i]->process(BUFFER_SIZE);
+    HelmSetParameterValue(CHANNEL + i, stutter_index, 1.0f);
+    for (int n = 0; n < NUM_NOTES; ++n)
+      HelmNoteOn(CHANNEL + i, LOWEST_NOTE + 4 * n, 0.8f);
+    for (int b = 0; b < PLAY_BLOCKS; ++b)
+      hosts[i]->process(BUFFER_SIZE);
+  }
+  double played_memory = residentMegabytes();
+
+  printf("create          %8.2f ms per instance\n", create_time / NUM_INSTANCES);
+  printf("resident        %8.2f MB per instance\n",
+         (created_memory - start_memory) / NUM_INSTANCES);
+  printf("after stutter   %8.2f MB more per instance\n",
+         (played_memory - created_memory) / NUM_INSTANCES);
+
+  for (int i = 0; i < NUM_INSTANCES; ++i)
+    delete hosts[i];
+  return 0;
+}
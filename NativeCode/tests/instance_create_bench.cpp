@@ -0,0 +1,84 @@
+/* Copyright 2017 Matt Tytel */
+
+// Times creating an instance three ways: building a new engine with the pool
+// empty, taking one HelmPrewarmInstances made, and taking one an earlier
+// instance released after playing. Also times the release that resets an
+// instance for the pool. Prints the best of several runs of each.
+
+#include "plugin_host.h"
+
+#include <chrono>
+#include <cstdio>
+
+using namespace Helm;
+
+namespace {
+  const int SAMPLE_RATE = 44100;
+  const int CHANNEL = 0;
+  const int BUFFER_SIZE = 512;
+  const int PLAY_BLOCKS = 16;
+  const int RUNS = 9;
+
+  typedef std::chrono::steady_clock Clock;
+
+  double microsecondsSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+  }
+
+  // Best time of _create_ after running _setup_ before each run.
+  template<typename Setup>
+  double bestCreateMicroseconds(Setup setup) {
+    double best = 0.0;
+    for (int r = 0; r < RUNS; ++r) {
+      setup();
+      auto start = Clock::now();
+      PluginHost* host = new PluginHost(SAMPLE_RATE, CHANNEL);
+      double time = microsecondsSince(start);
+      delete host;
+
+      if (r == 0 || time < best)
+        best = time;
+    }
+    return best;
+  }
+
+  void playAndRelease(PluginHost* host) {
+    host->process(BUFFER_SIZE);
+    HelmNoteOn(CHANNEL, 60, 1.0f);
+    HelmNoteOn(CHANNEL, 64, 1.0f);
+    for (int i = 0; i < PLAY_BLOCKS; ++i)
+      host->process(BUFFER_SIZE);
+  }
+} // namespace
+
+int main() {
+  double cold = bestCreateMicroseconds([]() {
+    // An empty pool that won't take released instances back either.
+    HelmReleasePrewarmedInstances();
+  });
+
+  double prewarmed = bestCreateMicroseconds([]() {
+    HelmReleasePrewarmedInstances();
+    HelmPrewarmInstances(1, SAMPLE_RATE);
+  });
+
+  // Each run's instance goes back in the pool for the next.
+  double release = 0.0;
+  double recycled = bestCreateMicroseconds([&]() {
+    PluginHost* host = new PluginHost(SAMPLE_RATE, CHANNEL);
+    playAndRelease(host);
+
+    auto start = Clock::now();
+    delete host;
+    double time = microsecondsSince(start);
+    if (release == 0.0 || time < release)
+      release = time;
+  });
+  HelmReleasePrewarmedInstances();
+
+  printf("create, empty pool     %10.1f us\n", cold);
+  printf("create, prewarmed      %10.1f us\n", prewarmed);
+  printf("create, recycled       %10.1f us\n", recycled);
+  printf("release into the pool  %10.1f us\n", release);
+  return 0;
+}
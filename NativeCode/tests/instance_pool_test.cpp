@@ -0,0 +1,98 @@
+/* Copyright 2017 Matt Tytel */
+
+// Checks that a released instance goes back in the pool and that the next
+// instance handed the same engine sounds exactly like a new one, even after
+// the old instance loaded a modulated patch and played it.
+
+#include "binary_patch.h"
+#include "helm_engine.h"
+#include "plugin_host.h"
+#include "preset_reader.h"
+
+#include <cstdio>
+
+using namespace Helm;
+
+namespace {
+  const char* PRESET_DIRECTORY = "../Assets/AudioHelm/Presets";
+  const int SAMPLE_RATE = 44100;
+  const int CHANNEL = 0;
+  const int BUFFER_SIZE = 512;
+  const int NOTE = 60;
+  const int HELD_BLOCKS = 24;
+  const int RELEASE_BLOCKS = 24;
+
+  std::vector<float> playNote(PluginHost* host) {
+    std::vector<float> rendered;
+    HelmNoteOn(CHANNEL, NOTE, 1.0f);
+    for (int i = 0; i < HELD_BLOCKS + RELEASE_BLOCKS; ++i) {
+      if (i == HELD_BLOCKS)
+        HelmNoteOff(CHANNEL, NOTE);
+      host->process(BUFFER_SIZE);
+      rendered.insert(rendered.end(), host->output().begin(), host->output().end());
+    }
+    return rendered;
+  }
+
+  // The first preset with modulations, so releasing has routing to undo.
+  bool findModulatedPatch(const mopo::HelmEngine* engine, std::vector<char>* patch) {
+    for (const std::string& path : PresetReader::findPresets(PRESET_DIRECTORY)) {
+      std::string text;
+      PresetReader::Preset preset;
+      if (PresetReader::readFile(path, &text) && PresetReader::parse(text, &preset) &&
+          preset.modulations.size() > 1) {
+        *patch = PresetReader::toBinaryPatch(preset, engine);
+        return true;
+      }
+    }
+    return false;
+  }
+} // namespace
+
+int main() {
+  mopo::HelmEngine engine;
+  std::vector<char> patch;
+  if (!findModulatedPatch(&engine, &patch)) {
+    printf("FAIL no modulated preset found in %s\n", PRESET_DIRECTORY);
+    return 1;
+  }
+
+  PluginHost* host = new PluginHost(SAMPLE_RATE, CHANNEL);
+  host->process(BUFFER_SIZE);
+  std::vector<float> expected = playNote(host);
+
+  const void* effect_data = host->effectData();
+  if (!HelmLoadPatch(CHANNEL, patch.data(), patch.size())) {
+    printf("FAIL couldn't load the modulated patch\n");
+    return 1;
+  }
+  playNote(host);
+  HelmNoteOn(CHANNEL, NOTE + 7, 1.0f);
+  host->process(BUFFER_SIZE);
+  delete host;
+
+  host = new PluginHost(SAMPLE_RATE, CHANNEL);
+  if (host->effectData() != effect_data) {
+    printf("FAIL the released instance wasn't reused\n");
+    return 1;
+  }
+
+  host->process(BUFFER_SIZE);
+  std::vector<float> recycled = playNote(host);
+  delete host;
+
+  int mismatches = 0;
+  for (size_t i = 0; i < expected.size(); ++i) {
+    if (expected[i] != recycled[i])
+      mismatches++;
+  }
+  if (mismatches) {
+    printf("FAIL a reused instance differed from a new one in %d of %d samples\n",
+           mismatches, static_cast<int>(expected.size()));
+    return 1;
+  }
+
+  HelmReleasePrewarmedInstances();
+  printf("pass\n");
+  return 0;
+}
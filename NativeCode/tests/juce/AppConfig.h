@@ -0,0 +1,19 @@
+/* Copyright 2017 Matt Tytel */
+
+// JUCE settings for tests and benchmarks of the helm code that only needs
+// the core, events and audio basics modules, built without the plugin's
+// JuceLibraryCode.
+
+#pragma once
+#ifndef APP_CONFIG_H
+#define APP_CONFIG_H
+
+#define JUCE_MODULE_AVAILABLE_juce_audio_basics 1
+#define JUCE_MODULE_AVAILABLE_juce_core 1
+#define JUCE_MODULE_AVAILABLE_juce_events 1
+#define JUCE_GLOBAL_MODULE_SETTINGS_INCLUDED 1
+#define JUCE_STANDALONE_APPLICATION 1
+#define JUCE_DONT_DECLARE_PROJECTINFO 1
+#define JUCE_USE_CURL 0
+
+#endif // APP_CONFIG_H
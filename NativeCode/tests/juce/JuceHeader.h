@@ -0,0 +1,15 @@
+/* Copyright 2017 Matt Tytel */
+
+#pragma once
+#ifndef JUCE_HEADER_H
+#define JUCE_HEADER_H
+
+#include "AppConfig.h"
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <juce_core/juce_core.h>
+#include <juce_events/juce_events.h>
+
+using namespace juce;
+
+#endif // JUCE_HEADER_H
@@ -0,0 +1,4 @@
+/* Copyright 2017 Matt Tytel */
+
+#include "AppConfig.h"
+#include <juce_audio_basics/juce_audio_basics.cpp>
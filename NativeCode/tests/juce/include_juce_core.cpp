@@ -0,0 +1,4 @@
+/* Copyright 2017 Matt Tytel */
+
+#include "AppConfig.h"
+#include <juce_core/juce_core.cpp>
@@ -0,0 +1,203 @@
+/* Copyright 2017 Matt Tytel */
+
+// Times the plugin's MIDI handling for one host block of dense MIDI, the way
+// HelmPlugin::processBlock did it before it read the block through a
+// SynthBase::MidiCursor and the way it does now. Both paths run the on screen
+// keyboard state and dispatch to a counter instead of the engine, so only
+// the MIDI handling is timed. Prints the sub-blocks each path renders in and
+// fails if they dispatch a different number of events.
+
+#include "JuceHeader.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+namespace {
+  const int MAX_BUFFER_PROCESS = 256;
+  const int REPEATS = 200;
+  const int RUNS = 7;
+  const int LOWEST_NOTE = 36;
+  const int NOTE_RANGE = 48;
+
+  typedef std::chrono::steady_clock Clock;
+
+  struct Case {
+    const char* name;
+    int samples;
+    int num_note_events;
+    int controller_interval;
+  };
+
+  const Case CASES[] = {
+    { "512 samples, 64 note events", 512, 64, 0 },
+    { "4096 samples, 1024 note events", 4096, 1024, 0 },
+    { "4096 samples, CC every 32", 4096, 0, 32 },
+    { "4096 samples, CC every 4", 4096, 0, 4 },
+    { "8192 samples, 4096 notes + CC every 16", 8192, 4096, 16 },
+  };
+
+  // Stands in for the MidiManager and the engine.
+  struct Dispatch {
+    Dispatch() : events(0), offsets(0), sub_blocks(0) { }
+
+    void processMidiMessage(const MidiMessage& message, int sample) {
+      events++;
+      offsets += sample + message.getRawDataSize();
+    }
+
+    void render(int samples) {
+      sub_blocks++;
+      offsets += samples;
+    }
+
+    int events;
+    long long offsets;
+    int sub_blocks;
+  };
+
+  // A copy of SynthBase::MidiCursor, which needs the plugin's JuceHeader.
+  struct MidiCursor {
+    MidiCursor(const MidiBuffer& buffer) : iterator(buffer) { next(); }
+
+    void next() { has_event = iterator.getNextEvent(message, sample); }
+
+    MidiBuffer::Iterator iterator;
+    MidiMessage message;
+    int sample;
+    bool has_event;
+  };
+
+  void processMidi(const MidiBuffer& buffer, Dispatch* dispatch) {
+    MidiBuffer::Iterator iterator(buffer);
+    MidiMessage message;
+    int sample = 0;
+    while (iterator.getNextEvent(message, sample))
+      dispatch->processMidiMessage(message, sample);
+  }
+
+  // processBlock before the cursor: copies the block for the keyboard, then
+  // scans the whole block for every sub-block.
+  void scanningBlock(MidiBuffer& midi_messages, int total_samples,
+                     MidiKeyboardState* keyboard_state, Dispatch* dispatch) {
+    MidiBuffer keyboard_copy = midi_messages;
+    MidiBuffer keyboard_messages;
+    keyboard_state->processNextMidiBuffer(keyboard_messages, 0, total_samples, true);
+    keyboard_state->processNextMidiBuffer(keyboard_copy, 0, total_samples, true);
+    processMidi(keyboard_messages, dispatch);
+
+    for (int sample_offset = 0; sample_offset < total_samples;) {
+      int num_samples = std::min<int>(total_samples - sample_offset, MAX_BUFFER_PROCESS);
+      int end_sample = sample_offset + num_samples;
+
+      MidiBuffer::Iterator iterator(midi_messages);
+      MidiMessage message;
+      int sample = 0;
+      while (iterator.getNextEvent(message, sample)) {
+        if (sample >= sample_offset && sample < end_sample)
+          dispatch->processMidiMessage(message, sample - sample_offset);
+      }
+      dispatch->render(num_samples);
+      sample_offset += num_samples;
+    }
+  }
+
+  // processBlock now: SynthBase::processKeyboardEvents and
+  // SynthBase::processMidi(MidiCursor&, int, int).
+  void cursorBlock(MidiBuffer& midi_messages, int total_samples,
+                   MidiKeyboardState* keyboard_state, MidiBuffer* keyboard_messages,
+                   Dispatch* dispatch) {
+    keyboard_messages->clear();
+    keyboard_state->processNextMidiBuffer(*keyboard_messages, 0, total_samples, true);
+    keyboard_state->processNextMidiBuffer(midi_messages, 0, total_samples, false);
+    processMidi(*keyboard_messages, dispatch);
+
+    MidiCursor cursor(midi_messages);
+    for (int sample_offset = 0; sample_offset < total_samples;) {
+      int end_sample = std::min<int>(total_samples, sample_offset + MAX_BUFFER_PROCESS);
+      for (; cursor.has_event && cursor.sample < end_sample; cursor.next()) {
+        const MidiMessage& message = cursor.message;
+        bool control = message.isController() || message.isPitchWheel();
+        if (control && cursor.sample > sample_offset) {
+          end_sample = cursor.sample;
+          break;
+        }
+
+        int offset = std::max(0, cursor.sample - sample_offset);
+        dispatch->processMidiMessage(message, offset);
+      }
+      dispatch->render(end_sample - sample_offset);
+      sample_offset = end_sample;
+    }
+  }
+
+  // Note ons and offs spread evenly over the block, and a mod wheel
+  // controller every _controller_interval_ samples.
+  MidiBuffer makeBlock(const Case& block_case) {
+    MidiBuffer buffer;
+    for (int i = 0; i < block_case.num_note_events; ++i) {
+      int sample = (1LL * i * block_case.samples) / block_case.num_note_events;
+      int note = LOWEST_NOTE + (i / 2) % NOTE_RANGE;
+      if (i % 2)
+        buffer.addEvent(MidiMessage::noteOff(1, note), sample);
+      else
+        buffer.addEvent(MidiMessage::noteOn(1, note, 0.8f), sample);
+    }
+
+    for (int s = 0; block_case.controller_interval && s < block_case.samples;
+         s += block_case.controller_interval) {
+      int value = (s / block_case.controller_interval) % 128;
+      buffer.addEvent(MidiMessage::controllerEvent(1, 1, value), s);
+    }
+    return buffer;
+  }
+
+  template<typename Work>
+  double bestMicroseconds(Work work) {
+    double best = 0.0;
+    for (int r = 0; r < RUNS; ++r) {
+      auto start = Clock::now();
+      for (int i = 0; i < REPEATS; ++i)
+        work();
+      auto end = Clock::now();
+      double time = std::chrono::duration<double, std::micro>(end - start).count() / REPEATS;
+      if (r == 0 || time < best)
+        best = time;
+    }
+    return best;
+  }
+} // namespace
+
+int main() {
+  int failures = 0;
+  MidiKeyboardState keyboard_state;
+  MidiBuffer keyboard_messages;
+  keyboard_messages.ensureSize(4096);
+
+  for (const Case& block_case : CASES) {
+    MidiBuffer midi_messages = makeBlock(block_case);
+
+    Dispatch scanning;
+    scanningBlock(midi_messages, block_case.samples, &keyboard_state, &scanning);
+    Dispatch cursor;
+    cursorBlock(midi_messages, block_case.samples, &keyboard_state, &keyboard_messages, &cursor);
+    if (scanning.events != cursor.events) {
+      printf("FAIL %s: scanning dispatched %d events, the cursor %d\n",
+             block_case.name, scanning.events, cursor.events);
+      failures++;
+    }
+
+    Dispatch sink;
+    double scanning_time = bestMicroseconds([&]() {
+      scanningBlock(midi_messages, block_case.samples, &keyboard_state, &sink);
+    });
+    double cursor_time = bestMicroseconds([&]() {
+      cursorBlock(midi_messages, block_case.samples, &keyboard_state, &keyboard_messages, &sink);
+    });
+
+    printf("%-40s %8.2f us in %3d sub-blocks, %7.2f us in %4d with the cursor (%5.1fx)\n",
+           block_case.name, scanning_time, scanning.sub_blocks,
+           cursor_time, cursor.sub_blocks, scanning_time / cursor_time);
+  }
+  return failures ? 1 : 0;
+}
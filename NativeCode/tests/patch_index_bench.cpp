@@ -0,0 +1,176 @@
+/* Copyright 2017 Matt Tytel */
+
+// Writes a library of 50,000 patches made from a factory preset and times
+// the patch browser's old path, listing and parsing every patch, against
+// building, saving, loading, updating and searching the patch index. Fails
+// if the index misses a patch or an update.
+
+#include "patch_index.h"
+
+#include <cstdio>
+
+namespace {
+  const char* TEMPLATE_PATCH = "helm/patches/Factory Presets/Bass/CM Grit Bass.helm";
+  const int NUM_BANKS = 10;
+  const int FOLDERS_PER_BANK = 20;
+  const int PATCHES_PER_FOLDER = 250;
+  const int NUM_PATCHES = NUM_BANKS * FOLDERS_PER_BANK * PATCHES_PER_FOLDER;
+  const int NUM_TOUCHED = 100;
+  const int SEARCHES = 20;
+  const int TAGGED_EVERY = 7;
+
+  const char* WORDS[] = {
+    "bass", "lead", "pad", "pluck", "keys", "sweep", "dark",
+    "bright", "warm", "glass", "acid", "wobble", "soft", "hard"
+  };
+  const char* AUTHORS[] = {
+    "Matt Tytel", "Someone Else", "A. Producer", "Patch Maker", "Sound Designer"
+  };
+
+  template<typename T, int size>
+  T choose(Random& random, T (&values)[size]) {
+    return values[random.nextInt(size)];
+  }
+
+  double now() {
+    return Time::getMillisecondCounterHiRes();
+  }
+
+  // Writes the library with names, authors, tags and one setting varied.
+  Array<File> writeLibrary(File bank_directory, const var& patch) {
+    Random random(3);
+    Array<File> folders;
+    int number = 0;
+    for (int b = 0; b < NUM_BANKS; ++b) {
+      for (int f = 0; f < FOLDERS_PER_BANK; ++f) {
+        File folder = bank_directory.getChildFile("Bank " + String(b))
+                                    .getChildFile("Folder " + String(f));
+        folder.createDirectory();
+        folders.add(folder);
+
+        for (int p = 0; p < PATCHES_PER_FOLDER; ++p) {
+          String name = String(choose(random, WORDS)) + " " + choose(random, WORDS) +
+                        " " + String(number++);
+          DynamicObject* object = patch.getDynamicObject();
+          object->setProperty("patch_name", name);
+          object->setProperty("author", choose(random, AUTHORS));
+          object->getProperty("settings").getDynamicObject()->setProperty(
+              "osc_1_volume", random.nextDouble());
+
+          if (p % TAGGED_EVERY == 0) {
+            var tags;
+            tags.append(choose(random, WORDS));
+            tags.append("fx");
+            object->setProperty("tags", tags);
+          }
+          else
+            object->removeProperty("tags");
+
+          folder.getChildFile(name + ".helm").replaceWithText(JSON::toString(patch));
+        }
+      }
+    }
+    return folders;
+  }
+
+  // The browser's path before the index: every patch is listed and parsed.
+  int parseEveryPatch(const Array<File>& folders) {
+    int parsed = 0;
+    for (File folder : folders) {
+      Array<File> patches;
+      folder.findChildFiles(patches, File::findFiles, false, "*.helm");
+      for (File patch : patches) {
+        var settings;
+        parsed += JSON::parse(patch.loadFileAsString(), settings).wasOk();
+      }
+    }
+    return parsed;
+  }
+
+  double searchMilliseconds(PatchIndex* index, const Array<File>& folders,
+                            const String& text, int* found) {
+    double start = now();
+    for (int i = 0; i < SEARCHES; ++i)
+      *found = index->search(folders, text).size();
+    return (now() - start) / SEARCHES;
+  }
+} // namespace
+
+int main() {
+  var patch = JSON::parse(File::getCurrentWorkingDirectory().getChildFile(TEMPLATE_PATCH));
+  if (!patch.isObject()) {
+    printf("FAIL couldn't read %s\n", TEMPLATE_PATCH);
+    return 1;
+  }
+
+  File directory = File::getSpecialLocation(File::tempDirectory)
+                       .getNonexistentChildFile("patch_index_bench", "");
+  File bank_directory = directory.getChildFile("patches");
+  File index_file = directory.getChildFile("patch_index.cache");
+
+  printf("writing %d patches\n", NUM_PATCHES);
+  Array<File> folders = writeLibrary(bank_directory, patch);
+
+  int failures = 0;
+  double start = now();
+  int parsed = parseEveryPatch(folders);
+  printf("list and parse every patch %8.1f ms\n", now() - start);
+
+  {
+    PatchIndex index(bank_directory, index_file);
+    start = now();
+    index.update();
+    printf("cold index build           %8.1f ms\n", now() - start);
+
+    start = now();
+    index.saveIndexFile();
+    printf("save index                 %8.1f ms, %.1f MB\n", now() - start,
+           index_file.getSize() / (1024.0 * 1024.0));
+    if (index.getNumPatches() != parsed) {
+      printf("FAIL indexed %d of %d patches\n", index.getNumPatches(), parsed);
+      failures++;
+    }
+  }
+
+  PatchIndex index(bank_directory, index_file);
+  start = now();
+  index.loadIndexFile();
+  printf("load cached index          %8.1f ms\n", now() - start);
+
+  start = now();
+  bool changed = index.update();
+  printf("update, nothing changed    %8.1f ms\n", now() - start);
+  if (changed) {
+    printf("FAIL an update with nothing changed changed the index\n");
+    failures++;
+  }
+
+  // Touches some patches, adds one and moves one to another folder.
+  Array<File> touched;
+  folders[3].findChildFiles(touched, File::findFiles, false, "*.helm");
+  for (int i = 0; i < NUM_TOUCHED; ++i)
+    touched[i].setLastModificationTime(Time::getCurrentTime() + RelativeTime::seconds(i + 5));
+  touched[0].copyFileTo(folders[0].getChildFile("added patch.helm"));
+  touched[1].moveFileTo(folders[1].getChildFile(touched[1].getFileName()));
+
+  start = now();
+  changed = index.update();
+  printf("update, %d changed       %8.1f ms\n", NUM_TOUCHED + 2, now() - start);
+  if (!changed || index.getNumPatches() != NUM_PATCHES + 1) {
+    printf("FAIL the update missed changed patches\n");
+    failures++;
+  }
+
+  int found = 0;
+  double time = searchMilliseconds(&index, folders, "bass", &found);
+  printf("search \"bass\"              %8.2f ms, %d patches\n", time, found);
+  time = searchMilliseconds(&index, folders, "", &found);
+  printf("list all                   %8.2f ms, %d patches\n", time, found);
+  if (found != NUM_PATCHES + 1) {
+    printf("FAIL listed %d of %d patches\n", found, NUM_PATCHES + 1);
+    failures++;
+  }
+
+  directory.deleteRecursively();
+  return failures ? 1 : 0;
+}
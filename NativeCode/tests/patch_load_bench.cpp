@@ -0,0 +1,105 @@
+/* Copyright 2017 Matt Tytel */
+
+// Times loading every factory preset: parsing its JSON, reading it as a
+// binary patch, and applying the binary patch to an instance with
+// HelmLoadPatch. Prints the average per preset of the best of several runs.
+
+#include "binary_patch.h"
+#include "helm_engine.h"
+#include "plugin_host.h"
+#include "preset_reader.h"
+
+#include <chrono>
+#include <cstdio>
+
+using namespace Helm;
+
+namespace {
+  const char* PRESET_DIRECTORY = "../Assets/AudioHelm/Presets";
+  const int SAMPLE_RATE = 44100;
+  const int CHANNEL = 0;
+  const int RUNS = 9;
+
+  typedef std::chrono::steady_clock Clock;
+
+  template<typename Function>
+  double bestMicroseconds(Function function) {
+    double best = 0.0;
+    for (int r = 0; r < RUNS; ++r) {
+      auto start = Clock::now();
+      function();
+      auto end = Clock::now();
+      double time = std::chrono::duration<double, std::micro>(end - start).count();
+      if (r == 0 || time < best)
+        best = time;
+    }
+    return best;
+  }
+} // namespace
+
+int main() {
+  std::vector<std::string> paths = PresetReader::findPresets(PRESET_DIRECTORY);
+  if (paths.empty()) {
+    printf("FAIL no presets found in %s\n", PRESET_DIRECTORY);
+    return 1;
+  }
+
+  mopo::HelmEngine engine;
+  PluginHost host(SAMPLE_RATE, CHANNEL);
+  host.process(mopo::MAX_BUFFER_SIZE);
+
+  double json_size = 0.0;
+  double binary_size = 0.0;
+  double parse_time = 0.0;
+  double read_time = 0.0;
+  double load_time = 0.0;
+  int failures = 0;
+
+  for (const std::string& path : paths) {
+    std::string text;
+    PresetReader::Preset preset;
+    if (!PresetReader::readFile(path, &text) || !PresetReader::parse(text, &preset)) {
+      printf("FAIL couldn't parse %s\n", path.c_str());
+      failures++;
+      continue;
+    }
+
+    std::vector<char> patch = PresetReader::toBinaryPatch(preset, &engine);
+    // Aligned for the values, as if the patch were memory mapped.
+    std::vector<mopo::mopo_float> aligned((patch.size() + sizeof(mopo::mopo_float) - 1) /
+                                          sizeof(mopo::mopo_float));
+    memcpy(aligned.data(), patch.data(), patch.size());
+    const char* buffer = reinterpret_cast<const char*>(aligned.data());
+    int size = patch.size();
+
+    bool loaded = true;
+    parse_time += bestMicroseconds([&]() {
+      PresetReader::Preset parsed;
+      PresetReader::parse(text, &parsed);
+    });
+    read_time += bestMicroseconds([&]() {
+      mopo::BinaryPatch binary_patch;
+      loaded = binary_patch.read(buffer, size) && loaded;
+    });
+    load_time += bestMicroseconds([&]() {
+      loaded = HelmLoadPatch(CHANNEL, buffer, size) && loaded;
+    });
+    host.process(mopo::MAX_BUFFER_SIZE);
+
+    if (!loaded) {
+      printf("FAIL couldn't load %s\n", path.c_str());
+      failures++;
+    }
+    json_size += text.size();
+    binary_size += size;
+  }
+
+  int num_presets = paths.size();
+  printf("%d presets\n", num_presets);
+  printf("file size        %8.0f B JSON, %.0f B binary\n",
+         json_size / num_presets, binary_size / num_presets);
+  printf("parse JSON       %8.2f us\n", parse_time / num_presets);
+  printf("read binary      %8.2f us\n", read_time / num_presets);
+  printf("HelmLoadPatch    %8.2f us\n", load_time / num_presets);
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,92 @@
+/* Copyright 2017 Matt Tytel */
+
+#pragma once
+#ifndef PLUGIN_HOST_H
+#define PLUGIN_HOST_H
+
+#include "AudioPluginInterface.h"
+#include "helm_sequencer.h"
+
+#include <cstring>
+#include <vector>
+
+extern "C" {
+  int UnityGetAudioEffectDefinitions(UnityAudioEffectDefinition*** definitions);
+
+  void HelmNoteOn(int channel, int note, float velocity);
+  void HelmNoteOff(int channel, int note);
+  void HelmAllNotesOff(int channel);
+  bool HelmLoadPatch(int channel, const char* buffer, int size);
+  bool HelmSetParameterValue(int channel, int index, float value);
+  void HelmClearModulations(int channel);
+  void HelmAddModulation(int channel, int index, const char* source, const char* dest, float amount);
+  void HelmSetVoiceThreads(int channel, int num_threads);
+  void HelmSetControlInterval(int channel, int samples);
+  void HelmSetSampleRateDivider(int channel, int divider);
+  Helm::HelmSequencer* CreateSequencer();
+  void DeleteSequencer(Helm::HelmSequencer* sequencer);
+  void EnableSequencer(Helm::HelmSequencer* sequencer, bool enable);
+  bool ChangeSequencerChannel(Helm::HelmSequencer* sequencer, int channel);
+  Helm::HelmSequencer::Note* CreateNote(Helm::HelmSequencer* sequencer, int note, float velocity,
+                                        float start, float end);
+  void DeleteNote(Helm::HelmSequencer* sequencer, Helm::HelmSequencer::Note* note);
+  void HelmPrewarmInstances(int num_instances, int sample_rate);
+  void HelmReleasePrewarmedInstances();
+#ifdef HELM_REALTIME_CHECK
+  int HelmGetRealtimeViolations();
+#endif
+}
+
+namespace Helm {
+
+  // Runs one plugin instance the way Unity does, through the effect
+  // definition the plugin registers, with the DSP tick moving on each block.
+  class PluginHost {
+    public:
+      static const int kNumChannels = 2;
+
+      PluginHost(int sample_rate, int channel) : dsp_tick_(0) {
+        UnityAudioEffectDefinition** definitions = nullptr;
+        UnityGetAudioEffectDefinitions(&definitions);
+        definition_ = definitions[0];
+
+        memset(&state_, 0, sizeof(state_));
+        state_.structsize = sizeof(state_);
+        state_.samplerate = sample_rate;
+        state_.internal = &state_;
+        definition_->create(&state_);
+        definition_->setfloatparameter(&state_, 0, channel);
+      }
+
+      ~PluginHost() {
+        definition_->release(&state_);
+      }
+
+      // Renders _num_samples_ into output().
+      void process(int num_samples) {
+        // Instances skip blocks with silent input, so feed it a constant
+        // signal the way the AudioSource in front of Helm does.
+        input_.assign(kNumChannels * num_samples, 1.0f);
+        output_.resize(kNumChannels * num_samples);
+        state_.currdsptick = dsp_tick_;
+        definition_->process(&state_, input_.data(), output_.data(),
+                             num_samples, kNumChannels, kNumChannels);
+        state_.prevdsptick = dsp_tick_;
+        dsp_tick_ += num_samples;
+      }
+
+      const std::vector<float>& output() const { return output_; }
+
+      // The instance's data, for telling pooled instances apart.
+      const void* effectData() const { return state_.effectdata; }
+
+    private:
+      UnityAudioEffectDefinition* definition_;
+      UnityAudioEffectState state_;
+      unsigned long long dsp_tick_;
+      std::vector<float> input_;
+      std::vector<float> output_;
+  };
+} // namespace Helm
+
+#endif // PLUGIN_HOST_H
@@ -0,0 +1,274 @@
+/* Copyright 2017 Matt Tytel */
+
+#pragma once
+#ifndef PRESET_READER_H
+#define PRESET_READER_H
+
+#include "binary_patch.h"
+
+#include <dirent.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace Helm {
+
+  // Reads the .helm JSON presets the tests play, without JUCE. Only the
+  // parts of JSON the presets use are handled, and presets are read as they
+  // are on disk, without the version upgrades the Helm app runs.
+  class PresetReader {
+    public:
+      struct Preset {
+        std::string path;
+        std::string metadata[mopo::BinaryPatch::kNumMetadata];
+        std::map<std::string, mopo::mopo_float> values;
+        std::vector<mopo::BinaryPatch::ModulationSetting> modulations;
+      };
+
+      // Every .helm file under _directory_, sorted by path.
+      static std::vector<std::string> findPresets(const std::string& directory) {
+        std::vector<std::string> paths;
+        addPresets(directory, &paths);
+        std::sort(paths.begin(), paths.end());
+        return paths;
+      }
+
+      static bool readFile(const std::string& path, std::string* text) {
+        std::ifstream file(path.c_str(), std::ios::binary);
+        if (!file)
+          return false;
+
+        std::stringstream contents;
+        contents << file.rdbuf();
+        *text = contents.str();
+        return true;
+      }
+
+      // Parses a preset's JSON. Returns false if it isn't a preset.
+      static bool parse(const std::string& text, Preset* preset) {
+        PresetReader reader(text);
+        return reader.readPreset(preset);
+      }
+
+      // The preset as a binary patch, ready for HelmLoadPatch.
+      static std::vector<char> toBinaryPatch(const Preset& preset, const mopo::HelmEngine* engine) {
+        int size = mopo::BinaryPatch::write(nullptr, 0, preset.values, preset.modulations,
+                                            preset.metadata, engine);
+        std::vector<char> buffer(size);
+        mopo::BinaryPatch::write(buffer.data(), size, preset.values, preset.modulations,
+                                 preset.metadata, engine);
+        return buffer;
+      }
+
+    private:
+      explicit PresetReader(const std::string& text) : text_(text), position_(0) { }
+
+      static void addPresets(const std::string& directory, std::vector<std::string>* paths) {
+        DIR* dir = opendir(directory.c_str());
+        if (dir == nullptr)
+          return;
+
+        while (dirent* entry = readdir(dir)) {
+          std::string name = entry->d_name;
+          if (name == "." || name == "..")
+            continue;
+
+          std::string path = directory + "/" + name;
+          const std::string extension = ".helm";
+          if (name.size() > extension.size() &&
+              name.compare(name.size() - extension.size(), extension.size(), extension) == 0)
+            paths->push_back(path);
+          else if (name.find('.') == std::string::npos)
+            addPresets(path, paths);
+        }
+        closedir(dir);
+      }
+
+      bool readPreset(Preset* preset) {
+        static const char* metadata_names[mopo::BinaryPatch::kNumMetadata] = {
+          "patch_name", "folder_name", "author", "license", "synth_version"
+        };
+
+        if (!consume('{'))
+          return false;
+
+        bool found_settings = false;
+        while (!consume('}')) {
+          std::string key;
+          if (!readString(&key) || !consume(':'))
+            return false;
+
+          int metadata = 0;
+          while (metadata < mopo::BinaryPatch::kNumMetadata && key != metadata_names[metadata])
+            metadata++;
+
+          bool read = false;
+          if (key == "settings") {
+            found_settings = true;
+            read = readSettings(preset);
+          }
+          else if (metadata < mopo::BinaryPatch::kNumMetadata && peek() == '"')
+            read = readString(&preset->metadata[metadata]);
+          else
+            read = skipValue();
+
+          if (!read)
+            return false;
+          consume(',');
+        }
+        return found_settings;
+      }
+
+      bool readSettings(Preset* preset) {
+        if (!consume('{'))
+          return false;
+
+        while (!consume('}')) {
+          std::string key;
+          if (!readString(&key) || !consume(':'))
+            return false;
+
+          bool read = false;
+          if (key == "modulations")
+            read = readModulations(preset);
+          else if (peek() == '-' || (peek() >= '0' && peek() <= '9'))
+            read = readNumber(&preset->values[key]);
+          else
+            read = skipValue();
+
+          if (!read)
+            return false;
+          consume(',');
+        }
+        return true;
+      }
+
+      bool readModulations(Preset* preset) {
+        if (!consume('['))
+          return false;
+
+        while (!consume(']')) {
+          mopo::BinaryPatch::ModulationSetting modulation;
+          modulation.amount = 0.0;
+          if (!consume('{'))
+            return false;
+
+          while (!consume('}')) {
+            std::string key;
+            if (!readString(&key) || !consume(':'))
+              return false;
+
+            bool read = false;
+            if (key == "source")
+              read = readString(&modulation.source);
+            else if (key == "destination")
+              read = readString(&modulation.destination);
+            else if (key == "amount")
+              read = readNumber(&modulation.amount);
+            else
+              read = skipValue();
+
+            if (!read)
+              return false;
+            consume(',');
+          }
+
+          preset->modulations.push_back(modulation);
+          consume(',');
+        }
+        return true;
+      }
+
+      void skipWhitespace() {
+        while (position_ < text_.size() && isspace(static_cast<unsigned char>(text_[position_])))
+          position_++;
+      }
+
+      char peek() {
+        skipWhitespace();
+        return position_ < text_.size() ? text_[position_] : '\0';
+      }
+
+      bool consume(char character) {
+        if (peek() != character)
+          return false;
+        position_++;
+        return true;
+      }
+
+      bool readString(std::string* value) {
+        if (!consume('"'))
+          return false;
+
+        value->clear();
+        while (position_ < text_.size() && text_[position_] != '"') {
+          char character = text_[position_++];
+          if (character == '\\' && position_ < text_.size()) {
+            character = text_[position_++];
+            if (character == 'n')
+              character = '\n';
+            else if (character == 't')
+              character = '\t';
+            else if (character == 'u') {
+              position_ = std::min(position_ + 4, text_.size());
+              character = '?';
+            }
+          }
+          value->push_back(character);
+        }
+        return consume('"');
+      }
+
+      bool readNumber(mopo::mopo_float* value) {
+        skipWhitespace();
+        const char* start = text_.c_str() + position_;
+        char* end = nullptr;
+        *value = strtod(start, &end);
+        if (end == start)
+          return false;
+        position_ += end - start;
+        return true;
+      }
+
+      bool skipValue() {
+        char next = peek();
+        if (next == '"') {
+          std::string ignored;
+          return readString(&ignored);
+        }
+        if (next == '{' || next == '[') {
+          char close = next == '{' ? '}' : ']';
+          position_++;
+          while (!consume(close)) {
+            if (next == '{') {
+              std::string ignored;
+              if (!readString(&ignored) || !consume(':'))
+                return false;
+            }
+            if (!skipValue())
+              return false;
+            consume(',');
+          }
+          return true;
+        }
+
+        size_t start = position_;
+        while (position_ < text_.size() && text_[position_] != ',' &&
+               text_[position_] != '}' && text_[position_] != ']' &&
+               !isspace(static_cast<unsigned char>(text_[position_])))
+          position_++;
+        return position_ > start;
+      }
+
+      const std::string& text_;
+      size_t position_;
+  };
+} // namespace Helm
+
+#endif // PRESET_READER_H
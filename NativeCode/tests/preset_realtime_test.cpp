@@ -0,0 +1,107 @@
+/* Copyright 2017 Matt Tytel */
+
+// Loads every factory preset into an instance and plays it through the
+// effect's process callback, which runs under a RealtimeScope. Fails if
+// rendering any preset allocates or frees memory or takes a lock on the audio
+// thread, or if a preset renders anything that isn't a finite sample.
+
+#include "binary_patch.h"
+#include "helm_engine.h"
+#include "plugin_host.h"
+#include "preset_reader.h"
+
+#include <cmath>
+#include <cstdio>
+
+using namespace Helm;
+
+namespace {
+  const char* PRESET_DIRECTORY = "../Assets/AudioHelm/Presets";
+  const int SAMPLE_RATE = 44100;
+  const int CHANNEL = 0;
+  const int BUFFER_SIZE = 512;
+  const int HELD_BLOCKS = 16;
+  const int RELEASE_BLOCKS = 16;
+
+  // More notes than there are voices, so voices get stolen too.
+  const int NUM_NOTES = mopo::MAX_POLYPHONY + 7;
+  const int LOWEST_NOTE = 36;
+
+  bool renderFinite(PluginHost* host) {
+    host->process(BUFFER_SIZE);
+    for (float sample : host->output()) {
+      if (!std::isfinite(sample))
+        return false;
+    }
+    return true;
+  }
+
+  // Plays a run of notes, a few at a time, then lets them ring out.
+  bool playPreset(PluginHost* host) {
+    bool finite = true;
+    for (int i = 0; i < NUM_NOTES; ++i) {
+      HelmNoteOn(CHANNEL, LOWEST_NOTE + i, 1.0f - (0.5f * i) / NUM_NOTES);
+      if (i % 4 == 3)
+        finite = renderFinite(host) && finite;
+    }
+
+    for (int i = 0; i < HELD_BLOCKS; ++i)
+      finite = renderFinite(host) && finite;
+
+    for (int i = 0; i < NUM_NOTES; i += 2)
+      HelmNoteOff(CHANNEL, LOWEST_NOTE + i);
+    finite = renderFinite(host) && finite;
+    HelmAllNotesOff(CHANNEL);
+
+    for (int i = 0; i < RELEASE_BLOCKS; ++i)
+      finite = renderFinite(host) && finite;
+    return finite;
+  }
+} // namespace
+
+int main() {
+  std::vector<std::string> paths = PresetReader::findPresets(PRESET_DIRECTORY);
+  if (paths.empty()) {
+    printf("FAIL no presets found in %s\n", PRESET_DIRECTORY);
+    return 1;
+  }
+
+  mopo::HelmEngine engine;
+  PluginHost host(SAMPLE_RATE, CHANNEL);
+  // Instances only take patches once they've rendered a block.
+  host.process(BUFFER_SIZE);
+
+  int failures = 0;
+  for (const std::string& path : paths) {
+    std::string text;
+    PresetReader::Preset preset;
+    if (!PresetReader::readFile(path, &text) || !PresetReader::parse(text, &preset)) {
+      printf("FAIL couldn't parse %s\n", path.c_str());
+      failures++;
+      continue;
+    }
+
+    std::vector<char> patch = PresetReader::toBinaryPatch(preset, &engine);
+    if (!HelmLoadPatch(CHANNEL, patch.data(), patch.size())) {
+      printf("FAIL couldn't load %s\n", path.c_str());
+      failures++;
+      continue;
+    }
+
+    int violations = HelmGetRealtimeViolations();
+    bool finite = playPreset(&host);
+    violations = HelmGetRealtimeViolations() - violations;
+
+    if (violations) {
+      printf("FAIL %s allocated or locked on the audio thread %d times\n", path.c_str(), violations);
+      failures++;
+    }
+    if (!finite) {
+      printf("FAIL %s rendered samples that aren't finite\n", path.c_str());
+      failures++;
+    }
+  }
+
+  printf("%d presets, %d failures\n", static_cast<int>(paths.size()), failures);
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,116 @@
+/* Copyright 2017 Matt Tytel */
+
+// Times HelmSequencer with tens of thousands of notes. Edits keep the active
+// note index up to date, so this reports what they cost on the calling
+// thread next to what getActiveNotes costs on the audio thread, and checks
+// getActiveNotes against a scan of every note.
+
+#include "helm_sequencer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace Helm;
+
+namespace {
+  const int NUM_NOTES = 20000;
+  const int NUM_QUERIES = 100000;
+  const int NUM_EDITS = 5000;
+  const double LENGTH = 4096.0;
+  const double MAX_NOTE_LENGTH = 8.0;
+
+  typedef std::chrono::steady_clock Clock;
+
+  double microsecondsSince(Clock::time_point start, int count) {
+    auto end = Clock::now();
+    return std::chrono::duration<double, std::micro>(end - start).count() / count;
+  }
+
+  int countActiveNotes(const std::vector<HelmSequencer::Note*>& notes, double position) {
+    int count = 0;
+    for (HelmSequencer::Note* note : notes) {
+      if (note->time_on < position && note->time_off >= position)
+        count++;
+    }
+    return count;
+  }
+} // namespace
+
+int main() {
+  std::mt19937 random_generator(17);
+  std::uniform_real_distribution<double> start_distribution(0.0, LENGTH - MAX_NOTE_LENGTH);
+  std::uniform_real_distribution<double> length_distribution(0.25, MAX_NOTE_LENGTH);
+  std::uniform_int_distribution<int> key_distribution(0, 127);
+
+  HelmSequencer sequencer;
+  sequencer.setLength(LENGTH);
+  std::vector<HelmSequencer::Note*> notes;
+
+  auto start = Clock::now();
+  for (int i = 0; i < NUM_NOTES; ++i) {
+    double time_on = start_distribution(random_generator);
+    double time_off = time_on + length_distribution(random_generator);
+    notes.push_back(sequencer.addNote(key_distribution(random_generator), 1.0, time_on, time_off));
+  }
+  printf("addNote          %8.3f us\n", microsecondsSince(start, NUM_NOTES));
+
+  start = Clock::now();
+  for (int i = 0; i < NUM_EDITS; ++i) {
+    HelmSequencer::Note* note = notes[i * (NUM_NOTES / NUM_EDITS)];
+    sequencer.changeNoteEnd(note, note->time_on + length_distribution(random_generator));
+  }
+  printf("changeNoteEnd    %8.3f us\n", microsecondsSince(start, NUM_EDITS));
+
+  start = Clock::now();
+  for (int i = 0; i < NUM_EDITS; ++i) {
+    HelmSequencer::Note* note = notes[i * (NUM_NOTES / NUM_EDITS) + 1];
+    double time_on = start_distribution(random_generator);
+    sequencer.changeNoteStart(note, time_on);
+    sequencer.changeNoteEnd(note, time_on + length_distribution(random_generator));
+  }
+  printf("changeNoteStart  %8.3f us (with its changeNoteEnd)\n",
+         microsecondsSince(start, NUM_EDITS));
+
+  std::vector<double> positions;
+  std::uniform_real_distribution<double> position_distribution(0.0, LENGTH);
+  for (int i = 0; i < NUM_QUERIES; ++i)
+    positions.push_back(position_distribution(random_generator));
+
+  HelmSequencer::Note* active[HelmSequencer::kMaxNotes];
+  long long total_active = 0;
+  start = Clock::now();
+  for (double position : positions)
+    total_active += sequencer.getActiveNotes(active, position);
+  printf("getActiveNotes   %8.3f us (%.1f active on average)\n",
+         microsecondsSince(start, NUM_QUERIES), (1.0 * total_active) / NUM_QUERIES);
+
+  int mismatches = 0;
+  for (int i = 0; i < NUM_QUERIES; i += 97) {
+    int expected = std::min<int>(countActiveNotes(notes, positions[i]), HelmSequencer::kMaxNotes);
+    if (sequencer.getActiveNotes(active, positions[i]) != expected)
+      mismatches++;
+  }
+
+  start = Clock::now();
+  for (int i = 0; i < NUM_NOTES; i += 2)
+    sequencer.deleteNote(notes[i]);
+  printf("deleteNote       %8.3f us\n", microsecondsSince(start, NUM_NOTES / 2));
+
+  for (int i = 1; i < NUM_NOTES; i += 2)
+    notes[i / 2] = notes[i];
+  notes.resize(NUM_NOTES / 2);
+  for (int i = 0; i < NUM_QUERIES; i += 97) {
+    int expected = std::min<int>(countActiveNotes(notes, positions[i]), HelmSequencer::kMaxNotes);
+    if (sequencer.getActiveNotes(active, positions[i]) != expected)
+      mismatches++;
+  }
+
+  if (mismatches) {
+    printf("FAIL getActiveNotes disagreed with a full scan %d times\n", mismatches);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,163 @@
+/* Copyright 2017 Matt Tytel */
+
+// Times a held chord on a new engine and on every factory preset twice: with
+// the voice processors the patch can't hear turned off, and with them all
+// running. Prints how many voice processors each patch turns off and the CPU
+// per block both ways. Turned off random sources no longer draw numbers, so
+// the two renders aren't compared.
+
+#include "helm_engine.h"
+#include "helm_voice_handler.h"
+#include "preset_reader.h"
+
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+using namespace Helm;
+
+namespace {
+  const char* PRESET_DIRECTORY = "../Assets/AudioHelm/Presets";
+  const int SAMPLE_RATE = 44100;
+  const int NUM_NOTES = 4;
+  const int LOWEST_NOTE = 48;
+  const int BLOCKS = 64;
+  const int RUNS = 5;
+
+  typedef std::chrono::steady_clock Clock;
+
+  struct Patch {
+    mopo::HelmEngine engine;
+    std::vector<mopo::ModulationConnection*> connections;
+
+    ~Patch() {
+      for (mopo::ModulationConnection* connection : connections) {
+        engine.disconnectModulation(connection);
+        delete connection;
+      }
+    }
+  };
+
+  struct Times {
+    double turned_off;
+    double pruned;
+    double full;
+  };
+
+  void load(Patch* patch, const PresetReader::Preset* preset) {
+    mopo::HelmEngine& engine = patch->engine;
+    engine.setSampleRate(SAMPLE_RATE);
+    engine.setBufferSize(mopo::MAX_BUFFER_SIZE);
+    if (preset == nullptr) {
+      engine.prepareVoices();
+      return;
+    }
+
+    mopo::control_map controls = engine.getControls();
+    for (auto& value : preset->values) {
+      if (controls.count(value.first))
+        controls[value.first]->set(value.second);
+    }
+    for (const mopo::BinaryPatch::ModulationSetting& modulation : preset->modulations) {
+      mopo::ModulationConnection* connection =
+          new mopo::ModulationConnection(modulation.source, modulation.destination);
+      connection->amount.set(modulation.amount);
+      engine.connectModulation(connection);
+      patch->connections.push_back(connection);
+    }
+    engine.prepareVoices();
+  }
+
+  int countOff(mopo::HelmEngine* engine) {
+    std::vector<std::pair<const mopo::Processor*, mopo::Processor*>> copies;
+    mopo::HelmVoiceHandler* voice_handler =
+        const_cast<mopo::HelmVoiceHandler*>(engine->getVoiceHandler());
+    voice_handler->getPolyRouter()->getProcessorCopies(&copies);
+
+    int off = 0;
+    for (auto& copy : copies)
+      off += !copy.second->enabled();
+    return off;
+  }
+
+  // Renders the chord from silence and returns the microseconds per block.
+  double render(mopo::HelmEngine* engine) {
+    engine->allNotesOff();
+    for (int i = 0; i < BLOCKS; ++i)
+      engine->process();
+    for (int n = 0; n < NUM_NOTES; ++n)
+      engine->noteOn(LOWEST_NOTE + 4 * n, 0.8);
+
+    auto start = Clock::now();
+    for (int i = 0; i < BLOCKS; ++i)
+      engine->process();
+    auto end = Clock::now();
+    return std::chrono::duration<double, std::micro>(end - start).count() / BLOCKS;
+  }
+
+  Times measure(const PresetReader::Preset* preset) {
+    Patch pruned;
+    load(&pruned, preset);
+
+    Patch full;
+    load(&full, preset);
+    mopo::HelmVoiceHandler* voice_handler =
+        const_cast<mopo::HelmVoiceHandler*>(full.engine.getVoiceHandler());
+    voice_handler->setSilentBranches({ }, { });
+    voice_handler->prepareVoices(voice_handler->getNumVoices());
+
+    Times times;
+    for (int r = 0; r < RUNS; ++r) {
+      double pruned_time = render(&pruned.engine);
+      double full_time = render(&full.engine);
+      if (r == 0 || pruned_time < times.pruned)
+        times.pruned = pruned_time;
+      if (r == 0 || full_time < times.full)
+        times.full = full_time;
+    }
+
+    // Modulation switches turn off the sums of unmodulated controls either way.
+    times.turned_off = countOff(&pruned.engine) - countOff(&full.engine);
+    return times;
+  }
+
+  void printTimes(const char* name, const Times& times) {
+    printf("%-16s %5.1f voice processors off %8.1f us per block, %8.1f with all on (%4.2fx)\n",
+           name, times.turned_off, times.pruned, times.full,
+           times.full / times.pruned);
+  }
+} // namespace
+
+int main() {
+  std::vector<std::string> paths = PresetReader::findPresets(PRESET_DIRECTORY);
+  if (paths.empty()) {
+    printf("FAIL no presets found in %s\n", PRESET_DIRECTORY);
+    return 1;
+  }
+
+  int failures = 0;
+  printTimes("new engine", measure(nullptr));
+
+  Times total = { 0, 0.0, 0.0 };
+  int num_presets = 0;
+  for (const std::string& path : paths) {
+    std::string text;
+    PresetReader::Preset preset;
+    if (!PresetReader::readFile(path, &text) || !PresetReader::parse(text, &preset)) {
+      printf("FAIL couldn't parse %s\n", path.c_str());
+      failures++;
+      continue;
+    }
+
+    Times times = measure(&preset);
+    total.turned_off += times.turned_off;
+    total.pruned += times.pruned;
+    total.full += times.full;
+    num_presets++;
+  }
+
+  Times average = { total.turned_off / num_presets, total.pruned / num_presets,
+                    total.full / num_presets };
+  printTimes("preset average", average);
+  return failures ? 1 : 0;
+}
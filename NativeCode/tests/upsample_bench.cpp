@@ -0,0 +1,145 @@
+/* Copyright 2017 Matt Tytel */
+
+// Times the polyphase upsampler raising stereo audio to the host rate at each
+// factor, then a plugin instance rendering a light and a heavy patch with no
+// divider and with a divider of 2 requested. The light patch is too light to
+// pay for upsampling, so it should keep the host rate and cost the same both
+// ways.
+
+#include "helm_engine.h"
+#include "plugin_host.h"
+#include "polyphase_upsampler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+
+using namespace Helm;
+
+namespace {
+  const int SAMPLE_RATE = 44100;
+  const int CHANNEL = 0;
+  const int BUFFER_SIZE = 512;
+  const int BLOCKS = 400;
+  const int RELEASE_BLOCKS = 8;
+  const int RUNS = 5;
+  const int LOWEST_NOTE = 48;
+  const int FACTORS[] = { 2, 3, 4 };
+
+  typedef std::chrono::steady_clock Clock;
+
+  struct Patch {
+    const char* name;
+    int num_notes;
+    int unison_voices;
+    bool effects;
+  };
+
+  const Patch PATCHES[] = {
+    { "3 plain notes", 3, 1, false },
+    { "8 notes, unison 5+5, reverb and delay", 8, 5, true },
+  };
+
+  // Parameters are registered after the plugin's own, in name order.
+  int parameterIndex(const std::string& name) {
+    int index = 1;
+    for (auto& parameter : mopo::Parameters::lookup_.getAllDetails()) {
+      if (parameter.first == name)
+        return index;
+      index++;
+    }
+    return -1;
+  }
+
+  // Milliseconds to upsample BLOCKS host blocks of stereo audio, in engine
+  // sized pieces the way the plugin does.
+  double timeUpsampler(int factor) {
+    mopo::PolyphaseUpsampler upsamplers[2];
+    upsamplers[0].setFactor(factor);
+    upsamplers[1].setFactor(factor);
+
+    mopo::mopo_float input[mopo::MAX_BUFFER_SIZE];
+    for (int i = 0; i < mopo::MAX_BUFFER_SIZE; ++i)
+      input[i] = sin(i * 0.05);
+
+    volatile mopo::mopo_float sink = 0.0;
+    double best = 0.0;
+    for (int r = 0; r < RUNS; ++r) {
+      auto start = Clock::now();
+      for (int b = 0; b < BLOCKS; ++b) {
+        for (int s = 0; s < BUFFER_SIZE; s += mopo::MAX_BUFFER_SIZE) {
+          int samples = std::min(BUFFER_SIZE - s, mopo::MAX_BUFFER_SIZE);
+          int input_samples = upsamplers[0].inputNeeded(samples);
+          if (input_samples) {
+            upsamplers[0].write(input, input_samples);
+            upsamplers[1].write(input, input_samples);
+          }
+          sink = upsamplers[0].read(samples)[0] + upsamplers[1].read(samples)[0];
+        }
+      }
+      auto end = Clock::now();
+      double time = std::chrono::duration<double, std::milli>(end - start).count();
+      if (r == 0 || time < best)
+        best = time;
+    }
+    return best;
+  }
+
+  // Renders the patch's chord from silence and returns the milliseconds it took.
+  double renderChord(PluginHost* host, const Patch& patch) {
+    HelmAllNotesOff(CHANNEL);
+    for (int i = 0; i < RELEASE_BLOCKS; ++i)
+      host->process(BUFFER_SIZE);
+    for (int n = 0; n < patch.num_notes; ++n)
+      HelmNoteOn(CHANNEL, LOWEST_NOTE + 2 * n, 0.8f);
+
+    auto start = Clock::now();
+    for (int i = 0; i < BLOCKS; ++i)
+      host->process(BUFFER_SIZE);
+    auto end = Clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+  }
+
+  void setPatch(PluginHost* host, const Patch& patch) {
+    HelmSetParameterValue(CHANNEL, parameterIndex("polyphony"), patch.num_notes);
+    HelmSetParameterValue(CHANNEL, parameterIndex("osc_1_unison_voices"), patch.unison_voices);
+    HelmSetParameterValue(CHANNEL, parameterIndex("osc_2_unison_voices"), patch.unison_voices);
+    HelmSetParameterValue(CHANNEL, parameterIndex("reverb_on"), patch.effects);
+    HelmSetParameterValue(CHANNEL, parameterIndex("delay_on"), patch.effects);
+    host->process(BUFFER_SIZE);
+  }
+} // namespace
+
+int main() {
+  double audio_seconds = (1.0 * BLOCKS * BUFFER_SIZE) / SAMPLE_RATE;
+  printf("%d blocks of %d samples, %.1f s of stereo audio\n", BLOCKS, BUFFER_SIZE, audio_seconds);
+
+  for (int factor : FACTORS)
+    printf("upsampling by %d %8.2f ms\n", factor, timeUpsampler(factor));
+
+  PluginHost host(SAMPLE_RATE, CHANNEL);
+  host.process(BUFFER_SIZE);
+
+  for (const Patch& patch : PATCHES) {
+    setPatch(&host, patch);
+
+    // Alternates the rates so both see the same machine load.
+    double full_rate = 0.0;
+    double reduced_rate = 0.0;
+    for (int r = 0; r < RUNS; ++r) {
+      HelmSetSampleRateDivider(CHANNEL, 1);
+      double time = renderChord(&host, patch);
+      if (r == 0 || time < full_rate)
+        full_rate = time;
+
+      HelmSetSampleRateDivider(CHANNEL, 2);
+      time = renderChord(&host, patch);
+      if (r == 0 || time < reduced_rate)
+        reduced_rate = time;
+    }
+    printf("%-38s %8.1f ms, %8.1f ms with divider 2 requested (%4.2fx)\n",
+           patch.name, full_rate, reduced_rate, reduced_rate / full_rate);
+  }
+  return 0;
+}
@@ -0,0 +1,152 @@
+/* Copyright 2017 Matt Tytel */
+
+// Times every vector_math kernel on MAX_BUFFER_SIZE blocks for each
+// instruction set the CPU supports. Prints the best of several runs per kernel
+// in nanoseconds per sample, with the speedup over the scalar kernel.
+
+#include "vector_math.h"
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+
+using namespace mopo;
+
+namespace {
+  const char* INSTRUCTION_SET_NAMES[vector_math::kNumInstructionSets] = {
+    "scalar", "sse2", "avx2", "neon"
+  };
+
+  const int SIZE = MAX_BUFFER_SIZE;
+  const int NUM_COEFFICIENTS = 16;
+  const int TABLE_MAX_INDEX = 64;
+  const int ITERATIONS = 20000;
+  const int RUNS = 9;
+
+  enum Kernel {
+    kAdd,
+    kMultiply,
+    kCorrelate,
+    kInterpolate,
+    kBilinearInterpolate,
+    kClamp,
+    kFill,
+    kRamp,
+    kCopy,
+    kLookup,
+    kIsSilent,
+    kSumOfSquares,
+    kPeak,
+    kTanh,
+    kLinearFold,
+    kSinFold,
+    kScaleInterleaved,
+    kNumKernels
+  };
+
+  const char* KERNEL_NAMES[kNumKernels] = {
+    "add", "multiply", "correlate", "interpolate", "bilinearInterpolate",
+    "clamp", "fill", "ramp", "copy", "lookup", "isSilent", "sumOfSquares",
+    "peak", "tanh", "linearFold", "sinFold", "scaleInterleaved"
+  };
+
+  mopo_float a[SIZE + NUM_COEFFICIENTS];
+  mopo_float b[SIZE];
+  mopo_float c[SIZE];
+  mopo_float d[SIZE];
+  mopo_float x[SIZE];
+  mopo_float y[SIZE];
+  mopo_float table[TABLE_MAX_INDEX + 2];
+  mopo_float dest[SIZE];
+  // Stereo, like most Unity mixer buffers.
+  const int kNumFrameChannels = 2;
+  float frames[kNumFrameChannels * SIZE];
+  // isSilent stops at the first loud sample, so it gets timed on silence.
+  mopo_float silence[SIZE];
+
+  // Keeps results the compiler would otherwise throw away.
+  volatile mopo_float sink;
+
+  void randomize(mopo_float* buffer, int size, mopo_float min, mopo_float max) {
+    static std::mt19937 random_generator(17);
+    std::uniform_real_distribution<mopo_float> distribution(min, max);
+    for (int i = 0; i < size; ++i)
+      buffer[i] = distribution(random_generator);
+  }
+
+  void run(const vector_math::Kernels& k, Kernel kernel) {
+    switch (kernel) {
+      case kAdd: k.add(dest, a, b, SIZE); break;
+      case kMultiply: k.multiply(dest, a, b, SIZE); break;
+      case kCorrelate: k.correlate(dest, a, table, NUM_COEFFICIENTS, SIZE); break;
+      case kInterpolate: k.interpolate(dest, a, b, x, SIZE); break;
+      case kBilinearInterpolate: k.bilinearInterpolate(dest, a, b, c, d, x, y, SIZE); break;
+      case kClamp: k.clamp(dest, a, -1.0, 1.0, SIZE); break;
+      case kFill: k.fill(dest, 0.5, SIZE); break;
+      case kRamp: k.ramp(dest, 0.0, 0.01, SIZE); break;
+      case kCopy: k.copy(dest, a, SIZE); break;
+      case kLookup: k.lookup(dest, a, table, -2.0, 16.0, TABLE_MAX_INDEX, SIZE); break;
+      case kIsSilent: sink = k.isSilent(silence, SIZE); break;
+      case kSumOfSquares: sink = k.sumOfSquares(a, SIZE); break;
+      case kPeak: sink = k.peak(a, SIZE); break;
+      case kTanh: k.tanh(dest, a, SIZE); break;
+      case kLinearFold: k.linearFold(dest, a, SIZE); break;
+      case kSinFold: k.sinFold(dest, a, SIZE); break;
+      case kScaleInterleaved:
+        k.scaleInterleaved(frames, frames, b, c, kNumFrameChannels, SIZE);
+        break;
+      default: break;
+    }
+  }
+
+  double nanosecondsPerSample(const vector_math::Kernels& kernels, Kernel kernel) {
+    double best = 0.0;
+    for (int r = 0; r < RUNS; ++r) {
+      auto start = std::chrono::steady_clock::now();
+      for (int i = 0; i < ITERATIONS; ++i)
+        run(kernels, kernel);
+      auto end = std::chrono::steady_clock::now();
+
+      double time = std::chrono::duration<double, std::nano>(end - start).count();
+      time /= 1.0 * ITERATIONS * SIZE;
+      if (r == 0 || time < best)
+        best = time;
+    }
+    sink = dest[0];
+    return best;
+  }
+} // namespace
+
+int main() {
+  randomize(a, SIZE + NUM_COEFFICIENTS, -2.0, 2.0);
+  randomize(b, SIZE, -2.0, 2.0);
+  randomize(c, SIZE, -2.0, 2.0);
+  randomize(d, SIZE, -2.0, 2.0);
+  randomize(x, SIZE, 0.0, 1.0);
+  randomize(y, SIZE, 0.0, 1.0);
+  randomize(table, TABLE_MAX_INDEX + 2, -1.0, 1.0);
+
+  printf("%-20s", "ns/sample");
+  for (int i = 0; i < vector_math::kNumInstructionSets; ++i) {
+    if (vector_math::supportsInstructionSet(static_cast<vector_math::InstructionSet>(i)))
+      printf("%16s", INSTRUCTION_SET_NAMES[i]);
+  }
+  printf("\n");
+
+  for (int kernel = 0; kernel < kNumKernels; ++kernel) {
+    printf("%-20s", KERNEL_NAMES[kernel]);
+    double scalar_time = 0.0;
+    for (int i = 0; i < vector_math::kNumInstructionSets; ++i) {
+      if (!vector_math::setInstructionSet(static_cast<vector_math::InstructionSet>(i)))
+        continue;
+
+      double time = nanosecondsPerSample(*vector_math::active_kernels,
+                                         static_cast<Kernel>(kernel));
+      if (i == vector_math::kScalar)
+        scalar_time = time;
+      printf("%9.3f (%4.1fx)", time, scalar_time / time);
+    }
+    printf("\n");
+  }
+  return 0;
+}
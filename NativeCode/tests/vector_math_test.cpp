@@ -0,0 +1,227 @@
+/* Copyright 2017 Matt Tytel */
+
+// Checks every vector_math kernel the CPU supports gives the same bits as the
+// scalar kernels, over sizes and alignments that hit every tail case.
+
+#include "vector_math.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+
+using namespace mopo;
+
+namespace {
+  const char* INSTRUCTION_SET_NAMES[vector_math::kNumInstructionSets] = {
+    "scalar", "sse2", "avx2", "neon"
+  };
+
+  const int SIZES[] = { 0, 1, 2, 3, 4, 5, 7, 8, 9, 15, 16, 17, 31, 33, 63, 64, 65, 255, 256 };
+  const int NUM_COEFFICIENTS[] = { 1, 2, 3, 8, 17 };
+  const int MAX_OFFSET = 3;
+  const int BUFFER_SIZE = 256 + 32 + MAX_OFFSET;
+  const int TABLE_MAX_INDEX = 64;
+  const int MAX_CHANNELS = 8;
+
+  std::mt19937 random_generator(17);
+
+  struct Buffers {
+    mopo_float a[BUFFER_SIZE];
+    mopo_float b[BUFFER_SIZE];
+    mopo_float c[BUFFER_SIZE];
+    mopo_float d[BUFFER_SIZE];
+    mopo_float x[BUFFER_SIZE];
+    mopo_float y[BUFFER_SIZE];
+    mopo_float table[TABLE_MAX_INDEX + 2];
+    float frames[MAX_CHANNELS * BUFFER_SIZE];
+  };
+
+  void randomize(mopo_float* buffer, int size, mopo_float min, mopo_float max) {
+    std::uniform_real_distribution<mopo_float> distribution(min, max);
+    for (int i = 0; i < size; ++i)
+      buffer[i] = distribution(random_generator);
+  }
+
+  void randomize(Buffers* buffers) {
+    randomize(buffers->a, BUFFER_SIZE, -40.0, 40.0);
+    randomize(buffers->b, BUFFER_SIZE, -40.0, 40.0);
+    randomize(buffers->c, BUFFER_SIZE, -40.0, 40.0);
+    randomize(buffers->d, BUFFER_SIZE, -40.0, 40.0);
+    randomize(buffers->x, BUFFER_SIZE, 0.0, 1.0);
+    randomize(buffers->y, BUFFER_SIZE, 0.0, 1.0);
+    randomize(buffers->table, TABLE_MAX_INDEX + 2, -1.0, 1.0);
+
+    std::uniform_real_distribution<float> sample(-1.0f, 1.0f);
+    for (int i = 0; i < MAX_CHANNELS * BUFFER_SIZE; ++i)
+      buffers->frames[i] = sample(random_generator);
+
+    // Values the folds and tanh have to range reduce or saturate.
+    buffers->a[3] = 1e12;
+    buffers->a[7] = -3e9;
+    buffers->a[11] = 0.0;
+    buffers->a[13] = -0.0;
+  }
+
+  int failures = 0;
+
+  void expectSame(const char* kernel, vector_math::InstructionSet instruction_set,
+                  int size, int offset, const mopo_float* expected,
+                  const mopo_float* actual, int num_values) {
+    if (memcmp(expected, actual, num_values * sizeof(mopo_float)) == 0)
+      return;
+
+    int index = 0;
+    while (memcmp(expected + index, actual + index, sizeof(mopo_float)) == 0)
+      index++;
+
+    failures++;
+    printf("FAIL %s %s size %d offset %d: [%d] %.17g != %.17g\n", kernel,
+           INSTRUCTION_SET_NAMES[instruction_set], size, offset,
+           index, expected[index], actual[index]);
+  }
+
+  void expectClose(const char* kernel, vector_math::InstructionSet instruction_set,
+                   int size, int offset, mopo_float expected, mopo_float actual) {
+    if (fabs(expected - actual) <= 1e-12 * fabs(expected))
+      return;
+
+    failures++;
+    printf("FAIL %s %s size %d offset %d: %.17g != %.17g\n", kernel,
+           INSTRUCTION_SET_NAMES[instruction_set], size, offset, expected, actual);
+  }
+
+  void checkKernels(const vector_math::Kernels& scalar, const vector_math::Kernels& kernels,
+                    vector_math::InstructionSet instruction_set,
+                    const Buffers& in, int size, int offset) {
+    mopo_float expected[BUFFER_SIZE];
+    mopo_float actual[BUFFER_SIZE];
+    const mopo_float* a = in.a + offset;
+    const mopo_float* b = in.b + offset;
+    const mopo_float* c = in.c + offset;
+    const mopo_float* d = in.d + offset;
+    const mopo_float* x = in.x + offset;
+    const mopo_float* y = in.y + offset;
+
+    // Outputs are written at _offset_ too, with a guard value past the end
+    // so kernels that write too far get caught.
+    mopo_float* expected_dest = expected + offset;
+    mopo_float* actual_dest = actual + offset;
+    int checked = size + 1;
+
+#define MOPO_CHECK_KERNEL(name, call)                                   \
+    do {                                                                \
+      for (int i = 0; i < BUFFER_SIZE; ++i)                             \
+        expected[i] = actual[i] = 1234.5;                               \
+      { const vector_math::Kernels& k = scalar;                         \
+        mopo_float* dest = expected_dest; call; }                       \
+      { const vector_math::Kernels& k = kernels;                        \
+        mopo_float* dest = actual_dest; call; }                         \
+      expectSame(name, instruction_set, size, offset,                   \
+                 expected_dest, actual_dest, checked);                  \
+    } while (0)
+
+    MOPO_CHECK_KERNEL("add", k.add(dest, a, b, size));
+    MOPO_CHECK_KERNEL("multiply", k.multiply(dest, a, b, size));
+    MOPO_CHECK_KERNEL("interpolate", k.interpolate(dest, a, b, x, size));
+    MOPO_CHECK_KERNEL("bilinearInterpolate",
+                      k.bilinearInterpolate(dest, a, b, c, d, x, y, size));
+    MOPO_CHECK_KERNEL("clamp", k.clamp(dest, a, -10.0, 12.5, size));
+    MOPO_CHECK_KERNEL("fill", k.fill(dest, 0.375, size));
+    MOPO_CHECK_KERNEL("ramp", k.ramp(dest, -2.0, 0.0625, size));
+    MOPO_CHECK_KERNEL("copy", k.copy(dest, a, size));
+    MOPO_CHECK_KERNEL("lookup", k.lookup(dest, a, in.table, -30.0, 1.25,
+                                         TABLE_MAX_INDEX, size));
+    MOPO_CHECK_KERNEL("tanh", k.tanh(dest, a, size));
+    MOPO_CHECK_KERNEL("linearFold", k.linearFold(dest, a, size));
+    MOPO_CHECK_KERNEL("sinFold", k.sinFold(dest, a, size));
+
+    for (int num_coefficients : NUM_COEFFICIENTS) {
+      MOPO_CHECK_KERNEL("correlate",
+                        k.correlate(dest, a, in.table, num_coefficients, size));
+    }
+
+    // In place, the way most operators call them.
+    MOPO_CHECK_KERNEL("add in place",
+                      (k.copy(dest, a, size), k.add(dest, dest, b, size)));
+    MOPO_CHECK_KERNEL("tanh in place",
+                      (k.copy(dest, a, size), k.tanh(dest, dest, size)));
+
+#undef MOPO_CHECK_KERNEL
+
+    mopo_float silent[BUFFER_SIZE] = {};
+    mopo_float* silent_tail = silent + offset;
+    bool expected_silent = scalar.isSilent(silent_tail, size);
+    if (size)
+      silent_tail[size - 1] = 1e-3;
+    bool expected_loud = scalar.isSilent(silent_tail, size);
+    if (size)
+      silent_tail[size - 1] = 0.0;
+    if (kernels.isSilent(silent_tail, size) != expected_silent) {
+      failures++;
+      printf("FAIL isSilent %s size %d offset %d: silent buffer\n",
+             INSTRUCTION_SET_NAMES[instruction_set], size, offset);
+    }
+    if (size)
+      silent_tail[size - 1] = 1e-3;
+    if (kernels.isSilent(silent_tail, size) != expected_loud) {
+      failures++;
+      printf("FAIL isSilent %s size %d offset %d: loud last sample\n",
+             INSTRUCTION_SET_NAMES[instruction_set], size, offset);
+    }
+
+    // Unity buffers: float frames of up to 8 channels, scaled in place.
+    for (int channels = 1; channels <= MAX_CHANNELS; ++channels) {
+      float expected_frames[MAX_CHANNELS * BUFFER_SIZE];
+      float actual_frames[MAX_CHANNELS * BUFFER_SIZE];
+      int num_samples = channels * (size + offset);
+      for (int i = 0; i < num_samples; ++i)
+        expected_frames[i] = actual_frames[i] = in.frames[i];
+      expected_frames[num_samples] = actual_frames[num_samples] = 1234.5f;
+
+      float* expected_start = expected_frames + channels * offset;
+      float* actual_start = actual_frames + channels * offset;
+      scalar.scaleInterleaved(expected_start, expected_start, a, b, channels, size);
+      kernels.scaleInterleaved(actual_start, actual_start, a, b, channels, size);
+      if (memcmp(expected_frames, actual_frames, (num_samples + 1) * sizeof(float))) {
+        failures++;
+        printf("FAIL scaleInterleaved %s size %d offset %d channels %d\n",
+               INSTRUCTION_SET_NAMES[instruction_set], size, offset, channels);
+      }
+    }
+
+    mopo_float expected_peak = scalar.peak(a, size);
+    mopo_float actual_peak = kernels.peak(a, size);
+    expectSame("peak", instruction_set, size, offset, &expected_peak, &actual_peak, 1);
+
+    // The only kernel allowed to sum in its own order.
+    expectClose("sumOfSquares", instruction_set, size, offset,
+                scalar.sumOfSquares(a, size), kernels.sumOfSquares(a, size));
+  }
+} // namespace
+
+int main() {
+  vector_math::setInstructionSet(vector_math::kScalar);
+  const vector_math::Kernels scalar = *vector_math::active_kernels;
+
+  Buffers buffers;
+  randomize(&buffers);
+
+  for (int i = 0; i < vector_math::kNumInstructionSets; ++i) {
+    vector_math::InstructionSet instruction_set = static_cast<vector_math::InstructionSet>(i);
+    if (!vector_math::setInstructionSet(instruction_set)) {
+      printf("skip %s, not supported here\n", INSTRUCTION_SET_NAMES[i]);
+      continue;
+    }
+
+    const vector_math::Kernels kernels = *vector_math::active_kernels;
+    int failures_before = failures;
+    for (int size : SIZES) {
+      for (int offset = 0; offset <= MAX_OFFSET; ++offset)
+        checkKernels(scalar, kernels, instruction_set, buffers, size, offset);
+    }
+    printf("%s %s\n", failures == failures_before ? "pass" : "FAIL", INSTRUCTION_SET_NAMES[i]);
+  }
+
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,118 @@
+/* Copyright 2017 Matt Tytel */
+
+// Measures what sharing voice output buffers saves. For a new engine and for
+// every factory preset, prints the bytes of audio output buffer the voice
+// graph holds and touches per voice pass, before and after outputs that
+// aren't needed at the same time share buffers. Every thread rendering
+// voices holds its own set of these outputs.
+
+#include "helm_engine.h"
+#include "helm_voice_handler.h"
+#include "preset_reader.h"
+
+#include <algorithm>
+#include <cstdio>
+
+using namespace Helm;
+
+namespace {
+  const char* PRESET_DIRECTORY = "../Assets/AudioHelm/Presets";
+  const int SAMPLE_RATE = 44100;
+  const double KIB = 1024.0;
+
+  struct Sizes {
+    double held;
+    double shared_held;
+    double touched;
+    double shared_touched;
+  };
+
+  Sizes measure(mopo::HelmEngine* engine) {
+    engine->setSampleRate(SAMPLE_RATE);
+    engine->setBufferSize(mopo::MAX_BUFFER_SIZE);
+    engine->prepareVoices();
+    engine->process();
+
+    const mopo::HelmVoiceHandler* voices = engine->getVoiceHandler();
+    Sizes sizes = { voices->getVoiceBufferSize() / KIB,
+                    voices->getSharedVoiceBufferSize() / KIB,
+                    voices->getVoiceWorkingSetSize() / KIB,
+                    voices->getSharedVoiceWorkingSetSize() / KIB };
+    return sizes;
+  }
+
+  bool measurePreset(const std::string& path, Sizes* sizes) {
+    std::string text;
+    PresetReader::Preset preset;
+    if (!PresetReader::readFile(path, &text) || !PresetReader::parse(text, &preset))
+      return false;
+
+    mopo::HelmEngine engine;
+    mopo::control_map controls = engine.getControls();
+    for (auto& value : preset.values) {
+      if (controls.count(value.first))
+        controls[value.first]->set(value.second);
+    }
+
+    std::vector<mopo::ModulationConnection*> connections;
+    for (const mopo::BinaryPatch::ModulationSetting& modulation : preset.modulations) {
+      mopo::ModulationConnection* connection =
+          new mopo::ModulationConnection(modulation.source, modulation.destination);
+      connection->amount.set(modulation.amount);
+      engine.connectModulation(connection);
+      connections.push_back(connection);
+    }
+
+    *sizes = measure(&engine);
+    for (mopo::ModulationConnection* connection : connections) {
+      engine.disconnectModulation(connection);
+      delete connection;
+    }
+    return true;
+  }
+
+  void printSizes(const char* name, const Sizes& sizes) {
+    printf("%-16s held %6.1f -> %6.1f KiB   touched %6.1f -> %6.1f KiB\n", name,
+           sizes.held, sizes.shared_held, sizes.touched, sizes.shared_touched);
+  }
+} // namespace
+
+int main() {
+  std::vector<std::string> paths = PresetReader::findPresets(PRESET_DIRECTORY);
+  if (paths.empty()) {
+    printf("FAIL no presets found in %s\n", PRESET_DIRECTORY);
+    return 1;
+  }
+
+  mopo::HelmEngine engine;
+  printSizes("new engine", measure(&engine));
+
+  Sizes total = { 0.0, 0.0, 0.0, 0.0 };
+  double least_saved = 0.0;
+  double most_saved = 0.0;
+  int failures = 0;
+  for (const std::string& path : paths) {
+    Sizes sizes;
+    if (!measurePreset(path, &sizes)) {
+      printf("FAIL couldn't parse %s\n", path.c_str());
+      failures++;
+      continue;
+    }
+
+    double saved = sizes.held - sizes.shared_held;
+    least_saved = total.held == 0.0 ? saved : std::min(least_saved, saved);
+    most_saved = std::max(most_saved, saved);
+    total.held += sizes.held;
+    total.shared_held += sizes.shared_held;
+    total.touched += sizes.touched;
+    total.shared_touched += sizes.shared_touched;
+  }
+
+  int num_presets = paths.size() - failures;
+  Sizes average = { total.held / num_presets, total.shared_held / num_presets,
+                    total.touched / num_presets, total.shared_touched / num_presets };
+  printSizes("preset average", average);
+  printf("held saving per thread's voice outputs: %.1f to %.1f KiB over %d presets\n",
+         least_saved, most_saved, num_presets);
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,84 @@
+/* Copyright 2017 Matt Tytel */
+
+// Times rendering a dense chord of unison voices with the voices spread over
+// 1, 2, 4 and 8 threads. Prints the best of several runs per block and the
+// speedup over one thread, and fails if any thread count renders different
+// samples than one thread does.
+
+#include "helm_engine.h"
+
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+using namespace mopo;
+
+namespace {
+  const int SAMPLE_RATE = 44100;
+  const int UNISON_VOICES = 8;
+  const int NUM_NOTES = 16;
+  const int LOWEST_NOTE = 40;
+  const int BLOCKS = 64;
+  const int RUNS = 5;
+  const int THREAD_COUNTS[] = { 1, 2, 4, 8 };
+
+  typedef std::chrono::steady_clock Clock;
+
+  // Renders BLOCKS blocks of the chord from a fresh start into _rendered_
+  // and returns the microseconds per block.
+  double renderChord(HelmEngine* engine, std::vector<mopo_float>* rendered) {
+    engine->allNotesOff();
+    for (int i = 0; i < BLOCKS; ++i)
+      engine->process();
+
+    for (int n = 0; n < NUM_NOTES; ++n)
+      engine->noteOn(LOWEST_NOTE + 3 * n, 0.5 + 0.5 * n / NUM_NOTES);
+
+    rendered->clear();
+    auto start = Clock::now();
+    for (int i = 0; i < BLOCKS; ++i) {
+      engine->process();
+      const mopo_float* left = engine->output(0)->buffer;
+      rendered->insert(rendered->end(), left, left + MAX_BUFFER_SIZE);
+    }
+    auto end = Clock::now();
+    return std::chrono::duration<double, std::micro>(end - start).count() / BLOCKS;
+  }
+} // namespace
+
+int main() {
+  int failures = 0;
+  double single_thread_time = 0.0;
+  std::vector<mopo_float> expected;
+
+  for (int num_threads : THREAD_COUNTS) {
+    HelmEngine engine;
+    engine.setSampleRate(SAMPLE_RATE);
+    engine.setBufferSize(MAX_BUFFER_SIZE);
+    engine.getControls()["polyphony"]->set(NUM_NOTES);
+    engine.getControls()["osc_1_unison_voices"]->set(UNISON_VOICES);
+    engine.getControls()["osc_2_unison_voices"]->set(UNISON_VOICES);
+    engine.setVoiceThreads(num_threads);
+
+    std::vector<mopo_float> rendered;
+    double best = 0.0;
+    for (int r = 0; r < RUNS; ++r) {
+      double time = renderChord(&engine, &rendered);
+      if (r == 0 || time < best)
+        best = time;
+    }
+
+    if (num_threads == 1) {
+      single_thread_time = best;
+      expected = rendered;
+    }
+    else if (rendered != expected) {
+      printf("FAIL %d threads rendered different samples than one thread\n", num_threads);
+      failures++;
+    }
+
+    printf("%d threads %10.1f us per block (%4.2fx)\n",
+           num_threads, best, single_thread_time / best);
+  }
+  return failures ? 1 : 0;
+}
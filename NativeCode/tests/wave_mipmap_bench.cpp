@@ -0,0 +1,146 @@
+/* Copyright 2017 Matt Tytel */
+
+// Times the oscillators of a 16 voice chord reading the band limited wave
+// levels at 1, 8 and 15 unison voices, and with their pitch swept so unison
+// voices cross between levels and fade. Each case runs with the tables warm
+// in the cache and with the cache flushed before every block, and the sizes
+// of the tables the oscillators read are printed.
+
+#include "fixed_point_wave.h"
+#include "helm_oscillators.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+using namespace mopo;
+
+namespace {
+  const int SAMPLE_RATE = 44100;
+  const int NUM_NOTES = 16;
+  const mopo_float LOWEST_FREQUENCY = 65.4;
+  const mopo_float NOTE_RATIO = 1.189;
+  const mopo_float UNISON_DETUNE = 20.0;
+  const int SWEEP_OCTAVES = 4;
+  const int BLOCKS = 256;
+  const int RUNS = 9;
+  const int FLUSH_BYTES = 64 * 1024 * 1024;
+  const int CACHE_LINE = 64;
+
+  struct Case {
+    const char* name;
+    int unison_voices;
+    bool swept;
+  };
+
+  const Case CASES[] = {
+    { "unison 1", 1, false },
+    { "unison 8", 8, false },
+    { "unison 15", 15, false },
+    { "swept unison 15", 15, true },
+  };
+
+  typedef std::chrono::steady_clock Clock;
+
+  std::vector<char> flush_buffer(FLUSH_BYTES);
+  volatile char flush_sink = 0;
+  volatile mopo_float output_sink = 0.0;
+
+  // Pushes the wave tables out of every cache level by reading and writing
+  // a buffer bigger than the last level.
+  void flushCache() {
+    char sum = 0;
+    for (int i = 0; i < FLUSH_BYTES; i += CACHE_LINE) {
+      flush_buffer[i]++;
+      sum += flush_buffer[i];
+    }
+    flush_sink = sum;
+  }
+
+  // One voice's oscillators with both oscillators playing a saw.
+  struct NoteOscillators {
+    NoteOscillators(int unison_voices, mopo_float frequency) :
+        waveform(FixedPointWaveLookup::kDownSaw), phase_inc(frequency / SAMPLE_RATE),
+        amplitude(1.0), unison(unison_voices), detune(UNISON_DETUNE), off(0.0),
+        base_phase_inc(frequency / SAMPLE_RATE) {
+      Processor* inputs[] = {
+        &waveform, &waveform, &phase_inc, &phase_inc, &amplitude, &amplitude,
+        &unison, &unison, &detune, &detune, &off, &off, &off, &off
+      };
+      for (int i = 0; i < HelmOscillators::kNumInputs; ++i)
+        oscillators.plug(inputs[i], i);
+      oscillators.setSampleRate(SAMPLE_RATE);
+      oscillators.setBufferSize(MAX_BUFFER_SIZE);
+    }
+
+    HelmOscillators oscillators;
+    Value waveform;
+    Value phase_inc;
+    Value amplitude;
+    Value unison;
+    Value detune;
+    Value off;
+    mopo_float base_phase_inc;
+  };
+
+  double microseconds(Clock::time_point start, Clock::time_point end) {
+    return std::chrono::duration<double, std::micro>(end - start).count();
+  }
+
+  // Microseconds per block for every voice. Each block keeps its best time
+  // over RUNS, so noise from other work on the machine drops out. Flushed
+  // blocks don't count the flush.
+  double renderChord(std::vector<NoteOscillators*>& voices, bool swept, bool flush) {
+    std::vector<double> best(BLOCKS);
+    for (int r = 0; r < RUNS; ++r) {
+      for (int b = 0; b < BLOCKS; ++b) {
+        if (swept) {
+          mopo_float octaves = (1.0 * SWEEP_OCTAVES * b) / BLOCKS;
+          for (NoteOscillators* voice : voices)
+            voice->phase_inc.set(voice->base_phase_inc * pow(2.0, octaves));
+        }
+        if (flush)
+          flushCache();
+
+        auto start = Clock::now();
+        for (NoteOscillators* voice : voices)
+          voice->oscillators.process();
+        double time = microseconds(start, Clock::now());
+        output_sink = voices[0]->oscillators.output()->buffer[0];
+
+        if (r == 0 || time < best[b])
+          best[b] = time;
+      }
+    }
+
+    double total = 0.0;
+    for (double time : best)
+      total += time;
+    return total / BLOCKS;
+  }
+} // namespace
+
+int main() {
+  printf("wave tables %.0f KB, %d levels of %.0f KB per waveform\n",
+         sizeof(FixedPointWaveLookup) / 1024.0, FixedPointWaveLookup::LEVELS,
+         2 * FixedPointWaveLookup::FIXED_LOOKUP_SIZE * sizeof(float) / 1024.0);
+
+  for (const Case& test_case : CASES) {
+    std::vector<NoteOscillators*> voices;
+    mopo_float frequency = LOWEST_FREQUENCY;
+    for (int n = 0; n < NUM_NOTES; ++n) {
+      voices.push_back(new NoteOscillators(test_case.unison_voices, frequency));
+      frequency *= NOTE_RATIO;
+    }
+
+    double warm = renderChord(voices, test_case.swept, false);
+    double flushed = renderChord(voices, test_case.swept, true);
+    printf("%-16s %7.1f us per block warm, %7.1f flushed (%4.2fx)\n",
+           test_case.name, warm, flushed, flushed / warm);
+
+    for (NoteOscillators* voice : voices)
+      delete voice;
+  }
+  return 0;
+}